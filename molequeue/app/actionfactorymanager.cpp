@@ -18,6 +18,9 @@
 
 #include "jobactionfactories/openwithactionfactory.h"
 
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+
 namespace MoleQueue {
 
 ActionFactoryManager *ActionFactoryManager::m_instance = NULL;
@@ -80,7 +83,13 @@ ActionFactoryManager *ActionFactoryManager::instance()
 
 void ActionFactoryManager::addFactory(JobActionFactory *newFactory)
 {
+  QMutexLocker locker(&m_factoriesMutex);
   if (!m_factories.contains(newFactory)) {
+    // Factories created by RPC requests are used by the GUI.
+    if (newFactory->thread() != thread() &&
+        newFactory->thread() == QThread::currentThread()) {
+      newFactory->moveToThread(thread());
+    }
     newFactory->setServer(server());
     m_factories.append(newFactory);
   }
@@ -88,6 +97,7 @@ void ActionFactoryManager::addFactory(JobActionFactory *newFactory)
 
 QList<JobActionFactory *> ActionFactoryManager::factories() const
 {
+  QMutexLocker locker(&m_factoriesMutex);
   return m_factories;
 }
 
@@ -95,7 +105,7 @@ QList<JobActionFactory *>
 ActionFactoryManager::factories(JobActionFactory::Flags flags) const
 {
   QList<JobActionFactory *> result;
-  foreach (JobActionFactory *factory, m_factories) {
+  foreach (JobActionFactory *factory, factories()) {
     if ((factory->flags() & flags) == flags)
       result << factory;
   }
@@ -104,6 +114,7 @@ ActionFactoryManager::factories(JobActionFactory::Flags flags) const
 
 void ActionFactoryManager::removeFactory(JobActionFactory *factory)
 {
+  QMutexLocker locker(&m_factoriesMutex);
   m_factories.removeOne(factory);
   factory->deleteLater();
 }
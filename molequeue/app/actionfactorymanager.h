@@ -17,6 +17,7 @@
 #ifndef MOLEQUEUE_ACTIONFACTORYMANAGER_H
 #define MOLEQUEUE_ACTIONFACTORYMANAGER_H
 
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include <QtCore/QSettings>
 
@@ -86,7 +87,7 @@ public:
   QList<FactoryType*> factoriesOfType() const
   {
     QList<FactoryType*> result;
-    foreach (JobActionFactory *factory, m_factories) {
+    foreach (JobActionFactory *factory, factories()) {
       if (FactoryType *f = qobject_cast<FactoryType*>(factory)) {
         result << f;
       }
@@ -106,6 +107,10 @@ protected:
 
   QList<JobActionFactory*> m_factories;
 
+  /// Guards m_factories, which is also used by RPC requests when the server
+  /// runs in a ServerThread.
+  mutable QMutex m_factoriesMutex;
+
 };
 
 } // namespace MoleQueue
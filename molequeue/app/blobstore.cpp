@@ -0,0 +1,247 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "blobstore.h"
+
+#include "filesystemtools.h"
+#include "logger.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryFile>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace MoleQueue
+{
+
+BlobStore *BlobStore::m_instance = NULL;
+
+BlobStore::BlobStore()
+  : m_threshold(DEFAULT_BLOB_THRESHOLD),
+    m_hits(0),
+    m_misses(0)
+{
+}
+
+BlobStore::~BlobStore()
+{
+  m_instance = NULL;
+}
+
+BlobStore *BlobStore::instance()
+{
+  if (!m_instance)
+    m_instance = new BlobStore;
+
+  return m_instance;
+}
+
+void BlobStore::setDirectory(const QString &dir)
+{
+  m_directory = dir.isEmpty() ? QString() : QDir::cleanPath(dir);
+  if (!m_directory.isEmpty() && !QDir().mkpath(m_directory)) {
+    Logger::logError(Logger::tr("Cannot create blob store directory '%1'.")
+                     .arg(m_directory));
+    m_directory.clear();
+  }
+}
+
+QString BlobStore::hash(const QByteArray &data)
+{
+  return QString::fromLatin1(
+        QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex());
+}
+
+QString BlobStore::add(const QByteArray &data, bool *alreadyStored)
+{
+  if (!isEnabled())
+    return QString();
+
+  QString dataHash = hash(data);
+  bool found = contains(dataHash);
+  if (alreadyStored)
+    *alreadyStored = found;
+  if (found) {
+    ++m_hits;
+    return dataHash;
+  }
+  ++m_misses;
+
+  QTemporaryFile tmpFile(m_directory + "/blob-XXXXXX");
+  tmpFile.setAutoRemove(false);
+  if (!tmpFile.open() || tmpFile.write(data) != data.size()) {
+    Logger::logError(Logger::tr("Cannot write to blob store '%1'.")
+                     .arg(m_directory));
+    tmpFile.remove();
+    return QString();
+  }
+  tmpFile.close();
+
+  return commit(tmpFile.fileName(), dataHash);
+}
+
+QString BlobStore::addFile(const QString &filePath, bool *alreadyStored)
+{
+  if (!isEnabled())
+    return QString();
+
+  QFile source(filePath);
+  if (!source.open(QFile::ReadOnly)) {
+    Logger::logError(Logger::tr("Error opening file for read: '%1'")
+                     .arg(filePath));
+    return QString();
+  }
+
+  // Hash and copy in a single pass.
+  QTemporaryFile tmpFile(m_directory + "/blob-XXXXXX");
+  tmpFile.setAutoRemove(false);
+  if (!tmpFile.open()) {
+    Logger::logError(Logger::tr("Cannot write to blob store '%1'.")
+                     .arg(m_directory));
+    return QString();
+  }
+
+  QCryptographicHash hasher(QCryptographicHash::Sha256);
+  QByteArray buffer;
+  while (!(buffer = source.read(64 * 1024)).isEmpty()) {
+    hasher.addData(buffer);
+    if (tmpFile.write(buffer) != buffer.size()) {
+      Logger::logError(Logger::tr("Cannot write to blob store '%1'.")
+                       .arg(m_directory));
+      tmpFile.remove();
+      return QString();
+    }
+  }
+  tmpFile.close();
+
+  QString dataHash = QString::fromLatin1(hasher.result().toHex());
+  bool found = contains(dataHash);
+  if (alreadyStored)
+    *alreadyStored = found;
+  if (found) {
+    ++m_hits;
+    tmpFile.remove();
+    return dataHash;
+  }
+  ++m_misses;
+
+  return commit(tmpFile.fileName(), dataHash);
+}
+
+QString BlobStore::commit(const QString &tmpPath, const QString &dataHash)
+{
+  QString blobPath = path(dataHash);
+  QDir().mkpath(QFileInfo(blobPath).absolutePath());
+
+  // Another writer may have stored the same contents meanwhile, that's fine.
+  if (!QFile::rename(tmpPath, blobPath) && !QFile::exists(blobPath)) {
+    Logger::logError(Logger::tr("Cannot add '%1' to blob store.")
+                     .arg(blobPath));
+    QFile::remove(tmpPath);
+    return QString();
+  }
+  QFile::remove(tmpPath);
+
+  return dataHash;
+}
+
+bool BlobStore::contains(const QString &dataHash) const
+{
+  return isEnabled() && !dataHash.isEmpty() && QFile::exists(path(dataHash));
+}
+
+QString BlobStore::path(const QString &dataHash) const
+{
+  return m_directory + "/" + dataHash.left(2) + "/" + dataHash;
+}
+
+qint64 BlobStore::size(const QString &dataHash) const
+{
+  QFileInfo info(path(dataHash));
+  return info.exists() ? info.size() : -1;
+}
+
+QByteArray BlobStore::read(const QString &dataHash) const
+{
+  QFile file(path(dataHash));
+  if (!file.open(QFile::ReadOnly)) {
+    Logger::logError(Logger::tr("Cannot read blob '%1' from store '%2'.")
+                     .arg(dataHash, m_directory));
+    return QByteArray();
+  }
+
+  return file.readAll();
+}
+
+bool BlobStore::copyTo(const QString &dataHash, const QString &target) const
+{
+  if (!contains(dataHash))
+    return false;
+
+  if (QFile::exists(target))
+    QFile::remove(target);
+
+  if (!FileSystemTools::copyFile(path(dataHash), target))
+    return false;
+
+  // Blobs are created private to the user; give the job's copy the usual
+  // permissions of a newly written file.
+  return QFile::setPermissions(target, QFile::ReadOwner | QFile::WriteOwner |
+                               QFile::ReadUser | QFile::WriteUser |
+                               QFile::ReadGroup | QFile::ReadOther);
+}
+
+bool BlobStore::linkTo(const QString &dataHash, const QString &target) const
+{
+  if (!contains(dataHash))
+    return false;
+
+#ifdef Q_OS_UNIX
+  if (QFile::exists(target))
+    QFile::remove(target);
+
+  QString blobPath = path(dataHash);
+  QFile::setPermissions(blobPath, QFile::ReadOwner | QFile::ReadUser |
+                        QFile::ReadGroup | QFile::ReadOther);
+  if (::link(QFile::encodeName(blobPath).constData(),
+             QFile::encodeName(target).constData()) == 0) {
+    return true;
+  }
+#endif
+
+  return copyTo(dataHash, target);
+}
+
+void BlobStore::removeUnreferenced(const QSet<QString> &referenced)
+{
+  if (!isEnabled())
+    return;
+
+  QDirIterator it(m_directory, QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext()) {
+    it.next();
+    if (!referenced.contains(it.fileName()))
+      QFile::remove(it.filePath());
+  }
+}
+
+} // namespace MoleQueue
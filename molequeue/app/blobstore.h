@@ -0,0 +1,160 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_BLOBSTORE_H
+#define MOLEQUEUE_BLOBSTORE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+
+namespace MoleQueue
+{
+
+/// Default size (in bytes) above which file contents are kept in the
+/// BlobStore rather than in memory.
+const qint64 DEFAULT_BLOB_THRESHOLD = 1024 * 1024;
+
+/**
+ * @class BlobStore blobstore.h <molequeue/blobstore.h>
+ * @brief Singleton content-addressed store for large file contents.
+ *
+ * Large input file contents received over RPC are written once to the store
+ * and referenced from FileSpecification objects by their SHA-256 hash. Blobs
+ * live in [directory]/[first two hash characters]/[hash] and are immutable
+ * once written.
+ *
+ * The store is disabled until setDirectory() is called (the Server does this
+ * when reading its settings); while disabled, FileSpecification keeps all
+ * contents in memory as before.
+ *
+ * Queues also use the store to deduplicate job input files: each distinct
+ * file is stored once and copied into the job directories (see copyTo()), or
+ * hard linked for programs that allow it (see linkTo()). hits() and misses()
+ * count how often add() and addFile() found their contents already present.
+ */
+class BlobStore
+{
+public:
+  /// @return The singleton instance of the store.
+  static BlobStore * instance();
+
+  ~BlobStore();
+
+  /// Set the directory that holds the blobs. An empty string disables the
+  /// store.
+  void setDirectory(const QString &dir);
+
+  /// @return The directory that holds the blobs.
+  QString directory() const { return m_directory; }
+
+  /// @return True if a directory has been set.
+  bool isEnabled() const { return !m_directory.isEmpty(); }
+
+  /// Contents larger than @a bytes are spilled to the store.
+  /// Default: DEFAULT_BLOB_THRESHOLD
+  void setThreshold(qint64 bytes) { m_threshold = bytes; }
+
+  /// Contents larger than threshold() bytes are spilled to the store.
+  qint64 threshold() const { return m_threshold; }
+
+  /// @return True if @a size bytes of content should be kept in the store.
+  bool shouldStore(qint64 size) const
+  {
+    return isEnabled() && size > m_threshold;
+  }
+
+  /// @return The hash used to identify @a data.
+  static QString hash(const QByteArray &data);
+
+  /**
+   * Add @a data to the store.
+   * @param alreadyStored If not NULL, set to true if the contents were
+   * already present.
+   * @return The hash of @a data, or a null string on error.
+   */
+  QString add(const QByteArray &data, bool *alreadyStored = NULL);
+
+  /**
+   * Add the contents of the file at @a path to the store without reading the
+   * whole file into memory.
+   * @param alreadyStored If not NULL, set to true if the contents were
+   * already present.
+   * @return The hash of the contents, or a null string on error.
+   */
+  QString addFile(const QString &path, bool *alreadyStored = NULL);
+
+  /// @return True if a blob with @a hash is present.
+  bool contains(const QString &hash) const;
+
+  /// @return The path to the blob with @a hash.
+  QString path(const QString &hash) const;
+
+  /// @return The size of the blob with @a hash, or -1 if not present.
+  qint64 size(const QString &hash) const;
+
+  /// @return The contents of the blob with @a hash.
+  QByteArray read(const QString &hash) const;
+
+  /**
+   * Place a copy of the blob with @a hash at @a target. The copy is a reflink
+   * where the filesystem supports it (see FileSystemTools::copyFile()), and
+   * is writable. An existing file at @a target is replaced.
+   * @return True on success.
+   */
+  bool copyTo(const QString &hash, const QString &target) const;
+
+  /**
+   * Place the blob with @a hash at @a target as a hard link, falling back to
+   * copyTo() where links are not supported (e.g. across filesystems or on
+   * Windows). Linked blobs are made read-only, since every link shares the
+   * same data. An existing file at @a target is replaced.
+   * @return True on success.
+   */
+  bool linkTo(const QString &hash, const QString &target) const;
+
+  /// @return The number of add()/addFile() calls that found their contents
+  /// already stored.
+  int hits() const { return m_hits; }
+
+  /// @return The number of add()/addFile() calls that stored new contents.
+  int misses() const { return m_misses; }
+
+  /// @return hits() as a percentage of all add()/addFile() calls.
+  double hitRate() const
+  {
+    return (m_hits + m_misses) > 0 ? 100.0 * m_hits / (m_hits + m_misses) : 0.0;
+  }
+
+  /// Delete all blobs whose hash is not in @a referenced.
+  void removeUnreferenced(const QSet<QString> &referenced);
+
+private:
+  BlobStore();
+  static BlobStore *m_instance;
+
+  /// Move the fully written temporary file @a tmpPath into place as @a hash.
+  QString commit(const QString &tmpPath, const QString &hash);
+
+  QString m_directory;
+  qint64 m_threshold;
+  int m_hits;
+  int m_misses;
+};
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_BLOBSTORE_H
@@ -0,0 +1,267 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "directoryoperation.h"
+
+#include "filesystemtools.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+
+namespace MoleQueue {
+
+/// Number of files handed to each worker task.
+static const int filesPerTask = 32;
+
+class DirectoryWalkTask : public QRunnable
+{
+public:
+  explicit DirectoryWalkTask(DirectoryOperation *op) : m_op(op) {}
+  void run() { m_op->walk(); }
+private:
+  DirectoryOperation *m_op;
+};
+
+class DirectoryFileTask : public QRunnable
+{
+public:
+  DirectoryFileTask(DirectoryOperation *op, const QStringList &files)
+    : m_op(op), m_files(files) {}
+  void run() { m_op->processFiles(m_files); }
+private:
+  DirectoryOperation *m_op;
+  QStringList m_files;
+};
+
+DirectoryOperation::DirectoryOperation(Type type, const QString &source,
+                                       const QString &target,
+                                       bool deleteContentsOnly,
+                                       QObject *parentObject)
+  : QObject(parentObject), m_type(type), m_source(QDir::cleanPath(source)),
+    m_target(target.isEmpty() ? QString() : QDir::cleanPath(target)),
+    m_deleteContentsOnly(deleteContentsOnly), m_running(false),
+    m_canceled(0), m_failed(0), m_filesProcessed(0), m_filesPending(0),
+    m_totalFiles(-1), m_progressQueued(0)
+{
+  // The walk task waits on nothing, but make sure it can never starve the
+  // file tasks on single core machines.
+  m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+}
+
+DirectoryOperation *DirectoryOperation::copyDirectory(const QString &from,
+                                                      const QString &to,
+                                                      QObject *parentObject)
+{
+  return new DirectoryOperation(Copy, from, to, false, parentObject);
+}
+
+DirectoryOperation *DirectoryOperation::removeDirectory(
+    const QString &path, bool deleteContentsOnly, QObject *parentObject)
+{
+  return new DirectoryOperation(Remove, path, QString(), deleteContentsOnly,
+                                parentObject);
+}
+
+DirectoryOperation::~DirectoryOperation()
+{
+  cancel();
+  m_pool.waitForDone();
+}
+
+QString DirectoryOperation::errorString() const
+{
+  QMutexLocker locker(&m_errorMutex);
+  return m_errorString;
+}
+
+void DirectoryOperation::start()
+{
+  if (m_running)
+    return;
+
+  m_running = true;
+  m_canceled.storeRelease(0);
+  m_failed.storeRelease(0);
+  m_filesProcessed.storeRelease(0);
+  m_totalFiles.storeRelease(-1);
+  m_directories.clear();
+  m_errorString.clear();
+
+  m_pool.start(new DirectoryWalkTask(this));
+}
+
+void DirectoryOperation::cancel()
+{
+  m_canceled.storeRelease(1);
+}
+
+void DirectoryOperation::reportProgress()
+{
+  m_progressQueued.storeRelease(0);
+  if (m_running)
+    emit progress(filesProcessed(), qMax(0, totalFiles()));
+}
+
+void DirectoryOperation::reportFinished()
+{
+  m_running = false;
+  emit progress(filesProcessed(), qMax(0, totalFiles()));
+  emit finished(m_failed.loadAcquire() == 0 && !isCanceled());
+}
+
+void DirectoryOperation::walk()
+{
+  // Just a safety to prevent accidentally wiping /
+  if (m_source.isEmpty() || m_source.simplified() == "/" ||
+      (m_type == Copy && m_target.isEmpty())) {
+    setError(tr("Invalid directory operation: '%1' -> '%2'")
+             .arg(m_source, m_target));
+    notifyFinished();
+    return;
+  }
+
+  QDir sourceDir(m_source);
+  if (!sourceDir.exists()) {
+    // Removing a directory that is not there is a no-op, as in
+    // FileSystemTools::recursiveRemoveDirectory.
+    if (m_type == Copy)
+      setError(tr("Source directory does not exist: '%1'").arg(m_source));
+    m_totalFiles.storeRelease(0);
+    notifyFinished();
+    return;
+  }
+
+  // Collect the tree. Directories are reported parent-first by the iterator,
+  // which is the order needed to build the skeleton of a copy. Copies follow
+  // symlinked directories like recursiveCopyDirectory does, while removal
+  // only unlinks them.
+  QDirIterator::IteratorFlags flags = QDirIterator::Subdirectories;
+  if (m_type == Copy)
+    flags |= QDirIterator::FollowSymlinks;
+  QStringList files;
+  QDirIterator it(m_source, QDir::NoDotAndDotDot | QDir::System |
+                  QDir::Hidden | QDir::AllDirs | QDir::Files, flags);
+  while (it.hasNext()) {
+    if (isCanceled()) {
+      notifyFinished();
+      return;
+    }
+    it.next();
+    QFileInfo info = it.fileInfo();
+    QString relativePath = sourceDir.relativeFilePath(info.absoluteFilePath());
+    if (info.isDir() && (m_type == Copy || !info.isSymLink()))
+      m_directories.append(relativePath);
+    else
+      files.append(relativePath);
+  }
+
+  if (m_type == Copy) {
+    QDir targetDir(m_target);
+    if (!targetDir.exists() && !targetDir.mkpath(m_target)) {
+      setError(tr("Cannot create directory '%1'").arg(m_target));
+      notifyFinished();
+      return;
+    }
+    foreach (const QString &dir, m_directories) {
+      if (!targetDir.mkpath(dir)) {
+        setError(tr("Cannot create directory '%1'")
+                 .arg(targetDir.absoluteFilePath(dir)));
+        notifyFinished();
+        return;
+      }
+    }
+  }
+
+  m_totalFiles.storeRelease(files.size());
+  if (files.isEmpty()) {
+    processDirectories();
+    notifyFinished();
+    return;
+  }
+
+  // Hand the files to the pool in batches. The last batch to complete
+  // finishes the operation.
+  m_filesPending.storeRelease(files.size());
+  for (int i = 0; i < files.size(); i += filesPerTask)
+    m_pool.start(new DirectoryFileTask(this, files.mid(i, filesPerTask)));
+}
+
+void DirectoryOperation::processFiles(const QStringList &files)
+{
+  foreach (const QString &file, files) {
+    if (isCanceled() || m_failed.loadAcquire() != 0)
+      break;
+
+    QString sourceFile = m_source + "/" + file;
+    if (m_type == Copy) {
+      QString targetFile = m_target + "/" + file;
+      if (!FileSystemTools::copyFile(sourceFile, targetFile))
+        setError(tr("Cannot copy '%1' -> '%2'").arg(sourceFile, targetFile));
+    }
+    else if (!QFile::remove(sourceFile)) {
+      setError(tr("Cannot remove '%1'").arg(sourceFile));
+    }
+
+    m_filesProcessed.fetchAndAddOrdered(1);
+  }
+
+  // Coalesce progress notifications -- only one may be queued at a time.
+  if (m_progressQueued.testAndSetOrdered(0, 1))
+    QMetaObject::invokeMethod(this, "reportProgress", Qt::QueuedConnection);
+
+  if (m_filesPending.fetchAndAddOrdered(-files.size()) == files.size()) {
+    processDirectories();
+    notifyFinished();
+  }
+}
+
+void DirectoryOperation::processDirectories()
+{
+  if (m_type != Remove || isCanceled() || m_failed.loadAcquire() != 0)
+    return;
+
+  // Children before parents.
+  QDir sourceDir(m_source);
+  for (int i = m_directories.size() - 1; i >= 0; --i) {
+    if (!sourceDir.rmdir(m_directories[i])) {
+      setError(tr("Cannot remove '%1'")
+               .arg(sourceDir.absoluteFilePath(m_directories[i])));
+      return;
+    }
+  }
+
+  if (!m_deleteContentsOnly && !sourceDir.rmdir(m_source))
+    setError(tr("Cannot remove '%1'").arg(m_source));
+}
+
+void DirectoryOperation::setError(const QString &error)
+{
+  QMutexLocker locker(&m_errorMutex);
+  if (m_failed.testAndSetOrdered(0, 1))
+    m_errorString = error;
+}
+
+void DirectoryOperation::notifyFinished()
+{
+  QMetaObject::invokeMethod(this, "reportFinished", Qt::QueuedConnection);
+}
+
+} // namespace MoleQueue
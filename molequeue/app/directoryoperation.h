@@ -0,0 +1,177 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_DIRECTORYOPERATION_H
+#define MOLEQUEUE_DIRECTORYOPERATION_H
+
+#include <QtCore/QObject>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVariant>
+
+namespace MoleQueue {
+
+/**
+ * @class DirectoryOperation directoryoperation.h <molequeue/directoryoperation.h>
+ * @brief Asynchronous, cancellable copy or removal of a local directory tree.
+ *
+ * This is the non-blocking counterpart of
+ * FileSystemTools::recursiveCopyDirectory and
+ * FileSystemTools::recursiveRemoveDirectory. The tree is walked on a worker
+ * thread, and the individual files are then copied or removed in batches on a
+ * private thread pool. File copies use FileSystemTools::copyFile, and thus the
+ * kernel fast paths where available.
+ *
+ * Use copyDirectory() or removeDirectory() to create an operation, connect to
+ * finished(), then call start(). The operation may be deleted at any time; the
+ * destructor cancels it and waits for the in-flight files to complete.
+ */
+class DirectoryOperation : public QObject
+{
+  Q_OBJECT
+public:
+  enum Type {
+    Copy = 0,
+    Remove
+  };
+
+  /**
+   * Create an operation that copies the contents of directory @a from into
+   * @a to. The operation is not started.
+   */
+  static DirectoryOperation * copyDirectory(const QString &from,
+                                            const QString &to,
+                                            QObject *parentObject = 0);
+
+  /**
+   * Create an operation that removes the directory at @a path. If
+   * @a deleteContentsOnly is true, the directory itself is kept. The operation
+   * is not started.
+   */
+  static DirectoryOperation * removeDirectory(const QString &path,
+                                              bool deleteContentsOnly = false,
+                                              QObject *parentObject = 0);
+
+  ~DirectoryOperation();
+
+  /** @return The type of operation. */
+  Type type() const { return m_type; }
+
+  /** @return The directory being copied or removed. */
+  QString source() const { return m_source; }
+
+  /** @return The destination directory of a Copy operation. */
+  QString target() const { return m_target; }
+
+  /** @return True if the operation has been started and is not finished. */
+  bool isRunning() const { return m_running; }
+
+  /** @return True if cancel() has been called. */
+  bool isCanceled() const { return m_canceled.loadAcquire() != 0; }
+
+  /** @return The number of files handled so far. */
+  int filesProcessed() const { return m_filesProcessed.loadAcquire(); }
+
+  /** @return The number of files in the tree, or -1 if not yet known. */
+  int totalFiles() const { return m_totalFiles.loadAcquire(); }
+
+  /** @return A description of the first error encountered, if any. */
+  QString errorString() const;
+
+  /** Maximum number of worker threads used by this operation. */
+  void setMaxThreadCount(int count) { m_pool.setMaxThreadCount(count); }
+
+  /** Maximum number of worker threads used by this operation. */
+  int maxThreadCount() const { return m_pool.maxThreadCount(); }
+
+  /** @return A reference to arbitrary data stored in the operation. */
+  QVariant & data() { return m_data; }
+
+  /** @return A reference to arbitrary data stored in the operation. */
+  const QVariant & data() const { return m_data; }
+
+  /** @param newData Arbitrary data to store in the operation. */
+  void setData(const QVariant &newData) { m_data = newData; }
+
+public slots:
+  /** Begin the operation. Does nothing if already running. */
+  void start();
+
+  /**
+   * Stop processing further files. Files in flight are completed, and
+   * finished() is emitted with success = false.
+   */
+  void cancel();
+
+signals:
+  /**
+   * Emitted periodically while files are being processed.
+   * @param processed Number of files handled so far.
+   * @param total Total number of files in the tree.
+   */
+  void progress(int processed, int total);
+
+  /**
+   * Emitted once the operation has completed, failed, or been canceled.
+   * @param success True if every file was copied/removed.
+   */
+  void finished(bool success);
+
+private slots:
+  void reportProgress();
+  void reportFinished();
+
+private:
+  DirectoryOperation(Type type, const QString &source, const QString &target,
+                     bool deleteContentsOnly, QObject *parentObject);
+
+  // Worker thread entry points:
+  friend class DirectoryWalkTask;
+  friend class DirectoryFileTask;
+  void walk();
+  void processFiles(const QStringList &files);
+  void processDirectories();
+  void setError(const QString &error);
+  void notifyFinished();
+
+  Type m_type;
+  QString m_source;
+  QString m_target;
+  bool m_deleteContentsOnly;
+  bool m_running;
+  QVariant m_data;
+
+  QThreadPool m_pool;
+  QAtomicInt m_canceled;
+  QAtomicInt m_failed;
+  QAtomicInt m_filesProcessed;
+  QAtomicInt m_filesPending;
+  QAtomicInt m_totalFiles;
+  QAtomicInt m_progressQueued;
+
+  /// Source directories, relative to m_source, in walk order (parents first).
+  QStringList m_directories;
+
+  mutable QMutex m_errorMutex;
+  QString m_errorString;
+};
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_DIRECTORYOPERATION_H
@@ -16,6 +16,7 @@
 
 #include "filespecification.h"
 
+#include "blobstore.h"
 #include "logger.h"
 
 #include <qjsondocument.h>
@@ -36,6 +37,13 @@ FileSpecification::FileSpecification()
 FileSpecification::FileSpecification(const QJsonObject &json)
 {
   m_json = json;
+
+  // Spill large contents as soon as they are received.
+  if (m_json.contains("contents")) {
+    QString contents_ = m_json.value("contents").toString();
+    if (BlobStore::instance()->shouldStore(contents_.size()))
+      storeContents(contents_.toLocal8Bit());
+  }
 }
 
 FileSpecification::FileSpecification(const QString &path)
@@ -47,7 +55,10 @@ FileSpecification::FileSpecification(const QString &filename_,
                                      const QString &contents_)
 {
   m_json.insert("filename", filename_);
-  m_json.insert("contents", contents_);
+  if (BlobStore::instance()->shouldStore(contents_.size()))
+    storeContents(contents_.toLocal8Bit());
+  else
+    m_json.insert("contents", contents_);
 }
 
 FileSpecification::FileSpecification(QFile *file,
@@ -59,6 +70,16 @@ FileSpecification::FileSpecification(QFile *file,
     break;
   case ContentsFileSpecification: {
     m_json.insert("filename", QFileInfo(*file).fileName());
+    BlobStore *store = BlobStore::instance();
+    if (store->shouldStore(file->size())) {
+      // Stream large files straight into the store.
+      QString contentsHash_ = store->addFile(file->fileName());
+      if (!contentsHash_.isNull()) {
+        m_json.insert("contentsHash", contentsHash_);
+        m_json.insert("contentsSize", static_cast<double>(file->size()));
+        break;
+      }
+    }
     if (!file->open(QFile::ReadOnly | QFile::Text)) {
       Logger::logError(Logger::tr("Error opening file for read: '%1'")
                        .arg(file->fileName()));
@@ -100,7 +121,7 @@ FileSpecification::Format FileSpecification::format() const
     return PathFileSpecification;
   }
   else if (m_json.contains("filename") &&
-           m_json.contains("contents")) {
+           (m_json.contains("contents") || m_json.contains("contentsHash"))) {
     return ContentsFileSpecification;
   }
 
@@ -112,9 +133,15 @@ QByteArray FileSpecification::toJson() const
   return QJsonDocument(m_json).toJson();
 }
 
-QJsonObject FileSpecification::toJsonObject() const
+QJsonObject FileSpecification::toJsonObject(bool inlineContents) const
 {
-  return m_json;
+  if (!inlineContents || !isStored())
+    return m_json;
+
+  QJsonObject result;
+  result.insert("filename", m_json.value("filename"));
+  result.insert("contents", contents());
+  return result;
 }
 
 bool FileSpecification::fileExists() const
@@ -135,6 +162,9 @@ bool FileSpecification::writeFile(const QDir &dir, const QString &filename_) con
   case ContentsFileSpecification: {
     QString path = dir.absoluteFilePath(filename_.isNull() ? filename()
                                                            : filename_);
+    if (isStored())
+      return BlobStore::instance()->copyTo(contentsHash(), path);
+
     QFile file(path);
     if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
       return false;
@@ -181,11 +211,29 @@ QString FileSpecification::contents() const
     return result;
   }
   case ContentsFileSpecification:
+    if (isStored()) {
+      return QString::fromLocal8Bit(
+            BlobStore::instance()->read(contentsHash()));
+    }
     return QString(m_json.value("contents").toString());
   }
 
 }
 
+void FileSpecification::storeContents(const QByteArray &data)
+{
+  QString contentsHash_ = BlobStore::instance()->add(data);
+  if (contentsHash_.isNull()) {
+    // Keep the contents in memory if the store cannot take them.
+    m_json.insert("contents", QString::fromLocal8Bit(data));
+    return;
+  }
+
+  m_json.remove("contents");
+  m_json.insert("contentsHash", contentsHash_);
+  m_json.insert("contentsSize", static_cast<double>(data.size()));
+}
+
 QString FileSpecification::filepath() const
 {
   if (format() == PathFileSpecification)
@@ -37,6 +37,12 @@ class FileSpecificationPrivate;
  * The FileSpecification class contains a description of a file to facilite
  * file manipulation during RPC communication. Files are stored as either a path
  * to the local file on disk, or a filename and content string.
+ *
+ * Contents larger than BlobStore::threshold() are spilled to the BlobStore
+ * when the FileSpecification is created, and only a reference to the blob
+ * ("contentsHash" and "contentsSize" members) is kept and serialized. Such
+ * specifications still report ContentsFileSpecification as their format;
+ * contents() reads the blob lazily, and toJsonObject(true) inlines it again.
  */
 class FileSpecification
 {
@@ -87,8 +93,20 @@ public:
   /// @return The FileSpecification as a formatted JSON string.
   QByteArray toJson() const;
 
-  /// @return The FileSpecification as a formatted JSON string.
-  QJsonObject toJsonObject() const;
+  /// @return The FileSpecification as a JSON object. If the contents are kept
+  /// in the BlobStore, they are only referenced by hash unless
+  /// @a inlineContents is true.
+  QJsonObject toJsonObject(bool inlineContents = false) const;
+
+  /// @return True if the contents are kept in the BlobStore rather than in
+  /// memory.
+  bool isStored() const { return m_json.contains("contentsHash"); }
+
+  /// @return The BlobStore hash of the contents, if isStored().
+  QString contentsHash() const
+  {
+    return m_json.value("contentsHash").toString();
+  }
 
   /// @return Whether or not the FileSpecification refers to an existing file
   /// @note This will always be false if format() does not return
@@ -123,6 +141,10 @@ public:
   QString fileExtension() const;
 
 private:
+  /// Move @a data into the BlobStore and reference it instead of keeping the
+  /// contents in m_json. Does nothing if the store is disabled.
+  void storeContents(const QByteArray &data);
+
   QJsonObject m_json;
 };
 
@@ -21,6 +21,82 @@
 #include <QtCore/QFileInfo>
 #include <QtCore/QString>
 
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+/// Copy @a from to @a to without bouncing the data through userspace. Returns
+/// false if the kernel cannot do this for these files, in which case nothing
+/// is left behind at @a to and the caller should fall back to QFile::copy.
+bool kernelCopyFile(const QString &from, const QString &to)
+{
+  QByteArray fromPath = QFile::encodeName(from);
+  QByteArray toPath = QFile::encodeName(to);
+
+  int in = ::open(fromPath.constData(), O_RDONLY | O_CLOEXEC);
+  if (in < 0)
+    return false;
+
+  struct stat info;
+  if (::fstat(in, &info) != 0 || !S_ISREG(info.st_mode)) {
+    ::close(in);
+    return false;
+  }
+
+  int out = ::open(toPath.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                   info.st_mode & 07777);
+  if (out < 0) {
+    ::close(in);
+    return false;
+  }
+
+  bool copied = false;
+
+#ifdef FICLONE
+  // Reflink: shares the extents on copy-on-write filesystems (btrfs, xfs).
+  copied = (::ioctl(out, FICLONE, in) == 0);
+#endif
+
+#ifdef __NR_copy_file_range
+  if (!copied) {
+    copied = true;
+    off_t remaining = info.st_size;
+    while (remaining > 0) {
+      ssize_t written = ::syscall(__NR_copy_file_range, in, NULL, out, NULL,
+                                  static_cast<size_t>(remaining), 0u);
+      if (written <= 0) {
+        copied = false;
+        break;
+      }
+      remaining -= written;
+    }
+  }
+#endif
+
+  // Match QFile::copy, which does not apply the umask to the new file.
+  if (copied)
+    ::fchmod(out, info.st_mode & 07777);
+
+  ::close(in);
+  ::close(out);
+
+  if (!copied)
+    ::unlink(toPath.constData());
+
+  return copied;
+}
+#endif
+
+} // end anon namespace
+
 namespace MoleQueue {
 namespace FileSystemTools {
 
@@ -84,8 +160,7 @@ bool recursiveCopyDirectory(const QString &from, const QString &to)
                                             newTargetPath);
     }
     else {
-      result = QFile::copy(info.absoluteFilePath(),
-                           newTargetPath);
+      result = copyFile(info.absoluteFilePath(), newTargetPath);
     }
 
     if (!result)
@@ -95,5 +170,15 @@ bool recursiveCopyDirectory(const QString &from, const QString &to)
   return true;
 }
 
+bool copyFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_LINUX
+  if (kernelCopyFile(from, to))
+    return true;
+#endif
+
+  return QFile::copy(from, to);
+}
+
 } // namespace FileSystemTools
 } // namespace MoleQueue
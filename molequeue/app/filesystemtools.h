@@ -30,6 +30,12 @@ bool recursiveRemoveDirectory(const QString &path,
 /// Copy the contents of directory @a from into @a to.
 bool recursiveCopyDirectory(const QString &from, const QString &to);
 
+/// Copy the file @a from to @a to. Like QFile::copy, this fails if @a to
+/// already exists. On Linux, the copy is attempted as a reflink (FICLONE) and
+/// then with copy_file_range before falling back to QFile::copy, so the data
+/// does not need to pass through userspace buffers.
+bool copyFile(const QString &from, const QString &to);
+
 } // namespace FileSystemTools
 } // namespace MoleQueue
 
@@ -0,0 +1,52 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_GUISERVER_H
+#define MOLEQUEUE_GUISERVER_H
+
+#include "server.h"
+
+namespace MoleQueue
+{
+
+/**
+ * @class GuiServer guiserver.h <molequeue/guiserver.h>
+ * @brief Server with the requests that only make sense with a user interface.
+ *
+ * Adds the registerOpenWith, listOpenWithNames and unregisterOpenWith methods,
+ * which manage the OpenWithActionFactory handlers offered in the job context
+ * menu. The headless molequeue-server uses a plain Server, which reports
+ * these methods as not found.
+ */
+class GuiServer : public Server
+{
+  Q_OBJECT
+public:
+  explicit GuiServer(QObject *parentObject = 0,
+                     QString serverName_ = "MoleQueue");
+
+protected:
+  void handleUnknownMethod(const MoleQueue::Message &message);
+
+private:
+  void handleRegisterOpenWithRequest(const MoleQueue::Message &message);
+  void handleListOpenWithNamesRequest(const MoleQueue::Message &message);
+  void handleUnregisterOpenWithRequest(const MoleQueue::Message &message);
+};
+
+} // end namespace MoleQueue
+
+#endif // MOLEQUEUE_GUISERVER_H
@@ -43,22 +43,59 @@ Job::~Job()
 
 void Job::setFromJson(const QJsonObject &state)
 {
-  if (warnIfInvalid())
+  if (!warnIfInvalid())
+    return;
+
+  // Jobs without a MoleQueue id are not indexed by the JobManager yet.
+  const IdType moleQueueId = m_jobData->moleQueueId();
+  if (moleQueueId == InvalidId) {
     m_jobData->setFromJson(state);
+    return;
+  }
+
+  // The JobManager indexes jobs by id, queue and state. An indexed job keeps
+  // its id, and queue and state changes go through the same hooks as
+  // setQueue() and setJobState().
+  QJsonObject otherMembers(state);
+  otherMembers.remove("moleQueueId");
+  otherMembers.remove("queue");
+  otherMembers.remove("jobState");
+  m_jobData->setFromJson(otherMembers);
+
+  JobManager *jobManager = m_jobData->jobManager();
+  if (state.contains("queue"))
+    jobManager->setJobQueue(moleQueueId, state.value("queue").toString());
+  if (state.contains("jobState")) {
+    jobManager->setJobState(
+          moleQueueId, stringToJobState(state.value("jobState").toString()));
+  }
 }
 
-QJsonObject Job::toJsonObject() const
+QJsonObject Job::toJsonObject(bool inlineContents) const
 {
   if (warnIfInvalid())
-    return m_jobData->toJsonObject();
+    return m_jobData->toJsonObject(inlineContents);
+  return QJsonObject();
+}
+
+QJsonObject Job::toJsonObject(const QStringList &members,
+                              bool inlineContents) const
+{
+  if (warnIfInvalid())
+    return m_jobData->toJsonObject(members, inlineContents);
   return QJsonObject();
 }
 
 void Job::setQueue(const QString &newQueue)
 {
+  if (!warnIfInvalid())
+    return;
 
-  if (warnIfInvalid())
+  // Jobs without a MoleQueue id are not indexed by the JobManager yet.
+  if (m_jobData->moleQueueId() == InvalidId)
     m_jobData->setQueue(newQueue);
+  else
+    m_jobData->jobManager()->setJobQueue(m_jobData->moleQueueId(), newQueue);
 }
 
 QString Job::queue() const
@@ -258,6 +295,19 @@ int Job::maxWallTime() const
   return -1;
 }
 
+void Job::setSubmissionTime(const QDateTime &time)
+{
+  if (warnIfInvalid())
+    m_jobData->setSubmissionTime(time);
+}
+
+QDateTime Job::submissionTime() const
+{
+  if (warnIfInvalid())
+    return m_jobData->submissionTime();
+  return QDateTime();
+}
+
 void Job::setMoleQueueId(IdType id)
 {
   if (warnIfInvalid()) {
@@ -321,27 +371,39 @@ QString Job::lookupKeywordReplacement(const QString &keyword) const
   return QString();
 }
 
-void Job::replaceKeywords(QString &launchScript) const
+void Job::setInputFileHashes(const QMap<QString, QString> &hashes)
+{
+  if (warnIfInvalid())
+    m_jobData->setInputFileHashes(hashes);
+}
+
+QMap<QString, QString> Job::inputFileHashes() const
+{
+  if (warnIfInvalid())
+    return m_jobData->inputFileHashes();
+  return QMap<QString, QString>();
+}
+
+void Job::insertKeywords(QHash<QString, QString> &keywords) const
 {
   if (!warnIfInvalid())
     return;
 
-  const QHash<QString, QString> &keywordHash = m_jobData->keywordsRef();
-  foreach (const QString &key, keywordHash.keys()) {
-    QString keyword = QString("$$%1$$").arg(key);
-    launchScript.replace(keyword, keywordHash.value(key));
-  }
-
   FileSpecification inputFileSpec(inputFile());
   if (inputFileSpec.isValid()) {
-    launchScript.replace("$$inputFileName$$", inputFileSpec.filename());
-    launchScript.replace("$$inputFileBaseName$$", inputFileSpec.fileBaseName());
+    keywords.insert("inputFileName", inputFileSpec.filename());
+    keywords.insert("inputFileBaseName", inputFileSpec.fileBaseName());
   }
 
-  launchScript.replace("$$moleQueueId$$", idTypeToString(moleQueueId()));
+  keywords.insert("moleQueueId", idTypeToString(moleQueueId()));
+  keywords.insert("numberOfCores", QString::number(numberOfCores()));
 
-  launchScript.replace("$$numberOfCores$$",
-                       QString::number(numberOfCores()));
+  // Job specific keywords take precedence.
+  const QHash<QString, QString> &keywordHash = m_jobData->keywordsRef();
+  for (QHash<QString, QString>::const_iterator it = keywordHash.constBegin(),
+       itEnd = keywordHash.constEnd(); it != itEnd; ++it) {
+    keywords.insert(it.key(), it.value());
+  }
 }
 
 } // end namespace MoleQueue
@@ -23,8 +23,11 @@
 
 #include <qjsonobject.h>
 
+#include <QtCore/QDateTime>
+#include <QtCore/QMap>
 #include <QtCore/QMetaType>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 
 namespace MoleQueue
 {
@@ -78,9 +81,17 @@ public:
   ~Job();
 
   /// @return The JobData's internal state as a QJsonObject
-  QJsonObject toJsonObject() const;
+  /// @sa JobData::toJsonObject
+  QJsonObject toJsonObject(bool inlineContents = false) const;
 
-  /// Update the JobData's internal state from a QJsonObject
+  /// @return Only the @a members of the JobData's internal state.
+  /// @sa JobData::toJsonObject
+  QJsonObject toJsonObject(const QStringList &members,
+                           bool inlineContents = false) const;
+
+  /// Update the JobData's internal state from a QJsonObject. If the job is
+  /// held by a JobManager, the queue and state are changed as by setQueue()
+  /// and setJobState(), and a "moleQueueId" member is ignored.
   void setFromJson(const QJsonObject &state);
 
   /// @param newQueue name of the queue.
@@ -208,6 +219,12 @@ public:
   /// available for remote queues. Default is -1.
   int maxWallTime() const;
 
+  /// @param time The time the job was submitted to the server.
+  void setSubmissionTime(const QDateTime &time);
+
+  /// @return The time the job was submitted to the server.
+  QDateTime submissionTime() const;
+
   /// @param id The new MoleQueue id for this job.
   /// @warning Do not call this function except in Server or Client as a
   ///   response to the JobManager::jobAboutToBeAdded signal.
@@ -240,9 +257,18 @@ public:
   /// @return The replacement string for the @a keyword.
   QString lookupKeywordReplacement(const QString &keyword) const;
 
-  /// Apply the replacements in the keywords() hash to the @a script.
-  /// @note Do not call this directly, use Queue::replaceKeywords instead.
-  void replaceKeywords(QString &launchScript) const;
+  /// @param hashes BlobStore hashes of the job's deduplicated input files,
+  /// keyed by filename. Set by Queue::writeInputFiles.
+  void setInputFileHashes(const QMap<QString, QString> &hashes);
+
+  /// @return BlobStore hashes of the job's deduplicated input files, keyed by
+  /// filename.
+  QMap<QString, QString> inputFileHashes() const;
+
+  /// Add the job specific launch script keywords (input file names,
+  /// moleQueueId, numberOfCores and the keywords() hash) to @a keywords.
+  /// @note Do not call this directly, use Queue::renderLaunchTemplate instead.
+  void insertKeywords(QHash<QString, QString> &keywords) const;
 };
 
 } // end namespace MoleQueue
@@ -20,6 +20,7 @@
 #include "../queue.h"
 #include "../queuemanager.h"
 #include "../server.h"
+#include "../serverthread.h"
 
 #include <QtWidgets/QAction>
 #include <QtWidgets/QMessageBox>
@@ -113,10 +114,20 @@ void KillJobActionFactory::actionTriggered()
   if (confirm != QMessageBox::Yes)
     return;
 
-  foreach (const Job &job, jobs) {
-    Queue *queue = m_server->queueManager()->lookupQueue(job.queue());
-    if (queue)
-      queue->killJob(job);
+  // Look up the queues with the server thread paused, then let each queue
+  // kill its jobs in its own thread.
+  QList<Queue*> queues;
+  {
+    ServerThreadLocker locker(m_server);
+    foreach (const Job &job, jobs)
+      queues << m_server->queueManager()->lookupQueue(job.queue());
+  }
+
+  for (int i = 0; i < jobs.size(); ++i) {
+    if (queues.at(i)) {
+      QMetaObject::invokeMethod(queues.at(i), "killJob",
+                                Q_ARG(MoleQueue::Job, jobs.at(i)));
+    }
   }
 }
 
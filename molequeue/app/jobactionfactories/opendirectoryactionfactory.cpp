@@ -17,6 +17,8 @@
 #include "opendirectoryactionfactory.h"
 
 #include "../job.h"
+#include "../server.h"
+#include "../serverthread.h"
 
 #include <QtWidgets/QAction>
 #include <QtGui/QDesktopServices>
@@ -85,10 +87,17 @@ void OpenDirectoryActionFactory::actionTriggered()
   if (!jobs.size())
     return;
 
-  foreach (const Job &job, jobs) {
-    if (job.isValid())
-      QDesktopServices::openUrl(QUrl::fromLocalFile(job.outputDirectory()));
+  QStringList directories;
+  {
+    ServerThreadLocker locker(m_server);
+    foreach (const Job &job, jobs) {
+      if (job.isValid())
+        directories << job.outputDirectory();
+    }
   }
+
+  foreach (const QString &directory, directories)
+    QDesktopServices::openUrl(QUrl::fromLocalFile(directory));
 }
 
 } // end namespace MoleQueue
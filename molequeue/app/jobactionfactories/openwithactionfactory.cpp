@@ -24,6 +24,7 @@
 #include "../queue.h"
 #include "../queuemanager.h"
 #include "../server.h"
+#include "../serverthread.h"
 
 #include <QtWidgets/QAction>
 #include <QtWidgets/QFileDialog>
@@ -436,7 +437,13 @@ void OpenWithActionFactory::actionTriggered()
 
   // The sender was a QAction. Is its data a job?
   Job job = action->data().value<Job>();
-  if (!job.isValid()) {
+  IdType moleQueueId = InvalidId;
+  {
+    ServerThreadLocker locker(m_server);
+    if (job.isValid())
+      moleQueueId = job.moleQueueId();
+  }
+  if (moleQueueId == InvalidId) {
     Logger::logWarning(tr("OpenWithActionFactory::actionTriggered: Action data "
                           "is not a Job."));
     return;
@@ -446,14 +453,14 @@ void OpenWithActionFactory::actionTriggered()
   QString fileName = action->property("fileName").toString();
   if (!QFileInfo(fileName).exists()) {
     Logger::logWarning(tr("OpenWithActionFactory::actionTriggered: No filename "
-                          "associated with job."), job.moleQueueId());
+                          "associated with job."), moleQueueId);
     return;
   }
 
   // Is the handler set?
   if (!m_handler) {
     Logger::logWarning(tr("OpenWithActionFactory::actionTriggered: No handler "
-                          "set."), job.moleQueueId());
+                          "set."), moleQueueId);
     return;
   }
 
@@ -467,7 +474,7 @@ void OpenWithActionFactory::actionTriggered()
   QString workDir = QFileInfo(fileName).absolutePath();
   if (!m_handler->openFile(fileName, workDir)) {
     QString err(tr("Error: %1").arg(m_handler->openFileError()));
-    Logger::logWarning(err, job.moleQueueId());
+    Logger::logWarning(err, moleQueueId);
     QMessageBox::critical(NULL, tr("Cannot start process"), err);
   }
 }
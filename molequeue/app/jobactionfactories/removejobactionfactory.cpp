@@ -19,6 +19,7 @@
 #include "../job.h"
 #include "../jobmanager.h"
 #include "../server.h"
+#include "../serverthread.h"
 
 #include <QtWidgets/QAction>
 #include <QtWidgets/QMessageBox>
@@ -93,7 +94,16 @@ void RemoveJobActionFactory::actionTriggered()
   if (confirm != QMessageBox::Yes)
     return;
 
-  m_server->jobManager()->removeJobs(jobs);
+  QList<IdType> moleQueueIds;
+  {
+    ServerThreadLocker locker(m_server);
+    foreach (const Job &job, jobs)
+      moleQueueIds << job.moleQueueId();
+  }
+
+  // Runs in the JobManager's thread.
+  QMetaObject::invokeMethod(m_server->jobManager(), "removeJobs",
+                            Q_ARG(QList<IdType>, moleQueueIds));
 }
 
 
@@ -18,6 +18,8 @@
 
 #include "logwindow.h"
 #include "job.h"
+#include "server.h"
+#include "serverthread.h"
 
 #include <QtWidgets/QAction>
 
@@ -78,11 +80,18 @@ void ViewJobLogActionFactory::actionTriggered()
 
   // The sender was a QAction. Is its data a list of jobs?
   QList<Job> jobs = action->data().value<QList<Job> >();
-  if (jobs.size() != 1 || !jobs.first().isValid())
+  if (jobs.size() != 1)
     return;
 
+  IdType moleQueueId = InvalidId;
+  {
+    ServerThreadLocker locker(m_server);
+    if (jobs.first().isValid())
+      moleQueueId = jobs.first().moleQueueId();
+  }
+  if (moleQueueId == InvalidId)
+    return;
 
-  IdType moleQueueId = jobs.first().moleQueueId();
   LogWindow *logWindow = m_windowMap.value(moleQueueId, NULL);
   if (!logWindow) {
     logWindow = new LogWindow(m_logWindowParent, moleQueueId);
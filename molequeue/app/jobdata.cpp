@@ -29,6 +29,7 @@ namespace MoleQueue
 
 JobData::JobData(JobManager *parentManager)
   : m_jobManager(parentManager),
+    m_jobManagerSlot(-1),
     m_jobState(MoleQueue::None),
     m_cleanRemoteFiles(false),
     m_retrieveOutput(true),
@@ -45,6 +46,7 @@ JobData::JobData(JobManager *parentManager)
 
 JobData::JobData(const MoleQueue::JobData &other)
   : m_jobManager(other.m_jobManager),
+    m_jobManagerSlot(-1),
     m_queue(other.m_queue),
     m_program(other.m_program),
     m_jobState(other.m_jobState),
@@ -60,13 +62,15 @@ JobData::JobData(const MoleQueue::JobData &other)
     m_popupOnStateChange(other.m_popupOnStateChange),
     m_numberOfCores(other.m_numberOfCores),
     m_maxWallTime(other.m_maxWallTime),
+    m_submissionTime(other.m_submissionTime),
     m_moleQueueId(other.m_moleQueueId),
     m_queueId(other.m_queueId),
+    m_inputFileHashes(other.m_inputFileHashes),
     m_needsSync(true)
 {
 }
 
-QJsonObject JobData::toJsonObject() const
+QJsonObject JobData::toJsonObject(bool inlineContents) const
 {
   QJsonObject result;
 
@@ -74,11 +78,11 @@ QJsonObject JobData::toJsonObject() const
   result.insert("program", m_program);
   result.insert("jobState", QLatin1String(jobStateToString(m_jobState)));
   result.insert("description", m_description);
-  result.insert("inputFile", m_inputFile.toJsonObject());
+  result.insert("inputFile", m_inputFile.toJsonObject(inlineContents));
   if (!m_additionalInputFiles.isEmpty()) {
     QJsonArray additionalFiles;
     foreach (const FileSpecification &spec, m_additionalInputFiles)
-      additionalFiles.append(spec.toJsonObject());
+      additionalFiles.append(spec.toJsonObject(inlineContents));
     result.insert("additionalInputFiles", additionalFiles);
   }
   result.insert("outputDirectory", m_outputDirectory);
@@ -90,6 +94,8 @@ QJsonObject JobData::toJsonObject() const
   result.insert("popupOnStateChange", m_popupOnStateChange);
   result.insert("numberOfCores", m_numberOfCores);
   result.insert("maxWallTime", m_maxWallTime);
+  if (m_submissionTime.isValid())
+    result.insert("submissionTime", m_submissionTime.toString(Qt::ISODate));
   result.insert("moleQueueId", idTypeToJson(m_moleQueueId));
   result.insert("queueId", idTypeToJson(m_queueId));
   if (!m_keywords.isEmpty()) {
@@ -102,6 +108,85 @@ QJsonObject JobData::toJsonObject() const
   return result;
 }
 
+QJsonObject JobData::toJsonObject(const QStringList &members,
+                                  bool inlineContents) const
+{
+  // Must match toJsonObject(bool); only the requested members are built.
+  QJsonObject result;
+  foreach (const QString &member, members) {
+    if (member == "queue") {
+      result.insert(member, m_queue);
+    }
+    else if (member == "program") {
+      result.insert(member, m_program);
+    }
+    else if (member == "jobState") {
+      result.insert(member, QLatin1String(jobStateToString(m_jobState)));
+    }
+    else if (member == "description") {
+      result.insert(member, m_description);
+    }
+    else if (member == "inputFile") {
+      result.insert(member, m_inputFile.toJsonObject(inlineContents));
+    }
+    else if (member == "additionalInputFiles") {
+      if (m_additionalInputFiles.isEmpty())
+        continue;
+      QJsonArray additionalFiles;
+      foreach (const FileSpecification &spec, m_additionalInputFiles)
+        additionalFiles.append(spec.toJsonObject(inlineContents));
+      result.insert(member, additionalFiles);
+    }
+    else if (member == "outputDirectory") {
+      result.insert(member, m_outputDirectory);
+    }
+    else if (member == "localWorkingDirectory") {
+      result.insert(member, m_localWorkingDirectory);
+    }
+    else if (member == "cleanRemoteFiles") {
+      result.insert(member, m_cleanRemoteFiles);
+    }
+    else if (member == "retrieveOutput") {
+      result.insert(member, m_retrieveOutput);
+    }
+    else if (member == "cleanLocalWorkingDirectory") {
+      result.insert(member, m_cleanLocalWorkingDirectory);
+    }
+    else if (member == "hideFromGui") {
+      result.insert(member, m_hideFromGui);
+    }
+    else if (member == "popupOnStateChange") {
+      result.insert(member, m_popupOnStateChange);
+    }
+    else if (member == "numberOfCores") {
+      result.insert(member, m_numberOfCores);
+    }
+    else if (member == "maxWallTime") {
+      result.insert(member, m_maxWallTime);
+    }
+    else if (member == "submissionTime") {
+      if (m_submissionTime.isValid())
+        result.insert(member, m_submissionTime.toString(Qt::ISODate));
+    }
+    else if (member == "moleQueueId") {
+      result.insert(member, idTypeToJson(m_moleQueueId));
+    }
+    else if (member == "queueId") {
+      result.insert(member, idTypeToJson(m_queueId));
+    }
+    else if (member == "keywords") {
+      if (m_keywords.isEmpty())
+        continue;
+      QJsonObject keywords_;
+      foreach (const QString &key, m_keywords.keys())
+        keywords_.insert(key, m_keywords.value(key));
+      result.insert(member, keywords_);
+    }
+  }
+
+  return result;
+}
+
 void JobData::setFromJson(const QJsonObject &state)
 {
   if (state.contains("queue"))
@@ -141,6 +226,10 @@ void JobData::setFromJson(const QJsonObject &state)
     m_numberOfCores = static_cast<int>(state.value("numberOfCores").toDouble());
   if (state.contains("maxWallTime"))
     m_maxWallTime = static_cast<int>(state.value("maxWallTime").toDouble());
+  if (state.contains("submissionTime")) {
+    m_submissionTime = QDateTime::fromString(
+          state.value("submissionTime").toString(), Qt::ISODate);
+  }
   if (state.contains("moleQueueId"))
     m_moleQueueId = toIdType(state.value("moleQueueId"));
   if (state.contains("queueId"))
@@ -202,6 +291,11 @@ bool JobData::load(const QString &stateFilename)
 
   setFromJson(jobObject);
 
+  m_inputFileHashes.clear();
+  QJsonObject hashes = jobObject.value("inputFileHashes").toObject();
+  foreach (const QString &filename, hashes.keys())
+    m_inputFileHashes.insert(filename, hashes.value(filename).toString());
+
   m_needsSync = false;
 
   return true;
@@ -258,6 +352,16 @@ bool JobData::save()
   foreach (const QString &key, jobObject.keys())
     root.insert(key, jobObject.value(key));
 
+  // Stored with the job so the BlobStore keeps the deduplicated input files
+  // across restarts.
+  root.remove("inputFileHashes");
+  if (!m_inputFileHashes.isEmpty()) {
+    QJsonObject hashes;
+    foreach (const QString &filename, m_inputFileHashes.keys())
+      hashes.insert(filename, m_inputFileHashes.value(filename));
+    root.insert("inputFileHashes", hashes);
+  }
+
   // Write the data back out:
   QByteArray outputText = QJsonDocument(root).toJson();
 
@@ -23,8 +23,11 @@
 
 #include <qjsonobject.h>
 
+#include <QtCore/QDateTime>
+#include <QtCore/QMap>
 #include <QtCore/QMetaType>
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 
 class ClientTest;
 class JobManagerTest;
@@ -57,6 +60,14 @@ public:
   /// @return The parent JobManager
   JobManager *jobManager() const { return m_jobManager; }
 
+  /// @return The index of this JobData in its JobManager's slot table, or -1
+  /// if it has not been added to the JobManager.
+  int jobManagerSlot() const { return m_jobManagerSlot; }
+
+  /// Set by the JobManager when the JobData is added to or removed from its
+  /// slot table.
+  void setJobManagerSlot(int slot) { m_jobManagerSlot = slot; }
+
   /// @param newQueue name of the queue.
   void setQueue(const QString &newQueue)
   {
@@ -265,6 +276,19 @@ public:
   /// available for remote queues. Default is -1.
   int maxWallTime() const { return m_maxWallTime; }
 
+  /// @param time The time the job was submitted to the server.
+  void setSubmissionTime(const QDateTime &time)
+  {
+    if (m_submissionTime != time) {
+      m_submissionTime = time;
+      modified();
+    }
+  }
+
+  /// @return The time the job was submitted to the server. Invalid for jobs
+  /// created before this was recorded.
+  QDateTime submissionTime() const { return m_submissionTime; }
+
   /// @param id Internal MoleQueue identifier
   void setMoleQueueId(IdType id)
   {
@@ -304,8 +328,29 @@ public:
   /// @return The keyword replacement hash
   QHash<QString, QString> keywords() const { return m_keywords; }
 
-  /// @return The Job's internal state as a QJsonObject
-  QJsonObject toJsonObject() const;
+  /// @param hashes BlobStore hashes of the job's deduplicated input files,
+  /// keyed by filename.
+  void setInputFileHashes(const QMap<QString, QString> &hashes)
+  {
+    if (m_inputFileHashes != hashes) {
+      m_inputFileHashes = hashes;
+      modified();
+    }
+  }
+
+  /// @return BlobStore hashes of the job's deduplicated input files, keyed by
+  /// filename.
+  QMap<QString, QString> inputFileHashes() const { return m_inputFileHashes; }
+
+  /// @return The Job's internal state as a QJsonObject. Input file contents
+  /// kept in the BlobStore are only referenced by hash unless
+  /// @a inlineContents is true.
+  QJsonObject toJsonObject(bool inlineContents = false) const;
+
+  /// @return Only the @a members of toJsonObject(), e.g. for the "fields" of
+  /// a listJobs request. Unknown and absent members are left out.
+  QJsonObject toJsonObject(const QStringList &members,
+                           bool inlineContents = false) const;
 
   /// Update the Job's internal state from a QJsonObject
   void setFromJson(const QJsonObject &state);
@@ -326,6 +371,8 @@ public:
 protected:
   /// Parent JobManager
   JobManager *m_jobManager;
+  /// Slot in m_jobManager, see JobManager::isCurrentSlot()
+  int m_jobManagerSlot;
   /// Name of queue to use
   QString m_queue;
   /// Name of program to run
@@ -363,12 +410,17 @@ protected:
   /// to a value <= 0 will use the queue-specific default max walltime. Only
   /// available for remote queues. Default is -1.
   int m_maxWallTime;
+  /// Time the job was submitted to the server.
+  QDateTime m_submissionTime;
   /// Internal MoleQueue identifier
   IdType m_moleQueueId;
   /// Queue Job ID
   IdType m_queueId;
   /// List of custom keyword replacements for the job's launch script
   QHash<QString, QString> m_keywords;
+  /// BlobStore hashes of the deduplicated input files (filename to hash).
+  /// Saved with the job state, but not part of toJsonObject().
+  QMap<QString, QString> m_inputFileHashes;
 
   /// True if the JobData has changed since load() or save() was called.
   bool m_needsSync;
@@ -0,0 +1,139 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "jobfilter.h"
+
+#include "idtypeutils.h"
+#include "jobdata.h"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+
+namespace MoleQueue
+{
+
+JobFilter::JobFilter()
+  : minMoleQueueId(InvalidId),
+    maxMoleQueueId(InvalidId)
+{
+}
+
+bool JobFilter::fromJsonObject(const QJsonObject &json, QString *error)
+{
+  static const char *lists[] = { "queues", "programs", "states" };
+  for (int i = 0; i < 3; ++i) {
+    QJsonValue value = json.value(lists[i]);
+    if (value.isUndefined())
+      continue;
+    if (!value.isArray()) {
+      if (error)
+        *error = QString("%1 must be an array of strings.").arg(lists[i]);
+      return false;
+    }
+    foreach (const QJsonValue &item, value.toArray()) {
+      if (!item.isString()) {
+        if (error)
+          *error = QString("%1 must be an array of strings.").arg(lists[i]);
+        return false;
+      }
+      if (i == 0) {
+        queues.insert(item.toString());
+      }
+      else if (i == 1) {
+        programs.insert(item.toString());
+      }
+      else {
+        JobState state = stringToJobState(item.toString());
+        if (state == Unknown) {
+          if (error)
+            *error = QString("Unknown job state '%1'.").arg(item.toString());
+          return false;
+        }
+        states.insert(static_cast<int>(state));
+      }
+    }
+  }
+
+  if (json.contains("descriptionContains")) {
+    if (!json.value("descriptionContains").isString()) {
+      if (error)
+        *error = "descriptionContains must be a string.";
+      return false;
+    }
+    descriptionContains = json.value("descriptionContains").toString();
+  }
+
+  static const char *times[] = { "submittedAfter", "submittedBefore" };
+  for (int i = 0; i < 2; ++i) {
+    if (!json.contains(times[i]))
+      continue;
+    QDateTime time = QDateTime::fromString(json.value(times[i]).toString(),
+                                           Qt::ISODate);
+    if (!time.isValid()) {
+      if (error)
+        *error = QString("%1 must be an ISO 8601 date.").arg(times[i]);
+      return false;
+    }
+    if (i == 0)
+      submittedAfter = time;
+    else
+      submittedBefore = time;
+  }
+
+  if (json.contains("minMoleQueueId"))
+    minMoleQueueId = toIdType(json.value("minMoleQueueId"));
+  if (json.contains("maxMoleQueueId"))
+    maxMoleQueueId = toIdType(json.value("maxMoleQueueId"));
+
+  return true;
+}
+
+bool JobFilter::matches(const JobData &jobdata) const
+{
+  return matches(jobdata, jobdata.jobState());
+}
+
+bool JobFilter::matches(const JobData &jobdata, JobState state) const
+{
+  const IdType moleQueueId = jobdata.moleQueueId();
+  if (minMoleQueueId != InvalidId && moleQueueId < minMoleQueueId)
+    return false;
+  if (maxMoleQueueId != InvalidId && moleQueueId > maxMoleQueueId)
+    return false;
+  if (!states.isEmpty() && !states.contains(static_cast<int>(state)))
+    return false;
+  if (!queues.isEmpty() && !queues.contains(jobdata.queue()))
+    return false;
+  if (!programs.isEmpty() && !programs.contains(jobdata.program()))
+    return false;
+  if (!descriptionContains.isEmpty() &&
+      !jobdata.description().contains(descriptionContains,
+                                      Qt::CaseInsensitive)) {
+    return false;
+  }
+  if (submittedAfter.isValid() || submittedBefore.isValid()) {
+    const QDateTime time = jobdata.submissionTime();
+    if (!time.isValid())
+      return false;
+    if (submittedAfter.isValid() && time < submittedAfter)
+      return false;
+    if (submittedBefore.isValid() && time >= submittedBefore)
+      return false;
+  }
+  return true;
+}
+
+} // namespace MoleQueue
@@ -0,0 +1,84 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_JOBFILTER_H
+#define MOLEQUEUE_JOBFILTER_H
+
+#include "molequeueglobal.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+
+class QJsonObject;
+
+namespace MoleQueue
+{
+class JobData;
+
+/**
+ * @class JobFilter jobfilter.h <molequeue/jobfilter.h>
+ * @brief Selects jobs by state, queue, program, description, submission time
+ * and MoleQueue id.
+ *
+ * Empty criteria match every job. Used by the "listJobs" and "subscribe"
+ * requests, whose params are parsed with fromJsonObject():
+~~~{.js}
+{
+  "queues": [ "Some big cluster", ... ],
+  "programs": [ "GAMESS", ... ],
+  "states": [ "RunningRemote", "Finished", ... ],
+  "descriptionContains": "benzene",
+  "submittedAfter": "2012-06-01T00:00:00",
+  "submittedBefore": "2012-07-01T00:00:00",
+  "minMoleQueueId": 100,
+  "maxMoleQueueId": 200
+}
+~~~
+ * Jobs without a submission time never match a time range.
+ */
+class JobFilter
+{
+public:
+  JobFilter();
+
+  /**
+   * Parse the filter in @a json.
+   * @param error If not NULL and @a json is invalid, set to a description of
+   * the problem.
+   * @return True on success.
+   */
+  bool fromJsonObject(const QJsonObject &json, QString *error = NULL);
+
+  /// @return True if @a jobdata is selected.
+  bool matches(const JobData &jobdata) const;
+
+  /// @return True if @a jobdata is selected when its state is @a state.
+  bool matches(const JobData &jobdata, JobState state) const;
+
+  QSet<QString> queues;
+  QSet<QString> programs;
+  QSet<int> states;
+  QString descriptionContains;
+  QDateTime submittedAfter;
+  QDateTime submittedBefore;
+  IdType minMoleQueueId;
+  IdType maxMoleQueueId;
+};
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_JOBFILTER_H
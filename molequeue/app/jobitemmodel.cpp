@@ -20,6 +20,8 @@
 #include "jobmanager.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QStringList>
+#include <QtCore/QtAlgorithms>
 
 namespace MoleQueue {
 
@@ -47,16 +49,27 @@ void JobItemModel::setJobManager(JobManager *newJobManager)
     m_jobManager->disconnect(this);
 
   m_jobManager = newJobManager;
+  m_rows.clear();
 
-  connect(newJobManager, SIGNAL(jobUpdated(MoleQueue::Job)),
-          this, SLOT(jobUpdated(MoleQueue::Job)));
+  if (m_jobManager) {
+    connect(m_jobManager,
+            SIGNAL(jobsChanged(QList<MoleQueue::JobSummary>,
+                               QList<MoleQueue::IdType>)),
+            this, SLOT(jobsChanged(QList<MoleQueue::JobSummary>,
+                                   QList<MoleQueue::IdType>)));
+    const QList<JobSummary> jobs = m_jobManager->jobSummaries();
+    m_rows.reserve(jobs.size());
+    foreach (const JobSummary &job, jobs)
+      m_rows.append(job);
+  }
+  updateRowLookup(0);
   endResetModel();
 }
 
 int JobItemModel::rowCount(const QModelIndex &modelIndex) const
 {
-  if (m_jobManager && !modelIndex.isValid())
-    return m_jobManager->count();
+  if (!modelIndex.isValid())
+    return m_rows.size();
   else
     return 0;
 }
@@ -93,56 +106,43 @@ QVariant JobItemModel::headerData(int section, Qt::Orientation orientation,
 
 QVariant JobItemModel::data(const QModelIndex &modelIndex, int role) const
 {
-  if (!m_jobManager || !modelIndex.isValid() ||
+  if (!modelIndex.isValid() || modelIndex.row() >= m_rows.size() ||
       modelIndex.column() + 1 > COLUMN_COUNT)
     return QVariant();
 
-  Job job = m_jobManager->jobAt(modelIndex.row());
-  if (job.isValid()) {
-    if (role == Qt::DisplayRole) {
-      switch (modelIndex.column()) {
-      case MOLEQUEUE_ID:
-        return QVariant(job.moleQueueId());
-      case JOB_TITLE:
-        return QVariant(job.description());
-      case NUM_CORES:
-        return QVariant(job.numberOfCores());
-      case QUEUE_NAME: {
-        if (job.queueId() != InvalidId)
-          return QVariant(QString("%1 (%2)").arg(job.queue())
-                          .arg(idTypeToString(job.queueId())));
-        else
-          return QVariant(job.queue());
-      }
-      case PROGRAM_NAME:
-        return QVariant(job.program());
-      case JOB_STATE:
-        return MoleQueue::jobStateToGuiString(job.jobState());
-      default:
-        return QVariant();
-      }
-    }
-    else if (role == FetchJobRole) {
-      return QVariant::fromValue(job);
+  const int row = modelIndex.row();
+  if (role == Qt::DisplayRole) {
+    switch (modelIndex.column()) {
+    case MOLEQUEUE_ID:
+      return QVariant(m_rows.moleQueueIds.at(row));
+    case JOB_TITLE:
+      return QVariant(m_rows.descriptions.at(row));
+    case NUM_CORES:
+      return QVariant(m_rows.numberOfCores.at(row));
+    case QUEUE_NAME:
+      return QVariant(m_rows.queueTexts.at(row));
+    case PROGRAM_NAME:
+      return QVariant(m_rows.programs.at(row));
+    case JOB_STATE:
+      return QVariant(stateText(m_rows.jobStates.at(row)));
+    default:
+      return QVariant();
     }
   }
+  else if (role == JobStateRole) {
+    return QVariant(static_cast<int>(m_rows.jobStates.at(row)));
+  }
+  else if (role == HideFromGuiRole) {
+    return QVariant(m_rows.hideFromGui.at(row));
+  }
+  else if (role == FetchJobRole && m_jobManager) {
+    Job handle(m_jobManager, m_rows.moleQueueIds.at(row));
+    if (handle.isValid())
+      return QVariant::fromValue(handle);
+  }
   return QVariant();
 }
 
-bool JobItemModel::removeRows(int row, int count, const QModelIndex &)
-{
-  beginRemoveRows(QModelIndex(), row, row + count - 1);
-  endRemoveRows();
-  return true;
-}
-
-bool JobItemModel::insertRows(int row, int count, const QModelIndex &)
-{
-  beginInsertRows(QModelIndex(), row, row + count - 1);
-  endInsertRows();
-  return true;
-}
-
 Qt::ItemFlags JobItemModel::flags(const QModelIndex &) const
 {
   return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
@@ -151,20 +151,219 @@ Qt::ItemFlags JobItemModel::flags(const QModelIndex &) const
 QModelIndex JobItemModel::index(int row, int column,
                                 const QModelIndex &/*modelIndex*/) const
 {
-  if (m_jobManager && row >= 0 && row < m_jobManager->count())
+  if (row >= 0 && row < m_rows.size())
     return createIndex(row, column);
   else
     return QModelIndex();
 }
 
-void JobItemModel::jobUpdated(const Job &job)
+void JobItemModel::jobsChanged(const QList<JobSummary> &jobs,
+                               const QList<IdType> &removed)
+{
+  removeJobRows(removed);
+
+  // Update known jobs in place and append the new ones.
+  QMap<int, QPair<int, int> > changedCells;
+  QList<JobSummary> added;
+  foreach (const JobSummary &job, jobs) {
+    const int row = m_rowLookup.value(job.moleQueueId, -1);
+    if (row < 0) {
+      added << job;
+      continue;
+    }
+    int firstColumn;
+    int lastColumn;
+    if (m_rows.update(row, job, &firstColumn, &lastColumn))
+      changedCells.insert(row, qMakePair(firstColumn, lastColumn));
+  }
+  emitDataChanged(changedCells);
+
+  if (!added.isEmpty()) {
+    const int firstRow = m_rows.size();
+    beginInsertRows(QModelIndex(), firstRow, firstRow + added.size() - 1);
+    m_rows.reserve(firstRow + added.size());
+    foreach (const JobSummary &job, added)
+      m_rows.append(job);
+    updateRowLookup(firstRow);
+    endInsertRows();
+  }
+}
+
+void JobItemModel::removeJobRows(const QList<IdType> &moleQueueIds)
 {
-  if (!m_jobManager)
+  QList<int> rows;
+  foreach (IdType moleQueueId, moleQueueIds) {
+    if (m_rowLookup.contains(moleQueueId))
+      rows << m_rowLookup.take(moleQueueId);
+  }
+  if (rows.isEmpty())
     return;
 
-  int row = m_jobManager->indexOf(job);
-  if (row >= 0)
-    emit dataChanged(index(row, 0), index(row, COLUMN_COUNT - 1));
+  // Bottom up, so the remaining rows stay valid.
+  qSort(rows.begin(), rows.end(), qGreater<int>());
+  int i = 0;
+  while (i < rows.size()) {
+    const int last = rows.at(i);
+    int first = last;
+    while (++i < rows.size() && rows.at(i) == first - 1)
+      --first;
+
+    beginRemoveRows(QModelIndex(), first, last);
+    m_rows.remove(first, last - first + 1);
+    endRemoveRows();
+  }
+  updateRowLookup(rows.last());
+}
+
+void JobItemModel::emitDataChanged(
+    const QMap<int, QPair<int, int> > &changedCells)
+{
+  QMap<int, QPair<int, int> >::const_iterator it = changedCells.constBegin();
+  const QMap<int, QPair<int, int> >::const_iterator end =
+      changedCells.constEnd();
+  while (it != end) {
+    const int firstRow = it.key();
+    int lastRow = firstRow;
+    int firstColumn = it.value().first;
+    int lastColumn = it.value().second;
+    while (++it != end && it.key() == lastRow + 1) {
+      lastRow = it.key();
+      firstColumn = qMin(firstColumn, it.value().first);
+      lastColumn = qMax(lastColumn, it.value().second);
+    }
+    emit dataChanged(index(firstRow, firstColumn),
+                     index(lastRow, lastColumn));
+  }
+}
+
+QString JobItemModel::queueText(const JobSummary &job)
+{
+  if (job.queueId != InvalidId)
+    return QString("%1 (%2)").arg(job.queue).arg(idTypeToString(job.queueId));
+  return job.queue;
+}
+
+const QString &JobItemModel::stateText(JobState state)
+{
+  static QVector<QString> texts;
+  if (texts.isEmpty()) {
+    for (int i = Unknown; i <= Error; ++i)
+      texts << QString(jobStateToGuiString(static_cast<JobState>(i)));
+  }
+
+  const int i = static_cast<int>(state) - Unknown;
+  return i >= 0 && i < texts.size() ? texts.at(i) : texts.first();
+}
+
+QString JobItemModel::makeFilterText(const JobSummary &job)
+{
+  QStringList columns;
+  columns << idTypeToString(job.moleQueueId)
+          << job.description
+          << QString::number(job.numberOfCores)
+          << queueText(job)
+          << job.program
+          << stateText(job.jobState);
+  return columns.join("\n").toLower();
+}
+
+void JobItemModel::updateRowLookup(int firstRow)
+{
+  if (firstRow == 0)
+    m_rowLookup.clear();
+  for (int row = firstRow; row < m_rows.size(); ++row)
+    m_rowLookup.insert(m_rows.moleQueueIds.at(row), row);
+}
+
+void JobItemModel::Rows::clear()
+{
+  moleQueueIds.clear();
+  descriptions.clear();
+  numberOfCores.clear();
+  queueTexts.clear();
+  programs.clear();
+  jobStates.clear();
+  hideFromGui.clear();
+  filterTexts.clear();
+}
+
+void JobItemModel::Rows::reserve(int count)
+{
+  moleQueueIds.reserve(count);
+  descriptions.reserve(count);
+  numberOfCores.reserve(count);
+  queueTexts.reserve(count);
+  programs.reserve(count);
+  jobStates.reserve(count);
+  hideFromGui.reserve(count);
+  filterTexts.reserve(count);
+}
+
+void JobItemModel::Rows::append(const JobSummary &job)
+{
+  moleQueueIds.append(job.moleQueueId);
+  descriptions.append(job.description);
+  numberOfCores.append(job.numberOfCores);
+  queueTexts.append(queueText(job));
+  programs.append(job.program);
+  jobStates.append(job.jobState);
+  hideFromGui.append(job.hideFromGui);
+  filterTexts.append(makeFilterText(job));
+}
+
+void JobItemModel::Rows::remove(int first, int count)
+{
+  moleQueueIds.remove(first, count);
+  descriptions.remove(first, count);
+  numberOfCores.remove(first, count);
+  queueTexts.remove(first, count);
+  programs.remove(first, count);
+  jobStates.remove(first, count);
+  hideFromGui.remove(first, count);
+  filterTexts.remove(first, count);
+}
+
+bool JobItemModel::Rows::update(int row, const JobSummary &job,
+                                int *firstColumn, int *lastColumn)
+{
+  const QString newQueueText = queueText(job);
+
+  bool changed[COLUMN_COUNT];
+  changed[MOLEQUEUE_ID] = moleQueueIds.at(row) != job.moleQueueId;
+  changed[JOB_TITLE] = descriptions.at(row) != job.description;
+  changed[NUM_CORES] = numberOfCores.at(row) != job.numberOfCores;
+  changed[QUEUE_NAME] = queueTexts.at(row) != newQueueText;
+  changed[PROGRAM_NAME] = programs.at(row) != job.program;
+  changed[JOB_STATE] = jobStates.at(row) != job.jobState;
+
+  *firstColumn = COLUMN_COUNT;
+  *lastColumn = -1;
+  for (int column = 0; column < COLUMN_COUNT; ++column) {
+    if (changed[column]) {
+      *firstColumn = qMin(*firstColumn, column);
+      *lastColumn = column;
+    }
+  }
+  const bool textChanged = *lastColumn >= 0;
+
+  // Not displayed, but the proxy needs to re-filter the row.
+  if (hideFromGui.at(row) != job.hideFromGui) {
+    hideFromGui[row] = job.hideFromGui;
+    if (!textChanged)
+      *firstColumn = *lastColumn = MOLEQUEUE_ID;
+  }
+
+  if (!textChanged)
+    return *lastColumn >= 0;
+
+  moleQueueIds[row] = job.moleQueueId;
+  descriptions[row] = job.description;
+  numberOfCores[row] = job.numberOfCores;
+  queueTexts[row] = newQueueText;
+  programs[row] = job.program;
+  jobStates[row] = job.jobState;
+  filterTexts[row] = makeFilterText(job);
+  return true;
 }
 
 } // End of namespace
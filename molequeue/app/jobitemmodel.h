@@ -20,13 +20,30 @@
 #include <QtCore/QAbstractItemModel>
 
 #include "molequeueglobal.h"
+#include "jobsummary.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QVector>
 
 namespace MoleQueue
 {
 class Job;
 class JobManager;
 
-/// @brief Item model for interacting with jobs.
+/**
+ * @brief Item model for interacting with jobs.
+ *
+ * The model shows copies of the jobs (JobSummary), kept up to date by
+ * JobManager::jobsChanged(). It never reads the JobManager while painting,
+ * so it may live in the GUI thread while the JobManager runs in a
+ * ServerThread.
+ *
+ * Each batch of changes from the JobManager results in one dataChanged()
+ * per run of adjacent changed rows, covering only the changed columns, and
+ * rows whose displayed data did not change are not reported at all.
+ */
 class JobItemModel : public QAbstractItemModel
 {
   Q_OBJECT
@@ -48,9 +65,31 @@ public:
 
   // Used with the data() method to get info.
   enum UserRoles {
-    FetchJobRole = Qt::UserRole
+    /// A Job handle. Only use it from the JobManager's thread, i.e. with a
+    /// ServerThreadLocker held in the GUI.
+    FetchJobRole = Qt::UserRole,
+    /// The JobState of the job, as an int.
+    JobStateRole,
+    /// The Job::hideFromGui() flag.
+    HideFromGuiRole
   };
 
+  /**
+   * @name Filter data
+   * Cached data of @a row for JobTableProxyModel. @a row must be valid.
+   * @{
+   */
+  JobState jobState(int row) const { return m_rows.jobStates.at(row); }
+  bool hideFromGui(int row) const { return m_rows.hideFromGui.at(row); }
+  /// The displayed text of all columns in lower case, one per line.
+  const QString &filterText(int row) const
+  {
+    return m_rows.filterTexts.at(row);
+  }
+  /** @} */
+
+  /// Show the jobs of @a jobManager. Call before the JobManager is moved to a
+  /// ServerThread.
   void setJobManager(JobManager *jobManager);
   JobManager *jobManager() const {return m_jobManager;}
 
@@ -64,30 +103,78 @@ public:
 
   QVariant data(const QModelIndex & modelIndex, int role = Qt::DisplayRole) const;
 
-  /// Remove the rows from the model. Does not modify the underlying data
-  /// structure.
-  /// @see JobManager::removeJob()
-  bool removeRows(int row, int count, const QModelIndex &);
-
-  /// Insert rows into the model. Does not modify the underlying data structure.
-  /// @see JobManager::newJob()
-  bool insertRows(int row, int count, const QModelIndex &);
-
   Qt::ItemFlags flags(const QModelIndex & modelIndex) const;
 
   QModelIndex index(int row, int column,
                     const QModelIndex & modelIndex = QModelIndex()) const;
 
-  friend class MoleQueue::JobManager;
-
 signals:
   void rowCountChanged();
 
-public slots:
-  void jobUpdated(const MoleQueue::Job &job);
+protected slots:
+  void jobsChanged(const QList<MoleQueue::JobSummary> &jobs,
+                   const QList<MoleQueue::IdType> &removed);
 
 protected:
+  /**
+   * The displayed jobs, stored by column: element i of each vector belongs to
+   * row i. Text is formatted when a job changes, so data() and the proxy
+   * model's filter only index into these.
+   */
+  struct Rows
+  {
+    QVector<IdType> moleQueueIds;
+    QVector<QString> descriptions;
+    QVector<int> numberOfCores;
+    /// Queue name and queue id, as displayed.
+    QVector<QString> queueTexts;
+    QVector<QString> programs;
+    QVector<JobState> jobStates;
+    QVector<bool> hideFromGui;
+    /// See JobItemModel::filterText().
+    QVector<QString> filterTexts;
+
+    int size() const { return moleQueueIds.size(); }
+    void clear();
+    void reserve(int count);
+    void append(const JobSummary &job);
+    void remove(int first, int count);
+
+    /**
+     * Replace @a row with @a job.
+     * @param firstColumn Set to the first changed column.
+     * @param lastColumn Set to the last changed column.
+     * @return False if no displayed or filtered data changed.
+     */
+    bool update(int row, const JobSummary &job,
+                int *firstColumn, int *lastColumn);
+  };
+
+  /// Update m_rowLookup for the rows starting at @a firstRow.
+  void updateRowLookup(int firstRow);
+
+  /// Remove the rows of the jobs with @a moleQueueIds, one range at a time.
+  void removeJobRows(const QList<IdType> &moleQueueIds);
+
+  /// Emit dataChanged() for @a changedCells (row --> first and last changed
+  /// column), merging adjacent rows.
+  void emitDataChanged(const QMap<int, QPair<int, int> > &changedCells);
+
+  /// @return The text shown in the queue column for @a job.
+  static QString queueText(const JobSummary &job);
+
+  /// @return The text shown for @a state. The strings are shared by all rows.
+  static const QString &stateText(JobState state);
+
+  /// @return The filterText() of @a job.
+  static QString makeFilterText(const JobSummary &job);
+
   JobManager *m_jobManager;
+
+  Rows m_rows;
+
+  /// MoleQueue id --> row
+  QHash<IdType, int> m_rowLookup;
 };
 
 } // End namespace
@@ -18,22 +18,24 @@
 
 #include "job.h"
 #include "jobdata.h"
-#include "jobitemmodel.h"
+#include "jobfilter.h"
 #include "logger.h"
 
 #include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QTimerEvent>
 
 namespace MoleQueue
 {
 
 JobManager::JobManager(QObject *parentObject) :
   QObject(parentObject),
-  m_itemModel(new JobItemModel(this))
+  m_jobsChangedTimer(0)
 {
   qRegisterMetaType<Job>("MoleQueue::Job");
-
-  m_itemModel->setJobManager(this);
+  qRegisterMetaType<QList<JobSummary> >("QList<MoleQueue::JobSummary>");
+  qRegisterMetaType<QList<IdType> >("QList<MoleQueue::IdType>");
+  qRegisterMetaType<QList<IdType> >("QList<IdType>");
 
   connect(this, SIGNAL(jobStateChanged(MoleQueue::Job,MoleQueue::JobState,
                                        MoleQueue::JobState)),
@@ -43,13 +45,16 @@ JobManager::JobManager(QObject *parentObject) :
 JobManager::~JobManager()
 {
   m_moleQueueMap.clear();
+  m_jobStateIndex.clear();
+  m_queueIndex.clear();
+  m_jobOwners.clear();
+  m_ownerIndex.clear();
   qDeleteAll(m_jobs);
   m_jobs.clear();
 }
 
 void JobManager::loadJobState(const QString &path)
 {
-  m_itemModel->beginResetModel();
   QDir dir(path);
   foreach (const QString &subDirName,
            dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot)) {
@@ -61,14 +66,13 @@ void JobManager::loadJobState(const QString &path)
     JobData *jobdata = new JobData(this);
     if (jobdata->load(stateFilename)) {
       m_jobs.append(jobdata);
+      acquireSlot(jobdata);
       insertJobData(jobdata);
     }
     else {
       delete jobdata;
     }
   }
-
-  m_itemModel->endResetModel();
 }
 
 void JobManager::syncJobState() const
@@ -85,6 +89,7 @@ Job JobManager::newJob()
   JobData *jobdata = new JobData(this);
 
   m_jobs.append(jobdata);
+  acquireSlot(jobdata);
   emit jobAboutToBeAdded(Job(jobdata));
 
   insertJobData(jobdata);
@@ -99,6 +104,7 @@ Job JobManager::newJob(const QJsonObject &jobState)
   jobdata->setMoleQueueId(InvalidId);
 
   m_jobs.append(jobdata);
+  acquireSlot(jobdata);
   emit jobAboutToBeAdded(Job(jobdata));
 
   insertJobData(jobdata);
@@ -108,17 +114,18 @@ Job JobManager::newJob(const QJsonObject &jobState)
 
 void JobManager::removeJob(JobData *jobdata)
 {
-  if (!jobdata || !m_jobs.contains(jobdata))
+  if (!jobdata || !hasJobData(jobdata))
     return;
 
   emit jobAboutToBeRemoved(Job(jobdata));
 
   IdType moleQueueId = jobdata->moleQueueId();
 
-  int jobsIndex = m_jobs.indexOf(jobdata);
-  m_jobs.removeAt(jobsIndex);
-  m_itemModel->removeRow(jobsIndex);
+  m_jobs.removeOne(jobdata);
+  releaseSlot(jobdata);
   m_moleQueueMap.remove(moleQueueId);
+  removeFromIndexes(jobdata);
+  setJobOwner(moleQueueId, NULL);
 
   // Save job state and move it so it won't get loaded next time.
   jobdata->save();
@@ -127,6 +134,7 @@ void JobManager::removeJob(JobData *jobdata)
 
   delete jobdata;
 
+  queueJobRemoval(moleQueueId);
   emit jobRemoved(moleQueueId);
 }
 
@@ -165,14 +173,201 @@ QList<Job> JobManager::jobsWithJobState(JobState state)
 {
   QList<Job> result;
 
-  foreach (JobData *jobdata, m_jobs) {
-    if (jobdata->jobState() == state)
-      result << Job(jobdata);
+  foreach (JobData *jobdata, m_jobStateIndex.value(static_cast<int>(state)))
+    result << Job(jobdata);
+
+  return result;
+}
+
+QList<Job> JobManager::findJobs(const JobFilter &filter, IdType after,
+                                int limit, bool *more) const
+{
+  // Use the smaller of the state and queue index entries as candidates, and
+  // fall back to all jobs if the filter restricts neither.
+  QList<const JobDataMap*> candidates;
+  int candidateCount = m_moleQueueMap.size();
+  if (!filter.states.isEmpty()) {
+    QList<const JobDataMap*> maps;
+    int count = 0;
+    foreach (int state, filter.states) {
+      QHash<int, JobDataMap>::const_iterator it =
+          m_jobStateIndex.constFind(state);
+      if (it != m_jobStateIndex.constEnd()) {
+        maps << &it.value();
+        count += it.value().size();
+      }
+    }
+    candidates = maps;
+    candidateCount = count;
+  }
+  if (!filter.queues.isEmpty()) {
+    QList<const JobDataMap*> maps;
+    int count = 0;
+    foreach (const QString &queue, filter.queues) {
+      QHash<QString, JobDataMap>::const_iterator it =
+          m_queueIndex.constFind(queue);
+      if (it != m_queueIndex.constEnd()) {
+        maps << &it.value();
+        count += it.value().size();
+      }
+    }
+    if (filter.states.isEmpty() || count < candidateCount) {
+      candidates = maps;
+      candidateCount = count;
+    }
+  }
+  if (filter.states.isEmpty() && filter.queues.isEmpty())
+    candidates << &m_moleQueueMap;
+
+  // Merge the candidates in MoleQueue id order. Only the first limit + 1
+  // matches are needed (the extra one tells whether there are more), so each
+  // candidate map is scanned until it has contributed that many, or until it
+  // is past the last id that could still be returned.
+  const int wanted = limit < 0 ? -1 : limit + 1;
+  if (filter.minMoleQueueId != InvalidId && filter.minMoleQueueId > after)
+    after = filter.minMoleQueueId - 1;
+  JobDataMap matches;
+  foreach (const JobDataMap *map, candidates) {
+    int found = 0;
+    for (JobDataMap::const_iterator it = map->upperBound(after),
+         itEnd = map->constEnd(); it != itEnd; ++it) {
+      if (wanted >= 0 && (found == wanted ||
+                          (matches.size() >= wanted &&
+                           it.key() > (matches.constEnd() - 1).key()))) {
+        break;
+      }
+      if (filter.maxMoleQueueId != InvalidId &&
+          it.key() > filter.maxMoleQueueId) {
+        break;
+      }
+      if (filter.matches(*it.value())) {
+        matches.insert(it.key(), it.value());
+        ++found;
+      }
+    }
+  }
+
+  QList<Job> result;
+  if (more)
+    *more = false;
+  for (JobDataMap::const_iterator it = matches.constBegin(),
+       itEnd = matches.constEnd(); it != itEnd; ++it) {
+    if (limit >= 0 && result.size() == limit) {
+      if (more)
+        *more = true;
+      break;
+    }
+    result << Job(it.value());
   }
 
   return result;
 }
 
+QList<JobSummary> JobManager::jobSummaries() const
+{
+  QList<JobSummary> result;
+  foreach (const JobData *jobdata, m_jobs) {
+    if (jobdata->moleQueueId() != InvalidId)
+      result << JobSummary(*jobdata);
+  }
+  return result;
+}
+
+void JobManager::setJobOwner(IdType moleQueueId, QObject *owner)
+{
+  QObject *oldOwner = m_jobOwners.value(moleQueueId, NULL);
+  if (oldOwner == owner)
+    return;
+
+  if (oldOwner) {
+    QHash<QObject*, QSet<IdType> >::iterator it = m_ownerIndex.find(oldOwner);
+    it.value().remove(moleQueueId);
+    if (it.value().isEmpty())
+      m_ownerIndex.erase(it);
+    m_jobOwners.remove(moleQueueId);
+  }
+
+  if (owner && moleQueueId != InvalidId) {
+    m_jobOwners.insert(moleQueueId, owner);
+    m_ownerIndex[owner].insert(moleQueueId);
+  }
+}
+
+void JobManager::removeJobOwner(QObject *owner)
+{
+  foreach (IdType moleQueueId, m_ownerIndex.take(owner))
+    m_jobOwners.remove(moleQueueId);
+}
+
+bool JobManager::checkIndexes(QString *error) const
+{
+  QString problem;
+  int stateCount = 0;
+  for (QHash<int, JobDataMap>::const_iterator it = m_jobStateIndex.constBegin(),
+       itEnd = m_jobStateIndex.constEnd(); it != itEnd && problem.isEmpty();
+       ++it) {
+    if (it.value().isEmpty())
+      problem = QString("Empty entry for state %1.").arg(it.key());
+    foreach (const JobData *jobdata, it.value()) {
+      if (static_cast<int>(jobdata->jobState()) != it.key() ||
+          m_moleQueueMap.value(jobdata->moleQueueId()) != jobdata) {
+        problem = QString("Job %1 is in the index for state %2.")
+            .arg(jobdata->moleQueueId()).arg(it.key());
+        break;
+      }
+    }
+    stateCount += it.value().size();
+  }
+
+  int queueCount = 0;
+  for (QHash<QString, JobDataMap>::const_iterator it = m_queueIndex.constBegin(),
+       itEnd = m_queueIndex.constEnd(); it != itEnd && problem.isEmpty();
+       ++it) {
+    if (it.value().isEmpty())
+      problem = QString("Empty entry for queue '%1'.").arg(it.key());
+    foreach (const JobData *jobdata, it.value()) {
+      if (jobdata->queue() != it.key() ||
+          m_moleQueueMap.value(jobdata->moleQueueId()) != jobdata) {
+        problem = QString("Job %1 is in the index for queue '%2'.")
+            .arg(jobdata->moleQueueId()).arg(it.key());
+        break;
+      }
+    }
+    queueCount += it.value().size();
+  }
+
+  if (problem.isEmpty() && (stateCount != m_moleQueueMap.size() ||
+                            queueCount != m_moleQueueMap.size())) {
+    problem = QString("%1 jobs, but %2 in the state index and %3 in the queue "
+                      "index.").arg(m_moleQueueMap.size()).arg(stateCount)
+        .arg(queueCount);
+  }
+
+  int ownedCount = 0;
+  for (QHash<QObject*, QSet<IdType> >::const_iterator
+       it = m_ownerIndex.constBegin(), itEnd = m_ownerIndex.constEnd();
+       it != itEnd && problem.isEmpty(); ++it) {
+    foreach (IdType moleQueueId, it.value()) {
+      if (m_jobOwners.value(moleQueueId) != it.key() ||
+          !m_moleQueueMap.contains(moleQueueId)) {
+        problem = QString("Job %1 is in the owner index for the wrong owner.")
+            .arg(moleQueueId);
+        break;
+      }
+    }
+    ownedCount += it.value().size();
+  }
+
+  if (problem.isEmpty() && ownedCount != m_jobOwners.size()) {
+    problem = QString("%1 owned jobs, but %2 in the owner index.")
+        .arg(m_jobOwners.size()).arg(ownedCount);
+  }
+
+  if (error)
+    *error = problem;
+  return problem.isEmpty();
+}
+
 Job JobManager::jobAt(int i) const
 {
   if (Q_LIKELY(i >= 0 && i < m_jobs.size()))
@@ -191,15 +386,24 @@ int JobManager::indexOf(const Job &job) const
 
 void JobManager::moleQueueIdChanged(const Job &job)
 {
-  JobData *jobdata = job.jobData();
-  if (!m_jobs.contains(jobdata))
+  if (!job.isValid())
     return;
+  JobData *jobdata = job.jobData();
 
   if (lookupJobDataByMoleQueueId(jobdata->moleQueueId()) != jobdata) {
     IdType oldMoleQueueId = m_moleQueueMap.key(jobdata, InvalidId);
-    if (oldMoleQueueId != InvalidId)
+    if (oldMoleQueueId != InvalidId) {
       m_moleQueueMap.remove(oldMoleQueueId);
+      removeFromIndexes(jobdata, oldMoleQueueId);
+      if (QObject *owner = jobOwner(oldMoleQueueId)) {
+        setJobOwner(oldMoleQueueId, NULL);
+        setJobOwner(jobdata->moleQueueId(), owner);
+      }
+      queueJobRemoval(oldMoleQueueId);
+    }
     m_moleQueueMap.insert(jobdata->moleQueueId(), jobdata);
+    addToIndexes(jobdata);
+    queueJobChange(jobdata->moleQueueId());
   }
 }
 
@@ -214,17 +418,38 @@ void JobManager::setJobState(IdType moleQueueId, JobState newState)
   if (oldState == newState)
     return;
 
+  removeFromIndexes(jobdata);
   jobdata->setJobState(newState);
+  addToIndexes(jobdata);
+
+  if (Logger::isEnabled(LogEntry::Notification)) {
+    Logger::logNotification(tr("Job '%1' has changed status from '%2' to '%3'.")
+                            .arg(jobdata->description())
+                            .arg(MoleQueue::jobStateToGuiString(oldState))
+                            .arg(MoleQueue::jobStateToGuiString(newState)),
+                            moleQueueId);
+  }
 
-  Logger::logNotification(tr("Job '%1' has changed status from '%2' to '%3'.")
-                          .arg(jobdata->description())
-                          .arg(MoleQueue::jobStateToGuiString(oldState))
-                          .arg(MoleQueue::jobStateToGuiString(newState)),
-                          moleQueueId);
-
+  queueJobChange(moleQueueId);
   emit jobStateChanged(jobdata, oldState, newState);
 }
 
+void JobManager::setJobQueue(IdType moleQueueId, const QString &queue)
+{
+  JobData *jobdata = lookupJobDataByMoleQueueId(moleQueueId);
+  if (!jobdata)
+    return;
+
+  if (jobdata->queue() == queue)
+    return;
+
+  removeFromIndexes(jobdata);
+  jobdata->setQueue(queue);
+  addToIndexes(jobdata);
+
+  queueJobChange(moleQueueId);
+}
+
 void JobManager::setJobQueueId(IdType moleQueueId, IdType queueId)
 {
   JobData *jobdata = lookupJobDataByMoleQueueId(moleQueueId);
@@ -236,16 +461,153 @@ void JobManager::setJobQueueId(IdType moleQueueId, IdType queueId)
 
   jobdata->setQueueId(queueId);
 
+  queueJobChange(moleQueueId);
   emit jobUpdated(jobdata);
 }
 
+void JobManager::timerEvent(QTimerEvent *e)
+{
+  if (e->timerId() != m_jobsChangedTimer) {
+    QObject::timerEvent(e);
+    return;
+  }
+
+  e->accept();
+  killTimer(m_jobsChangedTimer);
+  m_jobsChangedTimer = 0;
+
+  QList<JobSummary> jobs;
+  foreach (IdType moleQueueId, m_changedJobs) {
+    if (const JobData *jobdata = lookupJobDataByMoleQueueId(moleQueueId))
+      jobs << JobSummary(*jobdata);
+  }
+  QList<IdType> removed = m_removedJobs;
+  m_changedJobs.clear();
+  m_changedJobSet.clear();
+  m_removedJobs.clear();
+
+  emit jobsChanged(jobs, removed);
+}
+
+void JobManager::queueJobChange(IdType moleQueueId)
+{
+  if (moleQueueId == InvalidId ||
+      receivers(SIGNAL(jobsChanged(QList<MoleQueue::JobSummary>,
+                                   QList<MoleQueue::IdType>))) == 0) {
+    return;
+  }
+
+  if (!m_changedJobSet.contains(moleQueueId)) {
+    m_changedJobSet.insert(moleQueueId);
+    m_changedJobs.append(moleQueueId);
+  }
+
+  if (m_jobsChangedTimer == 0)
+    m_jobsChangedTimer = startTimer(0);
+}
+
+void JobManager::queueJobRemoval(IdType moleQueueId)
+{
+  if (moleQueueId == InvalidId ||
+      receivers(SIGNAL(jobsChanged(QList<MoleQueue::JobSummary>,
+                                   QList<MoleQueue::IdType>))) == 0) {
+    return;
+  }
+
+  // Jobs added and removed in the same turn are only reported as removed.
+  if (m_changedJobSet.remove(moleQueueId))
+    m_changedJobs.removeOne(moleQueueId);
+  m_removedJobs.append(moleQueueId);
+
+  if (m_jobsChangedTimer == 0)
+    m_jobsChangedTimer = startTimer(0);
+}
+
+bool JobManager::hasJobData(const JobData *data) const
+{
+  if (!data)
+    return false;
+  const int slot = data->jobManagerSlot();
+  return slot >= 0 && slot < m_slotJobs.size() && m_slotJobs.at(slot) == data;
+}
+
+void JobManager::acquireSlot(JobData *jobdata)
+{
+  int slot;
+  if (!m_freeSlots.isEmpty()) {
+    slot = m_freeSlots.last();
+    m_freeSlots.pop_back();
+    m_slotJobs[slot] = jobdata;
+  }
+  else {
+    slot = m_slotJobs.size();
+    m_slotJobs.append(jobdata);
+    m_slotGenerations.append(1);
+  }
+  jobdata->setJobManagerSlot(slot);
+}
+
+void JobManager::releaseSlot(JobData *jobdata)
+{
+  const int slot = jobdata->jobManagerSlot();
+  if (slot < 0 || slot >= m_slotJobs.size() || m_slotJobs.at(slot) != jobdata)
+    return;
+
+  m_slotJobs[slot] = NULL;
+  // Skip 0, which slotGeneration() returns for invalid slots.
+  if (++m_slotGenerations[slot] == 0)
+    m_slotGenerations[slot] = 1;
+  m_freeSlots.append(slot);
+  jobdata->setJobManagerSlot(-1);
+}
+
 void JobManager::insertJobData(JobData *jobdata)
 {
-  if (jobdata->moleQueueId() != MoleQueue::InvalidId)
+  if (jobdata->moleQueueId() != MoleQueue::InvalidId) {
     m_moleQueueMap.insert(jobdata->moleQueueId(), jobdata);
+    addToIndexes(jobdata);
+  }
 
-  m_itemModel->insertRow(m_jobs.size() - 1);
+  queueJobChange(jobdata->moleQueueId());
   emit jobAdded(Job(jobdata));
 }
 
+void JobManager::addToIndexes(JobData *jobdata)
+{
+  const IdType moleQueueId = jobdata->moleQueueId();
+  if (moleQueueId == InvalidId)
+    return;
+
+  m_jobStateIndex[static_cast<int>(jobdata->jobState())]
+      .insert(moleQueueId, jobdata);
+  m_queueIndex[jobdata->queue()].insert(moleQueueId, jobdata);
+}
+
+void JobManager::removeFromIndexes(JobData *jobdata)
+{
+  removeFromIndexes(jobdata, jobdata->moleQueueId());
+}
+
+void JobManager::removeFromIndexes(JobData *jobdata, IdType moleQueueId)
+{
+  if (moleQueueId == InvalidId)
+    return;
+
+  QHash<int, JobDataMap>::iterator state =
+      m_jobStateIndex.find(static_cast<int>(jobdata->jobState()));
+  if (state != m_jobStateIndex.end()) {
+    state.value().remove(moleQueueId);
+    if (state.value().isEmpty())
+      m_jobStateIndex.erase(state);
+  }
+
+  QHash<QString, JobDataMap>::iterator queue =
+      m_queueIndex.find(jobdata->queue());
+  if (queue != m_queueIndex.end()) {
+    queue.value().remove(moleQueueId);
+    if (queue.value().isEmpty())
+      m_queueIndex.erase(queue);
+  }
+}
+
 } // end namespace MoleQueue
@@ -20,8 +20,12 @@
 #include <QtCore/QObject>
 
 #include "job.h"
+#include "jobsummary.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QMap>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
 
 class QJsonObject;
 
@@ -30,7 +34,7 @@ class ConnectionTest;
 namespace MoleQueue
 {
 class JobData;
-class JobItemModel;
+class JobFilter;
 class JobReferenceBase;
 
 /**
@@ -102,9 +106,9 @@ public:
 
   /**
    * Remove the jobs with the specified @a moleQueueIds from this manager and
-   * delete them.
+   * delete them. Invokable, so other threads may queue a call.
    */
-  void removeJobs(const QList<IdType> &moleQueueIds);
+  Q_INVOKABLE void removeJobs(const QList<IdType> &moleQueueIds);
 
   /**
    * @param moleQueueId The MoleQueue Id of the requested Job.
@@ -113,13 +117,71 @@ public:
    */
   Job lookupJobByMoleQueueId(IdType moleQueueId) const;
 
+  /**
+   * @return True if a job with @a moleQueueId is held by this manager.
+   */
+  bool contains(IdType moleQueueId) const
+  {
+    return m_moleQueueMap.contains(moleQueueId);
+  }
+
   /**
    * Return a list of Job objects that have JobState @a state.
    * @param state JobState of interests
-   * @return List of Job objects with JobState @a state
+   * @return List of Job objects with JobState @a state, ordered by MoleQueue
+   * id.
    */
   QList<Job> jobsWithJobState(MoleQueue::JobState state);
 
+  /**
+   * Find the jobs selected by @a filter, ordered by MoleQueue id. If the
+   * filter restricts the states or queues, only the jobs in the matching
+   * entries of the state or queue index are examined.
+   * @param after Only jobs with a MoleQueue id greater than @a after are
+   * returned, for paging through the results.
+   * @param limit The maximum number of jobs to return, or -1 for all.
+   * @param more If not NULL, set to true if more than @a limit jobs match.
+   * @note Jobs without a MoleQueue id are not indexed and never returned.
+   */
+  QList<Job> findJobs(const JobFilter &filter, IdType after = 0,
+                      int limit = -1, bool *more = NULL) const;
+
+  /**
+   * Record @a owner as the owner of the job with @a moleQueueId, e.g. the
+   * client connection that submitted it. A null @a owner clears the owner.
+   * Owners are forgotten when their jobs are removed.
+   */
+  void setJobOwner(IdType moleQueueId, QObject *owner);
+
+  /**
+   * @return The owner of the job with @a moleQueueId, or NULL.
+   */
+  QObject *jobOwner(IdType moleQueueId) const
+  {
+    return m_jobOwners.value(moleQueueId, NULL);
+  }
+
+  /**
+   * @return The MoleQueue ids of the jobs owned by @a owner.
+   */
+  QList<IdType> jobsOwnedBy(QObject *owner) const
+  {
+    return m_ownerIndex.value(owner).toList();
+  }
+
+  /**
+   * Clear the owner of all jobs owned by @a owner.
+   */
+  void removeJobOwner(QObject *owner);
+
+  /**
+   * Check that the state, queue and owner indexes agree with the jobs.
+   * @param error If not NULL and an index is inconsistent, set to a
+   * description of the problem.
+   * @return True if the indexes are consistent.
+   */
+  bool checkIndexes(QString *error = NULL) const;
+
   /**
    * @return Number of Job objects held by this manager.
    */
@@ -139,9 +201,10 @@ public:
   int indexOf(const Job &job) const;
 
   /**
-   * @return the JobItemModel for this JobManager.
+   * @return A JobSummary of each job with a MoleQueue id, in the order of
+   * jobAt(). Call from the thread the JobManager lives in.
    */
-  JobItemModel * itemModel() const { return m_itemModel; }
+  QList<JobSummary> jobSummaries() const;
 
   friend class JobReferenceBase;
   friend class ConnectionTest;
@@ -171,6 +234,11 @@ public slots:
   void setJobState(MoleQueue::IdType jobManagerId,
                    MoleQueue::JobState newState);
 
+  /**
+   * Set the queue name for the job with the specified MoleQueue id
+   */
+  void setJobQueue(MoleQueue::IdType moleQueueId, const QString &queue);
+
   /**
    * Set the QueueId for the job with the specified MoleQueue id
    */
@@ -225,30 +293,125 @@ signals:
    */
   void jobRemoved(MoleQueue::IdType moleQueueId);
 
+  /**
+   * Emitted at most once per event loop turn with the jobs that were added,
+   * updated or removed since the previous emission. A job that changed
+   * several times is listed once, with its latest details.
+   *
+   * Unlike the per-job signals, this signal may be connected to objects in
+   * other threads (e.g. the JobItemModel when the server runs in a
+   * ServerThread): @a jobs are copies, taken in the JobManager's thread.
+   * Only emitted while something is connected to it.
+   * @param jobs The new and updated jobs.
+   * @param removed The MoleQueue ids of the removed jobs.
+   */
+  void jobsChanged(const QList<MoleQueue::JobSummary> &jobs,
+                   const QList<MoleQueue::IdType> &removed);
+
 protected:
+  void timerEvent(QTimerEvent *e);
+
+  /// Add the job with @a moleQueueId to the next jobsChanged() emission.
+  void queueJobChange(IdType moleQueueId);
+
+  /// Add the removal of the job with @a moleQueueId to the next jobsChanged()
+  /// emission.
+  void queueJobRemoval(IdType moleQueueId);
+
   /// @return The JobData with @a moleQueueId
   JobData *lookupJobDataByMoleQueueId(IdType moleQueueId) const
   {
     return m_moleQueueMap.value(moleQueueId, NULL);
   }
 
-  /// @return Whether the address @a data is stored in m_jobs.
-  bool hasJobData(const JobData *data) const
+  /// @return Whether @a data, which must not have been deleted, is stored in
+  /// m_jobs.
+  bool hasJobData(const JobData *data) const;
+
+  /**
+   * @name Slot table
+   * Each JobData held by the manager occupies a slot, which JobReferenceBase
+   * records together with the slot's generation. The generation changes when
+   * the slot is released, so validating a reference is a single compare.
+   * @{
+   */
+  /// Give @a jobdata a free slot. Called when it is added to m_jobs.
+  void acquireSlot(JobData *jobdata);
+
+  /// Release the slot of @a jobdata, invalidating all references to it.
+  void releaseSlot(JobData *jobdata);
+
+  /// @return The current generation of @a slot, or 0 if @a slot is invalid.
+  quint32 slotGeneration(int slot) const
   {
-    return m_jobs.contains(const_cast<JobData*>(data));
+    return slot >= 0 && slot < m_slotGenerations.size()
+        ? m_slotGenerations.at(slot) : 0;
   }
 
+  /// @return True if @a slot still has @a generation, i.e. the JobData that
+  /// was in it when the generation was read has not been removed.
+  bool isCurrentSlot(int slot, quint32 generation) const
+  {
+    return static_cast<uint>(slot) <
+        static_cast<uint>(m_slotGenerations.size()) &&
+        m_slotGenerations.at(slot) == generation;
+  }
+  /** @} */
+
   /// @param jobdata Job to insert into the internal lookup structures.
   void insertJobData(JobData *jobdata);
 
+  /// Add @a jobdata to the state and queue indexes under its current
+  /// MoleQueue id, state and queue.
+  void addToIndexes(JobData *jobdata);
+
+  /// Remove @a jobdata from the state and queue indexes. Must be called
+  /// before its MoleQueue id, state or queue change.
+  void removeFromIndexes(JobData *jobdata);
+
+  /// Remove @a jobdata, indexed under @a moleQueueId, from the indexes.
+  void removeFromIndexes(JobData *jobdata, IdType moleQueueId);
+
+  /// Jobs ordered by MoleQueue id.
+  typedef QMap<IdType, JobData*> JobDataMap;
+
   /// "Master" list of JobData
   QList<JobData*> m_jobs;
 
-  /// Item model for interacting with jobs
-  JobItemModel *m_itemModel;
+  /// Slot --> JobData, NULL for free slots
+  QVector<JobData*> m_slotJobs;
+
+  /// Slot --> generation, starting at 1 and never 0
+  QVector<quint32> m_slotGenerations;
+
+  /// Released slots, reused before the table grows
+  QVector<int> m_freeSlots;
 
   /// Lookup table for MoleQueue ids
-  QMap<IdType, JobData*> m_moleQueueMap;
+  JobDataMap m_moleQueueMap;
+
+  /// JobState --> jobs in that state
+  QHash<int, JobDataMap> m_jobStateIndex;
+
+  /// Queue name --> jobs in that queue
+  QHash<QString, JobDataMap> m_queueIndex;
+
+  /// MoleQueue id --> owner
+  QHash<IdType, QObject*> m_jobOwners;
+
+  /// Owner --> MoleQueue ids of the jobs it owns
+  QHash<QObject*, QSet<IdType> > m_ownerIndex;
+
+  /// Jobs changed since the last jobsChanged(), in the order of their first
+  /// change.
+  QList<IdType> m_changedJobs;
+  QSet<IdType> m_changedJobSet;
+
+  /// Jobs removed since the last jobsChanged().
+  QList<IdType> m_removedJobs;
+
+  /// Timer for emitting jobsChanged().
+  int m_jobsChangedTimer;
 };
 
 }
@@ -25,15 +25,19 @@ JobReferenceBase::JobReferenceBase(JobData *jobdata)
   : m_jobData(jobdata),
     m_jobManager( Q_LIKELY(jobdata != NULL) ? jobdata->jobManager() : NULL),
     m_moleQueueId( Q_LIKELY(jobdata != NULL) ? jobdata->moleQueueId() :
-                                               MoleQueue::InvalidId )
-
+                                               MoleQueue::InvalidId ),
+    m_slot( Q_LIKELY(jobdata != NULL) ? jobdata->jobManagerSlot() : -1),
+    m_generation( Q_LIKELY(m_jobManager != NULL) ?
+                    m_jobManager->slotGeneration(m_slot) : 0)
 {
 }
 
 JobReferenceBase::JobReferenceBase(JobManager *jobManager, IdType moleQueueId)
   : m_jobData(jobManager->lookupJobDataByMoleQueueId(moleQueueId)),
     m_jobManager(jobManager),
-    m_moleQueueId(moleQueueId)
+    m_moleQueueId(moleQueueId),
+    m_slot(m_jobData ? m_jobData->jobManagerSlot() : -1),
+    m_generation(jobManager->slotGeneration(m_slot))
 {
 }
 
@@ -43,34 +47,15 @@ JobReferenceBase::~JobReferenceBase()
 
 bool JobReferenceBase::isValid() const
 {
-  if (m_jobData) {
-    // If we have a molequeue id, validate the job data using the faster QMap
-    // lookup, O(log(n))
-    if (m_moleQueueId != InvalidId) {
-      JobData *ref = m_jobManager->lookupJobDataByMoleQueueId(m_moleQueueId);
-      if (ref) {
-        if (ref == m_jobData)
-          return true;
-
-        qWarning() << "Job with molequeue id" << m_moleQueueId << "maps to a "
-                      "different job than expected.\nExpected:\n"
-                   << m_jobData << "\nLookup returned:\n"
-                   << ref;
-        return false;
-      }
-    }
-    // If the cached molequeue id is invalid, do the slow QList lookup, O(n):
-    if (m_jobManager->hasJobData(m_jobData)) {
-      // m_jobData is still valid. Try to update our cached molequeueid:
-      if (m_jobData->moleQueueId() != InvalidId)
-        m_moleQueueId = m_jobData->moleQueueId();
-      return true;
-    }
-    // m_jobData is gone...
-    m_jobData = NULL;
-    return false;
+  // The generation changes when the JobData is removed, so the slot is never
+  // mistaken for a JobData that later reuses it.
+  if (Q_LIKELY(m_jobManager && m_jobManager->isCurrentSlot(m_slot,
+                                                            m_generation))) {
+    return true;
   }
-  // If m_jobData is NULL, the reference is invalid
+
+  // m_jobData is gone...
+  m_jobData = NULL;
   return false;
 }
 
@@ -40,9 +40,11 @@ class JobManager;
  * modifying job properties.
  *
  * JobReferenceBase validates the pointer to the JobData object it represents by
- * querying the JobManager. The validity of the JobData pointer can be checked
- * with isValid(), which will return false if the JobData has been removed from
- * the JobManager. Subclasses of JobReferenceBase, Job on the Server and
+ * comparing the generation of the JobData's JobManager slot with the one
+ * recorded when the reference was made, which is cheap enough to do on every
+ * access. The validity of the JobData pointer can be checked with isValid(),
+ * which will return false if the JobData has been removed from the
+ * JobManager. Subclasses of JobReferenceBase, Job on the Server and
  * JobRequest on the Client, will forward requests to the JobData. Certain
  * methods may cause signals to be emitted from JobManager; these cases will be
  * noted in the method documentation.
@@ -60,7 +62,8 @@ public:
   /// Construct a new JobReferenceBase with the same JobData as @a other.
   JobReferenceBase(const JobReferenceBase &other)
     : m_jobData(other.m_jobData),m_jobManager(other.m_jobManager),
-      m_moleQueueId(other.m_moleQueueId) {}
+      m_moleQueueId(other.m_moleQueueId), m_slot(other.m_slot),
+      m_generation(other.m_generation) {}
 
   virtual ~JobReferenceBase();
 
@@ -95,8 +98,12 @@ protected:
   /// May be set to NULL during validation
   mutable JobData* m_jobData;
   JobManager *m_jobManager;
-  /// Used to speed up lookups and validation
-  mutable IdType m_moleQueueId;
+  /// MoleQueue id when the reference was made, for diagnostics
+  IdType m_moleQueueId;
+  /// JobManager slot of m_jobData, or -1
+  int m_slot;
+  /// Generation of m_slot when the reference was made
+  quint32 m_generation;
 };
 
 } // namespace MoleQueue
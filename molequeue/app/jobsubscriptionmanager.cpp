@@ -0,0 +1,323 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "jobsubscriptionmanager.h"
+
+#include "idtypeutils.h"
+#include "job.h"
+#include "jobdata.h"
+#include "jobmanager.h"
+
+#include <molequeue/servercore/connection.h>
+#include <molequeue/servercore/message.h>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QTimerEvent>
+
+namespace MoleQueue
+{
+
+namespace {
+/// @return "moleQueueId" and the members of @a after that differ from
+/// @a before.
+QJsonObject changedMembers(const QJsonObject &before, const QJsonObject &after)
+{
+  QJsonObject result;
+  result.insert("moleQueueId", after.value("moleQueueId"));
+  for (QJsonObject::const_iterator it = after.constBegin(),
+       itEnd = after.constEnd(); it != itEnd; ++it) {
+    if (before.value(it.key()) != it.value())
+      result.insert(it.key(), it.value());
+  }
+  for (QJsonObject::const_iterator it = before.constBegin(),
+       itEnd = before.constEnd(); it != itEnd; ++it) {
+    if (!after.contains(it.key()))
+      result.insert(it.key(), QJsonValue());
+  }
+  return result;
+}
+} // end anon namespace
+
+JobSubscriptionManager::JobSubscriptionManager(JobManager *jobManager,
+                                               QObject *parentObject)
+  : QObject(parentObject),
+    m_jobManager(jobManager),
+    m_subscriptionIdCounter(0),
+    m_coalesceInterval(250),
+    m_maxPendingJobs(1000),
+    m_maxUnsentBytes(1024 * 1024),
+    m_flushTimer(0)
+{
+  connect(m_jobManager, SIGNAL(jobAdded(MoleQueue::Job)),
+          this, SLOT(jobAdded(MoleQueue::Job)));
+  connect(m_jobManager, SIGNAL(jobStateChanged(const MoleQueue::Job&,
+                                               MoleQueue::JobState,
+                                               MoleQueue::JobState)),
+          this, SLOT(jobStateChanged(const MoleQueue::Job&,
+                                     MoleQueue::JobState,
+                                     MoleQueue::JobState)));
+  connect(m_jobManager, SIGNAL(jobUpdated(MoleQueue::Job)),
+          this, SLOT(jobUpdated(MoleQueue::Job)));
+  connect(m_jobManager, SIGNAL(jobAboutToBeRemoved(MoleQueue::Job)),
+          this, SLOT(jobAboutToBeRemoved(MoleQueue::Job)));
+}
+
+JobSubscriptionManager::~JobSubscriptionManager()
+{
+}
+
+IdType JobSubscriptionManager::subscribe(Connection *connection,
+                                         const EndpointIdType &endpoint,
+                                         const JobFilter &filter)
+{
+  Subscription subscription;
+  subscription.id = ++m_subscriptionIdCounter;
+  subscription.connection = connection;
+  subscription.endpoint = endpoint;
+  subscription.filter = filter;
+  subscription.resyncNeeded = false;
+  m_subscriptions.append(subscription);
+  return subscription.id;
+}
+
+bool JobSubscriptionManager::unsubscribe(Connection *connection,
+                                         IdType subscriptionId)
+{
+  for (int i = 0; i < m_subscriptions.size(); ++i) {
+    if (m_subscriptions[i].id == subscriptionId &&
+        m_subscriptions[i].connection == connection) {
+      m_subscriptions.removeAt(i);
+      if (m_subscriptions.isEmpty())
+        m_lastSent.clear();
+      return true;
+    }
+  }
+  return false;
+}
+
+void JobSubscriptionManager::removeConnection(Connection *connection)
+{
+  for (int i = m_subscriptions.size() - 1; i >= 0; --i) {
+    if (m_subscriptions[i].connection == connection)
+      m_subscriptions.removeAt(i);
+  }
+  if (m_subscriptions.isEmpty())
+    m_lastSent.clear();
+}
+
+void JobSubscriptionManager::clear()
+{
+  m_subscriptions.clear();
+  m_lastSent.clear();
+  if (m_flushTimer != 0) {
+    killTimer(m_flushTimer);
+    m_flushTimer = 0;
+  }
+}
+
+void JobSubscriptionManager::setCoalesceInterval(int msecs)
+{
+  m_coalesceInterval = qMax(0, msecs);
+}
+
+void JobSubscriptionManager::setMaxPendingJobs(int jobs)
+{
+  m_maxPendingJobs = qMax(1, jobs);
+}
+
+void JobSubscriptionManager::setMaxUnsentBytes(qint64 bytes)
+{
+  m_maxUnsentBytes = qMax(Q_INT64_C(0), bytes);
+}
+
+void JobSubscriptionManager::flush()
+{
+  if (m_flushTimer != 0) {
+    killTimer(m_flushTimer);
+    m_flushTimer = 0;
+  }
+
+  bool heldBack = false;
+  for (int i = 0; i < m_subscriptions.size(); ++i) {
+    Subscription &subscription = m_subscriptions[i];
+    if (subscription.pending.isEmpty() && !subscription.resyncNeeded)
+      continue;
+
+    // Don't queue more for a client that isn't reading what it was sent.
+    if (subscription.connection->bytesToWrite() > m_maxUnsentBytes) {
+      requestResync(subscription);
+      heldBack = true;
+      continue;
+    }
+
+    QJsonObject paramsObject;
+    paramsObject.insert("subscriptionId", idTypeToJson(subscription.id));
+    if (subscription.resyncNeeded) {
+      paramsObject.insert("resyncNeeded", true);
+    }
+    else {
+      QJsonArray jobs;
+      foreach (const QJsonObject &change, subscription.pending)
+        jobs.append(change);
+      paramsObject.insert("jobs", jobs);
+    }
+    subscription.pending.clear();
+    subscription.resyncNeeded = false;
+
+    Message msg(Message::Notification, subscription.connection,
+                subscription.endpoint);
+    msg.setMethod("jobsChanged");
+    msg.setParams(paramsObject);
+    msg.send();
+  }
+
+  // Try again once the backlogged connections had time to drain.
+  if (heldBack)
+    startFlushTimer();
+}
+
+void JobSubscriptionManager::timerEvent(QTimerEvent *e)
+{
+  if (e->timerId() == m_flushTimer) {
+    e->accept();
+    flush();
+    return;
+  }
+
+  QObject::timerEvent(e);
+}
+
+void JobSubscriptionManager::jobAdded(const Job &job)
+{
+  addChange(job, Unknown, false);
+}
+
+void JobSubscriptionManager::jobStateChanged(const Job &job,
+                                             JobState oldState,
+                                             JobState newState)
+{
+  Q_UNUSED(newState);
+  addChange(job, oldState, false);
+}
+
+void JobSubscriptionManager::jobUpdated(const Job &job)
+{
+  addChange(job, Unknown, false);
+}
+
+void JobSubscriptionManager::jobAboutToBeRemoved(const Job &job)
+{
+  addChange(job, Unknown, true);
+}
+
+void JobSubscriptionManager::addChange(const Job &job, JobState oldState,
+                                       bool removed)
+{
+  if (m_subscriptions.isEmpty())
+    return;
+
+  const JobData *jobdata = job.jobData();
+  if (!jobdata)
+    return;
+  const IdType moleQueueId = jobdata->moleQueueId();
+
+  // Only serialize the job if someone is interested in it.
+  QJsonObject change;
+  QJsonObject changes;
+  bool changeReady = false;
+
+  for (int i = 0; i < m_subscriptions.size(); ++i) {
+    Subscription &subscription = m_subscriptions[i];
+    // Jobs leaving the selected states are reported too.
+    if (!subscription.filter.matches(*jobdata) &&
+        (oldState == Unknown ||
+         !subscription.filter.matches(*jobdata, oldState))) {
+      // It misses this change, so send the whole job if it matches again.
+      subscription.reported.remove(moleQueueId);
+      continue;
+    }
+
+    if (subscription.resyncNeeded)
+      continue;
+
+    if (!changeReady) {
+      if (removed) {
+        change.insert("moleQueueId", idTypeToJson(moleQueueId));
+        change.insert("removed", true);
+        changes = change;
+        m_lastSent.remove(moleQueueId);
+      }
+      else {
+        change = job.toJsonObject();
+        changes = changedMembers(m_lastSent.value(moleQueueId), change);
+        m_lastSent.insert(moleQueueId, change);
+      }
+      changeReady = true;
+    }
+
+    const QJsonObject &entryChange =
+        subscription.reported.contains(moleQueueId) ? changes : change;
+    if (removed)
+      subscription.reported.remove(moleQueueId);
+    else
+      subscription.reported.insert(moleQueueId);
+
+    QMap<IdType, QJsonObject>::iterator it =
+        subscription.pending.find(moleQueueId);
+    if (it == subscription.pending.end()) {
+      if (subscription.pending.size() >= m_maxPendingJobs) {
+        requestResync(subscription);
+        continue;
+      }
+      QJsonObject &entry = subscription.pending[moleQueueId];
+      entry = entryChange;
+      if (oldState != Unknown && !removed)
+        entry.insert("oldState", QString(jobStateToString(oldState)));
+    }
+    else if (removed) {
+      it.value() = entryChange;
+    }
+    else {
+      // Coalesce: merge the changes, keeping the state from the start of the
+      // window.
+      QJsonObject &entry = it.value();
+      for (QJsonObject::const_iterator member = entryChange.constBegin(),
+           memberEnd = entryChange.constEnd(); member != memberEnd; ++member) {
+        entry.insert(member.key(), member.value());
+      }
+      if (oldState != Unknown && !entry.contains("oldState"))
+        entry.insert("oldState", QString(jobStateToString(oldState)));
+    }
+  }
+
+  if (changeReady)
+    startFlushTimer();
+}
+
+void JobSubscriptionManager::requestResync(Subscription &subscription)
+{
+  subscription.pending.clear();
+  subscription.reported.clear();
+  subscription.resyncNeeded = true;
+}
+
+void JobSubscriptionManager::startFlushTimer()
+{
+  if (m_flushTimer == 0)
+    m_flushTimer = startTimer(m_coalesceInterval);
+}
+
+} // namespace MoleQueue
@@ -0,0 +1,172 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_JOBSUBSCRIPTIONMANAGER_H
+#define MOLEQUEUE_JOBSUBSCRIPTIONMANAGER_H
+
+#include <QtCore/QObject>
+
+#include "jobfilter.h"
+
+#include <molequeue/servercore/servercoreglobal.h>
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QSet>
+
+namespace MoleQueue
+{
+class Connection;
+class Job;
+class JobManager;
+
+/**
+ * @class JobSubscriptionManager jobsubscriptionmanager.h
+ * <molequeue/jobsubscriptionmanager.h>
+ * @brief Pushes job changes to connections that subscribed to them.
+ *
+ * Any connection may subscribe to the jobs matching a JobFilter,
+ * not only the ones it submitted. Changes are not sent as they happen, but
+ * collected for coalesceInterval() milliseconds: a job that changes several
+ * times in that window is reported once, with its latest state. The changes
+ * are then sent as a single "jobsChanged" notification per subscription:
+~~~{.js}
+{
+  "jsonrpc": "2.0",
+  "method": "jobsChanged",
+  "params": {
+    "subscriptionId": 1,
+    "jobs": [ { "moleQueueId": 17, "oldState": "Submitted",
+                "jobState": "RunningRemote" }, ... ]
+  }
+}
+~~~
+ * The first entry a subscription gets for a job is its full
+ * Job::toJsonObject(). After that, entries only carry "moleQueueId" and the
+ * members that changed; members that no longer exist are null. A job that
+ * leaves the subscription's filter and later matches again is sent in full
+ * again. Entries also hold the state the job had before the window
+ * ("oldState") when it changed. Removed jobs are reported as
+ * { "moleQueueId": id, "removed": true }.
+ *
+ * At most maxPendingJobs() jobs are buffered per subscription, and nothing
+ * is sent to a connection while more than maxUnsentBytes() are waiting to
+ * be written to it. When a slow or busy client exceeds either bound, the
+ * buffered changes are discarded and, once it has caught up, the next
+ * notification only carries "resyncNeeded": true, telling the client to
+ * look the jobs up again.
+ */
+class JobSubscriptionManager : public QObject
+{
+  Q_OBJECT
+public:
+  explicit JobSubscriptionManager(JobManager *jobManager,
+                                  QObject *parentObject = 0);
+  ~JobSubscriptionManager();
+
+  /**
+   * Add a subscription.
+   * @param connection The connection to notify.
+   * @param endpoint The endpoint on @a connection to notify.
+   * @param filter Selects the jobs to report.
+   * @return The id of the new subscription.
+   */
+  IdType subscribe(Connection *connection, const EndpointIdType &endpoint,
+                   const JobFilter &filter);
+
+  /**
+   * Remove the subscription @a subscriptionId owned by @a connection.
+   * @return True if the subscription existed.
+   */
+  bool unsubscribe(Connection *connection, IdType subscriptionId);
+
+  /// Remove all subscriptions owned by @a connection.
+  void removeConnection(Connection *connection);
+
+  /// Remove all subscriptions.
+  void clear();
+
+  /// @return The number of subscriptions.
+  int subscriptionCount() const { return m_subscriptions.size(); }
+
+  /// The time in milliseconds during which changes are collected before
+  /// they are sent. Default: 250.
+  int coalesceInterval() const { return m_coalesceInterval; }
+  void setCoalesceInterval(int msecs);
+
+  /// The number of changed jobs buffered per subscription before it is
+  /// marked as needing a resync. Default: 1000.
+  int maxPendingJobs() const { return m_maxPendingJobs; }
+  void setMaxPendingJobs(int jobs);
+
+  /// The number of bytes that may wait to be written to a connection before
+  /// its subscriptions are held back and marked as needing a resync.
+  /// Default: 1 MiB.
+  qint64 maxUnsentBytes() const { return m_maxUnsentBytes; }
+  void setMaxUnsentBytes(qint64 bytes);
+
+public slots:
+  /// Send all pending notifications now.
+  void flush();
+
+protected:
+  void timerEvent(QTimerEvent *e);
+
+private slots:
+  void jobAdded(const MoleQueue::Job &job);
+  void jobStateChanged(const MoleQueue::Job &job, MoleQueue::JobState oldState,
+                       MoleQueue::JobState newState);
+  void jobUpdated(const MoleQueue::Job &job);
+  void jobAboutToBeRemoved(const MoleQueue::Job &job);
+
+private:
+  struct Subscription
+  {
+    IdType id;
+    Connection *connection;
+    EndpointIdType endpoint;
+    JobFilter filter;
+    /// moleQueueId --> latest change in the current window.
+    QMap<IdType, QJsonObject> pending;
+    /// Jobs that were sent in full, and are only sent as changes since.
+    QSet<IdType> reported;
+    bool resyncNeeded;
+  };
+
+  /// Record the change of @a job for all matching subscriptions.
+  /// @a oldState is Unknown if the state did not change.
+  void addChange(const Job &job, JobState oldState, bool removed);
+  void startFlushTimer();
+  /// Drop the buffered changes of @a subscription and have it resync.
+  static void requestResync(Subscription &subscription);
+
+  JobManager *m_jobManager;
+  QList<Subscription> m_subscriptions;
+  /// moleQueueId --> the job as last sent to any subscription, which changes
+  /// are computed against.
+  QHash<IdType, QJsonObject> m_lastSent;
+  IdType m_subscriptionIdCounter;
+  int m_coalesceInterval;
+  int m_maxPendingJobs;
+  qint64 m_maxUnsentBytes;
+  int m_flushTimer;
+};
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_JOBSUBSCRIPTIONMANAGER_H
@@ -0,0 +1,45 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "jobsummary.h"
+
+#include "jobdata.h"
+
+namespace MoleQueue
+{
+
+JobSummary::JobSummary()
+  : moleQueueId(InvalidId),
+    queueId(InvalidId),
+    numberOfCores(0),
+    jobState(Unknown),
+    hideFromGui(false)
+{
+}
+
+JobSummary::JobSummary(const JobData &jobdata)
+  : moleQueueId(jobdata.moleQueueId()),
+    description(jobdata.description()),
+    queue(jobdata.queue()),
+    queueId(jobdata.queueId()),
+    program(jobdata.program()),
+    numberOfCores(jobdata.numberOfCores()),
+    jobState(jobdata.jobState()),
+    hideFromGui(jobdata.hideFromGui())
+{
+}
+
+} // namespace MoleQueue
@@ -0,0 +1,60 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_JOBSUMMARY_H
+#define MOLEQUEUE_JOBSUMMARY_H
+
+#include "molequeueglobal.h"
+
+#include <QtCore/QList>
+#include <QtCore/QMetaType>
+#include <QtCore/QString>
+
+namespace MoleQueue
+{
+class JobData;
+
+/**
+ * @class JobSummary jobsummary.h <molequeue/jobsummary.h>
+ * @brief A copy of the job details shown in the GUI.
+ *
+ * Unlike Job, a JobSummary does not refer to the JobManager, so it can be
+ * passed to and read by other threads.
+ * @sa JobManager::jobsChanged()
+ */
+class JobSummary
+{
+public:
+  JobSummary();
+  explicit JobSummary(const JobData &jobdata);
+
+  IdType moleQueueId;
+  QString description;
+  QString queue;
+  IdType queueId;
+  QString program;
+  int numberOfCores;
+  JobState jobState;
+  bool hideFromGui;
+};
+
+} // namespace MoleQueue
+
+Q_DECLARE_METATYPE(MoleQueue::JobSummary)
+Q_DECLARE_METATYPE(QList<MoleQueue::JobSummary>)
+Q_DECLARE_METATYPE(QList<MoleQueue::IdType>)
+
+#endif // MOLEQUEUE_JOBSUMMARY_H
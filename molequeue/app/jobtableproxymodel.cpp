@@ -17,14 +17,16 @@
 #include "jobtableproxymodel.h"
 
 #include "jobitemmodel.h"
-#include "job.h"
 
+#include <QtCore/QRegExp>
 #include <QtCore/QSettings>
+#include <QtCore/QStringList>
 
 namespace MoleQueue {
 
 JobTableProxyModel::JobTableProxyModel(QObject *parent_) :
-  QSortFilterProxyModel(parent_)
+  QSortFilterProxyModel(parent_),
+  m_jobItemModel(NULL)
 {
   connect(this, SIGNAL(rowsInserted(QModelIndex, int, int)),
           this, SIGNAL(rowCountChanged()));
@@ -54,6 +56,8 @@ JobTableProxyModel::JobTableProxyModel(QObject *parent_) :
 
   settings.endGroup(); // filter
   settings.endGroup(); // jobTable
+
+  updateFilterTerms();
 }
 
 JobTableProxyModel::~JobTableProxyModel()
@@ -61,12 +65,19 @@ JobTableProxyModel::~JobTableProxyModel()
   saveState();
 }
 
+void JobTableProxyModel::setSourceModel(QAbstractItemModel *sourceModel_)
+{
+  m_jobItemModel = qobject_cast<JobItemModel*>(sourceModel_);
+  QSortFilterProxyModel::setSourceModel(sourceModel_);
+}
+
 void JobTableProxyModel::setFilterString(const QString &str)
 {
   if (m_filterString == str)
     return;
 
   m_filterString = str;
+  updateFilterTerms();
   saveState();
   invalidateFilter();
 }
@@ -154,89 +165,68 @@ void JobTableProxyModel::setShowHiddenJobs(bool show)
 bool JobTableProxyModel::filterAcceptsRow(int sourceRow,
                                           const QModelIndex &sourceParent) const
 {
-  QModelIndex sourceIndex = sourceModel()->index(sourceRow, 0, sourceParent);
-  Job job = static_cast<JobItemModel*>(sourceModel())->data(
-        sourceIndex, JobItemModel::FetchJobRole).value<Job>();
+  if (!m_jobItemModel || sourceParent.isValid() || sourceRow < 0 ||
+      sourceRow >= m_jobItemModel->rowCount()) {
+    return false;
+  }
 
-  if (!job.isValid())
+  if (!acceptsState(m_jobItemModel->jobState(sourceRow),
+                    m_jobItemModel->hideFromGui(sourceRow))) {
     return false;
+  }
+
+  const QString &text = m_jobItemModel->filterText(sourceRow);
+  foreach (const FilterTerm &term, m_filterTerms) {
+    // If the term matches in a negated search or vice-versa, the row is
+    // not shown
+    if (text.contains(term.text) == term.negated)
+      return false;
+  }
+
+  return true;
+}
 
-  if (job.hideFromGui() && !m_showHiddenJobs)
+bool JobTableProxyModel::acceptsState(JobState state, bool hideFromGui) const
+{
+  if (!m_showHiddenJobs && hideFromGui)
     return false;
 
-  switch (job.jobState()) {
+  switch (state) {
   case Unknown:
   case None:
   case Accepted:
-    if (!m_showStatusNew)
-      return false;
-    break;
+    return m_showStatusNew;
   case QueuedLocal:
   case QueuedRemote:
-    if (!m_showStatusQueued)
-      return false;
-    break;
+    return m_showStatusQueued;
   case Submitted:
-    if (!m_showStatusSubmitted)
-      return false;
-    break;
+    return m_showStatusSubmitted;
   case RunningLocal:
   case RunningRemote:
-    if (!m_showStatusRunning)
-      return false;
-    break;
+    return m_showStatusRunning;
   case Finished:
-    if (!m_showStatusFinished)
-      return false;
-    break;
+    return m_showStatusFinished;
   case Canceled:
-    if (!m_showStatusCanceled)
-      return false;
-    break;
+    return m_showStatusCanceled;
   case Error:
-    if (!m_showStatusError)
-      return false;
-    break;
+    return m_showStatusError;
   default:
-    break;
+    return true;
   }
+}
 
-  if (!m_filterString.isEmpty()) {
-    QStringList filterTerms = m_filterString.split(QRegExp("\\s+"),
-                                                   QString::SkipEmptyParts);
-    foreach (QString fullTerm, filterTerms) {
-      bool termMatch = false;
-      bool isNegated = false;
-
-      QStringRef term(&fullTerm);
-      // terms starting with '-' should not be present
-      if (term.startsWith('-')) {
-        isNegated = true;
-        term = fullTerm.midRef(1);
-      }
-
-      for (int i = 0; i < static_cast<int>(sourceModel()->columnCount()); ++i) {
-        const QVariant disp = sourceModel()->data(
-              sourceModel()->index(sourceRow, i), Qt::DisplayRole);
-        if (disp.canConvert(QVariant::String)) {
-          if (disp.toString().contains(term, Qt::CaseInsensitive)) {
-            termMatch = true;
-            break;
-          } // end if string matches
-        } // end if variant is string
-      } // end foreach column
-
-      // If the term matches in a negated search or vice-versa, the row is
-      // not shown
-      if (termMatch == isNegated)
-        return false;
-
-    } // end foreach term
-
-
-  } // end if filter string exists
-
-  return true;
+void JobTableProxyModel::updateFilterTerms()
+{
+  m_filterTerms.clear();
+  const QStringList words = m_filterString.split(QRegExp("\\s+"),
+                                                 QString::SkipEmptyParts);
+  foreach (const QString &word, words) {
+    FilterTerm term;
+    // terms starting with '-' should not be present
+    term.negated = word.startsWith('-');
+    term.text = (term.negated ? word.mid(1) : word).toLower();
+    m_filterTerms << term;
+  }
 }
 
 void JobTableProxyModel::saveState() const
@@ -19,9 +19,20 @@
 
 #include <QtCore/QSortFilterProxyModel>
 
-namespace MoleQueue {
+#include "molequeueglobal.h"
+
+#include <QtCore/QList>
 
-/// @brief Filtering item model for the JobTableWidget job list.
+namespace MoleQueue {
+class JobItemModel;
+
+/**
+ * @brief Filtering item model for the JobTableWidget job list.
+ *
+ * The source model must be a JobItemModel. Rows are filtered on its cached
+ * job state and JobItemModel::filterText, and the filter string is split into
+ * terms once, when it is set.
+ */
 class JobTableProxyModel : public QSortFilterProxyModel
 {
   Q_OBJECT
@@ -29,6 +40,8 @@ public:
   explicit JobTableProxyModel(QObject *parent_ = 0);
   ~JobTableProxyModel();
 
+  void setSourceModel(QAbstractItemModel *sourceModel_);
+
   QString filterString() const { return m_filterString; }
   bool showStatusNew() const { return m_showStatusNew; }
   bool showStatusSubmitted() const { return m_showStatusSubmitted; }
@@ -62,6 +75,23 @@ protected:
   void saveState() const;
 
 private:
+  /// A word of the filter string.
+  struct FilterTerm
+  {
+    /// Lower case.
+    QString text;
+    /// The term started with '-': rows containing it are hidden.
+    bool negated;
+  };
+
+  /// Split m_filterString into m_filterTerms.
+  void updateFilterTerms();
+
+  /// @return True if the row passes the status and hidden job filters.
+  bool acceptsState(JobState state, bool hideFromGui) const;
+
+  JobItemModel *m_jobItemModel;
+  QList<FilterTerm> m_filterTerms;
   QString m_filterString;
   bool m_showStatusNew;
   bool m_showStatusSubmitted;
@@ -21,6 +21,7 @@
 #include "jobmanager.h"
 #include "jobitemmodel.h"
 #include "jobtableproxymodel.h"
+#include "serverthread.h"
 
 #include <QtWidgets/QMessageBox>
 
@@ -31,6 +32,7 @@ JobTableWidget::JobTableWidget(QWidget *parentObject) :
   QWidget(parentObject),
   ui(new Ui::JobTableWidget),
   m_jobManager(NULL),
+  m_itemModel(new JobItemModel(this)),
   m_proxyModel(new JobTableProxyModel (this)),
   m_filterDialog(NULL)
 {
@@ -38,7 +40,10 @@ JobTableWidget::JobTableWidget(QWidget *parentObject) :
 
   connect(m_proxyModel, SIGNAL(rowCountChanged()),
           this, SLOT(modelRowCountChanged()));
+  connect(m_itemModel, SIGNAL(rowCountChanged()),
+          this, SLOT(modelRowCountChanged()));
 
+  m_proxyModel->setSourceModel(m_itemModel);
   ui->table->setModel(m_proxyModel);
   ui->table->setSortingEnabled(true);
 
@@ -61,15 +66,8 @@ void JobTableWidget::setJobManager(MoleQueue::JobManager *jobMan)
   if (jobMan == m_jobManager)
     return;
 
-  if (m_jobManager) {
-    disconnect(m_jobManager->itemModel(), SIGNAL(rowCountChanged()),
-               this, SLOT(modelRowCountChanged()));
-  }
-
   m_jobManager = jobMan;
-  connect(m_jobManager->itemModel(), SIGNAL(rowCountChanged()),
-          this, SLOT(modelRowCountChanged()));
-  m_proxyModel->setSourceModel(jobMan->itemModel());
+  m_itemModel->setJobManager(jobMan);
   m_proxyModel->setDynamicSortFilter(true);
 
   for (int i = 0; i < m_proxyModel->columnCount(); ++i) {
@@ -91,9 +89,14 @@ void JobTableWidget::clearFinishedJobs()
   if (!m_jobManager)
     return;
 
-  QList<Job> finishedJobs =
-      m_jobManager->jobsWithJobState(MoleQueue::Finished);
-  finishedJobs.append(m_jobManager->jobsWithJobState(MoleQueue::Canceled));
+  QList<IdType> finishedJobs;
+  {
+    ServerThreadLocker locker(m_jobManager);
+    QList<Job> jobs = m_jobManager->jobsWithJobState(MoleQueue::Finished);
+    jobs.append(m_jobManager->jobsWithJobState(MoleQueue::Canceled));
+    foreach (const Job &job, jobs)
+      finishedJobs << job.moleQueueId();
+  }
 
   QMessageBox::StandardButton confirm =
       QMessageBox::question(this, tr("Really remove jobs?"),
@@ -105,7 +108,9 @@ void JobTableWidget::clearFinishedJobs()
   if (confirm != QMessageBox::Yes)
     return;
 
-  m_jobManager->removeJobs(finishedJobs);
+  // Runs in the JobManager's thread.
+  QMetaObject::invokeMethod(m_jobManager, "removeJobs",
+                            Q_ARG(QList<IdType>, finishedJobs));
 }
 
 void JobTableWidget::showFilterBar(bool visible)
@@ -143,8 +148,7 @@ void JobTableWidget::updateFilters()
 void JobTableWidget::modelRowCountChanged()
 {
   if (m_jobManager)
-    emit jobCountsChanged(m_jobManager->itemModel()->rowCount(),
-                          m_proxyModel->rowCount());
+    emit jobCountsChanged(m_itemModel->rowCount(), m_proxyModel->rowCount());
 }
 
 } // end namespace MoleQueue
@@ -28,6 +28,7 @@ namespace MoleQueue
 class AdvancedFilterDialog;
 class Job;
 class JobActionFactory;
+class JobItemModel;
 class JobManager;
 class JobTableProxyModel;
 
@@ -65,6 +66,7 @@ protected:
 
   Ui::JobTableWidget *ui;
   JobManager *m_jobManager;
+  JobItemModel *m_itemModel;
   JobTableProxyModel *m_proxyModel;
   AdvancedFilterDialog *m_filterDialog;
 };
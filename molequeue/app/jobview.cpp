@@ -21,6 +21,7 @@
 #include "jobactionfactory.h"
 #include "jobitemmodel.h"
 #include "jobtableproxymodel.h"
+#include "serverthread.h"
 
 #include <QtGui/QContextMenuEvent>
 #include <QtGui/QDesktopServices>
@@ -43,6 +44,15 @@ JobView::~JobView()
 }
 
 void JobView::contextMenuEvent(QContextMenuEvent *e)
+{
+  QMenu *menu = new QMenu(this);
+  addJobActions(menu, e->pos());
+  // The server thread is only paused while the menu is filled, not while it
+  // or the dialogs of its actions are shown.
+  menu->exec(QCursor::pos());
+}
+
+void JobView::addJobActions(QMenu *menu, const QPoint &pos)
 {
   // list of action factories. Map to sort by usefulness
   QMap<unsigned int, JobActionFactory*> factoryMap;
@@ -52,16 +62,22 @@ void JobView::contextMenuEvent(QContextMenuEvent *e)
     factoryMap.insertMulti(factory->usefulness(), factory);
   }
 
+  // The factories read the jobs.
+  JobItemModel *sourceModel = NULL;
+  if (JobTableProxyModel *proxyModel =
+      qobject_cast<JobTableProxyModel*>(model())) {
+    sourceModel = qobject_cast<JobItemModel*>(proxyModel->sourceModel());
+  }
+  ServerThreadLocker locker(sourceModel ? sourceModel->jobManager() : NULL);
+
   // Get job under cursor
   Job cursorJob =
-      model()->data(indexAt(e->pos()),
+      model()->data(indexAt(pos),
                     JobItemModel::FetchJobRole).value<Job>();
 
   // Get selected jobs
   QList<Job> jobs = selectedJobs();
 
-  QMenu *menu = new QMenu(this);
-
   // Factories sorted by usefulness:
   QList<JobActionFactory*> factories = factoryMap.values();
 
@@ -91,8 +107,6 @@ void JobView::contextMenuEvent(QContextMenuEvent *e)
       }
     }
   }
-
-  menu->exec(QCursor::pos());
 }
 
 QList<Job> JobView::selectedJobs()
@@ -19,6 +19,8 @@
 
 #include <QtWidgets/QTableView>
 
+class QMenu;
+
 namespace MoleQueue
 {
 class Job;
@@ -35,7 +37,13 @@ public:
   /** Custom context menu for this view. */
   void contextMenuEvent(QContextMenuEvent *e);
 
+  /** The selected jobs. Hold a ServerThreadLocker while using them. */
   QList<Job> selectedJobs();
+
+private:
+  /** Add the actions of the job action factories for the selected jobs and
+   * the job at @a pos to @a menu. */
+  void addJobActions(QMenu *menu, const QPoint &pos);
 };
 
 } // End of namespace
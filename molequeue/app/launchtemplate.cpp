@@ -0,0 +1,181 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "launchtemplate.h"
+
+namespace MoleQueue
+{
+
+/// Keyword values are expanded recursively up to this depth, which guards
+/// against values that refer to each other.
+static const int maxExpansionDepth = 8;
+
+LaunchTemplate::LaunchTemplate()
+{
+}
+
+LaunchTemplate::LaunchTemplate(const QString &source)
+  : m_source(source)
+{
+  parse();
+}
+
+void LaunchTemplate::setSource(const QString &source)
+{
+  m_source = source;
+  parse();
+}
+
+QString LaunchTemplate::render(const QHash<QString, QString> &keywords,
+                               const QHash<QString, QString> &lineKeywords,
+                               QStringList *unhandled) const
+{
+  QString result;
+  result.reserve(m_source.size() + m_source.size() / 2);
+  renderTo(result, keywords, lineKeywords, unhandled, 0);
+  return result;
+}
+
+void LaunchTemplate::parse()
+{
+  m_tokens.clear();
+
+  const QChar dollar('$');
+  const int size = m_source.size();
+  int textStart = 0;
+  int pos = 0;
+  while ((pos = m_source.indexOf(QLatin1String("$$"), pos)) != -1) {
+    int nameStart = pos;
+    while (nameStart < size && m_source.at(nameStart) == dollar)
+      ++nameStart;
+    int nameEnd = nameStart;
+    while (nameEnd < size && m_source.at(nameEnd) != dollar &&
+           !m_source.at(nameEnd).isSpace()) {
+      ++nameEnd;
+    }
+    int closeEnd = nameEnd;
+    while (closeEnd < size && m_source.at(closeEnd) == dollar)
+      ++closeEnd;
+
+    // Not a keyword, e.g. the shell's "$$".
+    if (nameEnd == nameStart || closeEnd - nameEnd < 2) {
+      pos = nameEnd;
+      continue;
+    }
+
+    // Surplus '$' on either side are literal text.
+    int delimiter = (nameStart - pos >= 3 && closeEnd - nameEnd >= 3) ? 3 : 2;
+    int keywordStart = nameStart - delimiter;
+    int keywordEnd = nameEnd + delimiter;
+
+    appendText(m_source.mid(textStart, keywordStart - textStart));
+    m_tokens.append(Token(delimiter == 3 ? Token::LineKeyword : Token::Keyword,
+                          m_source.mid(keywordStart, keywordEnd - keywordStart),
+                          m_source.mid(nameStart, nameEnd - nameStart)));
+    textStart = pos = keywordEnd;
+  }
+
+  appendText(m_source.mid(textStart));
+}
+
+void LaunchTemplate::appendText(const QString &text)
+{
+  if (text.isEmpty())
+    return;
+
+  if (!m_tokens.isEmpty() && m_tokens.last().type == Token::Text)
+    m_tokens.last().text.append(text);
+  else
+    m_tokens.append(Token(Token::Text, text));
+}
+
+void LaunchTemplate::renderTo(QString &out,
+                              const QHash<QString, QString> &keywords,
+                              const QHash<QString, QString> &lineKeywords,
+                              QStringList *unhandled, int depth) const
+{
+  const int numTokens = m_tokens.size();
+  for (int i = 0; i < numTokens; ++i) {
+    const Token &token = m_tokens[i];
+    switch (token.type) {
+    case Token::Text:
+      out.append(token.text);
+      break;
+    case Token::Keyword: {
+      QHash<QString, QString>::const_iterator value =
+          keywords.constFind(token.name);
+      if (value == keywords.constEnd()) {
+        if (unhandled)
+          unhandled->append(token.text);
+        break;
+      }
+      appendValue(out, value.value(), keywords, lineKeywords, unhandled, depth);
+      break;
+    }
+    case Token::LineKeyword: {
+      QHash<QString, QString>::const_iterator value =
+          lineKeywords.constFind(token.name);
+      if (value == lineKeywords.constEnd()) {
+        if (unhandled)
+          unhandled->append(token.text);
+        break;
+      }
+      if (!value.value().isNull()) {
+        appendValue(out, value.value(), keywords, lineKeywords, unhandled,
+                    depth);
+        break;
+      }
+
+      // Remove the line: drop its beginning from the output, and skip the
+      // tokens up to and including the next newline.
+      out.truncate(out.lastIndexOf(QLatin1Char('\n')) + 1);
+      for (++i; i < numTokens; ++i) {
+        if (m_tokens[i].type != Token::Text)
+          continue;
+        int newline = m_tokens[i].text.indexOf(QLatin1Char('\n'));
+        if (newline != -1) {
+          out.append(m_tokens[i].text.mid(newline + 1));
+          break;
+        }
+      }
+      break;
+    }
+    }
+  }
+}
+
+void LaunchTemplate::appendValue(QString &out, const QString &value,
+                                 const QHash<QString, QString> &keywords,
+                                 const QHash<QString, QString> &lineKeywords,
+                                 QStringList *unhandled, int depth) const
+{
+  if (!value.contains(QLatin1String("$$"))) {
+    out.append(value);
+    return;
+  }
+
+  // Past the depth limit, only strip the remaining keywords.
+  LaunchTemplate nested(value);
+  if (depth < maxExpansionDepth) {
+    nested.renderTo(out, keywords, lineKeywords, unhandled, depth + 1);
+  }
+  else {
+    nested.renderTo(out, QHash<QString, QString>(), QHash<QString, QString>(),
+                    unhandled, depth + 1);
+  }
+}
+
+} // namespace MoleQueue
@@ -0,0 +1,114 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_LAUNCHTEMPLATE_H
+#define MOLEQUEUE_LAUNCHTEMPLATE_H
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+namespace MoleQueue
+{
+
+/**
+ * @class LaunchTemplate launchtemplate.h <molequeue/launchtemplate.h>
+ * @brief A launch script template, parsed once and rendered many times.
+ *
+ * The template text is split into literal text and keyword tokens when it is
+ * set. render() then produces the script for a set of keyword values in a
+ * single pass over the tokens.
+ *
+ * Keywords are written as $$name$$ or $$$name$$$:
+ * - $$name$$ is replaced by the value of "name" in the keyword hash.
+ * - $$$name$$$ is replaced by the value of "name" in the line keyword hash.
+ *   If that value is a null QString, the entire line containing the keyword
+ *   is removed instead (e.g. $$$maxWallTime$$$ when no walltime is set).
+ *
+ * Values that contain keywords themselves are expanded recursively, so that
+ * e.g. an outputFileName of "$$inputFileBaseName$$.out" works. Keywords that
+ * have no value are removed from the output and reported to the caller.
+ */
+class LaunchTemplate
+{
+public:
+  /// Create an empty template.
+  LaunchTemplate();
+
+  /// Create a template from the text @a source.
+  explicit LaunchTemplate(const QString &source);
+
+  /// Replace the template text with @a source and parse it.
+  void setSource(const QString &source);
+
+  /// @return The template text.
+  QString source() const { return m_source; }
+
+  /// @return True if the template text is empty.
+  bool isEmpty() const { return m_source.isEmpty(); }
+
+  /**
+   * Render the template.
+   * @param keywords Values of the $$keyword$$ keywords.
+   * @param lineKeywords Values of the $$$keyword$$$ keywords. A null value
+   * removes the line containing the keyword.
+   * @param unhandled If not NULL, the keywords without a value (including
+   * their '$' delimiters) are appended to this list.
+   * @return The rendered script.
+   */
+  QString render(const QHash<QString, QString> &keywords,
+                 const QHash<QString, QString> &lineKeywords =
+                   QHash<QString, QString>(),
+                 QStringList *unhandled = NULL) const;
+
+private:
+  struct Token
+  {
+    enum Type {
+      Text = 0,
+      Keyword,
+      LineKeyword
+    };
+
+    Token(Type type_ = Text, const QString &text_ = QString(),
+          const QString &name_ = QString())
+      : type(type_), text(text_), name(name_) {}
+
+    Type type;
+    /// The literal text, or the full keyword including delimiters.
+    QString text;
+    /// Keyword name (without delimiters).
+    QString name;
+  };
+
+  void parse();
+  void appendText(const QString &text);
+  void renderTo(QString &out, const QHash<QString, QString> &keywords,
+                const QHash<QString, QString> &lineKeywords,
+                QStringList *unhandled, int depth) const;
+  void appendValue(QString &out, const QString &value,
+                   const QHash<QString, QString> &keywords,
+                   const QHash<QString, QString> &lineKeywords,
+                   QStringList *unhandled, int depth) const;
+
+  QString m_source;
+  QVector<Token> m_tokens;
+};
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_LAUNCHTEMPLATE_H
@@ -20,6 +20,7 @@
 #include "molequeueglobal.h"
 
 #include <QtCore/QDateTime>
+#include <QtCore/QMetaType>
 #include <QtCore/QString>
 
 class QJsonObject;
@@ -133,4 +134,6 @@ private:
 
 } // namespace MoleQueue
 
+Q_DECLARE_METATYPE(MoleQueue::LogEntry)
+
 #endif // MOLEQUEUE_LOGENTRY_H
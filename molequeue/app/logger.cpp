@@ -21,11 +21,13 @@
 #include <QtCore/QDir>
 #include <QtCore/QDebug>
 #include <QtCore/QFile>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRegExp>
 #include <QtCore/QSettings>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
-#include <QtWidgets/QApplication>
+#include <QtCore/QCoreApplication>
 
 namespace MoleQueue {
 
@@ -36,140 +38,371 @@ Logger::Logger() :
   m_printNotifications(false),
   m_printWarnings(false),
   m_printErrors(false),
-  m_maxEntries(1000),
+  m_logLevel(LogEntry::DebugMessage),
+  m_suppressedCount(0),
   m_newErrorCount(0),
   m_silenceNewErrors(false),
-  m_logFile(NULL)
+  m_logFile(NULL),
+  m_logGeneration(0),
+  m_firstLogGeneration(0),
+  m_maxLogFileSize(1024 * 1024),
+  m_maxLogFiles(5),
+  m_log(1000),
+  m_logPositions(1000)
 {
+  qRegisterMetaType<LogEntry>("MoleQueue::LogEntry");
+
   // Call destructor when program exits
-  connect(QApplication::instance(), SIGNAL(aboutToQuit()), SLOT(cleanUp()));
+  connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), SLOT(cleanUp()));
+
+  QSettings settings;
+  int maxEntries = settings.value("logMaxEntries", 1000).toInt();
+  m_log.setCapacity(maxEntries);
+  m_logPositions.setCapacity(maxEntries);
+  m_logLevel = static_cast<LogEntry::LogEntryType>(
+        settings.value("logLevel", LogEntry::DebugMessage).toInt());
+
+  QString workDir = settings.value("workingDirectoryBase").toString();
+  if (workDir.isEmpty()) {
+    qWarning() << "MoleQueue::Logger::Logger() -- Cannot determine working "
+                  "directory.";
+    return;
+  }
 
-  QFile *lfile = logFile();
+  m_logDirectory = workDir + "/log";
+  openLogFile();
+}
 
-  if (lfile) {
+Logger::~Logger()
+{
+  closeLogFile();
+}
 
-    if (!lfile->open(QFile::ReadOnly | QFile::Text)) {
-      QSettings settings;
-      if (settings.value("logWritten", false).toBool()) {
-        qWarning() << "MoleQueue::Logger::~Logger() -- Cannot open log "
-                      "file " + lfile->fileName() + "; cannot read log.";
-      }
-      return;
-    }
+int Logger::maxEntries()
+{
+  Logger *instance = Logger::getInstance();
+  QMutexLocker locker(&instance->m_mutex);
+  return instance->m_log.capacity();
+}
 
-    QByteArray logData = lfile->readAll();
-    lfile->close();
+QList<LogEntry> Logger::log()
+{
+  Logger *instance = Logger::getInstance();
+  QMutexLocker locker(&instance->m_mutex);
+  return instance->m_log.toList();
+}
 
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(logData, &error);
-    if (error.error != QJsonParseError::NoError) {
-      qWarning() << "MoleQueue::Logger::~Logger() -- Error parsing log file"
-                 << lfile->fileName() << ":" << error.errorString()
-                 << "(at offset" << error.offset << ").";
-      return;
-    }
+void Logger::setMaxEntries(int max)
+{
+  Logger *instance = Logger::getInstance();
+  {
+    QMutexLocker locker(&instance->m_mutex);
+    instance->m_log.setCapacity(max);
+    instance->m_logPositions.setCapacity(max);
+  }
 
-    if (!doc.isObject()) {
-      qWarning() << "MoleQueue::Logger::~Logger() -- Error parsing log file"
-                 << lfile->fileName() << ": Invalid format, expected JSON "
-                    "object at top level.";
-      return;
-    }
+  QSettings settings;
+  settings.setValue("logMaxEntries", max);
+}
 
-    QJsonObject logObject = doc.object();
+void Logger::setLogLevel(LogEntry::LogEntryType level)
+{
+  Logger::getInstance()->m_logLevel = level;
 
-    if (logObject.value("maxEntries").isDouble()) {
-      m_maxEntries =
-          static_cast<int>(logObject.value("maxEntries").toDouble() + 0.5);
-    }
+  QSettings settings;
+  settings.setValue("logLevel", static_cast<int>(level));
+}
 
-    if (logObject.value("entries").isArray()) {
-      const QJsonArray &entries = logObject.value("entries").toArray();
-      foreach (QJsonValue val, entries) {
-        if (val.isObject())
-          m_log.push_back(LogEntry(val.toObject()));
-      }
+void Logger::setLogDirectory(const QString &dir)
+{
+  Logger *instance = Logger::getInstance();
+  QMutexLocker locker(&instance->m_mutex);
+  instance->m_logDirectory = dir;
+  instance->openLogFile();
+}
+
+void Logger::clear()
+{
+  Logger *instance = Logger::getInstance();
+  QMutexLocker locker(&instance->m_mutex);
+  instance->closeLogFile();
+  if (!instance->m_logDirectory.isEmpty()) {
+    for (int generation = instance->m_firstLogGeneration;
+         generation <= instance->m_logGeneration; ++generation) {
+      QFile::remove(instance->logFilePath(generation));
     }
-  } // end if (lfile)
+  }
+  instance->openLogFile();
 }
 
-Logger::~Logger()
+LogFilePosition Logger::oldestPosition()
 {
-  QFile *lfile = logFile();
+  Logger *instance = Logger::getInstance();
+  QMutexLocker locker(&instance->m_mutex);
+  if (!instance->m_logPositions.isEmpty())
+    return instance->m_logPositions.first();
+  if (instance->m_logFile)
+    return LogFilePosition(instance->m_logGeneration);
+  return LogFilePosition();
+}
 
-  if (lfile) {
+QList<LogEntry> Logger::readOlderEntries(LogFilePosition &position, int count)
+{
+  Logger *instance = Logger::getInstance();
+  QMutexLocker locker(&instance->m_mutex);
+  return instance->readEntriesBefore(position, count, NULL);
+}
 
-    if (!lfile->open(QFile::WriteOnly | QFile::Text | QFile::Truncate)) {
-      qWarning() << "MoleQueue::Logger::~Logger() -- Cannot create log "
-                    "file" + lfile->fileName() + "; cannot save log.";
-      return;
-    }
+void Logger::openLogFile()
+{
+  closeLogFile();
+  m_log.clear();
+  m_logPositions.clear();
+  m_logGeneration = 0;
+  m_firstLogGeneration = 0;
+
+  if (m_logDirectory.isEmpty())
+    return;
 
-    QJsonObject root;
-    root.insert("maxEntries", static_cast<double>(m_maxEntries));
+  QDir logDir(m_logDirectory);
+  if (!logDir.exists() && !logDir.mkpath(logDir.absolutePath())) {
+    qWarning() << "MoleQueue::Logger -- Cannot create log directory"
+               << logDir.absolutePath() << "; the log will not be saved.";
+    return;
+  }
+
+  // Find the existing log files.
+  QRegExp fileNameExpr("^log-(\\d+)\\.jsonl$");
+  bool found = false;
+  foreach (const QString &fileName,
+           logDir.entryList(QStringList("log-*.jsonl"), QDir::Files)) {
+    if (!fileNameExpr.exactMatch(fileName))
+      continue;
+    int generation = fileNameExpr.cap(1).toInt();
+    if (!found || generation > m_logGeneration)
+      m_logGeneration = generation;
+    if (!found || generation < m_firstLogGeneration)
+      m_firstLogGeneration = generation;
+    found = true;
+  }
 
-    QJsonArray entriesArray;
-    foreach(const LogEntry &entry, m_log) {
-      QJsonObject entryObject;
-      entry.writeSettings(entryObject);
-      entriesArray.append(entryObject);
+  m_logFile = new QFile(logFilePath(m_logGeneration));
+  if (!m_logFile->open(QFile::WriteOnly | QFile::Append)) {
+    qWarning() << "MoleQueue::Logger -- Cannot open log file"
+               << m_logFile->fileName() << "; the log will not be saved.";
+    delete m_logFile;
+    m_logFile = NULL;
+    return;
+  }
+
+  // Terminate a line left incomplete by a crash.
+  if (m_logFile->size() > 0) {
+    QFile check(m_logFile->fileName());
+    if (check.open(QFile::ReadOnly) && check.seek(check.size() - 1) &&
+        check.read(1) != "\n") {
+      m_logFile->write("\n");
+      m_logFile->flush();
     }
-    root.insert("entries", entriesArray);
+  }
 
-    lfile->write(QJsonDocument(root).toJson());
-    lfile->close();
+  importLegacyLog();
 
-    QSettings settings;
-    settings.setValue("logWritten", true);
-  } // end if (lfile)
+  // Load the tail of the log.
+  LogFilePosition position(m_logGeneration);
+  QList<LogFilePosition> positions;
+  QList<LogEntry> entries = readEntriesBefore(position, m_log.capacity(),
+                                              &positions);
+  for (int i = 0; i < entries.size(); ++i) {
+    m_log.append(entries.at(i));
+    m_logPositions.append(positions.at(i));
+  }
 }
 
-void Logger::resetNewErrorCount()
+void Logger::closeLogFile()
 {
-  Logger *instance = Logger::getInstance();
-  if (instance->m_newErrorCount == 0)
-    return;
+  if (m_logFile) {
+    m_logFile->close();
+    delete m_logFile;
+    m_logFile = NULL;
+  }
+}
 
-  emit instance->newErrorCountReset();
-  instance->m_newErrorCount = 0;
+QString Logger::logFilePath(int generation) const
+{
+  return QString("%1/log-%2.jsonl").arg(m_logDirectory).arg(generation);
 }
 
-void Logger::cleanUp()
+LogFilePosition Logger::writeEntry(const LogEntry &entry)
 {
-  delete m_instance;
-  m_instance = NULL;
+  if (m_logFile && m_logFile->size() >= m_maxLogFileSize)
+    rotateLogFile();
+
+  if (!m_logFile)
+    return LogFilePosition();
+
+  QJsonObject entryObject;
+  entry.writeSettings(entryObject);
+  QByteArray line = QJsonDocument(entryObject).toJson(QJsonDocument::Compact);
+  line.append('\n');
+
+  LogFilePosition position(m_logGeneration, m_logFile->size());
+  if (m_logFile->write(line) != line.size()) {
+    qWarning() << "MoleQueue::Logger -- Cannot write to log file"
+               << m_logFile->fileName();
+    return LogFilePosition();
+  }
+  m_logFile->flush();
+
+  return position;
 }
 
-QFile *Logger::logFile()
+void Logger::rotateLogFile()
 {
-  if (!m_logFile) {
+  closeLogFile();
+  ++m_logGeneration;
+
+  while (m_logGeneration - m_firstLogGeneration + 1 > m_maxLogFiles)
+    QFile::remove(logFilePath(m_firstLogGeneration++));
+
+  m_logFile = new QFile(logFilePath(m_logGeneration));
+  if (!m_logFile->open(QFile::WriteOnly | QFile::Append)) {
+    qWarning() << "MoleQueue::Logger -- Cannot open log file"
+               << m_logFile->fileName() << "; the log will not be saved.";
+    delete m_logFile;
+    m_logFile = NULL;
+  }
+}
+
+void Logger::importLegacyLog()
+{
+  QFile legacyFile(m_logDirectory + "/log.json");
+  if (!legacyFile.exists())
+    return;
+
+  if (!legacyFile.open(QFile::ReadOnly | QFile::Text)) {
+    qWarning() << "MoleQueue::Logger -- Cannot open log file"
+               << legacyFile.fileName() << "; cannot import log.";
+    return;
+  }
+
+  QByteArray logData = legacyFile.readAll();
+  legacyFile.close();
+
+  QJsonParseError error;
+  QJsonDocument doc = QJsonDocument::fromJson(logData, &error);
+  if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+    qWarning() << "MoleQueue::Logger -- Error parsing log file"
+               << legacyFile.fileName() << ":" << error.errorString()
+               << "(at offset" << error.offset << ").";
+    return;
+  }
+
+  QJsonObject logObject = doc.object();
+  if (logObject.value("maxEntries").isDouble()) {
+    int maxEntries =
+        static_cast<int>(logObject.value("maxEntries").toDouble() + 0.5);
+    m_log.setCapacity(maxEntries);
+    m_logPositions.setCapacity(maxEntries);
     QSettings settings;
-    QString workDir = settings.value("workingDirectoryBase").toString();
+    settings.setValue("logMaxEntries", maxEntries);
+  }
 
-    if (workDir.isEmpty()) {
-      qWarning() << "MoleQueue::Logger::~Logger() -- Cannot determine working "
-                    "directory.";
-      return NULL;
+  if (logObject.value("entries").isArray()) {
+    const QJsonArray &entries = logObject.value("entries").toArray();
+    foreach (QJsonValue val, entries) {
+      if (val.isObject())
+        writeEntry(LogEntry(val.toObject()));
     }
+  }
 
-    QDir logDir(workDir + "/log");
-    if (!logDir.exists()) {
-      if (!logDir.mkpath(logDir.absolutePath())) {
-        qWarning() << "MoleQueue::Logger::~Logger() -- Cannot create log "
-                      "directory" + logDir.absolutePath();
-        return NULL;
+  legacyFile.remove();
+}
+
+QList<LogEntry> Logger::readEntriesBefore(LogFilePosition &position,
+                                          int count,
+                                          QList<LogFilePosition> *positions) const
+{
+  // Collected newest first.
+  QList<LogEntry> entries;
+  QList<LogFilePosition> entryPositions;
+  const qint64 blockSize = 64 * 1024;
+
+  while (count > 0 && position.isValid()) {
+    if (m_logDirectory.isEmpty() ||
+        position.generation < m_firstLogGeneration) {
+      position = LogFilePosition();
+      break;
+    }
+
+    QFile file(logFilePath(position.generation));
+    if (!file.open(QFile::ReadOnly)) {
+      position = LogFilePosition(position.generation - 1);
+      continue;
+    }
+
+    // Read the file backwards in blocks. Lines that straddle a block boundary
+    // are carried over in pending.
+    qint64 end = file.size();
+    if (position.offset >= 0)
+      end = qMin(position.offset, end);
+    QByteArray pending;
+    while (count > 0 && end > 0) {
+      qint64 start = qMax(Q_INT64_C(0), end - blockSize);
+      file.seek(start);
+      QByteArray block = file.read(end - start) + pending;
+
+      int lineEnd = block.size();
+      while (count > 0 && lineEnd > 0) {
+        int newline = lineEnd >= 2 ? block.lastIndexOf('\n', lineEnd - 2) : -1;
+        if (newline < 0 && start > 0)
+          break;
+        int lineStart = newline + 1;
+        QJsonDocument doc =
+            QJsonDocument::fromJson(block.mid(lineStart, lineEnd - lineStart));
+        position = LogFilePosition(position.generation, start + lineStart);
+        if (doc.isObject()) {
+          entries.append(LogEntry(doc.object()));
+          entryPositions.append(position);
+          --count;
+        }
+        lineEnd = lineStart;
       }
+
+      pending = block.left(lineEnd);
+      end = start;
     }
 
-    m_logFile = new QFile(logDir.absoluteFilePath("log.json"));
+    // Continue with the previous file.
+    if (count > 0)
+      position = LogFilePosition(position.generation - 1);
   }
 
-  if (m_logFile) {
-    if (m_logFile->isOpen())
-      m_logFile->close();
+  QList<LogEntry> result;
+  for (int i = entries.size() - 1; i >= 0; --i) {
+    result.append(entries.at(i));
+    if (positions)
+      positions->append(entryPositions.at(i));
+  }
+  return result;
+}
+
+void Logger::resetNewErrorCount()
+{
+  Logger *instance = Logger::getInstance();
+  {
+    QMutexLocker locker(&instance->m_mutex);
+    if (instance->m_newErrorCount == 0)
+      return;
+    instance->m_newErrorCount = 0;
   }
 
-  return m_logFile;
+  emit instance->newErrorCountReset();
+}
+
+void Logger::cleanUp()
+{
+  delete m_instance;
+  m_instance = NULL;
 }
 
 Logger *Logger::getInstance()
@@ -180,12 +413,29 @@ Logger *Logger::getInstance()
   return m_instance;
 }
 
+bool Logger::printEnabled(LogEntry::LogEntryType type) const
+{
+  switch (type) {
+  case LogEntry::DebugMessage:
+    return m_printDebugMessages;
+  case LogEntry::Notification:
+    return m_printNotifications;
+  case LogEntry::Warning:
+    return m_printWarnings;
+  case LogEntry::Error:
+    return m_printErrors;
+  }
+  return false;
+}
+
 void Logger::handleNewLogEntry(LogEntry &entry)
 {
   entry.setTimeStamp();
-  m_log.push_back(entry);
-
-  trimLog();
+  {
+    QMutexLocker locker(&m_mutex);
+    m_log.append(entry);
+    m_logPositions.append(writeEntry(entry));
+  }
 
   switch (entry.entryType()) {
   case LogEntry::DebugMessage:
@@ -242,20 +492,16 @@ inline void Logger::handleNewError(const MoleQueue::LogEntry &error)
              << "MoleQueueId: (" << error.moleQueueId() << ")";
   }
 
-  ++m_newErrorCount;
+  int newErrorCount;
+  {
+    QMutexLocker locker(&m_mutex);
+    newErrorCount = ++m_newErrorCount;
+  }
 
   emit newError(error);
 
-  if (!m_silenceNewErrors && m_newErrorCount == 1)
+  if (!m_silenceNewErrors && newErrorCount == 1)
     emit firstNewErrorOccurred();
 }
 
-void Logger::trimLog()
-{
-  if (m_log.size() > m_maxEntries) {
-    m_log.erase(m_log.begin(),
-                m_log.begin() + (m_log.size() - m_maxEntries));
-  }
-}
-
 } // namespace MoleQueue
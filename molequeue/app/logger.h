@@ -20,14 +20,37 @@
 #include <QtCore/QObject>
 
 #include "logentry.h"
+#include "ringbuffer.h"
 
-#include <QtCore/QLinkedList>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
 
 class QFile;
 
 namespace MoleQueue
 {
 
+/**
+ * @class LogFilePosition logger.h <molequeue/logger.h>
+ * @brief Location of an entry in the log files, used to page through the
+ * entries that are no longer held in memory.
+ * @see Logger::readOlderEntries
+ */
+struct LogFilePosition
+{
+  explicit LogFilePosition(int generation_ = -1, qint64 offset_ = -1)
+    : generation(generation_), offset(offset_) {}
+
+  /// @return False if there are no entries before this position.
+  bool isValid() const { return generation >= 0; }
+
+  /// Number of the log file. Larger numbers are newer files.
+  int generation;
+  /// Byte offset of the entry in the file. -1 means the end of the file.
+  qint64 offset;
+};
+
 /**
  * @class Logger logger.h <molequeue/logger.h>
  * @brief Manage log messages.
@@ -52,6 +75,29 @@ namespace MoleQueue
  * one of newDebugMessage, newNotification, newWarning, or newError, depending
  * on the LogEntry type. Details of new log entries will be automatically
  * sent to qDebug() if the print* methods are set to true (false by default).
+ *
+ * Everything is recorded by default. Entries below logLevel() are dropped
+ * unless they are printed to qDebug. Code that builds expensive messages
+ * (e.g. serializing a request) should check isEnabled() first, so that the
+ * formatting is skipped along with the entry:
+ * @code
+ * if (Logger::isEnabled(LogEntry::DebugMessage))
+ *   Logger::logDebugMessage(tr("Request:\n%1").arg(QString(msg.toJson())));
+ * @endcode
+ * Entries passed to the log functions and dropped are counted by
+ * suppressedCount(). Messages skipped by an isEnabled() check are not.
+ *
+ * The most recent maxEntries() entries are kept in memory. Every entry is
+ * also appended to a line-delimited JSON file in the log directory
+ * ([workingDirectoryBase]/log by default) as it is added, so that the log
+ * survives crashes. The files are rotated once they exceed maxLogFileSize(),
+ * and only the newest maxLogFiles() are kept. At startup, only the tail of
+ * the log is loaded; older entries can be read on demand with
+ * readOlderEntries().
+ *
+ * Entries may be added from any thread. The signals are emitted in the
+ * thread that added the entry, so connections to objects in other threads
+ * are queued.
  */
 class Logger : public QObject
 {
@@ -85,9 +131,62 @@ public:
     return Logger::getInstance()->m_printErrors;
   }
 
-  /// @return The maximum number of entries the Logger will track.
+  /// @return The lowest type of entry that is recorded. Default: DebugMessage
+  static LogEntry::LogEntryType logLevel()
+  {
+    return Logger::getInstance()->m_logLevel;
+  }
+
+  /**
+   * @return True if entries of @a type are recorded, i.e. @a type is at or
+   * above logLevel() or is printed to qDebug. Check this before formatting
+   * expensive messages.
+   */
+  static bool isEnabled(LogEntry::LogEntryType type)
+  {
+    Logger *instance = Logger::getInstance();
+    return type >= instance->m_logLevel || instance->printEnabled(type);
+  }
+
+  /// @return The number of entries that were dropped because their type was
+  /// not enabled.
+  static int suppressedCount()
+  {
+    return Logger::getInstance()->m_suppressedCount.load();
+  }
+
+  /// @return The maximum number of entries the Logger will keep in memory.
   /// Default: 1000
-  static int maxEntries() { return Logger::getInstance()->m_maxEntries; }
+  static int maxEntries();
+
+  /// @return The size in bytes above which the log file is rotated.
+  /// Default: 1 MiB
+  static qint64 maxLogFileSize()
+  {
+    return Logger::getInstance()->m_maxLogFileSize;
+  }
+
+  /// @return The number of log files kept on disk. Default: 5
+  static int maxLogFiles() { return Logger::getInstance()->m_maxLogFiles; }
+
+  /// @return The directory holding the log files.
+  static QString logDirectory()
+  {
+    return Logger::getInstance()->m_logDirectory;
+  }
+
+  /// @return The position in the log files of the oldest entry held in
+  /// memory. Pass this to readOlderEntries to page back from there.
+  static LogFilePosition oldestPosition();
+
+  /**
+   * Read up to @a count entries logged before @a position from the log files.
+   * @a position is updated to the position of the oldest entry returned, and
+   * is invalid once the beginning of the log is reached.
+   * @return The entries, oldest first.
+   */
+  static QList<LogEntry> readOlderEntries(LogFilePosition &position,
+                                          int count);
 
   /// @return The number of new errors that have occurred since the last
   /// Logger::resetNewErrors call.
@@ -122,7 +221,10 @@ public slots:
   /// Add @a entry to the log.
   static void logEntry(MoleQueue::LogEntry &entry)
   {
-    Logger::getInstance()->handleNewLogEntry(entry);
+    if (Logger::isEnabled(entry.entryType()))
+      Logger::getInstance()->handleNewLogEntry(entry);
+    else
+      Logger::getInstance()->m_suppressedCount.ref();
   }
 
   /// Add a new log entry to the log.
@@ -191,19 +293,41 @@ public slots:
     Logger::getInstance()->m_printErrors = print;
   }
 
-  /// @return A list of all log entries.
-  static QLinkedList<LogEntry> log() { return Logger::getInstance()->m_log; }
+  /// @param level The lowest type of entry that is recorded.
+  /// Default: DebugMessage
+  static void setLogLevel(MoleQueue::LogEntry::LogEntryType level);
+
+  /// Reset suppressedCount() to zero.
+  static void resetSuppressedCount()
+  {
+    Logger::getInstance()->m_suppressedCount.store(0);
+  }
+
+  /// @return The log entries held in memory, oldest first.
+  static QList<LogEntry> log();
 
-  /// @param max The maximum number of entries the Logger will track.
+  /// @param max The maximum number of entries the Logger will keep in memory.
   /// Default: 1000
-  static void setMaxEntries(int max)
+  static void setMaxEntries(int max);
+
+  /// @param bytes The size above which the log file is rotated.
+  static void setMaxLogFileSize(qint64 bytes)
+  {
+    Logger::getInstance()->m_maxLogFileSize = bytes;
+  }
+
+  /// @param count The number of log files kept on disk.
+  static void setMaxLogFiles(int count)
   {
-    Logger::getInstance()->m_maxEntries = max;
-    Logger::getInstance()->trimLog();
+    Logger::getInstance()->m_maxLogFiles = qMax(1, count);
   }
 
-  /// Remove all entries from the log
-  static void clear() { Logger::getInstance()->m_log.clear(); }
+  /// Use the log files in @a dir. The entries in memory are replaced by the
+  /// tail of the log found there.
+  static void setLogDirectory(const QString &dir);
+
+  /// Remove all entries from the log, including the log files.
+  static void clear();
 
   /// Reset the number of new errors.
   static void resetNewErrorCount();
@@ -221,31 +345,61 @@ protected slots:
 private:
   Logger();
   ~Logger();
-  /// Create and return the log file. When finished, close but do not delete the
-  /// object. If an error occurs, a message is printed to qWarning and NULL is
-  /// returned.
-  QFile *logFile();
   static Logger *m_instance;
 
+  /// Open the newest log file in m_logDirectory for appending and load the
+  /// tail of the log into memory. If an error occurs, a message is printed to
+  /// qWarning and the log is only kept in memory.
+  void openLogFile();
+  void closeLogFile();
+  /// @return The path of the log file with @a generation.
+  QString logFilePath(int generation) const;
+  /// Append @a entry to the log file, rotating it if needed.
+  LogFilePosition writeEntry(const LogEntry &entry);
+  /// Start a new log file and remove the ones exceeding m_maxLogFiles.
+  void rotateLogFile();
+  /// Import the log.json file written by earlier versions.
+  void importLegacyLog();
+  /// Implementation of readOlderEntries. If not NULL, @a positions receives
+  /// the position of each entry.
+  QList<LogEntry> readEntriesBefore(LogFilePosition &position, int count,
+                                    QList<LogFilePosition> *positions) const;
+
+  /// @return True if entries of @a type are printed to qDebug.
+  bool printEnabled(LogEntry::LogEntryType type) const;
+
   void handleNewLogEntry(LogEntry &entry);
   void handleNewDebugMessage(const MoleQueue::LogEntry &debug);
   void handleNewNotification(const MoleQueue::LogEntry &notif);
   void handleNewWarning(const MoleQueue::LogEntry &warning);
   void handleNewError(const MoleQueue::LogEntry &error);
 
-  void trimLog();
-
   bool m_printDebugMessages;
   bool m_printNotifications;
   bool m_printWarnings;
   bool m_printErrors;
 
-  int m_maxEntries;
+  LogEntry::LogEntryType m_logLevel;
+  /// Incremented from any thread that logs.
+  QAtomicInt m_suppressedCount;
+
   int m_newErrorCount;
   bool m_silenceNewErrors;
 
+  QString m_logDirectory;
   QFile *m_logFile;
-  QLinkedList<LogEntry> m_log;
+  /// Generation of m_logFile, and of the oldest log file on disk.
+  int m_logGeneration;
+  int m_firstLogGeneration;
+  qint64 m_maxLogFileSize;
+  int m_maxLogFiles;
+
+  RingBuffer<LogEntry> m_log;
+  /// Location of each entry in m_log in the log files.
+  RingBuffer<LogFilePosition> m_logPositions;
+
+  /// Guards the entries in memory, the log files and m_newErrorCount.
+  mutable QMutex m_mutex;
 };
 
 } // namespace MoleQueue
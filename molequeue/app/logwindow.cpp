@@ -23,6 +23,7 @@
 #include <QtCore/QSettings>
 
 #include <QtGui/QBrush>
+#include <QtWidgets/QCheckBox>
 #include <QtWidgets/QHBoxLayout>
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QPushButton>
@@ -42,6 +43,8 @@ LogWindow::LogWindow(QWidget *theParent, IdType moleQueueId) :
   ui(new Ui::LogWindow),
   m_log(NULL),
   m_maxEntries(NULL),
+  m_logDebugMessages(NULL),
+  m_olderEntriesButton(NULL),
   m_logEntryBlockFormat(new QTextBlockFormat()),
   m_timeStampFormat(new QTextCharFormat()),
   m_debugMessageFormat(new QTextCharFormat()),
@@ -129,6 +132,11 @@ void LogWindow::showEvent(QShowEvent *e)
 }
 
 void LogWindow::addLogEntry(const LogEntry &entry)
+{
+  insertLogEntry(entry, false);
+}
+
+void LogWindow::insertLogEntry(const LogEntry &entry, bool atEnd)
 {
   if (m_moleQueueId != InvalidId && m_moleQueueId != entry.moleQueueId())
     return;
@@ -160,7 +168,7 @@ void LogWindow::addLogEntry(const LogEntry &entry)
   QTextDocument *doc = m_log->document();
   QTextCursor cur(doc);
   cur.beginEditBlock();
-  cur.movePosition(QTextCursor::Start);
+  cur.movePosition(atEnd ? QTextCursor::End : QTextCursor::Start);
   cur.insertBlock(*m_logEntryBlockFormat);
   cur.insertText(entry.timeStamp().toString("[yyyy-MM-dd hh:mm:ss]"),
                  *m_timeStampFormat);
@@ -192,6 +200,23 @@ void LogWindow::changeMaxEntries()
   Logger::getInstance()->setMaxEntries(m_maxEntries->value());
 }
 
+void LogWindow::changeLogDebugMessages(bool log)
+{
+  Logger::setLogLevel(log ? LogEntry::DebugMessage : LogEntry::Notification);
+}
+
+void LogWindow::loadOlderEntries()
+{
+  QList<LogEntry> entries =
+      Logger::readOlderEntries(m_olderEntriesPosition, 200);
+
+  // Entries are returned oldest first, and the view shows the newest first.
+  for (int i = entries.size() - 1; i >= 0; --i)
+    insertLogEntry(entries.at(i), true);
+
+  m_olderEntriesButton->setEnabled(m_olderEntriesPosition.isValid());
+}
+
 void LogWindow::createUi()
 {
   ui->setupUi(this);
@@ -203,14 +228,21 @@ void LogWindow::createUi()
   m_log->setReadOnly(true);
   mainLayout->addWidget(m_log);
 
+  QHBoxLayout *logSettingsLayout = new QHBoxLayout ();
+  mainLayout->addLayout(logSettingsLayout);
+
+  m_olderEntriesButton = new QPushButton(tr("Show &older entries"), this);
+  connect(m_olderEntriesButton, SIGNAL(clicked()),
+          this, SLOT(loadOlderEntries()));
+  logSettingsLayout->addWidget(m_olderEntriesButton);
+
   // Skip the settings widgets if the molequeueid is set. Update window title
   if (m_moleQueueId != InvalidId) {
+    logSettingsLayout->addStretch();
     setWindowTitle(tr("History for Job %1").arg(idTypeToString(m_moleQueueId)));
     return;
   }
 
-  QHBoxLayout *logSettingsLayout = new QHBoxLayout ();
-
   QPushButton *clearLogButton = new QPushButton(tr("&Clear log"), this);
   connect(clearLogButton, SIGNAL(clicked()), this, SLOT(clearLog()));
   logSettingsLayout->addWidget(clearLogButton);
@@ -228,7 +260,11 @@ void LogWindow::createUi()
   logSettingsLayout->addWidget(maxEntriesLabel);
   logSettingsLayout->addWidget(m_maxEntries);
 
-  mainLayout->addLayout(logSettingsLayout);
+  m_logDebugMessages = new QCheckBox(tr("Record &debug messages"), this);
+  m_logDebugMessages->setChecked(Logger::logLevel() <= LogEntry::DebugMessage);
+  connect(m_logDebugMessages, SIGNAL(toggled(bool)),
+          this, SLOT(changeLogDebugMessages(bool)));
+  logSettingsLayout->addWidget(m_logDebugMessages);
 }
 
 void LogWindow::setupFormats()
@@ -270,6 +306,9 @@ void LogWindow::initializeLogText()
   foreach (const LogEntry &entry, Logger::log())
     addLogEntry(entry);
 
+  m_olderEntriesPosition = Logger::oldestPosition();
+  m_olderEntriesButton->setEnabled(m_olderEntriesPosition.isValid());
+
   m_log->moveCursor(QTextCursor::Start);
   m_log->ensureCursorVisible();
 }
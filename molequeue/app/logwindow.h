@@ -20,7 +20,10 @@
 #include <QtWidgets/QDialog>
 
 #include "molequeueglobal.h"
+#include "logger.h"
 
+class QCheckBox;
+class QPushButton;
 class QSpinBox;
 class QTextBlockFormat;
 class QTextCharFormat;
@@ -58,16 +61,25 @@ private slots:
   void addLogEntry(const MoleQueue::LogEntry &);
   void clearLog();
   void changeMaxEntries();
+  void changeLogDebugMessages(bool log);
+  /// Append the next page of entries that are no longer held in memory by the
+  /// Logger, read from the log files.
+  void loadOlderEntries();
 
 private:
   void createUi();
   void setupFormats();
   void initializeLogText();
+  /// Insert @a entry at the top of the log view, or at the bottom if
+  /// @a atEnd is true.
+  void insertLogEntry(const MoleQueue::LogEntry &entry, bool atEnd);
 
   Ui::LogWindow *ui;
 
   QTextEdit *m_log;
   QSpinBox *m_maxEntries;
+  QCheckBox *m_logDebugMessages;
+  QPushButton *m_olderEntriesButton;
 
   QTextBlockFormat *m_logEntryBlockFormat;
   QTextCharFormat *m_timeStampFormat;
@@ -79,6 +91,8 @@ private:
   QTextCharFormat *m_messageFormat;
 
   IdType m_moleQueueId;
+  /// Position in the log files of the oldest entry shown.
+  LogFilePosition m_olderEntriesPosition;
 };
 
 
@@ -14,7 +14,6 @@
 
 ******************************************************************************/
 
-#include <QtCore/QDir>
 #include <QtCore/QSettings>
 #include <QtCore/QStringList>
 
@@ -23,12 +22,12 @@
 #include <QtWidgets/QMessageBox>
 
 #include "mainwindow.h"
+#include "workdir.h"
 
 #include <cstdio>
 
 void printVersion();
 void printUsage();
-bool setWorkDir(const QString &workDir);
 
 int main(int argc, char *argv[])
 {
@@ -41,6 +40,7 @@ int main(int argc, char *argv[])
 
   bool customWorkDirSet = false;
   bool enableRpcKill = false;
+  bool serverThread = false;
   QString socketName("MoleQueue");
 
   QStringList args = QCoreApplication::arguments();
@@ -54,7 +54,7 @@ int main(int argc, char *argv[])
                                         "directories!")));
         return EXIT_FAILURE;
       }
-      if (!setWorkDir(it + 1 == itEnd ? QString("") : *(++it))) {
+      if (!MoleQueue::setWorkDir(it + 1 == itEnd ? QString("") : *(++it))) {
         return EXIT_FAILURE;
       }
       customWorkDirSet = true;
@@ -78,6 +78,10 @@ int main(int argc, char *argv[])
       enableRpcKill = true;
       continue;
     }
+    else if (*it == "--server-thread") {
+      serverThread = true;
+      continue;
+    }
     else if (*it == "-h" || *it == "-H" || *it == "--help" || *it == "-help") {
       printUsage();
       return EXIT_SUCCESS;
@@ -95,6 +99,7 @@ int main(int argc, char *argv[])
   QSettings settings;
   settings.setValue("socketName", socketName);
   settings.setValue("enableRpcKill", enableRpcKill);
+  settings.setValue("serverThread", serverThread);
 
   if (!QSystemTrayIcon::isSystemTrayAvailable()) {
     QMessageBox::critical(0, QObject::tr("MoleQueue"),
@@ -131,6 +136,9 @@ void printUsage()
   qWarning(format, "", "--rpc-kill",
            qPrintable(QObject::tr("Allow the app to be killed by a special "
                                   "RPC call (testing only).")));
+  qWarning(format, "", "--server-thread",
+           qPrintable(QObject::tr("Handle client requests on a separate "
+                                  "thread from the user interface.")));
   qWarning(format, "-s,", "--socketname [name]",
            qPrintable(QObject::tr("Name of the socket on which to listen.")));
   qWarning(format, "-v,", "--version",
@@ -139,70 +147,3 @@ void printUsage()
            qPrintable(QObject::tr("Run MoleQueue in a custom working "
                                   "directory.")));
 }
-
-bool setWorkDir(const QString &workDir)
-{
-  if (workDir.isEmpty()) {
-    qWarning("%s", qPrintable(QObject::tr("No specified working directory!")));
-    return false;
-  }
-
-  QFileInfo dirInfo(QDir::cleanPath(workDir));
-  if (!dirInfo.exists()) {
-    qWarning(qPrintable(QObject::tr("Specified working directory does not "
-                                    "exist: '%s'")), qPrintable(workDir));
-    return false;
-  }
-  if (!dirInfo.isReadable()) {
-    qWarning(qPrintable(QObject::tr("Specified working directory is not "
-                                    "readable: '%s'")), qPrintable(workDir));
-    return false;
-  }
-  if (!dirInfo.isWritable()) {
-    qWarning(qPrintable(QObject::tr("Specified working directory is not "
-                                    "writable: '%s'")), qPrintable(workDir));
-    return false;
-  }
-
-  QDir dir(workDir);
-
-  if (dir.exists("config")) {
-    QFileInfo configInfo(dir, "config");
-    if (!configInfo.isDir()) {
-      qWarning(qPrintable(QObject::tr("Invalid working directory '%s': "
-                                      "'%s/config' exists and is not a "
-                                      "directory!")), qPrintable(workDir),
-                                      qPrintable(workDir));
-      return false;
-    }
-    if (!configInfo.isReadable()) {
-      qWarning(qPrintable(QObject::tr("Invalid working directory '%s': "
-                                      "'%s/config' is not readable!")),
-                                      qPrintable(workDir), qPrintable(workDir));
-      return false;
-    }
-    if (!configInfo.isWritable()) {
-      qWarning(qPrintable(QObject::tr("Invalid working directory '%s': "
-                                      "'%s/config' is not writable!")),
-                                      qPrintable(workDir), qPrintable(workDir));
-      return false;
-    }
-  }
-  else {
-    if (!dir.mkdir("config")) {
-      qWarning(qPrintable(QObject::tr("Cannot create directory '%s'. "
-                                      "Aborting.")), qPrintable(workDir));
-      return false;
-    }
-  }
-
-  qDebug(qPrintable(QObject::tr("Running in working directory '%s'...")),
-         qPrintable(dirInfo.absolutePath()));
-
-  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
-                     workDir + "/config/");
-  QSettings settings;
-  settings.setValue("workingDirectoryBase", workDir);
-
-  return true;
-}
@@ -19,6 +19,7 @@
 
 #include "aboutdialog.h"
 #include "actionfactorymanager.h"
+#include "guiserver.h"
 #include "job.h"
 #include "jobactionfactories/killjobactionfactory.h"
 #include "jobactionfactories/opendirectoryactionfactory.h"
@@ -28,10 +29,15 @@
 #include "logentry.h"
 #include "logger.h"
 #include "logwindow.h"
+#include "molequeueconfig.h"
 #include "openwithmanagerdialog.h"
 #include "queuemanager.h"
 #include "queuemanagerdialog.h"
-#include "server.h"
+#include "serverthread.h"
+
+#ifdef MoleQueue_USE_EZHPC_UIT
+#include "queues/queueuit.h"
+#endif
 
 #include <QtCore/QSettings>
 #include <QtCore/QTimer>
@@ -58,11 +64,23 @@ MainWindow::MainWindow()
     m_trayIconMenu(NULL),
     m_statusTotalJobs(new QLabel(this)),
     m_statusHiddenJobs(new QLabel(this)),
-    m_server(NULL)
+    m_server(NULL),
+    m_serverThread(NULL),
+    m_queueManagerOpen(false)
 {
+#ifdef MoleQueue_USE_EZHPC_UIT
+  // UIT queues ask for credentials with dialogs, so they are only available
+  // in the GUI.
+  QueueManager::registerQueueType("ezHPC UIT", &QueueUit::create);
+#endif
+
   QSettings settings;
-  m_server = new Server(this,
-                        settings.value("socketName", "MoleQueue").toString());
+  // No parent: the server may be moved to its own thread.
+  m_server = new GuiServer(NULL,
+                           settings.value("socketName",
+                                          "MoleQueue").toString());
+  if (settings.value("serverThread", false).toBool())
+    m_serverThread = new ServerThread(m_server, this);
 
   m_ui->setupUi(this);
 
@@ -93,7 +111,8 @@ MainWindow::MainWindow()
                                                          MoleQueue::JobState)),
           this, SLOT(notifyJobStateChange(MoleQueue::Job,
                                           MoleQueue::JobState,
-                                          MoleQueue::JobState)));
+                                          MoleQueue::JobState)),
+          Qt::DirectConnection);
 
   // This will get handled when the event loop
   // starts and will launch the server. This must be done this way, otherwise
@@ -105,6 +124,10 @@ MainWindow::MainWindow()
 
 MainWindow::~MainWindow()
 {
+  // Bring the server back before touching it.
+  delete m_serverThread;
+  m_serverThread = NULL;
+
   writeSettings();
 
   delete m_ui;
@@ -175,24 +198,35 @@ void MainWindow::errorCleared()
 void MainWindow::notifyJobStateChange(const Job &job,
                                       JobState oldState, JobState newState)
 {
+  // Connected directly, so this runs in the JobManager's thread: read the job
+  // here and only hand the text to the GUI thread.
   if (job.popupOnStateChange()) {
-    m_trayIcon->showMessage(tr("Job '%1' is %2")
-                            .arg(job.description())
-                            .arg(jobStateToGuiString(job.jobState())),
-                            tr("MoleQueue Job #%1 has changed from %2 to %3.")
-                            .arg(idTypeToString(job.moleQueueId()))
-                            .arg(jobStateToGuiString(oldState))
-                            .arg(jobStateToGuiString(newState)),
-                            QSystemTrayIcon::Information,
-                            5000);
+    QString title = tr("Job '%1' is %2")
+        .arg(job.description())
+        .arg(jobStateToGuiString(job.jobState()));
+    QString message = tr("MoleQueue Job #%1 has changed from %2 to %3.")
+        .arg(idTypeToString(job.moleQueueId()))
+        .arg(jobStateToGuiString(oldState))
+        .arg(jobStateToGuiString(newState));
+    QMetaObject::invokeMethod(this, "showJobNotification",
+                              Qt::QueuedConnection,
+                              Q_ARG(QString, title), Q_ARG(QString, message));
   }
 }
 
+void MainWindow::showJobNotification(const QString &title,
+                                     const QString &message)
+{
+  m_trayIcon->showMessage(title, message, QSystemTrayIcon::Information, 5000);
+}
+
 void MainWindow::onEventLoopStart()
 {
   // Start the server first -- this may call qApp->exit() if the socket name
   // is in use and the user opts to quit.
   m_server->start();
+  if (m_serverThread)
+    m_serverThread->startServer();
 
   m_trayIcon->show();
   m_ui->errorNotificationLabel->hide();
@@ -201,15 +235,33 @@ void MainWindow::onEventLoopStart()
 
 void MainWindow::showQueueManagerDialog()
 {
+  // The dialog and the queue settings widgets edit the queues directly, so
+  // run the server on this thread until it is closed. Restarting the thread
+  // afterwards also notices queues that were added and need the GUI thread.
+  if (m_serverThread && !m_queueManagerOpen) {
+    m_serverThread->stopServer();
+    m_queueManagerOpen = true;
+  }
+
   if (!m_queueManagerDialog) {
     m_queueManagerDialog =
         new QueueManagerDialog(m_server->queueManager(), this);
+    connect(m_queueManagerDialog, SIGNAL(finished(int)),
+            this, SLOT(queueManagerDialogFinished()));
   }
 
   m_queueManagerDialog->show();
   m_queueManagerDialog->raise();
 }
 
+void MainWindow::queueManagerDialogFinished()
+{
+  if (m_serverThread && m_queueManagerOpen) {
+    m_queueManagerOpen = false;
+    m_serverThread->startServer();
+  }
+}
+
 void MainWindow::showOpenWithManagerDialog()
 {
   if (!m_openWithManagerDialog)
@@ -253,7 +305,8 @@ void MainWindow::handleServerConnectionError(ConnectionListener::Error err,
     }
     // Take over connection
     else {
-      m_server->forceStart();
+      // Runs in the server's thread.
+      QMetaObject::invokeMethod(m_server, "forceStart");
     }
   }
 
@@ -44,6 +44,7 @@ class LogWindow;
 class OpenWithManagerDialog;
 class QueueManagerDialog;
 class Server;
+class ServerThread;
 
 /// The main window for the MoleQueue application.
 class MainWindow : public QMainWindow
@@ -69,8 +70,13 @@ public slots:
                             MoleQueue::JobState oldState,
                             MoleQueue::JobState newState);
 
+  /// Show a job notification in the tray icon. Called by
+  /// notifyJobStateChange() through a queued connection.
+  void showJobNotification(const QString &title, const QString &message);
+
 protected slots:
   void showQueueManagerDialog();
+  void queueManagerDialogFinished();
   void showOpenWithManagerDialog();
   void showLogWindow();
   void handleServerConnectionError(MoleQueue::ConnectionListener::Error,
@@ -111,6 +117,12 @@ protected:
 
   Server *m_server;
 
+  /// Runs m_server when the "serverThread" setting is enabled, NULL otherwise.
+  ServerThread *m_serverThread;
+
+  /// True while m_serverThread is stopped for the queue manager dialog.
+  bool m_queueManagerOpen;
+
 private slots:
   void showAboutDialog();
 };
@@ -39,7 +39,8 @@ Program::Program(Queue *parentQueue) :
   m_arguments(),
   m_outputFilename("$$inputFileBaseName$$.out"),
   m_launchSyntax(REDIRECT),
-  m_customLaunchTemplate("")
+  m_customLaunchTemplate(""),
+  m_linkInputFiles(false)
 {
 }
 
@@ -53,7 +54,8 @@ Program::Program(const Program &other)
     m_arguments(other.m_arguments),
     m_outputFilename(other.m_outputFilename),
     m_launchSyntax(other.m_launchSyntax),
-    m_customLaunchTemplate(other.m_customLaunchTemplate)
+    m_customLaunchTemplate(other.m_customLaunchTemplate),
+    m_linkInputFiles(other.m_linkInputFiles)
 {
 }
 
@@ -72,6 +74,7 @@ Program &Program::operator=(const Program &other)
   m_outputFilename = other.m_outputFilename;
   m_launchSyntax = other.m_launchSyntax;
   m_customLaunchTemplate = other.m_customLaunchTemplate;
+  m_linkInputFiles = other.m_linkInputFiles;
   return *this;
 }
 
@@ -154,6 +157,7 @@ bool Program::writeJsonSettings(QJsonObject &json, bool exportOnly) const
   json.insert("outputFilename", m_outputFilename);
   json.insert("customLaunchTemplate", m_customLaunchTemplate);
   json.insert("launchSyntax", static_cast<double>(m_launchSyntax));
+  json.insert("linkInputFiles", m_linkInputFiles);
 
   return true;
 }
@@ -181,6 +185,7 @@ bool Program::readJsonSettings(const QJsonObject &json, bool importOnly)
   m_launchSyntax =
       static_cast<LaunchSyntax>(
         static_cast<int>(json.value("launchSyntax").toDouble() + 0.5));
+  m_linkInputFiles = json.value("linkInputFiles").toBool(false);
 
   return true;
 }
@@ -209,6 +214,15 @@ QString Program::launchTemplate() const
   return result;
 }
 
+const LaunchTemplate &Program::compiledLaunchTemplate() const
+{
+  QString source = launchTemplate();
+  if (source != m_compiledLaunchTemplate.source())
+    m_compiledLaunchTemplate.setSource(source);
+
+  return m_compiledLaunchTemplate;
+}
+
 QString Program::generateFormattedExecutionString(
     const QString &executable_, const QString &arguments_,
     const QString &outputFilename_, Program::LaunchSyntax syntax_)
@@ -19,6 +19,8 @@
 
 #include <QtCore/QObject>
 
+#include "launchtemplate.h"
+
 #include <QtCore/QMap>
 #include <QtCore/QMetaType>
 #include <QtCore/QString>
@@ -159,10 +161,21 @@ public:
   }
   QString customLaunchTemplate() const {return m_customLaunchTemplate;}
 
+  /// If true, deduplicated input files are hard linked into the job
+  /// directories instead of copied. Linked files are read-only, since all
+  /// jobs share them, so only enable this for programs that never write to
+  /// their input files. Default: false
+  void setLinkInputFiles(bool link) {m_linkInputFiles = link;}
+  bool linkInputFiles() const {return m_linkInputFiles;}
+
   /// @return Either the custom launch template or a default generated template,
   /// depending on the value of launchSyntax.
   QString launchTemplate() const;
 
+  /// @return launchTemplate(), parsed for rendering. The parsed template is
+  /// cached and only rebuilt when launchTemplate() changes.
+  const LaunchTemplate & compiledLaunchTemplate() const;
+
   static QString generateFormattedExecutionString(
       const QString &executable_, const QString &arguments_,
       const QString &outputFilename_, LaunchSyntax syntax_);
@@ -193,6 +206,10 @@ protected:
   LaunchSyntax m_launchSyntax;
   /// Bash/Shell/Queue script template used to launch program
   QString m_customLaunchTemplate;
+  /// Hard link deduplicated input files into the job directories
+  bool m_linkInputFiles;
+  /// Cache for compiledLaunchTemplate()
+  mutable LaunchTemplate m_compiledLaunchTemplate;
 
 };
 
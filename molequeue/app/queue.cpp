@@ -16,10 +16,12 @@
 
 #include "queue.h"
 
+#include "blobstore.h"
+#include "directoryoperation.h"
 #include "filespecification.h"
-#include "filesystemtools.h"
 #include "job.h"
 #include "jobmanager.h"
+#include "launchtemplate.h"
 #include "logentry.h"
 #include "logger.h"
 #include "program.h"
@@ -324,11 +326,6 @@ bool Queue::readJsonSettings(const QJsonObject &root, bool importOnly,
   return true;
 }
 
-AbstractQueueSettingsWidget* Queue::settingsWidget()
-{
-  return NULL;
-}
-
 bool Queue::addProgram(Program *newProgram, bool replace)
 {
   // Check for duplicates, unless we are replacing, and return false if found.
@@ -370,22 +367,24 @@ bool Queue::removeProgram(const QString &programName)
 void Queue::replaceKeywords(QString &launchScript, const Job &job,
                             bool addNewline)
 {
-  if (job.isValid()) {
-    if (Program *program = lookupProgram(job.program())) {
-      // This will probably contain other keywords (like inputFileBaseName), so
-      // keep it towards the top of the replacement list.
-      launchScript.replace("$$outputFileName$$", program->outputFilename());
-    }
+  launchScript = renderLaunchTemplate(LaunchTemplate(launchScript), job,
+                                      addNewline);
+}
 
-    job.replaceKeywords(launchScript);
-  }
+QString Queue::renderLaunchTemplate(const LaunchTemplate &launchTemplate,
+                                    const Job &job, bool addNewline)
+{
+  QHash<QString, QString> keywords;
+  QHash<QString, QString> lineKeywords;
+  insertKeywords(job, keywords, lineKeywords);
+
+  QStringList unhandled;
+  QString launchScript = launchTemplate.render(keywords, lineKeywords,
+                                               &unhandled);
 
-  // Remove any unreplaced keywords
-  QRegExp expr("[^\\$]?(\\${2,3}[^\\$\\s]+\\${2,3})[^\\$]?");
-  while (expr.indexIn(launchScript) != -1) {
+  foreach (const QString &keyword, unhandled) {
     Logger::logWarning(tr("Unhandled keyword in launch script: %1. Removing.")
-                       .arg(expr.cap(1)), job.moleQueueId());
-    launchScript.remove(expr.cap(1));
+                       .arg(keyword), job.moleQueueId());
   }
 
   // Add newline at end if not present
@@ -393,9 +392,27 @@ void Queue::replaceKeywords(QString &launchScript, const Job &job,
       !launchScript.endsWith(QChar('\n'))) {
     launchScript.append(QChar('\n'));
   }
+
+  return launchScript;
 }
 
-bool Queue::writeInputFiles(const Job &job)
+void Queue::insertKeywords(const Job &job, QHash<QString, QString> &keywords,
+                           QHash<QString, QString> &lineKeywords) const
+{
+  Q_UNUSED(lineKeywords);
+
+  if (!job.isValid())
+    return;
+
+  job.insertKeywords(keywords);
+
+  // This will probably contain other keywords (like inputFileBaseName), which
+  // are expanded when rendering.
+  if (Program *program = lookupProgram(job.program()))
+    keywords.insert("outputFileName", program->outputFilename());
+}
+
+bool Queue::writeInputFiles(Job &job)
 {
   QString workdir = job.localWorkingDirectory();
 
@@ -432,10 +449,26 @@ bool Queue::writeInputFiles(const Job &job)
     }
   }
 
-  // Create input files
+  QMap<QString, QString> inputFileHashes;
+  int linkedFiles = 0;
+  int reusedFiles = 0;
+  bool reused = false;
+
+  // Create input files. These are usually unique to the job, so only
+  // deduplicate them if they are in the BlobStore already.
   FileSpecification inputFile = job.inputFile();
-  if (inputFile.isValid())
-    inputFile.writeFile(dir);
+  if (inputFile.isValid()) {
+    if (inputFile.isStored() &&
+        linkInputFile(inputFile, dir, program->linkInputFiles(),
+                      inputFileHashes, &reused)) {
+      ++linkedFiles;
+      if (reused)
+        ++reusedFiles;
+    }
+    else {
+      inputFile.writeFile(dir);
+    }
+  }
 
   // Write additional input files
   QList<FileSpecification> additionalInputFiles = job.additionalInputFiles();
@@ -476,11 +509,35 @@ bool Queue::writeInputFiles(const Job &job)
                            .arg(target.absoluteFilePath()), job.moleQueueId());
         QFile::remove(target.absoluteFilePath());
       }
-      filespec.writeFile(dir);
+      if (linkInputFile(filespec, dir, program->linkInputFiles(),
+                        inputFileHashes, &reused)) {
+        ++linkedFiles;
+        if (reused)
+          ++reusedFiles;
+      }
+      else {
+        filespec.writeFile(dir);
+      }
       continue;
     }
   }
 
+  // Saved with the job, so the blobs are kept until the job is removed.
+  job.setInputFileHashes(inputFileHashes);
+
+  // Cache statistics, logged once per job: not for the user's attention.
+  if (linkedFiles > 0 && Logger::isEnabled(LogEntry::DebugMessage)) {
+    BlobStore *store = BlobStore::instance();
+    Logger::logDebugMessage(tr("Placed %1 input files from the blob store, %2 "
+                               "of them shared with earlier jobs. Overall hit "
+                               "rate: %3% (%4 of %5).")
+                            .arg(linkedFiles).arg(reusedFiles)
+                            .arg(store->hitRate(), 0, 'f', 1)
+                            .arg(store->hits())
+                            .arg(store->hits() + store->misses()),
+                            job.moleQueueId());
+  }
+
   // Do we need a driver script?
   const QueueLocal *localQueue = qobject_cast<const QueueLocal*>(this);
   const QueueRemote *remoteQueue = qobject_cast<const QueueRemote*>(this);
@@ -493,9 +550,8 @@ bool Queue::writeInputFiles(const Job &job)
                        job.moleQueueId());
       return false;
     }
-    QString launchString = program->launchTemplate();
-
-    replaceKeywords(launchString, job);
+    QString launchString =
+        renderLaunchTemplate(program->compiledLaunchTemplate(), job);
 
     launcherFile.write(launchString.toLatin1());
     if (!launcherFile.setPermissions(
@@ -530,6 +586,40 @@ bool Queue::addJobFailure(IdType moleQueueId)
   return true;
 }
 
+bool Queue::linkInputFile(const FileSpecification &filespec, const QDir &dir,
+                          bool hardLink, QMap<QString, QString> &hashes,
+                          bool *reused)
+{
+  BlobStore *store = BlobStore::instance();
+  if (!store->isEnabled())
+    return false;
+
+  // Stored contents were counted by the BlobStore when the FileSpecification
+  // was created, and are not known to be shared with another job.
+  *reused = false;
+  QString contentsHash;
+  if (filespec.isStored())
+    contentsHash = filespec.contentsHash();
+  else if (filespec.format() == FileSpecification::PathFileSpecification)
+    contentsHash = store->addFile(filespec.filepath(), reused);
+  else
+    contentsHash = store->add(filespec.contents().toLocal8Bit(), reused);
+
+  if (contentsHash.isNull())
+    return false;
+
+  // Copies are reflinked where the filesystem supports it, so they cost
+  // little more than a link but leave the job free to modify its inputs.
+  QString target = dir.absoluteFilePath(filespec.filename());
+  if (hardLink ? !store->linkTo(contentsHash, target)
+               : !store->copyTo(contentsHash, target)) {
+    return false;
+  }
+
+  hashes.insert(filespec.filename(), contentsHash);
+  return true;
+}
+
 void Queue::jobAboutToBeRemoved(const Job &job)
 {
   m_failureTracker.remove(job.moleQueueId());
@@ -553,10 +643,28 @@ void Queue::programNameChanged(const QString &newName, const QString &oldName)
 
 void Queue::cleanLocalDirectory(const Job &job)
 {
-  if (!FileSystemTools::recursiveRemoveDirectory(job.localWorkingDirectory(),
-                                                 true)) {
-    Logger::logError(tr("Cannot remove '%1' from local filesystem.")
-                     .arg(job.localWorkingDirectory()));
+  // Large job directories can take a while to remove, so do it off of the
+  // GUI thread.
+  DirectoryOperation *op =
+      DirectoryOperation::removeDirectory(job.localWorkingDirectory(), true,
+                                          this);
+  op->setData(QVariant::fromValue(job));
+  connect(op, SIGNAL(finished(bool)), this, SLOT(localDirectoryCleaned(bool)));
+  op->start();
+}
+
+void Queue::localDirectoryCleaned(bool success)
+{
+  DirectoryOperation *op = qobject_cast<DirectoryOperation*>(sender());
+  if (!op)
+    return;
+
+  op->deleteLater();
+
+  if (!success) {
+    Logger::logError(tr("Cannot remove '%1' from local filesystem: %2")
+                     .arg(op->source(), op->errorString()),
+                     op->data().value<Job>().moleQueueId());
   }
 }
 
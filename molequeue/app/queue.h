@@ -23,18 +23,20 @@
 
 #include "idtypeutils.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QMap>
 #include <QtCore/QList>
 #include <QtCore/QMetaType>
 #include <QtCore/QPointer>
 #include <QtCore/QStringList>
 
+class QDir;
 class QJsonObject;
 
 namespace MoleQueue
 {
-class AbstractQueueSettingsWidget;
 class Job;
+class LaunchTemplate;
 class Program;
 class QueueManager;
 class Server;
@@ -94,6 +96,13 @@ public:
    */
   virtual QString typeName() const { return "Unknown"; }
 
+  /**
+   * @return True if the queue interacts with the user while running jobs,
+   * e.g. to prompt for credentials, and so must live in the GUI thread.
+   * @sa ServerThread
+   */
+  virtual bool requiresGuiThread() const { return false; }
+
   /**
    * Read settings for the queue, done early on at startup.
    * @param filePath Path to the .mqq file with the queue settings.
@@ -180,12 +189,6 @@ public:
                                 bool includePrograms);
 
 
-  /**
-   * Returns a widget that can be used to configure the settings for the
-   * queue.
-   */
-  virtual AbstractQueueSettingsWidget* settingsWidget();
-
   /**
    * Add a new program to the queue. Program names must be unique in each
    * queue, as they are used to specify which program will be used.
@@ -281,8 +284,21 @@ public:
    * with queue/job specific values.
    * @param launchScript Launch script to complete.
    * @param job Job data to use.
+   * @see renderLaunchTemplate
    */
-  virtual void replaceKeywords(QString & launchScript,
+  void replaceKeywords(QString & launchScript,
+                       const Job &job,
+                       bool addNewline = true);
+
+  /**
+   * @brief renderLaunchTemplate Render a parsed template with queue/job
+   * specific keyword values. Unhandled keywords are removed and logged.
+   * @param launchTemplate Template to render, e.g.
+   * Program::compiledLaunchTemplate().
+   * @param job Job data to use.
+   * @return The completed script.
+   */
+  QString renderLaunchTemplate(const LaunchTemplate &launchTemplate,
                                const Job &job,
                                bool addNewline = true);
 
@@ -368,13 +384,53 @@ protected slots:
   void programNameChanged(const QString &newName, const QString &oldName);
 
   /**
-   * Delete the local working directory of @a Job.
+   * Delete the contents of the local working directory of @a Job. The removal
+   * is performed asynchronously by a DirectoryOperation.
    */
   void cleanLocalDirectory(const MoleQueue::Job &job);
 
+  /**
+   * Called when the DirectoryOperation started by cleanLocalDirectory
+   * completes.
+   */
+  void localDirectoryCleaned(bool success);
+
 protected:
-  /// Write the input files for @a job to the local working directory.
-  bool writeInputFiles(const Job &job);
+  /**
+   * Collect the keyword values used by renderLaunchTemplate for @a job.
+   * Subclasses may reimplement this to add queue specific keywords; later
+   * insertions take precedence.
+   * @param keywords Values for $$keyword$$.
+   * @param lineKeywords Values for $$$keyword$$$. A null value removes the
+   * lines containing the keyword.
+   */
+  virtual void insertKeywords(const Job &job,
+                              QHash<QString, QString> &keywords,
+                              QHash<QString, QString> &lineKeywords) const;
+
+  /**
+   * Write the input files for @a job to the local working directory.
+   * Additional input files, and input files whose contents are kept in the
+   * BlobStore, are deduplicated: they are stored once in the BlobStore and
+   * copied (or hard linked, if the program allows it) into the working
+   * directory. Their hashes are recorded with the job, see
+   * Job::inputFileHashes(), so @a job is modified.
+   */
+  bool writeInputFiles(Job &job);
+
+  /**
+   * Place @a filespec in @a dir by way of the BlobStore.
+   * @param hardLink If true, hard link the file from the BlobStore (see
+   * Program::linkInputFiles()), otherwise copy it.
+   * @param hashes The hash of the contents is added here, keyed by filename.
+   * @param reused Set to true if the contents were found in the BlobStore by
+   * this call, i.e. they are shared with an earlier job.
+   * @return True on success, false if the file could not be deduplicated and
+   * must be written normally.
+   */
+  bool linkInputFile(const FileSpecification &filespec, const QDir &dir,
+                     bool hardLink, QMap<QString, QString> &hashes,
+                     bool *reused);
 
   /**
    * @brief addJobFailure Call this when a job encounters a problem but will be
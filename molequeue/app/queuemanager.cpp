@@ -27,15 +27,18 @@
 #include "queues/sge.h"
 #include "queues/slurm.h"
 #include "queues/oar.h"
-#ifdef MoleQueue_USE_EZHPC_UIT
-#include "queues/queueuit.h"
-#endif
+
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
 #include <QtCore/QSettings>
 
 namespace MoleQueue {
 
+namespace {
+typedef QMap<QString, QueueManager::QueueCreator> QueueCreatorMap;
+Q_GLOBAL_STATIC(QueueCreatorMap, registeredQueueTypes)
+}
+
 QueueManager::QueueManager(Server *parentServer)
   : QObject(parentServer),
     m_server(parentServer)
@@ -95,12 +98,16 @@ QStringList QueueManager::availableQueues()
 {
   QStringList result;
   result << "Local" << "Sun Grid Engine" << "PBS/Torque" << "SLURM" << "OAR";
-#ifdef MoleQueue_USE_EZHPC_UIT
-  result << "ezHPC UIT";
-#endif
+  result << registeredQueueTypes()->keys();
   return result;
 }
 
+void QueueManager::registerQueueType(const QString &queueType,
+                                     QueueCreator creator)
+{
+  registeredQueueTypes()->insert(queueType, creator);
+}
+
 bool QueueManager::queueTypeIsValid(const QString &queueType)
 {
   return QueueManager::availableQueues().contains(queueType);
@@ -127,10 +134,8 @@ Queue * QueueManager::addQueue(const QString &queueName,
     newQueue = new QueueSlurm(this);
   else if (queueType== "OAR")
     newQueue = new QueueOar(this);
-#ifdef MoleQueue_USE_EZHPC_UIT
-  else if (queueType== "ezHPC UIT")
-    newQueue = new QueueUit(this);
-#endif
+  else if (QueueCreator creator = registeredQueueTypes()->value(queueType))
+    newQueue = creator(this);
   if (!newQueue)
     return NULL;
 
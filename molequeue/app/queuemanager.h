@@ -63,6 +63,18 @@ public:
    */
   static QStringList availableQueues();
 
+  /// Function creating a Queue of a registered type.
+  typedef Queue * (*QueueCreator)(QueueManager *parentManager);
+
+  /**
+   * Make the queue type @a queueType available to addQueue(), which will call
+   * @a creator to construct it. This is used for queue types that are not
+   * part of the core library, such as those that need the GUI. Register the
+   * types before the queue settings are read.
+   */
+  static void registerQueueType(const QString &queueType,
+                                QueueCreator creator);
+
   /**
    * @param queueType Type of Queue (SGE, PBS/Torque, Local, etc)
    * @return True if the queue can be instantiated, false otherwise.
@@ -16,10 +16,9 @@
 
 #include "local.h"
 
-#include "../filesystemtools.h"
+#include "../directoryoperation.h"
 #include "../job.h"
 #include "../jobmanager.h"
-#include "../localqueuewidget.h"
 #include "../logentry.h"
 #include "../logger.h"
 #include "../program.h"
@@ -39,9 +38,6 @@
 #include <QtCore/QTimerEvent>
 #include <QtCore/QThread> // For ideal thread count
 
-#include <QtWidgets/QFormLayout>
-#include <QtWidgets/QSpinBox>
-
 #include <QtCore/QDebug>
 
 #ifdef _WIN32
@@ -130,12 +126,6 @@ bool QueueLocal::readJsonSettings(const QJsonObject &json, bool importOnly,
   return true;
 }
 
-AbstractQueueSettingsWidget *QueueLocal::settingsWidget()
-{
-  LocalQueueWidget *widget = new LocalQueueWidget(this);
-  return widget;
-}
-
 bool QueueLocal::submitJob(Job job)
 {
   if (job.isValid()) {
@@ -249,17 +239,44 @@ void QueueLocal::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
 
   if (!job.outputDirectory().isEmpty() &&
       job.outputDirectory() != job.localWorkingDirectory()) {
-    // copy function logs errors if needed
-    if (!FileSystemTools::recursiveCopyDirectory(job.localWorkingDirectory(),
-                                                 job.outputDirectory())) {
-      Logger::logError(tr("Cannot copy '%1' -> '%2'.")
-                       .arg(job.localWorkingDirectory(),
-                            job.outputDirectory()), job.moleQueueId());
-      job.setJobState(MoleQueue::Error);
-      return;
-    }
+    // Copy in the background; the job is finalized once the copy completes.
+    DirectoryOperation *op =
+        DirectoryOperation::copyDirectory(job.localWorkingDirectory(),
+                                          job.outputDirectory(), this);
+    op->setData(QVariant::fromValue(job));
+    connect(op, SIGNAL(finished(bool)), this, SLOT(outputCopied(bool)));
+    op->start();
+    return;
   }
 
+  finalizeJob(job);
+}
+
+void QueueLocal::outputCopied(bool success)
+{
+  DirectoryOperation *op = qobject_cast<DirectoryOperation*>(sender());
+  if (!op)
+    return;
+
+  op->deleteLater();
+
+  Job job = op->data().value<Job>();
+  if (!job.isValid())
+    return;
+
+  if (!success) {
+    Logger::logError(tr("Cannot copy '%1' -> '%2': %3")
+                     .arg(op->source(), op->target(), op->errorString()),
+                     job.moleQueueId());
+    job.setJobState(MoleQueue::Error);
+    return;
+  }
+
+  finalizeJob(job);
+}
+
+void QueueLocal::finalizeJob(Job job)
+{
   if (job.cleanLocalWorkingDirectory())
     cleanLocalDirectory(job);
 
@@ -43,12 +43,6 @@ public:
   bool readJsonSettings(const QJsonObject &json, bool importOnly,
                         bool includePrograms);
 
-  /**
-   * Returns a widget that can be used to configure the settings for the
-   * queue.
-   */
-  AbstractQueueSettingsWidget* settingsWidget();
-
   /// The number of cores available.
   int maxNumberOfCores() const;
 
@@ -79,6 +73,13 @@ protected slots:
    */
   void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
+  /**
+   * Called when the output of a finished job has been copied to its output
+   * directory.
+   * @param success Whether the copy succeeded.
+   */
+  void outputCopied(bool success);
+
   /**
    * Called when a error occurs with a process.
    * @param error the specific error that occurred
@@ -98,6 +99,9 @@ protected:
   /// Submit the job with MoleQueue id @a moleQueueId.
   bool startJob(IdType moleQueueId);
 
+  /// Clean up after @a job and mark it as finished.
+  void finalizeJob(Job job);
+
   /// Reimplemented to monitor queue events.
   void timerEvent(QTimerEvent *theEvent);
 
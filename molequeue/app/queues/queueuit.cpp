@@ -25,6 +25,8 @@
 #include "uit/jobsubmissioninfo.h"
 #include "uit/directoryupload.h"
 #include "uit/directorydownload.h"
+#include "uit/archiveupload.h"
+#include "uit/archivedownload.h"
 #include "uit/directorydelete.h"
 #include "uit/directorycreate.h"
 
@@ -33,20 +35,20 @@
 #include "logentry.h"
 #include "logger.h"
 #include "program.h"
-#include "uitqueuewidget.h"
 #include "server.h"
 #include "credentialsdialog.h"
 #include "logger.h"
 #include "mainwindow.h"
-#include "filesystemtools.h"
+#include "directoryoperation.h"
 #include <qjsonobject.h>
 #include <qjsondocument.h>
 
+#include <QtCore/QDateTime>
 #include <QtCore/QTimer>
 #include <QtCore/QXmlStreamWriter>
+#include <QtCore/QSet>
 #include <QtCore/QSettings>
 #include <QtCore/QDir>
-#include <QtXmlPatterns/QAbstractMessageHandler>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QMessageBox>
 
@@ -55,10 +57,14 @@ namespace MoleQueue
 
 const QString QueueUit::clientId = "0adc5b59-5827-4331-a544-5ba7922ec2b8";
 
+namespace {
+const qint64 secondsPerDay = 24 * 60 * 60;
+}
+
 QueueUit::QueueUit(QueueManager *parentObject)
   : QueueRemote("ezHPC UIT", parentObject), m_uitSession(NULL),
     m_kerberosRealm("HPCMP.HPC.MIL"), m_hostID(-1),  m_dialogParent(NULL),
-    m_isCheckingQueue(false)
+    m_isCheckingQueue(false), m_archiveTransfers(false), m_lastEventTime(0)
 {
   setLaunchScriptName("job.uit");
 
@@ -92,6 +98,7 @@ bool QueueUit::writeJsonSettings(QJsonObject &json, bool exportOnly,
   json["kerberosRealm"] = m_kerberosRealm;
   json["hostName"] = m_hostName;
   json["hostID"] = QString::number(m_hostID);
+  json["archiveTransfers"] = m_archiveTransfers;
 
   return true;
 }
@@ -103,7 +110,9 @@ bool QueueUit::readJsonSettings(const QJsonObject &json, bool importOnly,
   if (!json["kerberosUserName"].isString() ||
       !json["kerberosRealm"].isString() ||
       !json["hostName"].isString() ||
-      !json["hostID"].isString()) {
+      !json["hostID"].isString() ||
+      (json.contains("archiveTransfers") &&
+       !json["archiveTransfers"].isBool())) {
     Logger::logError(tr("Error reading queue settings: Invalid format:\n%1")
                      .arg(QJsonDocument(json).toJson().constData()));
     return false;
@@ -112,10 +121,11 @@ bool QueueUit::readJsonSettings(const QJsonObject &json, bool importOnly,
   if (!QueueRemote::readJsonSettings(json, importOnly, includePrograms))
     return false;
 
-  m_kerberosUserName = json["kerberosUserName"].toString();
-  m_kerberosRealm = json["kerberosRealm"].toString();
+  setKerberosUserName(json["kerberosUserName"].toString());
+  setKerberosRealm(json["kerberosRealm"].toString());
   m_hostName = json["hostName"].toString();
-  m_hostID = json["hostID"].toString().toLongLong();
+  setHostID(json["hostID"].toString().toLongLong());
+  m_archiveTransfers = json["archiveTransfers"].toBool(false);
 
   return true;
 }
@@ -144,12 +154,6 @@ void QueueUit::testConnectionError(const QString &errorMessage)
   QMessageBox::critical(m_dialogParent, tr("UIT Error"), errorMessage);
 }
 
-AbstractQueueSettingsWidget* QueueUit::settingsWidget()
-{
-  UitQueueWidget *widget = new UitQueueWidget (this);
-  return widget;
-}
-
 void QueueUit::createRemoteDirectory(Job job)
 {
 
@@ -255,11 +259,23 @@ void QueueUit::uploadInputFilesToHost(Job job)
                                       .arg(m_workingDirectoryBase)
                                       .arg(job.moleQueueId()));
 
-  Uit::DirectoryUpload *uploader = new Uit::DirectoryUpload(uitSession(), this);
+  Uit::FileSystemOperation *uploader = NULL;
+  if (m_archiveTransfers) {
+    Uit::ArchiveUpload *archiveUpload = new Uit::ArchiveUpload(uitSession(),
+                                                               this);
+    archiveUpload->setLocalPath(localDir);
+    archiveUpload->setRemotePath(remoteDir);
+    uploader = archiveUpload;
+  }
+  else {
+    Uit::DirectoryUpload *directoryUpload =
+        new Uit::DirectoryUpload(uitSession(), this);
+    directoryUpload->setLocalPath(localDir);
+    directoryUpload->setRemotePath(remoteDir);
+    uploader = directoryUpload;
+  }
   uploader->setHostId(m_hostID);
   uploader->setUserName(m_kerberosUserName);
-  uploader->setLocalPath(localDir);
-  uploader->setRemotePath(remoteDir);
   uploader->setJob(job);
 
   connect(uploader, SIGNAL(finished()),
@@ -301,8 +317,8 @@ void QueueUit::copyInputFilesToHostError(const QString &errorString)
 
 void QueueUit::inputFilesCopied()
 {
-  Uit::DirectoryUpload *uploader
-    = qobject_cast<Uit::DirectoryUpload*>(sender());
+  Uit::FileSystemOperation *uploader
+    = qobject_cast<Uit::FileSystemOperation*>(sender());
 
   if (!uploader) {
     Logger::logError(tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
@@ -323,8 +339,8 @@ void QueueUit::submitJobToRemoteQueue(Job job)
   const Program *prog = lookupProgram(job.program());
 
   // TODO Should be pust to queue??
-  QString launchString = prog->launchTemplate();
-  replaceKeywords(launchString, job);
+  QString launchString =
+      renderLaunchTemplate(prog->compiledLaunchTemplate(), job);
   QString workingDir = QString("%1/%2").arg(m_workingDirectoryBase)
                                         .arg(job.moleQueueId());
   request->setHostId(hostId());
@@ -381,7 +397,7 @@ void QueueUit::jobSubmittedToRemoteQueue()
   job.setJobState(MoleQueue::Submitted);
   clearJobFailures(job.moleQueueId());
   job.setQueueId(queueId);
-  m_jobs.insert(queueId, job.moleQueueId());
+  watchJob(job);
 }
 
 void QueueUit::jobSubmissionError(const QString &errorString)
@@ -427,8 +443,7 @@ void QueueUit::requestQueueUpdate()
   request->setHostId(m_hostID);
   request->setSearchUser(m_kerberosUserName);
   request->setUserName(m_kerberosUserName);
-  // What should we set this too???
-  request->setNumDays(1);
+  request->setNumDays(queueUpdateNumDays());
 
   connect(request, SIGNAL(finished()),
           this, SLOT(handleQueueUpdate()));
@@ -469,80 +484,158 @@ void QueueUit::handleQueueUpdate()
   }
   request->deleteLater();
 
-  Uit::JobEventList jobEvents = request->jobEventList(m_jobs.keys());
+  // Usually only events since the last update are parsed, the older ones are
+  // already in m_jobEvents.
+  Uit::JobEventList jobEvents = request->jobEventList(m_jobs.keys(),
+                                                      minEventTime());
 
   if (!jobEvents.isValid()) {
+    // Covers no period, so no job may be finalized for lack of events.
     Logger::logError(tr("Invalid response from UIT server: %1")
                         .arg(jobEvents.xml()));
+    m_isCheckingQueue = false;
+    return;
   }
 
-  handleQueueUpdate(jobEvents.jobEvents());
+  const qint64 windowStart = QDateTime::currentDateTime().toTime_t() -
+      request->numDays() * secondsPerDay;
+  expireJobEvents(windowStart);
+  handleQueueUpdate(jobEvents.jobEvents(), windowStart);
 }
 
-bool lessThan(const Uit::JobEvent &j1, const Uit::JobEvent &j2)
+void QueueUit::handleQueueUpdate(const QList<Uit::JobEvent> &jobEvents,
+                                 qint64 windowStart)
 {
-    return j1.eventTime() < j2.eventTime();
-}
-
-
-void QueueUit::handleQueueUpdate(const QList<Uit::JobEvent> &jobEvents)
-{
-  QList<IdType> justFinished;
-  QList<IdType> queueIds = m_jobs.keys();
-
-  QMap<IdType, QList<Uit::JobEvent> > eventMap;
+  // Nothing is indexed yet, e.g. after a restart: all jobs are new. Those
+  // with an unknown submission time only need this response.
+  if (m_lastEventTime <= 0) {
+    foreach (IdType queueId, m_jobs.keys()) {
+      if (m_jobEvents.contains(queueId) || m_newJobs.contains(queueId))
+        continue;
+      QDateTime submissionTime;
+      if (m_server) {
+        submissionTime = m_server->jobManager()->lookupJobByMoleQueueId(
+              m_jobs.value(queueId)).submissionTime();
+      }
+      m_newJobs.insert(queueId, submissionTime.isValid()
+                       ? static_cast<qint64>(submissionTime.toTime_t())
+                       : windowStart);
+    }
+  }
 
-  // Filter JobEvents by jobId
+  // Merge the new events into the index, keeping the latest one of each job.
+  QSet<IdType> updatedJobs;
   foreach(const Uit::JobEvent& jobEvent, jobEvents) {
+    const IdType queueId = jobEvent.jobId();
+    if (!m_jobs.contains(queueId))
+      continue;
+
+    QHash<IdType, Uit::JobEvent>::iterator it = m_jobEvents.find(queueId);
+    if (it == m_jobEvents.end())
+      m_jobEvents.insert(queueId, jobEvent);
+    else if (jobEvent.eventTime() >= it->eventTime())
+      *it = jobEvent;
+    else
+      continue;
+
+    updatedJobs.insert(queueId);
+    m_newJobs.remove(queueId);
+    m_lastEventTime = qMax(m_lastEventTime, jobEvent.eventTime());
+  }
 
-    QList<Uit::JobEvent> events;
+  // Get pointer to jobmanager to lookup jobs
+  if (!m_server) {
+    Logger::logError(tr("Queue '%1' cannot locate Server instance!")
+                     .arg(m_name));
+    m_isCheckingQueue = false;
+    return;
+  }
 
-    if (!eventMap.contains(jobEvent.jobId())) {
-      eventMap[jobEvent.jobId()] = QList<Uit::JobEvent>();
+  foreach(IdType queueId, m_jobs.keys()) {
+    // If there are no events then we assume it has finished. A new job may
+    // only have events from before the response's period.
+    if (!m_jobEvents.contains(queueId)) {
+      QHash<IdType, qint64>::const_iterator newJob = m_newJobs.find(queueId);
+      if (newJob == m_newJobs.constEnd() || windowStart <= newJob.value())
+        beginFinalizeJob(queueId);
+      continue;
     }
 
-    eventMap[jobEvent.jobId()].append(jobEvent);
-  }
-
-  foreach(IdType queueId, queueIds) {
+    if (!updatedJobs.contains(queueId))
+      continue;
 
     IdType moleQueueId = m_jobs.value(queueId, InvalidId);
-
-    if (moleQueueId != InvalidId) {
-      // Get pointer to jobmanager to lookup job
-      if (!m_server) {
-        Logger::logError(tr("Queue '%1' cannot locate Server instance!")
+    Job job = m_server->jobManager()->lookupJobByMoleQueueId(moleQueueId);
+    if (!job.isValid()) {
+      Logger::logError(tr("Queue '%1' Cannot update invalid Job reference!")
                           .arg(m_name), moleQueueId);
-        m_isCheckingQueue = false;
-        return;
-      }
+      continue;
+    }
 
-      Job job = m_server->jobManager()->lookupJobByMoleQueueId(moleQueueId);
-      if (!job.isValid()) {
-        Logger::logError(tr("Queue '%1' Cannot update invalid Job reference!")
-                            .arg(m_name), moleQueueId);
-        continue;
+    JobState currentState = jobEventToJobState(m_jobEvents.value(queueId));
 
-      }
+    if (currentState != job.jobState())
+      job.setJobState(currentState);
+  }
 
-      QList<Uit::JobEvent> events = eventMap[queueId];
+  m_isCheckingQueue = false;
+}
 
-      // If there are no events then we assume it has finished.
-      if (events.isEmpty()) {
-        beginFinalizeJob(queueId);
-        continue;
-      }
+void QueueUit::watchJob(const Job &job)
+{
+  const IdType queueId = job.queueId();
+  const QDateTime submissionTime = job.submissionTime();
+  m_jobs.insert(queueId, job.moleQueueId());
+  m_newJobs.insert(queueId, static_cast<qint64>(
+                     submissionTime.isValid()
+                     ? submissionTime.toTime_t()
+                     : QDateTime::currentDateTime().toTime_t()));
+}
 
-      Uit::JobEvent lastEvent = events.last();
+qint64 QueueUit::minEventTime() const
+{
+  return m_newJobs.isEmpty() ? m_lastEventTime : 0;
+}
 
-      JobState currentState = jobEventToJobState(lastEvent);
+qint64 QueueUit::queueUpdateNumDays() const
+{
+  qint64 since = m_lastEventTime;
+  foreach (qint64 submissionTime, m_newJobs) {
+    if (since <= 0 || submissionTime < since)
+      since = submissionTime;
+  }
+  if (since <= 0)
+    return 1;
 
-      if (currentState != job.jobState())
-        job.setJobState(currentState);
-    }
+  const qint64 age = QDateTime::currentDateTime().toTime_t() - since;
+  return qMax(static_cast<qint64>(1),
+              (age + secondsPerDay - 1) / secondsPerDay);
+}
+
+void QueueUit::expireJobEvents(qint64 windowStart)
+{
+  QHash<IdType, Uit::JobEvent>::iterator it = m_jobEvents.begin();
+  while (it != m_jobEvents.end()) {
+    if (!m_jobs.contains(it.key()) || it->eventTime() < windowStart)
+      it = m_jobEvents.erase(it);
+    else
+      ++it;
   }
 
-  m_isCheckingQueue = false;
+  QHash<IdType, qint64>::iterator newJob = m_newJobs.begin();
+  while (newJob != m_newJobs.end()) {
+    if (!m_jobs.contains(newJob.key()))
+      newJob = m_newJobs.erase(newJob);
+    else
+      ++newJob;
+  }
+}
+
+void QueueUit::clearJobEvents()
+{
+  m_jobEvents.clear();
+  m_newJobs.clear();
+  m_lastEventTime = 0;
 }
 
 void QueueUit::beginFinalizeJob(IdType queueId)
@@ -552,6 +645,8 @@ void QueueUit::beginFinalizeJob(IdType queueId)
     return;
 
   m_jobs.remove(queueId);
+  m_jobEvents.remove(queueId);
+  m_newJobs.remove(queueId);
 
   // Lookup job
   if (!m_server)
@@ -577,13 +672,24 @@ void QueueUit::finalizeJobCopyFromServer(Job job)
   QString remoteDir
     = QString("%1/%2").arg(m_workingDirectoryBase).arg(job.moleQueueId());
 
-  Uit::DirectoryDownload *downloader = new Uit::DirectoryDownload(uitSession(),
-                                                                  this);
+  Uit::FileSystemOperation *downloader = NULL;
+  if (m_archiveTransfers) {
+    Uit::ArchiveDownload *archiveDownload =
+        new Uit::ArchiveDownload(uitSession(), this);
+    archiveDownload->setRemotePath(remoteDir);
+    archiveDownload->setLocalPath(localDir);
+    downloader = archiveDownload;
+  }
+  else {
+    Uit::DirectoryDownload *directoryDownload =
+        new Uit::DirectoryDownload(uitSession(), this);
+    directoryDownload->setRemotePath(remoteDir);
+    directoryDownload->setLocalPath(localDir);
+    downloader = directoryDownload;
+  }
   downloader->setJob(job);
   downloader->setHostId(m_hostID);
   downloader->setUserName(m_kerberosUserName);
-  downloader->setRemotePath(remoteDir);
-  downloader->setLocalPath(localDir);
 
   connect(downloader, SIGNAL(finished()),
           this, SLOT(finalizeJobOutputCopiedFromServer()));
@@ -596,8 +702,8 @@ void QueueUit::finalizeJobCopyFromServer(Job job)
 
 void QueueUit::finalizeJobCopyFromServerError(const QString &errorString)
 {
-  Uit::DirectoryDownload *downloader
-      = qobject_cast<Uit::DirectoryDownload*>(sender());
+  Uit::FileSystemOperation *downloader
+      = qobject_cast<Uit::FileSystemOperation*>(sender());
 
   if (!downloader) {
     Logger::logError(tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
@@ -618,8 +724,8 @@ void QueueUit::finalizeJobCopyFromServerError(const QString &errorString)
 
 void QueueUit::finalizeJobOutputCopiedFromServer()
 {
-  Uit::DirectoryDownload *downloader
-      = qobject_cast<Uit::DirectoryDownload*>(sender());
+  Uit::FileSystemOperation *downloader
+      = qobject_cast<Uit::FileSystemOperation*>(sender());
 
   if (!downloader) {
     Logger::logError(tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
@@ -641,14 +747,15 @@ void QueueUit::finalizeJobCopyToCustomDestination(Job job)
     return;
   }
 
-  // The copy function will throw errors if needed.
-  if (!FileSystemTools::recursiveCopyDirectory(job.localWorkingDirectory(),
-                                               job.outputDirectory())) {
-    job.setJobState(MoleQueue::Error);
-    return;
-  }
-
-  finalizeJobCleanup(job);
+  // Copy in the background; finalizeJobOutputCopiedToCustomDestination
+  // continues once the copy completes.
+  DirectoryOperation *op =
+      DirectoryOperation::copyDirectory(job.localWorkingDirectory(),
+                                        job.outputDirectory(), this);
+  op->setData(QVariant::fromValue(job));
+  connect(op, SIGNAL(finished(bool)),
+          this, SLOT(finalizeJobOutputCopiedToCustomDestination(bool)));
+  op->start();
 }
 
 void QueueUit::finalizeJobCleanup(Job job)
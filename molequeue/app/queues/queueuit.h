@@ -25,8 +25,7 @@
 #include "uit/jobevent.h"
 #include "remote.h"
 
-#include <QtXmlPatterns/QXmlQuery>
-#include <QtXmlPatterns/QAbstractXmlReceiver>
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QMutex>
 
@@ -45,16 +44,23 @@ public:
   explicit QueueUit(QueueManager *parentManager = 0);
   ~QueueUit();
 
+  /// Construct a QueueUit. For QueueManager::registerQueueType().
+  static Queue *create(QueueManager *parentManager)
+  {
+    return new QueueUit(parentManager);
+  }
+
   virtual QString typeName() const { return "ezHPC UIT"; }
 
+  /// Prompts for Kerberos credentials when a session expires.
+  bool requiresGuiThread() const { return true; }
+
   bool writeJsonSettings(QJsonObject &json, bool exportOnly,
                          bool includePrograms) const;
 
   bool readJsonSettings(const QJsonObject &json, bool importOnly,
                         bool includePrograms);
 
-  AbstractQueueSettingsWidget* settingsWidget();
-
   /**
    * @return The Kerberos username.
    */
@@ -67,6 +73,8 @@ public:
    */
   void setKerberosUserName(const QString &userName) {
     m_kerberosUserName = userName;
+    // Look up the session for the new principal on next use.
+    m_uitSession = NULL;
   }
 
   /**
@@ -81,6 +89,7 @@ public:
    */
   void setKerberosRealm(const QString &realm) {
     m_kerberosRealm = realm;
+    m_uitSession = NULL;
   }
 
   QString hostName() const {
@@ -96,9 +105,26 @@ public:
   }
 
   void setHostID(qint64 id) {
+    if (id != m_hostID)
+      clearJobEvents();
     m_hostID = id;
   }
 
+  /**
+   * @return true if job files are transferred as a single tar archive that is
+   * packed and unpacked on the remote host, rather than file by file.
+   */
+  bool archiveTransfers() const {
+    return m_archiveTransfers;
+  }
+
+  /**
+   * @param archive Whether to transfer job files as a single tar archive.
+   */
+  void setArchiveTransfers(bool archive) {
+    m_archiveTransfers = archive;
+  }
+
   /**
    * Test the connection to UIT.
    */
@@ -137,7 +163,10 @@ protected slots:
   void jobSubmittedToRemoteQueue();
   void jobSubmissionError(const QString &errorString);
   void handleQueueUpdate();
-  void handleQueueUpdate(const QList<Uit::JobEvent> &jobEvents);
+  /// Merge @a jobEvents into m_jobEvents and update the jobs. @a windowStart
+  /// is the start of the period covered by the response.
+  void handleQueueUpdate(const QList<Uit::JobEvent> &jobEvents,
+                         qint64 windowStart = 0);
   void requestQueueUpdateError(const QString&);
 
   //void beginJobSubmission(Job job);
@@ -179,9 +208,42 @@ private:
   UitapiService m_uit;
   QWidget *m_dialogParent;
   bool m_isCheckingQueue;
+  bool m_archiveTransfers;
+  /// Newest eventTime seen by handleQueueUpdate(), or 0 before the first
+  /// update. Older events are skipped while parsing the next response,
+  /// unless there are new jobs.
+  qint64 m_lastEventTime;
+  /// Latest event of each job in m_jobs, by queue id, kept between updates.
+  QHash<IdType, Uit::JobEvent> m_jobEvents;
+  /// Jobs in m_jobs that have had no event yet, by queue id, with the time
+  /// from which their events may appear. Their events may be older than
+  /// m_lastEventTime, and they are only finalized for lack of events by a
+  /// response covering that whole period.
+  QHash<IdType, qint64> m_newJobs;
 
   Uit::Session * uitSession();
 
+  /// Add @a job, which was just submitted, to m_jobs and m_newJobs.
+  void watchJob(const Job &job);
+
+  /// @return The eventTime of the oldest event to parse from the next
+  /// response: m_lastEventTime, or 0 while there are new jobs.
+  qint64 minEventTime() const;
+
+  /// @return The number of days of events to request so that every event
+  /// since m_lastEventTime, and since the submission of the new jobs, is
+  /// included. The UIT API only filters by day.
+  qint64 queueUpdateNumDays() const;
+
+  /// Forget the events of jobs that were removed from m_jobs, and of those
+  /// whose latest event is older than @a windowStart, the start of the
+  /// period covered by the last response. Such jobs are finalized by the
+  /// next handleQueueUpdate().
+  void expireJobEvents(qint64 windowStart);
+
+  /// Forget all events, e.g. when the host changes.
+  void clearJobEvents();
+
 private slots:
   void getUserHostAssoc();
   void getUserHostAssocComplete();
@@ -16,13 +16,12 @@
 
 #include "remote.h"
 
-#include "../filesystemtools.h"
+#include "../directoryoperation.h"
 #include "../job.h"
 #include "../jobmanager.h"
 #include "../logentry.h"
 #include "../logger.h"
 #include "../program.h"
-#include "../remotequeuewidget.h"
 #include "../server.h"
 
 #include <qjsondocument.h>
@@ -30,8 +29,6 @@
 #include <QtCore/QTimer>
 #include <QtCore/QDebug>
 
-#include <QtGui>
-
 namespace MoleQueue {
 
 QueueRemote::QueueRemote(const QString &queueName, QueueManager *parentObject)
@@ -106,38 +103,25 @@ void QueueRemote::setQueueUpdateInterval(int interval)
   requestQueueUpdate();
 }
 
-void QueueRemote::replaceKeywords(QString &launchScript,
-                                  const Job &job, bool addNewline)
+void QueueRemote::insertKeywords(const Job &job,
+                                 QHash<QString, QString> &keywords,
+                                 QHash<QString, QString> &lineKeywords) const
 {
+  Queue::insertKeywords(job, keywords, lineKeywords);
+
   // If a valid walltime is set, replace all occurances with the appropriate
-  // string:
+  // string. Otherwise, erase all lines containing $$$maxWallTime$$$.
   int wallTime = job.maxWallTime();
-  int hours = wallTime / 60;
-  int minutes = wallTime % 60;
-  if (wallTime > 0) {
-    launchScript.replace("$$$maxWallTime$$$",
-                         QString("%1:%2:00")
-                         .arg(hours, 2, 10, QChar('0'))
-                         .arg(minutes, 2, 10, QChar('0')));
-  }
-  // Otherwise, erase all lines containing the keyword
-  else {
-    QRegExp expr("\\n[^\\n]*\\${3,3}maxWallTime\\${3,3}[^\\n]*\\n");
-    launchScript.replace(expr, "\n");
-  }
-
-  if (wallTime <= 0) {
+  bool hasWallTime = wallTime > 0;
+  if (!hasWallTime)
     wallTime = defaultMaxWallTime();
-    hours = wallTime / 60;
-    minutes = wallTime % 60;
-  }
 
-  launchScript.replace("$$maxWallTime$$",
-                       QString("%1:%2:00")
-                       .arg(hours, 2, 10, QChar('0'))
-                       .arg(minutes, 2, 10, QChar('0')));
+  QString wallTimeString = QString("%1:%2:00")
+      .arg(wallTime / 60, 2, 10, QChar('0'))
+      .arg(wallTime % 60, 2, 10, QChar('0'));
 
-  Queue::replaceKeywords(launchScript, job, addNewline);
+  lineKeywords.insert("maxWallTime", hasWallTime ? wallTimeString : QString());
+  keywords.insert("maxWallTime", wallTimeString);
 }
 
 bool QueueRemote::submitJob(Job job)
@@ -242,12 +226,33 @@ void QueueRemote::finalizeJobCopyToCustomDestination(Job job)
     return;
   }
 
-  // The copy function will throw errors if needed.
-  if (!FileSystemTools::recursiveCopyDirectory(job.localWorkingDirectory(),
-                                               job.outputDirectory())) {
-    Logger::logError(tr("Cannot copy '%1' -> '%2'.")
-                     .arg(job.localWorkingDirectory(),
-                          job.outputDirectory()), job.moleQueueId());
+  // Copy in the background; finalizeJobOutputCopiedToCustomDestination
+  // continues once the copy completes.
+  DirectoryOperation *op =
+      DirectoryOperation::copyDirectory(job.localWorkingDirectory(),
+                                        job.outputDirectory(), this);
+  op->setData(QVariant::fromValue(job));
+  connect(op, SIGNAL(finished(bool)),
+          this, SLOT(finalizeJobOutputCopiedToCustomDestination(bool)));
+  op->start();
+}
+
+void QueueRemote::finalizeJobOutputCopiedToCustomDestination(bool success)
+{
+  DirectoryOperation *op = qobject_cast<DirectoryOperation*>(sender());
+  if (!op)
+    return;
+
+  op->deleteLater();
+
+  Job job = op->data().value<Job>();
+  if (!job.isValid())
+    return;
+
+  if (!success) {
+    Logger::logError(tr("Cannot copy '%1' -> '%2': %3")
+                     .arg(op->source(), op->target(), op->errorString()),
+                     job.moleQueueId());
     job.setJobState(MoleQueue::Error);
     return;
   }
@@ -280,7 +285,7 @@ void QueueRemote::removeStaleJobs()
       QList<IdType> staleQueueIds;
       for (QMap<IdType, IdType>::const_iterator it = m_jobs.constBegin(),
            it_end = m_jobs.constEnd(); it != it_end; ++it) {
-        if (jobManager->lookupJobByMoleQueueId(it.value()).isValid())
+        if (jobManager->contains(it.value()))
           continue;
         staleQueueIds << it.key();
         Logger::logError(tr("Job with MoleQueue id %1 is missing, but the Queue"
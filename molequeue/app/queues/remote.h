@@ -39,8 +39,6 @@ public:
   bool readJsonSettings(const QJsonObject &json, bool importOnly,
                         bool includePrograms);
 
-  virtual AbstractQueueSettingsWidget* settingsWidget() = 0;
-
   void setWorkingDirectoryBase(const QString &base)
   {
     m_workingDirectoryBase = base;
@@ -75,10 +73,6 @@ public:
    */
   int defaultMaxWallTime() const { return m_defaultMaxWallTime; }
 
-  /// Reimplemented from Queue::replaceKeywords
-  void replaceKeywords(QString &launchScript, const Job &job,
-                       bool addNewline = true);
-
 public slots:
 
   bool submitJob(MoleQueue::Job job);
@@ -106,6 +100,7 @@ protected slots:
   virtual void finalizeJobCopyFromServer(MoleQueue::Job job) = 0;
   virtual void finalizeJobOutputCopiedFromServer() = 0;
   virtual void finalizeJobCopyToCustomDestination(MoleQueue::Job job) = 0;
+  virtual void finalizeJobOutputCopiedToCustomDestination(bool success);
   virtual void finalizeJobCleanup(MoleQueue::Job job);
 
   virtual void cleanRemoteDirectory(MoleQueue::Job job) = 0;
@@ -131,6 +126,10 @@ protected:
   /// Reimplemented to monitor queue events.
   virtual void timerEvent(QTimerEvent *theEvent);
 
+  /// Reimplemented to add the $$maxWallTime$$ and $$$maxWallTime$$$ keywords.
+  void insertKeywords(const Job &job, QHash<QString, QString> &keywords,
+                      QHash<QString, QString> &lineKeywords) const;
+
   int m_checkQueueTimerId;
 
   /// MoleQueue ids of jobs that have been accepted but not submitted.
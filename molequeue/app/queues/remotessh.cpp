@@ -16,31 +16,46 @@
 
 #include "remotessh.h"
 
-#include "../filesystemtools.h"
+#include "../directoryoperation.h"
 #include "../job.h"
 #include "../jobmanager.h"
 #include "../logentry.h"
 #include "../logger.h"
 #include "../program.h"
-#include "../remotequeuewidget.h"
 #include "../server.h"
 #include "../sshcommandfactory.h"
 
 #include <qjsondocument.h>
 
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegExp>
+#include <QtCore/QSet>
 #include <QtCore/QTimer>
 #include <QtCore/QDebug>
 
-#include <QtGui>
 
 namespace MoleQueue {
 
+namespace {
+/// Quote @a arg for use in a POSIX shell command line. Used for input
+/// filenames; directories are passed unquoted, as elsewhere in this class, so
+/// that "~" keeps working.
+QString shellQuote(const QString &arg)
+{
+  QString quoted = arg;
+  quoted.replace("'", "'\\''");
+  return "'" + quoted + "'";
+}
+} // end anon namespace
+
 QueueRemoteSsh::QueueRemoteSsh(const QString &queueName, QueueManager *parentObject)
   : QueueRemote(queueName, parentObject),
     m_sshExecutable(SshCommandFactory::defaultSshCommand()),
     m_scpExecutable(SshCommandFactory::defaultScpCommand()),
     m_sshPort(22),
-    m_isCheckingQueue(false)
+    m_isCheckingQueue(false),
+    m_useInputCache(true)
 {
   // Check for jobs to submit every 5 seconds
   m_checkForPendingJobsTimerId = startTimer(5000);
@@ -64,6 +79,7 @@ bool QueueRemoteSsh::writeJsonSettings(QJsonObject &json, bool exportOnly,
   json.insert("killCommand", m_killCommand);
   json.insert("hostName", m_hostName);
   json.insert("sshPort", static_cast<double>(m_sshPort));
+  json.insert("useInputCache", m_useInputCache);
 
   if (!exportOnly) {
     json.insert("sshExecutable", m_sshExecutable);
@@ -102,6 +118,9 @@ bool QueueRemoteSsh::readJsonSettings(const QJsonObject &json, bool importOnly,
   m_killCommand = json.value("killCommand").toString();
   m_hostName = json.value("hostName").toString();
   m_sshPort = static_cast<int>(json.value("sshPort").toDouble() + 0.5);
+  // Optional, older configurations do not have it.
+  if (json.value("useInputCache").isBool())
+    m_useInputCache = json.value("useInputCache").toBool();
 
   if (!importOnly) {
     m_sshExecutable = json.value("sshExecutable").toString();
@@ -113,12 +132,6 @@ bool QueueRemoteSsh::readJsonSettings(const QJsonObject &json, bool importOnly,
   return true;
 }
 
-AbstractQueueSettingsWidget* QueueRemoteSsh::settingsWidget()
-{
-  RemoteQueueWidget *widget = new RemoteQueueWidget (this);
-  return widget;
-}
-
 void QueueRemoteSsh::createRemoteDirectory(Job job)
 {
   // Note that this is just the working directory base -- the job folder is
@@ -176,6 +189,12 @@ void QueueRemoteSsh::remoteDirectoryCreated()
 
 void QueueRemoteSsh::copyInputFilesToHost(Job job)
 {
+  m_uncachedInputFiles.remove(job.moleQueueId());
+  if (m_useInputCache && !job.inputFileHashes().isEmpty()) {
+    checkRemoteInputCache(job);
+    return;
+  }
+
   QString localDir = job.localWorkingDirectory();
   QString remoteDir = QDir::cleanPath(QString("%1/%2")
                                       .arg(m_workingDirectoryBase)
@@ -196,6 +215,130 @@ void QueueRemoteSsh::copyInputFilesToHost(Job job)
   }
 }
 
+void QueueRemoteSsh::checkRemoteInputCache(Job job)
+{
+  QString remoteDir = QDir::cleanPath(QString("%1/%2")
+                                      .arg(m_workingDirectoryBase)
+                                      .arg(idTypeToString(job.moleQueueId())));
+  QString cacheDir = QDir::cleanPath(inputCacheDirectory());
+
+  // Copy every cached input file into the job directory, and print the hashes
+  // of those that are not cached yet. Cached files are read-only, so make the
+  // copies writable; only programs that allow it get the shared file itself.
+  QString place("cp %1 %2 && chmod u+w %2");
+  const Program *program = lookupProgram(job.program());
+  if (program && program->linkInputFiles())
+    place = "ln -f %1 %2 || cp %1 %2";
+
+  QStringList commands;
+  commands << QString("mkdir -p %1 %2").arg(remoteDir, cacheDir)
+           << QString("cd %1").arg(remoteDir);
+  QMap<QString, QString> hashes = job.inputFileHashes();
+  for (QMap<QString, QString>::const_iterator it = hashes.constBegin(),
+       itEnd = hashes.constEnd(); it != itEnd; ++it) {
+    QString cached = cacheDir + "/" + it.value();
+    QString target = shellQuote(it.key());
+    commands << QString("{ if [ -f %1 ]; then %2; else echo %3; fi; }")
+                .arg(cached, place.arg(cached, target), it.value());
+  }
+
+  SshConnection *conn = newSshConnection();
+  conn->setData(QVariant::fromValue(job));
+  connect(conn, SIGNAL(requestComplete()),
+          this, SLOT(remoteInputCacheChecked()));
+
+  if (!conn->execute(commands.join(" && "))) {
+    Logger::logError(tr("Could not initialize ssh resources: user= '%1'\nhost ="
+                        " '%2' port = '%3'")
+                     .arg(conn->userName()).arg(conn->hostName())
+                     .arg(conn->portNumber()), job.moleQueueId());
+    job.setJobState(MoleQueue::Error);
+    conn->deleteLater();
+    return;
+  }
+}
+
+void QueueRemoteSsh::remoteInputCacheChecked()
+{
+  SshConnection *conn = qobject_cast<SshConnection*>(sender());
+  if (!conn) {
+    Logger::logError(tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                     .arg("Sender is not an SshConnection!"));
+    return;
+  }
+  conn->deleteLater();
+
+  Job job = conn->data().value<Job>();
+
+  if (!job.isValid()) {
+    Logger::logError(tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                     .arg("Sender does not have an associated job!"));
+    return;
+  }
+
+  QMap<QString, QString> hashes = job.inputFileHashes();
+  QMap<QString, QString> uncached;
+
+  if (conn->exitCode() != 0) {
+    // Not fatal, just upload everything.
+    Logger::logWarning(tr("Error while checking the remote input cache '%1'. "
+                          "Uploading all input files.\nExit code (%2) %3")
+                       .arg(inputCacheDirectory()).arg(conn->exitCode())
+                       .arg(conn->output()), job.moleQueueId());
+    uncached = hashes;
+  }
+  else {
+    QSet<QString> missing = QSet<QString>::fromList(
+          conn->output().split(QRegExp("\\s+"), QString::SkipEmptyParts));
+    for (QMap<QString, QString>::const_iterator it = hashes.constBegin(),
+         itEnd = hashes.constEnd(); it != itEnd; ++it) {
+      if (missing.contains(it.value()))
+        uncached.insert(it.key(), it.value());
+    }
+    Logger::logDebugMessage(tr("%1 of %2 input files found in the remote input "
+                               "cache.").arg(hashes.size() - uncached.size())
+                            .arg(hashes.size()), job.moleQueueId());
+  }
+
+  // Upload the contents of the job directory, except for the files that have
+  // been linked from the cache.
+  QString localDir = job.localWorkingDirectory();
+  QString remoteDir = QDir::cleanPath(QString("%1/%2")
+                                      .arg(m_workingDirectoryBase)
+                                      .arg(idTypeToString(job.moleQueueId())));
+  QStringList uploads;
+  foreach (const QFileInfo &info, QDir(localDir).entryInfoList(
+             QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden |
+             QDir::System, QDir::Name)) {
+    if (!hashes.contains(info.fileName()) ||
+        uncached.contains(info.fileName())) {
+      uploads << info.absoluteFilePath();
+    }
+  }
+
+  if (!uncached.isEmpty())
+    m_uncachedInputFiles.insert(job.moleQueueId(), uncached);
+
+  if (uploads.isEmpty()) {
+    submitJobToRemoteQueue(job);
+    return;
+  }
+
+  SshConnection *upload = newSshConnection();
+  upload->setData(QVariant::fromValue(job));
+  connect(upload, SIGNAL(requestComplete()), this, SLOT(inputFilesCopied()));
+
+  if (!upload->copyFilesTo(uploads, remoteDir)) {
+    Logger::logError(tr("Could not initialize ssh resources: user= '%1'\nhost ="
+                        " '%2' port = '%3'")
+                     .arg(upload->userName()).arg(upload->hostName())
+                     .arg(upload->portNumber()), job.moleQueueId());
+    job.setJobState(MoleQueue::Error);
+    upload->deleteLater();
+    return;
+  }
+}
+
 void QueueRemoteSsh::inputFilesCopied()
 {
   SshConnection *conn = qobject_cast<SshConnection*>(sender());
@@ -236,6 +379,78 @@ void QueueRemoteSsh::inputFilesCopied()
     return;
   }
 
+  if (m_uncachedInputFiles.contains(job.moleQueueId())) {
+    updateRemoteInputCache(job);
+    return;
+  }
+
+  submitJobToRemoteQueue(job);
+}
+
+void QueueRemoteSsh::updateRemoteInputCache(Job job)
+{
+  QString remoteDir = QDir::cleanPath(QString("%1/%2")
+                                      .arg(m_workingDirectoryBase)
+                                      .arg(idTypeToString(job.moleQueueId())));
+  QString cacheDir = QDir::cleanPath(inputCacheDirectory());
+
+  // Cached files are shared between jobs, so make them read-only. Linking the
+  // job's own file into the cache would make it read-only too, so copy it
+  // unless the program allows linked input files.
+  QString place("cp %1 %2");
+  const Program *program = lookupProgram(job.program());
+  if (program && program->linkInputFiles())
+    place = "{ ln -f %1 %2 || cp %1 %2; }";
+
+  QStringList commands;
+  commands << QString("cd %1").arg(remoteDir);
+  QMap<QString, QString> uncached = m_uncachedInputFiles.take(job.moleQueueId());
+  for (QMap<QString, QString>::const_iterator it = uncached.constBegin(),
+       itEnd = uncached.constEnd(); it != itEnd; ++it) {
+    QString cached = cacheDir + "/" + it.value();
+    QString source = shellQuote(it.key());
+    commands << place.arg(source, cached)
+             << QString("chmod a-w %1").arg(cached);
+  }
+
+  SshConnection *conn = newSshConnection();
+  conn->setData(QVariant::fromValue(job));
+  connect(conn, SIGNAL(requestComplete()),
+          this, SLOT(remoteInputCacheUpdated()));
+
+  if (!conn->execute(commands.join(" && "))) {
+    // The job itself is fine, just submit it.
+    conn->deleteLater();
+    submitJobToRemoteQueue(job);
+    return;
+  }
+}
+
+void QueueRemoteSsh::remoteInputCacheUpdated()
+{
+  SshConnection *conn = qobject_cast<SshConnection*>(sender());
+  if (!conn) {
+    Logger::logError(tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                     .arg("Sender is not an SshConnection!"));
+    return;
+  }
+  conn->deleteLater();
+
+  Job job = conn->data().value<Job>();
+
+  if (!job.isValid()) {
+    Logger::logError(tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                     .arg("Sender does not have an associated job!"));
+    return;
+  }
+
+  if (conn->exitCode() != 0) {
+    Logger::logWarning(tr("Error while adding input files to the remote input "
+                          "cache '%1'.\nExit code (%2) %3")
+                       .arg(inputCacheDirectory()).arg(conn->exitCode())
+                       .arg(conn->output()), job.moleQueueId());
+  }
+
   submitJobToRemoteQueue(job);
 }
 
@@ -480,17 +695,15 @@ void QueueRemoteSsh::finalizeJobCopyToCustomDestination(Job job)
     return;
   }
 
-  // The copy function will throw errors if needed.
-  if (!FileSystemTools::recursiveCopyDirectory(job.localWorkingDirectory(),
-                                               job.outputDirectory())) {
-    Logger::logError(tr("Cannot copy '%1' -> '%2'.")
-                     .arg(job.localWorkingDirectory(),
-                          job.outputDirectory()), job.moleQueueId());
-    job.setJobState(MoleQueue::Error);
-    return;
-  }
-
-  finalizeJobCleanup(job);
+  // Copy in the background; finalizeJobOutputCopiedToCustomDestination
+  // continues once the copy completes.
+  DirectoryOperation *op =
+      DirectoryOperation::copyDirectory(job.localWorkingDirectory(),
+                                        job.outputDirectory(), this);
+  op->setData(QVariant::fromValue(job));
+  connect(op, SIGNAL(finished(bool)),
+          this, SLOT(finalizeJobOutputCopiedToCustomDestination(bool)));
+  op->start();
 }
 
 void QueueRemoteSsh::finalizeJobCleanup(Job job)
@@ -131,7 +131,24 @@ public:
     return m_requestQueueCommand;
   }
 
-  virtual AbstractQueueSettingsWidget* settingsWidget();
+  /// If true, deduplicated input files are kept in inputCacheDirectory() on
+  /// the remote host and only uploaded if no file with the same hash is
+  /// present there. Default: true
+  void setUseInputCache(bool use)
+  {
+    m_useInputCache = use;
+  }
+
+  bool useInputCache() const
+  {
+    return m_useInputCache;
+  }
+
+  /// @return The directory on the remote host holding cached input files.
+  QString inputCacheDirectory() const
+  {
+    return m_workingDirectoryBase + "/.molequeue-cache";
+  }
 
 public slots:
   void requestQueueUpdate();
@@ -141,7 +158,11 @@ protected slots:
   void createRemoteDirectory(MoleQueue::Job job);
   void remoteDirectoryCreated();
   void copyInputFilesToHost(MoleQueue::Job job);
+  void checkRemoteInputCache(MoleQueue::Job job);
+  void remoteInputCacheChecked();
   void inputFilesCopied();
+  void updateRemoteInputCache(MoleQueue::Job job);
+  void remoteInputCacheUpdated();
   void submitJobToRemoteQueue(MoleQueue::Job job);
   void jobSubmittedToRemoteQueue();
   void handleQueueUpdate();
@@ -208,6 +229,11 @@ protected:
   /// has completed.
   QList<int> m_allowedQueueRequestExitCodes;
 
+  bool m_useInputCache;
+  /// Deduplicated input files that were missing from the remote input cache
+  /// and have been uploaded with the job (MoleQueueId to (filename to hash)).
+  QMap<IdType, QMap<QString, QString> > m_uncachedInputFiles;
+
 };
 
 } // End namespace
@@ -0,0 +1,169 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "archivedownload.h"
+#include "requests.h"
+#include "filestreamingdata.h"
+#include "filetransferscheduler.h"
+#include "logger.h"
+#include "session.h"
+#include "tarextractdevice.h"
+
+namespace MoleQueue {
+namespace Uit {
+
+ArchiveDownload::ArchiveDownload(Session *session, QObject *parentObject)
+  : FileSystemOperation(session, parentObject),
+    m_extractor(NULL),
+    m_transfers(new FileTransferScheduler(this))
+{
+  connect(m_transfers, SIGNAL(finished()),
+          this, SLOT(archiveDownloaded()));
+  connect(m_transfers, SIGNAL(error(const QString &)),
+          this, SLOT(transferError(const QString &)));
+}
+
+void ArchiveDownload::start()
+{
+  RunSimpleCommandRequest *request = new RunSimpleCommandRequest(m_session,
+                                                                 this);
+  request->setHostId(m_hostID);
+  request->setUserName(m_userName);
+  request->setJob(m_job);
+  // A single arg() call, so %1 or %2 in a path is not replaced again.
+  request->setCommand(
+        QString("tar -cf %1 -C %2 .")
+        .arg(RunSimpleCommandRequest::quote(archivePath()),
+             RunSimpleCommandRequest::quote(QDir::cleanPath(m_remotePath))));
+
+  connect(request, SIGNAL(finished()),
+          this, SLOT(packComplete()));
+  connect(request, SIGNAL(error(const QString &)),
+          this, SLOT(requestError(const QString &)));
+
+  request->submit();
+}
+
+void ArchiveDownload::packComplete()
+{
+  RunSimpleCommandRequest *request
+    = qobject_cast<RunSimpleCommandRequest*>(sender());
+
+  if (!request) {
+    QString msg = tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                  .arg("Sender is not RunSimpleCommandRequest!");
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+  request->deleteLater();
+
+  if (!request->succeeded()) {
+    QString msg = tr("Unable to archive %1 on the remote host: %2")
+                  .arg(m_remotePath, request->output());
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+
+  GetStreamingFileDownloadURLRequest *urlRequest
+    = new GetStreamingFileDownloadURLRequest(m_session, this);
+
+  connect(urlRequest, SIGNAL(finished()),
+          this, SLOT(downloadInternal()));
+  connect(urlRequest, SIGNAL(error(const QString &)),
+          this, SLOT(requestError(const QString &)));
+
+  urlRequest->submit();
+}
+
+void ArchiveDownload::downloadInternal()
+{
+  GetStreamingFileDownloadURLRequest *request
+    = qobject_cast<GetStreamingFileDownloadURLRequest*>(sender());
+
+  if (!request) {
+    QString msg = tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                  .arg("Sender is not GetStreamingFileDownloadURLRequest!");
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+
+  request->deleteLater();
+  m_transfers->setUrl(QUrl(request->url()));
+
+  FileStreamingData fileData;
+  fileData.setToken(m_session->token());
+  fileData.setFileName(archivePath());
+  fileData.setUserName(m_userName);
+  fileData.setHostID(m_hostID);
+
+  // Unpacked as it arrives, the archive itself never touches the disk.
+  m_extractor = new TarExtractDevice(m_localPath, this);
+  m_transfers->addDownload(fileData, m_extractor);
+  m_transfers->close();
+}
+
+void ArchiveDownload::archiveDownloaded()
+{
+  if (!m_extractor->isComplete()) {
+    QString msg = tr("Archive %1 is truncated.").arg(archivePath());
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+
+  DeleteFileRequest *request = new DeleteFileRequest(m_session, this);
+  request->setHostId(m_hostID);
+  request->setUserName(m_userName);
+  request->setFile(archivePath());
+
+  connect(request, SIGNAL(finished()),
+          this, SLOT(cleanupComplete()));
+  connect(request, SIGNAL(error(const QString &)),
+          this, SLOT(cleanupError(const QString &)));
+
+  request->submit();
+}
+
+void ArchiveDownload::cleanupComplete()
+{
+  Request *request = qobject_cast<Request*>(sender());
+  if (request)
+    request->deleteLater();
+
+  emit finished();
+}
+
+void ArchiveDownload::cleanupError(const QString &errorString)
+{
+  // The output has been retrieved, a stale archive is not worth failing for.
+  Logger::logWarning(tr("Unable to remove %1: %2").arg(archivePath(),
+                                                       errorString),
+                     m_job.moleQueueId());
+  cleanupComplete();
+}
+
+void ArchiveDownload::transferError(const QString &errorString)
+{
+  Logger::logError(tr("Error downloading archive: %1").arg(errorString),
+                   m_job.moleQueueId());
+  emit error(errorString);
+}
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
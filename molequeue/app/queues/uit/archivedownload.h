@@ -0,0 +1,117 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef UITARCHIVEDOWNLOAD_H_
+#define UITARCHIVEDOWNLOAD_H_
+
+#include "filesystemoperation.h"
+
+#include <QtCore/QDir>
+
+namespace MoleQueue {
+namespace Uit {
+
+class FileTransferScheduler;
+class Session;
+class TarExtractDevice;
+
+/**
+ * @brief File system operation to download a directory from a remote UIT
+ * system as a single tar archive.
+ *
+ * The remote directory is packed into archivePath() with a runSimpleCommand
+ * request. The archive is unpacked locally while it is downloaded, then
+ * removed from the remote host.
+ */
+class ArchiveDownload : public FileSystemOperation
+{
+  Q_OBJECT
+public:
+  /**
+   * @param session The UIT session.
+   * @param parentObject The parent object.
+   */
+  ArchiveDownload(Session *session, QObject *parentObject = 0);
+
+  /**
+   * @return The remote path being downloaded.
+   */
+  QString remotePath() const
+  {
+    return m_remotePath;
+  }
+
+  /**
+   * @param path The remote path to be downloaded.
+   */
+  void setRemotePath(const QString& path)
+  {
+    m_remotePath = path;
+  }
+
+  /**
+   * @return The local path to download the directory to.
+   */
+  QString localPath() const
+  {
+    return m_localPath;
+  }
+
+  /**
+   * @param path The local path to download the directory to.
+   */
+  void setLocalPath(const QString& path)
+  {
+    m_localPath = path;
+  }
+
+  /**
+   * @return The remote path of the archive, next to remotePath().
+   */
+  QString archivePath() const
+  {
+    return QDir::cleanPath(m_remotePath) + ".tar";
+  }
+
+  /**
+   * @return The scheduler used to stream the archive.
+   */
+  FileTransferScheduler * transfers() const
+  {
+    return m_transfers;
+  }
+
+  void start();
+
+private slots:
+  void packComplete();
+  void downloadInternal();
+  void archiveDownloaded();
+  void cleanupComplete();
+  void cleanupError(const QString &errorString);
+  void transferError(const QString &errorString);
+
+private:
+  QString m_remotePath;
+  QString m_localPath;
+  TarExtractDevice *m_extractor;
+  FileTransferScheduler *m_transfers;
+};
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
+
+#endif /* UITARCHIVEDOWNLOAD_H_ */
@@ -0,0 +1,144 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "archiveupload.h"
+#include "requests.h"
+#include "filestreamingdata.h"
+#include "filetransferscheduler.h"
+#include "logger.h"
+#include "session.h"
+#include "tararchivedevice.h"
+
+namespace MoleQueue {
+namespace Uit {
+
+ArchiveUpload::ArchiveUpload(Session *session, QObject *parentObject)
+  : FileSystemOperation(session, parentObject),
+    m_archive(NULL),
+    m_transfers(new FileTransferScheduler(this))
+{
+  connect(m_transfers, SIGNAL(finished()),
+          this, SLOT(archiveUploaded()));
+  connect(m_transfers, SIGNAL(error(const QString &)),
+          this, SLOT(transferError(const QString &)));
+}
+
+void ArchiveUpload::start()
+{
+  GetStreamingFileUploadURLRequest *request
+    = new GetStreamingFileUploadURLRequest(m_session, this);
+
+  connect(request, SIGNAL(finished()),
+          this, SLOT(uploadInternal()));
+  connect(request, SIGNAL(error(const QString &)),
+          this, SLOT(requestError(const QString &)));
+
+  request->submit();
+}
+
+void ArchiveUpload::uploadInternal()
+{
+  GetStreamingFileUploadURLRequest *request
+    = qobject_cast<GetStreamingFileUploadURLRequest*>(sender());
+
+  if (!request) {
+    QString msg = tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                     .arg("Sender is not GetStreamingFileUploadURLRequest!");
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+
+  request->deleteLater();
+  m_transfers->setUrl(QUrl(request->url()));
+
+  m_archive = new TarArchiveDevice(m_localPath, this);
+  if (!m_archive->open(QIODevice::ReadOnly)) {
+    QString msg = tr("Unable to archive %1: %2").arg(m_localPath,
+                                                     m_archive->errorString());
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+
+  FileStreamingData fileData;
+  fileData.setToken(m_session->token());
+  fileData.setFileName(archivePath());
+  fileData.setUserName(m_userName);
+  fileData.setHostID(m_hostID);
+
+  m_transfers->addUpload(m_archive, fileData);
+  m_transfers->close();
+}
+
+void ArchiveUpload::archiveUploaded()
+{
+  m_archive->close();
+
+  QString remoteDir = RunSimpleCommandRequest::quote(
+        QDir::cleanPath(m_remotePath));
+  QString archive = RunSimpleCommandRequest::quote(archivePath());
+
+  RunSimpleCommandRequest *request = new RunSimpleCommandRequest(m_session,
+                                                                 this);
+  request->setHostId(m_hostID);
+  request->setUserName(m_userName);
+  request->setJob(m_job);
+  // A single arg() call, so %1 or %2 in a path is not replaced again.
+  request->setCommand(QString("mkdir -p %1 && tar -xf %2 -C %1 && rm -f %2")
+                      .arg(remoteDir, archive));
+
+  connect(request, SIGNAL(finished()),
+          this, SLOT(unpackComplete()));
+  connect(request, SIGNAL(error(const QString &)),
+          this, SLOT(requestError(const QString &)));
+
+  request->submit();
+}
+
+void ArchiveUpload::unpackComplete()
+{
+  RunSimpleCommandRequest *request
+    = qobject_cast<RunSimpleCommandRequest*>(sender());
+
+  if (!request) {
+    QString msg = tr("Internal error: %1\n%2").arg(Q_FUNC_INFO)
+                     .arg("Sender is not RunSimpleCommandRequest!");
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+  request->deleteLater();
+
+  if (!request->succeeded()) {
+    QString msg = tr("Unable to unpack %1 on the remote host: %2")
+                     .arg(archivePath(), request->output());
+    Logger::logError(msg, m_job.moleQueueId());
+    emit error(msg);
+    return;
+  }
+
+  emit finished();
+}
+
+void ArchiveUpload::transferError(const QString &errorString)
+{
+  Logger::logError(errorString, m_job.moleQueueId());
+  emit error(errorString);
+}
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
@@ -0,0 +1,114 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef UITARCHIVEUPLOAD_H_
+#define UITARCHIVEUPLOAD_H_
+
+#include "filesystemoperation.h"
+
+#include <QtCore/QDir>
+
+namespace MoleQueue {
+namespace Uit {
+
+class FileTransferScheduler;
+class Session;
+class TarArchiveDevice;
+
+/**
+ * @brief File system operation to upload a directory to a remote UIT system
+ * as a single tar archive.
+ *
+ * The archive is generated while it is streamed to archivePath(), then
+ * unpacked into the remote path with a runSimpleCommand request and removed.
+ */
+class ArchiveUpload: public FileSystemOperation
+{
+  Q_OBJECT
+public:
+  /**
+   * @param session The UIT session.
+   * @param parentObject The parent object.
+   */
+  ArchiveUpload(Session *session, QObject *parentObject = 0);
+
+  /**
+   * @return The local path to be uploaded.
+   */
+  QString localPath() const
+  {
+    return m_localPath;
+  }
+
+  /**
+   * @param path The local path to be uploaded.
+   */
+  void setLocalPath(const QString& path)
+  {
+    m_localPath = path;
+  }
+
+  /**
+   * @return The remote directory the archive is unpacked into.
+   */
+  QString remotePath() const
+  {
+    return m_remotePath;
+  }
+
+  /**
+   * @param path The remote directory to unpack the archive into.
+   */
+  void setRemotePath(const QString& path)
+  {
+    m_remotePath = path;
+  }
+
+  /**
+   * @return The remote path of the archive, next to remotePath().
+   */
+  QString archivePath() const
+  {
+    return QDir::cleanPath(m_remotePath) + ".tar";
+  }
+
+  /**
+   * @return The scheduler used to stream the archive.
+   */
+  FileTransferScheduler * transfers() const
+  {
+    return m_transfers;
+  }
+
+  void start();
+
+private slots:
+  void uploadInternal();
+  void archiveUploaded();
+  void unpackComplete();
+  void transferError(const QString &errorString);
+
+private:
+  QString m_localPath;
+  QString m_remotePath;
+  TarArchiveDevice *m_archive;
+  FileTransferScheduler *m_transfers;
+};
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
+
+#endif /* UITARCHIVEUPLOAD_H_ */
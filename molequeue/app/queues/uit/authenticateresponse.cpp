@@ -15,10 +15,45 @@
  ******************************************************************************/
 
 #include "authenticateresponse.h"
-#include "messagehandler.h"
+#include "xmlreaderutils.h"
 #include "logger.h"
 
-#include <QtXmlPatterns/QXmlQuery>
+#include <QtCore/QXmlStreamReader>
+
+namespace {
+
+/**
+ * Read the Prompt children of the "prompts" element @a reader is at.
+ */
+QList<MoleQueue::Uit::Prompt> readPrompts(QXmlStreamReader &reader)
+{
+  using MoleQueue::Uit::XmlReaderUtils::readText;
+
+  QList<MoleQueue::Uit::Prompt> prompts;
+  while (reader.readNextStartElement()) {
+    if (reader.name() != QLatin1String("Prompt")) {
+      reader.skipCurrentElement();
+      continue;
+    }
+
+    QString id;
+    QString prompt;
+    while (reader.readNextStartElement()) {
+      if (reader.name() == QLatin1String("id"))
+        id = readText(reader);
+      else if (reader.name() == QLatin1String("prompt"))
+        prompt = readText(reader);
+      else
+        reader.skipCurrentElement();
+    }
+    prompts.append(MoleQueue::Uit::Prompt(id.trimmed().toInt(),
+                                          prompt.trimmed()));
+  }
+
+  return prompts;
+}
+
+} /* namespace anonymous */
 
 namespace MoleQueue {
 namespace Uit {
@@ -70,88 +105,38 @@ AuthenticateResponse &AuthenticateResponse::operator=(
 
 void AuthenticateResponse::setContent(const QString &xml)
 {
-  m_valid = true;
-
-  MessageHandler handler;
-  QXmlQuery query;
-  query.setMessageHandler(&handler);
-  m_valid = query.setFocus(xml);
-
-  if (!m_valid)
-    return;
-
-  // Get the session id
-  QString authId;
-  query.setQuery("/AuthenticateResponse/auth__session__id/string()");
-  m_valid = query.evaluateTo(&authId);
-
-  if (!m_valid)
-      return;
-
-  m_authSessionId = authId.trimmed();
-
-  // Was the call successful
-  QString successful;
-  query.setQuery("/AuthenticateResponse/success/string()");
-  m_valid = query.evaluateTo(&successful);
-  if (!m_valid)
-    return;
-
-  m_success = successful.trimmed().toLower() == "true";
-
-  // Do we have prompts
-  QString hasProm;
-  query.setQuery("/AuthenticateResponse/has__prompts/string()");
-  m_valid = query.evaluateTo(&hasProm);
-  if (!m_valid)
-    return;
-
-  m_hasPrompts = hasProm.trimmed().toLower() == "true";
-
-  // Get the banner
-  QString ban;
-  query.setQuery("/AuthenticateResponse/banner/string()");
-  m_valid = query.evaluateTo(&ban);
-  if (!m_valid)
-    return;
-
-  m_banner = ban.trimmed();
-
-  // Get the token, if there is one
-  QString tok;
-  query.setQuery("/AuthenticateResponse/token/string()");
-  m_valid = query.evaluateTo(&tok);
-  if (!m_valid)
-    return;
-
-  m_token = tok.trimmed();
-
-  // if we have prompts then get them
-  if (m_hasPrompts) {
-    query.setQuery("/AuthenticateResponse/prompts/Prompt/id/string()");
-    QStringList ids;
-    m_valid = query.evaluateTo(&ids);
-    if (!m_valid)
-      return;
-
-
-    foreach (const QString &id, ids) {
-      query.bindVariable("id", QVariant(id));
-      query.setQuery(QString("/AuthenticateResponse/prompts/Prompt[id=$id]/" \
-                             "prompt/string()"));
-      QString prompt;
-      m_valid = query.evaluateTo(&prompt);
-      if (!m_valid)
-        return;
-
-      m_prompts.append(Prompt(id.toInt(), prompt.trimmed()));
+  using XmlReaderUtils::readText;
+
+  QList<Prompt> prompts;
+  QXmlStreamReader reader(xml);
+  if (reader.readNextStartElement() &&
+      reader.name() == QLatin1String("AuthenticateResponse")) {
+    while (reader.readNextStartElement()) {
+      const QStringRef name = reader.name();
+      if (name == QLatin1String("auth__session__id"))
+        m_authSessionId = readText(reader).trimmed();
+      else if (name == QLatin1String("success"))
+        m_success = readText(reader).trimmed().toLower() == "true";
+      else if (name == QLatin1String("has__prompts"))
+        m_hasPrompts = readText(reader).trimmed().toLower() == "true";
+      else if (name == QLatin1String("banner"))
+        m_banner = readText(reader).trimmed();
+      else if (name == QLatin1String("token"))
+        m_token = readText(reader).trimmed();
+      else if (name == QLatin1String("error__message"))
+        m_errorMessage = readText(reader).trimmed();
+      else if (name == QLatin1String("prompts"))
+        prompts.append(readPrompts(reader));
+      else
+        reader.skipCurrentElement();
     }
   }
 
-  QString error;
-  query.setQuery("/AuthenticateResponse/error__message/string()");
-  m_valid = query.evaluateTo(&error);
-  m_errorMessage = error.trimmed();
+  m_valid = XmlReaderUtils::finish(reader);
+
+  // has__prompts may follow the prompts themselves.
+  if (m_valid && m_hasPrompts)
+    m_prompts = prompts;
 }
 
 QString AuthenticateResponse::authSessionId() const
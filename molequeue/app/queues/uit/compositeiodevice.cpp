@@ -17,21 +17,30 @@
 #include "compositeiodevice.h"
 #include "logger.h"
 
+#include <algorithm>
+
 namespace MoleQueue {
 namespace Uit {
 
 CompositeIODevice::CompositeIODevice(QObject *parentObject)
-  : QIODevice(parentObject), m_deviceIndex(0)
+  : QIODevice(parentObject), m_size(0), m_deviceIndex(0)
 {
 
 }
 
+bool CompositeIODevice::open(OpenMode mode)
+{
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
 bool CompositeIODevice::addDevice(QIODevice *device)
 {
   bool added = false;
   // The device should be readable.
   if (device->isReadable()) {
     m_devices.append(device);
+    m_offsets.append(m_size);
+    m_size += device->size();
     added = true;
   }
 
@@ -44,21 +53,28 @@ qint64 CompositeIODevice::readData(char* data, qint64 maxSize)
   if (m_deviceIndex >= m_devices.size())
     return -1;
 
-  QIODevice *device = m_devices[m_deviceIndex];
-  qint64 bytesRead = device->read(data, maxSize);
-  while (bytesRead < maxSize) {
+  qint64 bytesRead = 0;
+  while (bytesRead < maxSize && m_deviceIndex < m_devices.size()) {
+    // Read as much as we can from each device straight into the caller's
+    // buffer.
+    QIODevice *device = m_devices[m_deviceIndex];
+    qint64 count = device->read(data + bytesRead, maxSize - bytesRead);
+    if (count > 0)
+      bytesRead += count;
+
     // If the current device is done move on the next in the list.
-    if (device->atEnd()) {
+    if (count < 0 || device->atEnd()) {
       m_deviceIndex++;
-      if (m_deviceIndex < m_devices.size())
+      if (m_deviceIndex < m_devices.size()) {
         device = m_devices[m_deviceIndex];
-      else
-        // No more devices to read
-        break;
+        if (!device->isSequential() && device->pos() != 0)
+          device->seek(0);
+      }
+    }
+    // Nothing available yet from a sequential device.
+    else if (count == 0) {
+      break;
     }
-
-    qint64 leftToRead = maxSize - bytesRead;
-    bytesRead += device->read(data + bytesRead, leftToRead);
   }
 
   return bytesRead;
@@ -76,12 +92,37 @@ qint64 CompositeIODevice::writeData(const char * data, qint64 maxSize)
 
 qint64 CompositeIODevice::size () const
 {
-  qint64 totalSize = 0;
+  return m_size;
+}
+
+bool CompositeIODevice::seek(qint64 position)
+{
+  if (position < 0 || position > m_size)
+    return false;
+
+  int index = deviceAt(position);
+  if (index < m_devices.size()
+      && !m_devices[index]->seek(position - m_offsets[index])) {
+    return false;
+  }
+
+  m_deviceIndex = index;
+
+  return QIODevice::seek(position);
+}
+
+int CompositeIODevice::deviceAt(qint64 position) const
+{
+  if (m_devices.isEmpty())
+    return 0;
 
-  foreach(const QIODevice *device, m_devices)
-    totalSize += device->size();
+  // The last device starting at or before position, this skips empty
+  // devices.
+  QVector<qint64>::const_iterator it
+    = std::upper_bound(m_offsets.constBegin(), m_offsets.constEnd(),
+                       position);
 
-  return totalSize;
+  return qMax(0, static_cast<int>(it - m_offsets.constBegin()) - 1);
 }
 
 } /* namespace Uit */
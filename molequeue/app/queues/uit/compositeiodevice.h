@@ -18,7 +18,7 @@
 #define COMPOSITEIODEVICE_H_
 
 #include <QtCore/QIODevice>
-#include <QtCore/QQueue>
+#include <QtCore/QVector>
 
 namespace MoleQueue {
 namespace Uit {
@@ -29,6 +29,10 @@ namespace Uit {
  * @brief The CompositeIODevice class is facade that allows several QIODevices
  * into a single QIODevice.
  *
+ * The size of each device is recorded when it is added, so size() and
+ * bytesAvailable() are cheap. The devices must not change size once added.
+ * The composite is seekable, provided the devices are, so an upload can be
+ * restarted with reset().
  */
 class CompositeIODevice: public QIODevice
 {
@@ -36,9 +40,15 @@ class CompositeIODevice: public QIODevice
 public:
   CompositeIODevice(QObject *parentObject = 0);
 
+  /**
+   * Open the device. The composite is always opened unbuffered, reads are
+   * passed straight through to the devices.
+   */
+  bool open(OpenMode mode);
+
   /**
    * Add a QIODevice to the device. The QIODevice being added must be open in
-   * read mode.
+   * read mode, it is read from the start.
    *
    * @param device The QIODevice to add.
    */
@@ -47,6 +57,13 @@ public:
    * @return The combine size of all the QIODevices this composite represents.
    */
   qint64 size () const;
+  /**
+   * Seek to @a position, positioning the device that contains it.
+   *
+   * @return false if the position is out of range or the device containing it
+   * can't seek.
+   */
+  bool seek(qint64 position);
 
 protected:
   /**
@@ -59,8 +76,17 @@ protected:
   qint64  writeData ( const char * data, qint64 maxSize );
 
 private:
+  /**
+   * @return The index of the device containing @a position.
+   */
+  int deviceAt(qint64 position) const;
+
   /// The list of QIODevices in the composite.
   QList<QIODevice *> m_devices;
+  /// The offset of each QIODevice in the composite.
+  QVector<qint64> m_offsets;
+  /// The combined size of the QIODevices.
+  qint64 m_size;
   /// The index of the QIODevice currently being read.
   int m_deviceIndex;
 };
@@ -20,21 +20,23 @@
 #include "session.h"
 #include "filestreamingdata.h"
 #include "filesystemoperation.h"
+#include "filetransferscheduler.h"
 
 #include <QtCore/QDir>
-#include <QtCore/QBuffer>
 
 namespace MoleQueue {
 namespace Uit {
 
 DirectoryDownload::DirectoryDownload(Session *session,
                                      QObject *parentObject)
-: FileSystemOperation(session, parentObject)
+: FileSystemOperation(session, parentObject),
+  m_transfers(new FileTransferScheduler(this)),
+  m_pendingListings(0)
 {
-  m_networkAccess = new QNetworkAccessManager(this);
-
-  connect(m_networkAccess, SIGNAL(finished(QNetworkReply*)),
-          this, SLOT(finished(QNetworkReply*)));
+  connect(m_transfers, SIGNAL(finished()),
+          this, SIGNAL(finished()));
+  connect(m_transfers, SIGNAL(error(const QString &)),
+          this, SLOT(transferError(const QString &)));
 }
 
 void DirectoryDownload::start()
@@ -65,9 +67,9 @@ void DirectoryDownload::downloadInternal()
 
   request->deleteLater();
   m_url = request->url();
-  m_directories.enqueue(m_remotePath);
+  m_transfers->setUrl(QUrl(m_url));
 
-  downloadNext();
+  download(m_remotePath);
 }
 
 void DirectoryDownload::download(const QString &dir)
@@ -84,6 +86,7 @@ void DirectoryDownload::download(const QString &dir)
   connect(request, SIGNAL(error(const QString &)),
           this, SLOT(requestError(const QString &)));
 
+  ++m_pendingListings;
   request->submit();
 }
 
@@ -112,106 +115,49 @@ void DirectoryDownload::processDirectoryListing()
     return;
   }
 
-  // Process directories
+  // Create the local directory even if it turns out to be empty.
+  QString localDir = localPath(info.currentDirectory());
+  if (!QDir(m_localPath).mkpath(localDir)) {
+    QString msg = tr("Unable to create directory: %1").arg(localDir);
+    Logger::logError(msg);
+    emit error(msg);
+    return;
+  }
+
+  // List subdirectories concurrently.
   foreach(const FileInfo& dir, info.directories()) {
-    // enqueue directory include full path ...
     if (dir.name() != "." && dir.name() != "..")
-      m_directories.enqueue(info.currentDirectory() + "/" + dir.name());
+      download(info.currentDirectory() + "/" + dir.name());
   }
 
-  // Process files
+  // Files start streaming as soon as they are found.
   foreach(const FileInfo& file, info.files()) {
-    // enqueue directory include full path ...
-    m_files.enqueue(info.currentDirectory() + "/" + file.name());
-  }
+    QString remoteFilePath = info.currentDirectory() + "/" + file.name();
 
-  downloadNext();
-}
-
-void DirectoryDownload::downloadNext()
-{
-  // Process all files in a directory first
-  if (!m_files.isEmpty()) {
-    QString remoteFilePath = m_files.dequeue();
-    QString localFilePath = remoteFilePath;
-    localFilePath = m_localPath + localFilePath.replace(m_remotePath, "");
-
-
-    // Ensure the directory exists
-    QString path = QFileInfo(localFilePath).path();
-    if (!QDir(m_localPath).mkpath(path)) {
-      QString msg = tr("Unable to create directory: %1").arg(path);
-      Logger::logError(msg);
-      emit error(msg);
-      return;
-    }
-
-    // Save the file path so we know where to write the data.
-    m_currentFilePath = localFilePath;
-
-    // Now transfer the file
     FileStreamingData fileData;
     fileData.setToken(m_session->token());
     fileData.setFileName(remoteFilePath);
     fileData.setUserName(m_userName);
     fileData.setHostID(m_hostID);
 
-    QString xml = fileData.toXml();
-
-    QByteArray bytes;
-    QTextStream stream(&bytes);
-
-    stream << xml.size();
-    stream << "|";
-    stream << xml;
-    stream.flush();
-
-    QNetworkRequest request;
-    request.setUrl(QUrl(m_url));
-    request.setHeader(QNetworkRequest::ContentTypeHeader,
-                      QVariant("application/xml"));
-    m_networkAccess->post(request, bytes);
-  }
-  else if (!m_directories.isEmpty()) {
-    QString nextDir = m_directories.dequeue();
-    download(nextDir);
-  }
-  else {
-    emit FileSystemOperation::finished();
+    m_transfers->addDownload(fileData, localPath(remoteFilePath));
   }
+
+  if (--m_pendingListings == 0)
+    m_transfers->close();
 }
 
-void DirectoryDownload::finished(QNetworkReply *reply)
+void DirectoryDownload::transferError(const QString &errorString)
 {
-  if (reply->error() == QNetworkReply::NoError)
-  {
-    QFile file(m_currentFilePath);
-    if (!file.open(QFile::WriteOnly)) {
-      QString msg = tr("Unable to open file for write: %1")
-                              .arg(m_currentFilePath);
-      Logger::logError(msg);
-      emit error(msg);
-      return;
-    }
-
-    qint64 bytesRead = -1;
-    char bytes[4048];
-
-    while((bytesRead = reply->read(bytes, 4048)) != -1) {
-      file.write(bytes, bytesRead);
-    }
-
-    file.close();
-
-    downloadNext();
-  }
-  else
-  {
-    Logger::logError(tr("Error downloading file: %1")
-                          .arg(reply->errorString()), m_job.moleQueueId());
+  Logger::logError(tr("Error downloading file: %1").arg(errorString),
+                   m_job.moleQueueId());
+  emit error(errorString);
+}
 
-    emit error(reply->errorString());
-  }
+QString DirectoryDownload::localPath(const QString &remotePath) const
+{
+  QString path = remotePath;
+  return m_localPath + path.replace(m_remotePath, "");
 }
 
 } /* namespace Uit */
@@ -20,17 +20,18 @@
 #include "filesystemoperation.h"
 
 #include <QtCore/QObject>
-#include <QtNetwork/QNetworkReply>
-#include <QtCore/QQueue>
-#include <QtCore/QFileInfo>
 
 namespace MoleQueue {
 namespace Uit {
 
+class FileTransferScheduler;
 class Session;
 
 /**
  * @brief File system operation to download a directory from a remote UIT system.
+ *
+ * Directories are listed concurrently and each file found is handed to a
+ * FileTransferScheduler, so files are streamed while the listing continues.
  */
 class DirectoryDownload : public FileSystemOperation
 {
@@ -90,34 +91,35 @@ public:
     m_url = u;
   }
 
+  /**
+   * @return The scheduler used to stream the files. Use it to configure the
+   * concurrency and retries, and for progress and throughput.
+   */
+  FileTransferScheduler * transfers() const
+  {
+    return m_transfers;
+  }
+
   void start();
 
 private slots:
   void download(const QString &dir);
   void downloadInternal();
-  void downloadNext();
   /**
    * Slot to process a directory listing.
    */
   void processDirectoryListing();
-  /**
-   * Slot called when the current download request is complete.
-   *
-   * @param reply The reply used to read the file contents.
-   */
-  void finished(QNetworkReply *reply);
+  void transferError(const QString &errorString);
 
 private:
   QString m_remotePath;
   QString m_localPath;
-  QNetworkAccessManager *m_networkAccess;
+  FileTransferScheduler *m_transfers;
   QString m_url;
-  // Queue of directories to download.
-  QQueue<QString> m_directories;
-  // Queue of files to download.
-  QQueue<QString> m_files;
-  // The current local file path to write data to.
-  QString m_currentFilePath;
+  // Number of GetDirectoryListingRequests in flight.
+  int m_pendingListings;
+
+  QString localPath(const QString &remotePath) const;
 };
 
 } /* namespace Uit */
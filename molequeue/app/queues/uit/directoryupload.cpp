@@ -17,24 +17,26 @@
 #include "directoryupload.h"
 #include "requests.h"
 #include "filestreamingdata.h"
+#include "filetransferscheduler.h"
 #include "logger.h"
 #include "session.h"
-#include "compositeiodevice.h"
 
 #include <QtCore/QDir>
-#include <QtCore/QBuffer>
+#include <QtCore/QDirIterator>
 
 namespace MoleQueue {
 namespace Uit {
 
 DirectoryUpload::DirectoryUpload(Session *session,
                                        QObject *parentObject)
-  : FileSystemOperation(session, parentObject)
+  : FileSystemOperation(session, parentObject),
+    m_transfers(new FileTransferScheduler(this)),
+    m_pendingDirectories(0)
 {
-  m_networkAccess = new QNetworkAccessManager(this);
-
-  connect(m_networkAccess, SIGNAL(finished(QNetworkReply*)),
-          this, SLOT(finished(QNetworkReply*)));
+  connect(m_transfers, SIGNAL(finished()),
+          this, SIGNAL(finished()));
+  connect(m_transfers, SIGNAL(error(const QString &)),
+          this, SLOT(transferError(const QString &)));
 }
 
 void DirectoryUpload::start()
@@ -64,39 +66,51 @@ void DirectoryUpload::uploadInternal()
   }
 
   request->deleteLater();
-  m_url = request->url();
+  m_transfers->setUrl(QUrl(request->url()));
+
+  // Walk the local tree up front, the directories must exist before any of
+  // the files can be streamed.
+  m_directoryLevels.clear();
+  m_files.clear();
+  m_directoryLevels.enqueue(QStringList() << m_remotePath + "/");
+
+  QDir localDir(m_localPath);
+  QDirIterator it(m_localPath,
+                  QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+  while (it.hasNext()) {
+    QString path = it.next();
+    if (it.fileInfo().isDir()) {
+      int depth = localDir.relativeFilePath(path).count('/') + 1;
+      while (m_directoryLevels.size() <= depth)
+        m_directoryLevels.enqueue(QStringList());
+      m_directoryLevels[depth] << remotePath(path);
+    }
+    else {
+      m_files << path;
+    }
+  }
 
-  m_fileEntries.enqueue(QFileInfo(m_localPath));
-  uploadNext();
+  createNextDirectoryLevel();
 }
 
-void DirectoryUpload::uploadNext()
+void DirectoryUpload::createNextDirectoryLevel()
 {
-  if (m_fileEntries.isEmpty()) {
-    emit FileSystemOperation::finished();
+  if (m_directoryLevels.isEmpty()) {
+    uploadFiles();
     return;
   }
 
-  QFileInfo path = m_fileEntries.dequeue();
-
-  if (path.isDir()) {
-    QFileInfoList entries  = QDir(path.absoluteFilePath())
-                                 .entryInfoList(QDir::Dirs |
-                                                QDir::Files |
-                                                QDir::NoDotAndDotDot);
-
-    m_fileEntries.append(entries);
-
-    QString dir = path.absoluteFilePath().replace(m_localPath, "");
-
-    if (!dir.startsWith("/"))
-      dir = "/" + dir;
+  // Siblings do not depend on each other, so a whole level is created at once.
+  QStringList directories = m_directoryLevels.dequeue();
+  m_pendingDirectories = directories.size();
 
+  foreach (const QString &dir, directories) {
     CreateDirectoryRequest *request = new CreateDirectoryRequest(m_session,
                                                                  this);
     request->setHostId(m_hostID);
     request->setUserName(m_userName);
-    request->setDirectory(m_remotePath + dir);
+    request->setDirectory(dir);
 
     connect(request, SIGNAL(finished()),
             this, SLOT(createDirectoryComplete()));
@@ -104,10 +118,7 @@ void DirectoryUpload::uploadNext()
             this, SLOT(requestError(const QString &)));
 
     request->submit();
- }
- else {
-   uploadFile(path);
- }
+  }
 }
 
 void DirectoryUpload::createDirectoryComplete()
@@ -124,69 +135,35 @@ void DirectoryUpload::createDirectoryComplete()
   }
   request->deleteLater();
 
-  uploadNext();
+  if (--m_pendingDirectories == 0)
+    createNextDirectoryLevel();
 }
 
-void DirectoryUpload::uploadFile(const QFileInfo &fileInfo)
+void DirectoryUpload::uploadFiles()
 {
-  FileStreamingData fileData;
-
-  QString filePath = fileInfo.absoluteFilePath().replace(m_localPath, "");
-
-  if (!filePath.startsWith("/"))
-    filePath = "/" + filePath;
-
-  QString remoteFilePath = m_remotePath + filePath;
-
-
-  fileData.setToken(m_session->token());
-  fileData.setFileName(remoteFilePath);
-  fileData.setUserName(m_userName);
-  fileData.setHostID(m_hostID);
-
-  QString xml = fileData.toXml();
-
-  // Open file and get size
-  QFile *file = new QFile(fileInfo.absoluteFilePath());
-  if (!file->open(QIODevice::ReadOnly)) {
-    QString msg = tr("Unable to open file: %1")
-                     .arg(fileInfo.absoluteFilePath());
-    Logger::logError(msg, m_job.moleQueueId());
-    emit error(msg);
-    return;
+  foreach (const QString &localFile, m_files) {
+    FileStreamingData fileData;
+    fileData.setToken(m_session->token());
+    fileData.setFileName(remotePath(localFile));
+    fileData.setUserName(m_userName);
+    fileData.setHostID(m_hostID);
+
+    m_transfers->addUpload(localFile, fileData);
   }
 
-  CompositeIODevice *dataStream = new CompositeIODevice(this);
-  dataStream->open(QIODevice::ReadWrite);
-  QBuffer *headerBuffer = new QBuffer(dataStream);
-  headerBuffer->open(QIODevice::ReadWrite);
-  QTextStream headerStream(headerBuffer);
-
-  headerStream << xml.size();
-  headerStream << "|";
-  headerStream << xml;
-  headerStream << file->size();
-  headerStream << "|";
-  headerStream.flush();
-
-  headerBuffer->seek(0);
-  dataStream->addDevice(headerBuffer);
-  dataStream->addDevice(file);
-
-  m_networkAccess->post(QNetworkRequest(QUrl(m_url)), dataStream);
+  m_files.clear();
+  m_transfers->close();
 }
 
-void DirectoryUpload::finished(QNetworkReply *reply)
+void DirectoryUpload::transferError(const QString &errorString)
 {
-  QByteArray response = reply->readAll();
-
-  if (!response.isEmpty() && !QString(response).contains("DONE"))
-    Logger::logError(response, m_job.moleQueueId());
+  Logger::logError(errorString, m_job.moleQueueId());
+  emit error(errorString);
+}
 
-  if (reply->error() == QNetworkReply::NoError)
-    uploadNext();
-  else
-    emit error(reply->errorString());
+QString DirectoryUpload::remotePath(const QString &localPath) const
+{
+  return m_remotePath + "/" + QDir(m_localPath).relativeFilePath(localPath);
 }
 
 } /* namespace Uit */
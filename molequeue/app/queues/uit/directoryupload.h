@@ -20,17 +20,20 @@
 #include "filesystemoperation.h"
 
 #include <QtCore/QObject>
-#include <QtNetwork/QNetworkReply>
 #include <QtCore/QQueue>
-#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
 
 namespace MoleQueue {
 namespace Uit {
 
+class FileTransferScheduler;
 class Session;
 
 /**
  * @brief File system operation to upload a directory to a remote UIT system.
+ *
+ * The remote directory tree is created first, one level at a time, then the
+ * files are streamed by a FileTransferScheduler.
  */
 class DirectoryUpload: public FileSystemOperation
 {
@@ -74,25 +77,36 @@ public:
     m_remotePath = path;
   }
 
+  /**
+   * @return The scheduler used to stream the files. Use it to configure the
+   * concurrency and retries, and for progress and throughput.
+   */
+  FileTransferScheduler * transfers() const
+  {
+    return m_transfers;
+  }
+
   void start();
 
 private slots:
   void uploadInternal();
-  void uploadNext();
-  void uploadFile(const QFileInfo &fileInfo);
-  void finished(QNetworkReply *reply);
   void createDirectoryComplete();
+  void transferError(const QString &errorString);
 
 private:
   QString m_localPath;
   QString m_remotePath;
-  QNetworkAccessManager *m_networkAccess;
-  QString m_url;
-  QQueue<QFileInfo> m_fileEntries;
-
-  void uploadFile(const QString &filePath);
-
-
+  FileTransferScheduler *m_transfers;
+  /// Remote directories to create, grouped by depth.
+  QQueue<QStringList> m_directoryLevels;
+  /// Number of CreateDirectoryRequests in flight.
+  int m_pendingDirectories;
+  /// Local files to upload once the directories exist.
+  QStringList m_files;
+
+  void createNextDirectoryLevel();
+  void uploadFiles();
+  QString remotePath(const QString &localPath) const;
 };
 
 } /* namespace Uit */
@@ -17,109 +17,71 @@
 #include "queues/uit/dirlistinginfo.h"
 #include "logger.h"
 #include "fileinfo.h"
-#include "messagehandler.h"
+#include "xmlreaderutils.h"
 
-#include <QtXmlPatterns/QAbstractXmlReceiver>
-#include <QtXmlPatterns/QXmlNamePool>
-#include <QtXmlPatterns/QXmlQuery>
 #include <QtCore/QList>
+#include <QtCore/QXmlStreamReader>
 
 namespace {
 
-class FileInfoXmlReceiver : public QAbstractXmlReceiver
+/**
+ * Read a FileInfo element. @a reader must be at its start element, and is
+ * left at its end element.
+ */
+MoleQueue::Uit::FileInfo readFileInfo(QXmlStreamReader &reader)
 {
-
-public:
-  FileInfoXmlReceiver(QXmlNamePool pool);
-
-  void  atomicValue ( const QVariant & value ) { Q_UNUSED(value); }
-  void  attribute ( const QXmlName & name, const QStringRef & value ) {
-    Q_UNUSED(name);
-    Q_UNUSED(value);
-  }
-  void  characters ( const QStringRef & value );
-  void  comment ( const QString & value ) { Q_UNUSED(value); }
-  void  endDocument () {};
-  void  endElement ();
-  void  endOfSequence () {};
-  void  namespaceBinding ( const QXmlName & name ) { Q_UNUSED(name); }
-  void  processingInstruction ( const QXmlName & target,
-                               const QString & value) {
-    Q_UNUSED(target);
-    Q_UNUSED(value);
+  using MoleQueue::Uit::XmlReaderUtils::readText;
+
+  MoleQueue::Uit::FileInfo fileInfo;
+  while (reader.readNextStartElement()) {
+    const QStringRef name = reader.name();
+    if (name == QLatin1String("size")) {
+      const QString value = readText(reader);
+      bool ok;
+      fileInfo.setSize(value.toLongLong(&ok));
+
+      if (!ok) {
+        MoleQueue::Logger::logError(
+            QObject::tr("Unable to convert value to qint64: %1").arg(value));
+      }
+    }
+    else if (name == QLatin1String("name")) {
+      fileInfo.setName(readText(reader));
+    }
+    else if (name == QLatin1String("perms")) {
+      fileInfo.setPerms(readText(reader));
+    }
+    else if (name == QLatin1String("date")) {
+      fileInfo.setDate(readText(reader));
+    }
+    else if (name == QLatin1String("user")) {
+      fileInfo.setUser(readText(reader));
+    }
+    else if (name == QLatin1String("group")) {
+      fileInfo.setGroup(readText(reader));
+    }
+    else {
+      reader.skipCurrentElement();
+    }
   }
-  void  startDocument () {};
-  void  startElement ( const QXmlName & name );
-  void  startOfSequence () {};
-
-  QList<MoleQueue::Uit::FileInfo> fileInfos() const {
-    return m_fileInfos;
-  };
-
-private:
-  QXmlNamePool m_pool;
-  MoleQueue::Uit::FileInfo m_currentFileInfo;
-  QString m_currentName;
-  QString m_currentValue;
-  QList<MoleQueue::Uit::FileInfo> m_fileInfos;
-  int tagDepth;
-
-};
-
-FileInfoXmlReceiver::FileInfoXmlReceiver(QXmlNamePool pool)
-  : m_pool(pool), tagDepth(0)
-{
 
+  return fileInfo;
 }
 
-void  FileInfoXmlReceiver::characters ( const QStringRef & value )
+/**
+ * Read the FileInfo children of the current element, e.g. "directories".
+ */
+QList<MoleQueue::Uit::FileInfo> readFileInfos(QXmlStreamReader &reader)
 {
-  if (!m_currentName.isEmpty()) {
-    m_currentValue.append(value);
+  QList<MoleQueue::Uit::FileInfo> fileInfos;
+  while (reader.readNextStartElement()) {
+    if (reader.name() == QLatin1String("FileInfo"))
+      fileInfos.append(readFileInfo(reader));
+    else
+      reader.skipCurrentElement();
   }
-}
 
-void  FileInfoXmlReceiver::endElement ()
-{
-  if (tagDepth-- == 2) {
-    m_fileInfos.append(m_currentFileInfo);
-    m_currentFileInfo = MoleQueue::Uit::FileInfo();
-  }
-  else if (m_currentName == "size") {
-    bool ok;
-    m_currentFileInfo.setSize(m_currentValue.toLongLong(&ok));
-
-    if (!ok) {
-      MoleQueue::Logger::logError(
-          QObject::tr("Unable to convert value to qint64: %1")
-                       .arg(m_currentValue));
-    }
-  }
-  else if (m_currentName == "name") {
-    m_currentFileInfo.setName(m_currentValue);
-  }
-  else if (m_currentName == "perms") {
-    m_currentFileInfo.setPerms(m_currentValue);
-  }
-  else if (m_currentName == "date") {
-    m_currentFileInfo.setDate(m_currentValue);
-  }
-  else if (m_currentName == "user") {
-    m_currentFileInfo.setUser(m_currentValue);
-  }
-  else if (m_currentName == "group") {
-    m_currentFileInfo.setGroup(m_currentValue);
-  }
-
-  m_currentValue.clear();
-  m_currentName.clear();
-}
-
-void  FileInfoXmlReceiver::startElement ( const QXmlName & name )
-{
-  tagDepth++;
-  m_currentName =  name.localName(m_pool);
-  m_currentValue.clear();
+  return fileInfos;
 }
 
 } /* namespace anonymous */
@@ -152,41 +114,24 @@ DirListingInfo DirListingInfo::fromXml(const QString &xml)
 void DirListingInfo::setContent(const QString &content)
 {
   m_xml = content;
-  m_valid = true;
-
-  MessageHandler handler;
-  QXmlQuery query;
-  query.setMessageHandler(&handler);
-  query.setFocus(m_xml);
-
-  QString dir;
-  query.setQuery("/DirListingInfo/currentDirectory/string()");
-  m_valid = query.evaluateTo(&dir);
 
-  if (!m_valid)
-    return;
-
-  m_currentDirectory = dir.trimmed();
-
-  // Get the directories;
-  FileInfoXmlReceiver dirReceiver(query.namePool());
-  query.setQuery("/DirListingInfo/directories");
-  m_valid = query.evaluateTo(&dirReceiver);
-
-  if (!m_valid)
-    return;
-
-  m_directories = dirReceiver.fileInfos();
-
-  // Get the files
-  FileInfoXmlReceiver fileReceiver(query.namePool());
-  query.setQuery("/DirListingInfo/files");
-  m_valid = query.evaluateTo(&fileReceiver);
-
-  if (!m_valid)
-    return;
+  QXmlStreamReader reader(m_xml);
+  if (reader.readNextStartElement() &&
+      reader.name() == QLatin1String("DirListingInfo")) {
+    while (reader.readNextStartElement()) {
+      const QStringRef name = reader.name();
+      if (name == QLatin1String("currentDirectory"))
+        m_currentDirectory = XmlReaderUtils::readText(reader).trimmed();
+      else if (name == QLatin1String("directories"))
+        m_directories.append(readFileInfos(reader));
+      else if (name == QLatin1String("files"))
+        m_files.append(readFileInfos(reader));
+      else
+        reader.skipCurrentElement();
+    }
+  }
 
-  m_files = fileReceiver.fileInfos();
+  m_valid = XmlReaderUtils::finish(reader);
 }
 
 } /* namespace Uit */
@@ -0,0 +1,384 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "filetransferscheduler.h"
+#include "compositeiodevice.h"
+#include "logger.h"
+#include "mappedfiledevice.h"
+
+#include <QtCore/QBuffer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTextStream>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+
+namespace MoleQueue {
+namespace Uit {
+
+namespace {
+/// Files at least this large are uploaded from a memory mapping.
+const qint64 mappedFileThreshold = 1024 * 1024;
+}
+
+FileTransferScheduler::FileTransferScheduler(QObject *parentObject)
+  : QObject(parentObject),
+    m_networkAccess(new QNetworkAccessManager(this)),
+    m_maxConcurrentTransfers(4),
+    m_maxAttempts(3),
+    m_closed(false),
+    m_failed(false),
+    m_fileCount(0),
+    m_filesTransferred(0),
+    m_bytesTransferred(0),
+    m_retryCount(0),
+    m_elapsed(-1)
+{
+}
+
+void FileTransferScheduler::setMaxConcurrentTransfers(int max)
+{
+  m_maxConcurrentTransfers = qMax(1, max);
+  startTransfers();
+}
+
+void FileTransferScheduler::addUpload(const QString &localFile,
+                                      const FileStreamingData &remote)
+{
+  enqueue(Upload, localFile, NULL, remote);
+}
+
+void FileTransferScheduler::addUpload(QIODevice *source,
+                                      const FileStreamingData &remote)
+{
+  enqueue(Upload, QString(), source, remote);
+}
+
+void FileTransferScheduler::addDownload(const FileStreamingData &remote,
+                                        const QString &localFile)
+{
+  enqueue(Download, localFile, NULL, remote);
+}
+
+void FileTransferScheduler::addDownload(const FileStreamingData &remote,
+                                        QIODevice *sink)
+{
+  enqueue(Download, QString(), sink, remote);
+}
+
+void FileTransferScheduler::close()
+{
+  m_closed = true;
+  checkFinished();
+}
+
+qint64 FileTransferScheduler::elapsed() const
+{
+  if (m_elapsed >= 0)
+    return m_elapsed;
+
+  return m_timer.isValid() ? m_timer.elapsed() : 0;
+}
+
+double FileTransferScheduler::throughput() const
+{
+  qint64 ms = elapsed();
+  return ms > 0 ? m_bytesTransferred * 1000.0 / ms : 0.0;
+}
+
+void FileTransferScheduler::readyRead()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+  if (!reply || !m_active.contains(reply))
+    return;
+
+  // Stream downloads to disk rather than holding whole files in memory.
+  writeOutput(m_active[reply], reply);
+}
+
+void FileTransferScheduler::replyFinished()
+{
+  QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+  if (!reply || !m_active.contains(reply))
+    return;
+
+  reply->deleteLater();
+
+  if (reply->error() == QNetworkReply::NoError) {
+    if (!writeOutput(m_active[reply], reply))
+      return;
+
+    Transfer transfer = m_active.take(reply);
+    if (transfer.direction == Upload) {
+      QByteArray response = reply->readAll();
+      if (!response.isEmpty() && !QString(response).contains("DONE"))
+        Logger::logError(response);
+    }
+    transferComplete(transfer);
+  }
+  else {
+    Transfer transfer = m_active.take(reply);
+    closeOutput(transfer);
+
+    if (transfer.attempts < m_maxAttempts) {
+      Logger::logWarning(tr("Transfer of %1 failed, retrying: %2")
+                         .arg(transfer.remote.fileName())
+                         .arg(reply->errorString()));
+      ++m_retryCount;
+      m_pending.prepend(transfer);
+    }
+    else {
+      fail(tr("Error transferring %1: %2").arg(transfer.remote.fileName())
+           .arg(reply->errorString()));
+      return;
+    }
+  }
+
+  startTransfers();
+  checkFinished();
+}
+
+void FileTransferScheduler::enqueue(Direction direction,
+                                    const QString &localFile,
+                                    QIODevice *device,
+                                    const FileStreamingData &remote)
+{
+  Transfer transfer;
+  transfer.direction = direction;
+  transfer.localFile = localFile;
+  transfer.remote = remote;
+  transfer.attempts = 0;
+  transfer.device = device;
+  transfer.output = NULL;
+  transfer.bytes = 0;
+
+  m_pending.enqueue(transfer);
+  ++m_fileCount;
+
+  startTransfers();
+}
+
+void FileTransferScheduler::startTransfers()
+{
+  while (!m_failed && !m_pending.isEmpty()
+         && m_active.size() < m_maxConcurrentTransfers) {
+    Transfer transfer = m_pending.dequeue();
+    ++transfer.attempts;
+
+    if (!m_timer.isValid())
+      m_timer.start();
+
+    QString errorString;
+    QNetworkReply *reply = post(transfer, errorString);
+    if (!reply) {
+      fail(errorString);
+      return;
+    }
+
+    m_active.insert(reply, transfer);
+  }
+}
+
+QNetworkReply * FileTransferScheduler::post(Transfer &transfer,
+                                            QString &errorString)
+{
+  QString xml = transfer.remote.toXml();
+  QNetworkRequest request(m_url);
+  QNetworkReply *reply = NULL;
+
+  if (transfer.direction == Upload) {
+    // The body is "<xml size>|<xml><file size>|<file contents>".
+    CompositeIODevice *dataStream = new CompositeIODevice(this);
+    dataStream->open(QIODevice::ReadOnly);
+
+    QIODevice *source = transfer.device;
+    if (source) {
+      if (!source->isOpen())
+        source->open(QIODevice::ReadOnly);
+      if (!source->isReadable() || !source->reset()) {
+        errorString = tr("Unable to read %1: %2")
+                      .arg(transfer.remote.fileName(),
+                           source->errorString());
+        delete dataStream;
+        return NULL;
+      }
+    }
+    else {
+      // Large files are served from a mapping, falling back to plain reads
+      // if the file can't be mapped.
+      if (QFileInfo(transfer.localFile).size() >= mappedFileThreshold) {
+        MappedFileDevice *mapped = new MappedFileDevice(transfer.localFile,
+                                                        dataStream);
+        if (mapped->open(QIODevice::ReadOnly))
+          source = mapped;
+        else
+          delete mapped;
+      }
+
+      if (!source) {
+        QFile *file = new QFile(transfer.localFile, dataStream);
+        if (!file->open(QIODevice::ReadOnly)) {
+          errorString = tr("Unable to open file: %1").arg(transfer.localFile);
+          delete dataStream;
+          return NULL;
+        }
+        source = file;
+      }
+    }
+
+    QByteArray header;
+    QTextStream headerStream(&header);
+    headerStream << xml.size() << "|" << xml << source->size() << "|";
+    headerStream.flush();
+
+    QBuffer *headerBuffer = new QBuffer(dataStream);
+    headerBuffer->setData(header);
+    headerBuffer->open(QIODevice::ReadOnly);
+
+    dataStream->addDevice(headerBuffer);
+    dataStream->addDevice(source);
+
+    reply = m_networkAccess->post(request, dataStream);
+    dataStream->setParent(reply);
+  }
+  else {
+    QIODevice *output = transfer.device;
+    if (!output)
+      output = new QFile(transfer.localFile, this);
+
+    // Each attempt starts from scratch.
+    if (output->isOpen())
+      output->close();
+    if (!output->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+      errorString = tr("Unable to open %1 for write: %2")
+                    .arg(transfer.localFile.isEmpty()
+                         ? transfer.remote.fileName() : transfer.localFile,
+                         output->errorString());
+      if (output != transfer.device)
+        delete output;
+      return NULL;
+    }
+    transfer.output = output;
+    transfer.bytes = 0;
+
+    // The body is "<xml size>|<xml>", the response is the file contents.
+    QByteArray bytes;
+    QTextStream stream(&bytes);
+    stream << xml.size() << "|" << xml;
+    stream.flush();
+
+    request.setHeader(QNetworkRequest::ContentTypeHeader,
+                      QVariant("application/xml"));
+    reply = m_networkAccess->post(request, bytes);
+    connect(reply, SIGNAL(readyRead()), this, SLOT(readyRead()));
+  }
+
+  connect(reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+
+  return reply;
+}
+
+bool FileTransferScheduler::writeOutput(Transfer &transfer,
+                                        QNetworkReply *reply)
+{
+  if (!transfer.output)
+    return true;
+
+  QByteArray data = reply->readAll();
+  if (data.isEmpty())
+    return true;
+
+  if (transfer.output->write(data) != data.size()) {
+    // Retrying will not help, e.g. the disk is full.
+    fail(tr("Error writing %1: %2").arg(transfer.remote.fileName())
+         .arg(transfer.output->errorString()));
+    return false;
+  }
+
+  transfer.bytes += data.size();
+  return true;
+}
+
+void FileTransferScheduler::closeOutput(Transfer &transfer)
+{
+  if (!transfer.output)
+    return;
+
+  if (transfer.output == transfer.device)
+    transfer.output->close();
+  else
+    delete transfer.output;
+  transfer.output = NULL;
+}
+
+void FileTransferScheduler::transferComplete(Transfer &transfer)
+{
+  if (transfer.direction == Download) {
+    m_bytesTransferred += transfer.bytes;
+    closeOutput(transfer);
+  }
+  else if (transfer.device) {
+    m_bytesTransferred += transfer.device->size();
+  }
+  else {
+    m_bytesTransferred += QFileInfo(transfer.localFile).size();
+  }
+
+  ++m_filesTransferred;
+
+  emit fileTransferred(transfer.localFile.isEmpty()
+                       ? transfer.remote.fileName() : transfer.localFile);
+  emit progress(m_filesTransferred, m_fileCount, m_bytesTransferred);
+}
+
+void FileTransferScheduler::fail(const QString &errorString)
+{
+  m_failed = true;
+  m_pending.clear();
+
+  // Abandon the transfers still in flight.
+  QHash<QNetworkReply *, Transfer> active = m_active;
+  m_active.clear();
+  foreach (QNetworkReply *reply, active.keys()) {
+    reply->disconnect(this);
+    reply->abort();
+    reply->deleteLater();
+    Transfer transfer = active.value(reply);
+    closeOutput(transfer);
+  }
+
+  emit error(errorString);
+}
+
+void FileTransferScheduler::checkFinished()
+{
+  if (!m_closed || m_failed || m_elapsed >= 0 || !m_pending.isEmpty()
+      || !m_active.isEmpty()) {
+    return;
+  }
+
+  m_elapsed = elapsed();
+  Logger::logDebugMessage(tr("Transferred %1 files (%2 bytes) in %3 ms, "
+                             "%4 retries, %5 bytes/s")
+                          .arg(m_filesTransferred).arg(m_bytesTransferred)
+                          .arg(m_elapsed).arg(m_retryCount)
+                          .arg(throughput(), 0, 'f', 0));
+  emit finished();
+}
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
@@ -0,0 +1,248 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef FILETRANSFERSCHEDULER_H_
+#define FILETRANSFERSCHEDULER_H_
+
+#include "filestreamingdata.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QUrl>
+
+class QIODevice;
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace MoleQueue {
+namespace Uit {
+
+/**
+ * @class FileTransferScheduler filetransferscheduler.h
+ * <molequeue/queue/uit/filetransferscheduler.h>
+ * @brief The FileTransferScheduler class streams files to or from the UIT
+ * streaming endpoint, running up to maxConcurrentTransfers() requests at once.
+ *
+ * Transfers that fail are retried until they have been attempted maxAttempts()
+ * times, after which the remaining transfers are abandoned and error() is
+ * emitted. Once close() has been called, finished() is emitted when the last
+ * queued transfer completes.
+ */
+class FileTransferScheduler : public QObject
+{
+  Q_OBJECT
+public:
+  FileTransferScheduler(QObject *parentObject = 0);
+
+  /**
+   * @return The streaming URL the transfers are posted to.
+   */
+  QUrl url() const
+  {
+    return m_url;
+  }
+
+  /**
+   * @param u The streaming URL to post the transfers to.
+   */
+  void setUrl(const QUrl &u)
+  {
+    m_url = u;
+  }
+
+  /**
+   * @return The maximum number of requests in flight at any time.
+   */
+  int maxConcurrentTransfers() const
+  {
+    return m_maxConcurrentTransfers;
+  }
+
+  /**
+   * @param max The maximum number of requests in flight at any time.
+   */
+  void setMaxConcurrentTransfers(int max);
+
+  /**
+   * @return The number of times a file is attempted before giving up.
+   */
+  int maxAttempts() const
+  {
+    return m_maxAttempts;
+  }
+
+  /**
+   * @param attempts The number of times a file is attempted before giving up.
+   */
+  void setMaxAttempts(int attempts)
+  {
+    m_maxAttempts = qMax(1, attempts);
+  }
+
+  /**
+   * Queue the upload of @a localFile to the file described by @a remote.
+   */
+  void addUpload(const QString &localFile, const FileStreamingData &remote);
+
+  /**
+   * Queue the upload of the contents of @a source to the file described by
+   * @a remote. @a source must be seekable with a known size(), it is rewound
+   * for each attempt. The scheduler does not take ownership of @a source.
+   */
+  void addUpload(QIODevice *source, const FileStreamingData &remote);
+
+  /**
+   * Queue the download of the file described by @a remote to @a localFile.
+   */
+  void addDownload(const FileStreamingData &remote, const QString &localFile);
+
+  /**
+   * Queue the download of the file described by @a remote into @a sink. The
+   * sink is (re)opened write only for each attempt and closed once the
+   * download is complete. The scheduler does not take ownership of @a sink.
+   */
+  void addDownload(const FileStreamingData &remote, QIODevice *sink);
+
+  /**
+   * Indicate that no more transfers will be added. finished() is emitted as
+   * soon as the queued transfers are complete.
+   */
+  void close();
+
+  /**
+   * @return The number of files added so far.
+   */
+  int fileCount() const
+  {
+    return m_fileCount;
+  }
+
+  /**
+   * @return The number of files transferred successfully.
+   */
+  int filesTransferred() const
+  {
+    return m_filesTransferred;
+  }
+
+  /**
+   * @return The number of file contents bytes transferred successfully.
+   */
+  qint64 bytesTransferred() const
+  {
+    return m_bytesTransferred;
+  }
+
+  /**
+   * @return The number of failed attempts that were retried.
+   */
+  int retryCount() const
+  {
+    return m_retryCount;
+  }
+
+  /**
+   * @return The number of milliseconds since the first transfer started, or
+   * the total duration once finished() has been emitted.
+   */
+  qint64 elapsed() const;
+
+  /**
+   * @return The aggregate throughput in bytes per second.
+   */
+  double throughput() const;
+
+signals:
+  /**
+   * Emitted each time a file has been transferred.
+   */
+  void progress(int filesTransferred, int fileCount, qint64 bytesTransferred);
+
+  /**
+   * Emitted when a file has been transferred.
+   *
+   * @param fileName The local path of the file, or the remote path for
+   * transfers to or from a QIODevice.
+   */
+  void fileTransferred(const QString &fileName);
+
+  /**
+   * Emitted when all transfers are complete and close() has been called.
+   */
+  void finished();
+
+  /**
+   * Emitted when a transfer has failed maxAttempts() times. No further
+   * transfers are made.
+   */
+  void error(const QString &errorString);
+
+private slots:
+  void readyRead();
+  void replyFinished();
+
+private:
+  enum Direction {
+    Upload,
+    Download
+  };
+
+  struct Transfer
+  {
+    Direction direction;
+    QString localFile;
+    FileStreamingData remote;
+    int attempts;
+    /// Caller's source or sink, NULL to use localFile.
+    QIODevice *device;
+    /// Open destination of a download while its request is in flight.
+    QIODevice *output;
+    /// Bytes received so far by a download.
+    qint64 bytes;
+  };
+
+  void enqueue(Direction direction, const QString &localFile,
+               QIODevice *device, const FileStreamingData &remote);
+  bool writeOutput(Transfer &transfer, QNetworkReply *reply);
+  void closeOutput(Transfer &transfer);
+  void startTransfers();
+  QNetworkReply * post(Transfer &transfer, QString &errorString);
+  void transferComplete(Transfer &transfer);
+  void fail(const QString &errorString);
+  void checkFinished();
+
+  QNetworkAccessManager *m_networkAccess;
+  QUrl m_url;
+  int m_maxConcurrentTransfers;
+  int m_maxAttempts;
+  QQueue<Transfer> m_pending;
+  QHash<QNetworkReply *, Transfer> m_active;
+  bool m_closed;
+  bool m_failed;
+  int m_fileCount;
+  int m_filesTransferred;
+  qint64 m_bytesTransferred;
+  int m_retryCount;
+  QElapsedTimer m_timer;
+  qint64 m_elapsed;
+};
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
+
+#endif /* FILETRANSFERSCHEDULER_H_ */
@@ -15,113 +15,61 @@
  ******************************************************************************/
 
 #include "jobeventlist.h"
-#include "messagehandler.h"
+#include "xmlreaderutils.h"
 
-#include <QtXmlPatterns/QAbstractXmlReceiver>
-#include <QtXmlPatterns/QXmlNamePool>
-#include <QtXmlPatterns/QXmlQuery>
 #include <QtCore/QList>
-#include <QtCore/QRegExp>
+#include <QtCore/QSet>
+#include <QtCore/QXmlStreamReader>
 
 namespace {
 
 /**
- * @brief XML receiver to parser JobEvent tags.
+ * @return The number at the start of @a jobId, e.g. 100535 for
+ * "100535.sdb".
  */
-class JobEventListXmlReceiver : public QAbstractXmlReceiver
-{
-
-public:
-  JobEventListXmlReceiver(QXmlNamePool pool);
-
-  void  atomicValue ( const QVariant & value ) { Q_UNUSED(value); }
-  void  attribute ( const QXmlName & name, const QStringRef & value ) {
-    Q_UNUSED(name);
-    Q_UNUSED(value);
-  }
-  void  characters ( const QStringRef & value );
-  void  comment ( const QString & value ) { Q_UNUSED(value); }
-  void  endDocument () {}
-  void  endElement ();
-  void  endOfSequence () {};
-  void  namespaceBinding ( const QXmlName & name ) { Q_UNUSED(name); };
-  void  processingInstruction ( const QXmlName & target,
-                                const QString & value) {
-    Q_UNUSED(target);
-    Q_UNUSED(value);
-  };
-  void  startDocument () {};
-  void  startElement ( const QXmlName & name );
-  void  startOfSequence () {};
-
-  QList<MoleQueue::Uit::JobEvent> jobEvents() const {
-    return m_events;
-  };
-
-private:
-  QXmlNamePool m_pool;
-  MoleQueue::Uit::JobEvent m_currentEvent;
-  QString m_currentName;
-  QString m_currentValue;
-  QList<MoleQueue::Uit::JobEvent> m_events;
-  int tagDepth;
-
-};
-
-JobEventListXmlReceiver::JobEventListXmlReceiver(QXmlNamePool pool)
-  : m_pool(pool), tagDepth(0)
+qint64 parseJobId(const QString &jobId)
 {
+  const QString trimmed = jobId.trimmed();
+  int length = 0;
+  while (length < trimmed.size() && trimmed.at(length).isDigit())
+    ++length;
 
+  return trimmed.left(length).toLongLong();
 }
 
-
-void  JobEventListXmlReceiver::characters ( const QStringRef & value )
+/**
+ * Read a JobEvent element. @a reader must be at its start element, and is
+ * left at its end element.
+ */
+MoleQueue::Uit::JobEvent readJobEvent(QXmlStreamReader &reader,
+                                      QString &userName)
 {
-  if (!m_currentName.isEmpty()) {
-    m_currentValue.append(value);
+  using MoleQueue::Uit::XmlReaderUtils::readText;
+
+  MoleQueue::Uit::JobEvent event;
+  while (reader.readNextStartElement()) {
+    const QStringRef name = reader.name();
+    if (name == QLatin1String("acctHost"))
+      event.setAcctHost(readText(reader));
+    else if (name == QLatin1String("eventType"))
+      event.setEventType(readText(reader));
+    else if (name == QLatin1String("eventTime"))
+      event.setEventTime(readText(reader).trimmed().toLongLong());
+    else if (name == QLatin1String("jobID"))
+      event.setJobId(parseJobId(readText(reader)));
+    else if (name == QLatin1String("jobQueue"))
+      event.setJobQueue(readText(reader));
+    else if (name == QLatin1String("jobStatus"))
+      event.setJobStatus(readText(reader));
+    else if (name == QLatin1String("jobStatusText"))
+      event.setJobStatusText(readText(reader));
+    else if (name == QLatin1String("userName"))
+      userName = readText(reader).trimmed();
+    else
+      reader.skipCurrentElement();
   }
-}
 
-void  JobEventListXmlReceiver::endElement ()
-{
-  if (tagDepth-- == 1) {
-    // Save the current event.
-    m_events.append(m_currentEvent);
-    m_currentEvent = MoleQueue::Uit::JobEvent();
-  }
-  else if (m_currentName == "acctHost") {
-    m_currentEvent.setAcctHost(m_currentValue);
-  }
-  else if (m_currentName == "eventType") {
-    m_currentEvent.setEventType(m_currentValue);
-  }
-  else if (m_currentName == "eventTime") {
-    m_currentEvent.setEventTime(m_currentValue.toInt());
-  }
-  else if (m_currentName == "jobID") {
-    QRegExp regex ("^(\\d+)\\..*$");
-    regex.indexIn(m_currentValue.trimmed());
-    m_currentEvent.setJobId(regex.cap(1).toLongLong());
-  }
-  else if (m_currentName == "jobQueue") {
-    m_currentEvent.setJobQueue(m_currentValue);
-  }
-  else if (m_currentName == "jobStatus") {
-    m_currentEvent.setJobStatus(m_currentValue);
-  }
-  else if (m_currentName == "jobStatusText") {
-    m_currentEvent.setJobStatusText(m_currentValue);
-  }
-
-  m_currentName.clear();
-  m_currentValue.clear();
-}
-
-void  JobEventListXmlReceiver::startElement ( const QXmlName & name )
-{
-  tagDepth++;
-  m_currentName =  name.localName(m_pool);
-  m_currentValue.clear();
+  return event;
 }
 
 } /* namespace anonymous */
@@ -136,7 +84,8 @@ JobEventList::JobEventList()
 }
 
 JobEventList::JobEventList(const JobEventList &other)
-  : m_valid(false), m_jobEvents(other.jobEvents())
+  : m_valid(other.isValid()), m_jobEvents(other.jobEvents()),
+    m_xml(other.xml())
 {
 
 }
@@ -148,48 +97,47 @@ JobEventList JobEventList::fromXml(const QString &xml)
 }
 
 JobEventList JobEventList::fromXml(const QString &xml, const QString &userName,
-                                   QList<qint64> jobIds)
+                                   QList<qint64> jobIds, qint64 minEventTime)
 {
   JobEventList list;
-  list.setContent(xml, userName, jobIds);
+  list.setContent(xml, userName, jobIds, minEventTime);
 
   return list;
 }
 
 void JobEventList::setContent(const QString &content, const QString &userName,
-                              QList<qint64> jobIds)
+                              QList<qint64> jobIds, qint64 minEventTime)
 {
   m_xml = content;
-  m_valid = true;
-
-  MessageHandler handler;
-  QXmlQuery query;
-  query.setMessageHandler(&handler);
-  JobEventListXmlReceiver receiver(query.namePool());
-  query.setFocus(m_xml);
-
-  if (jobIds.isEmpty()) {
-    query.setQuery("/list/JobEvent");
-  }
-  else {
-    QString xpath = "/list/JobEvent/jobID[";
-    QListIterator<qint64> iter(jobIds);
-
-    while (iter.hasNext()) {
-      qint64 jobId = iter.next();
-      xpath += QString("starts-with(text(), '%1')").arg(jobId);
-      if (iter.hasNext())
-        xpath += " or ";
+  m_jobEvents.clear();
+
+  // Responses list every event of the day, so filter while reading rather
+  // than keeping all of them.
+  const QSet<qint64> jobIdSet = jobIds.toSet();
+
+  QXmlStreamReader reader(m_xml);
+  if (reader.readNextStartElement() && reader.name() == QLatin1String("list")) {
+    QString eventUserName;
+    while (reader.readNextStartElement()) {
+      if (reader.name() != QLatin1String("JobEvent")) {
+        reader.skipCurrentElement();
+        continue;
+      }
+
+      eventUserName.clear();
+      JobEvent event = readJobEvent(reader, eventUserName);
+      if (!jobIdSet.isEmpty() && !jobIdSet.contains(event.jobId()))
+        continue;
+      if (!userName.isEmpty() && eventUserName != userName)
+        continue;
+      if (event.eventTime() < minEventTime)
+        continue;
+
+      m_jobEvents.append(event);
     }
-
-    xpath += "]/parent::node()";
-
-    query.setQuery(xpath);
   }
 
-  m_valid = query.evaluateTo(&receiver);
-
-  m_jobEvents = receiver.jobEvents();
+  m_valid = XmlReaderUtils::finish(reader);
 }
 
 } /* namespace Uit */
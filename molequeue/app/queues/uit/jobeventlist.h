@@ -74,11 +74,15 @@ public:
    *
    * @return The object model.
    * @param xml The XML document to parse.
-   * @param userName The username to filter JobEvents on.
-   * @param jobIds The job ids to filer JobEvents on.
+   * @param userName The username to filter JobEvents on, or an empty string
+   * for all users.
+   * @param jobIds The job ids to filer JobEvents on, or an empty list for all
+   * jobs. The number before the first "." of a jobID must match.
+   * @param minEventTime Events with an earlier eventTime are skipped, e.g.
+   * those already processed by a previous poll.
    */
   static JobEventList fromXml(const QString &xml, const QString &userName,
-                              QList<qint64> jobIds);
+                              QList<qint64> jobIds, qint64 minEventTime = 0);
 
 private:
   bool m_valid;
@@ -86,7 +90,7 @@ private:
   QString m_xml;
 
   void setContent(const QString &xml, const QString &userName,
-                  QList<qint64> jobIds);
+                  QList<qint64> jobIds, qint64 minEventTime);
 };
 
 } /* namespace Uit */
@@ -15,10 +15,10 @@
  ******************************************************************************/
 
 #include "jobsubmissioninfo.h"
-#include "messagehandler.h"
+#include "xmlreaderutils.h"
 
-#include <QtXmlPatterns/QXmlQuery>
 #include <QtCore/QRegExp>
+#include <QtCore/QXmlStreamReader>
 
 namespace MoleQueue {
 namespace Uit {
@@ -80,20 +80,25 @@ JobSubmissionInfo JobSubmissionInfo::fromXml(const QString &xml)
 void JobSubmissionInfo::setContent(const QString &content)
 {
   m_xml = content;
-  m_valid = true;
 
-  MessageHandler handler;
-  QXmlQuery query;
-  query.setMessageHandler(&handler);
-  m_valid = query.setFocus(m_xml);
-
-  if (!m_valid)
-    return;
-
-  query.setQuery("/JobSubmissionInfo/jobNumber/string()");
   QString jobNum;
-  m_valid = query.evaluateTo(&jobNum);
-
+  QXmlStreamReader reader(m_xml);
+  if (reader.readNextStartElement() &&
+      reader.name() == QLatin1String("JobSubmissionInfo")) {
+    while (reader.readNextStartElement()) {
+      const QStringRef name = reader.name();
+      if (name == QLatin1String("jobNumber"))
+        jobNum = XmlReaderUtils::readText(reader);
+      else if (name == QLatin1String("stdout"))
+        m_stdout = XmlReaderUtils::readText(reader).trimmed();
+      else if (name == QLatin1String("stderr"))
+        m_stderr = XmlReaderUtils::readText(reader).trimmed();
+      else
+        reader.skipCurrentElement();
+    }
+  }
+
+  m_valid = XmlReaderUtils::finish(reader);
   if (!m_valid)
     return;
 
@@ -103,24 +108,6 @@ void JobSubmissionInfo::setContent(const QString &content)
 
   if (index != -1)
     m_jobNumber = regex.cap(1).toLongLong();
-
-  query.setQuery("/JobSubmissionInfo/stdout/string()");
-  QString out;
-  m_valid = query.evaluateTo(&out);
-
-  if (!m_valid)
-    return;
-
-  m_stdout = out.trimmed();
-
-  query.setQuery("/JobSubmissionInfo/stderr/string()");
-  QString err;
-  m_valid = query.evaluateTo(&err);
-
-  if (!m_valid)
-    return;
-
-  m_stderr = err.trimmed();
 }
 
 QString JobSubmissionInfo::xml() const
@@ -0,0 +1,96 @@
+/******************************************************************************
+
+ This source file is part of the MoleQueue project.
+
+ Copyright 2012 Kitware, Inc.
+
+ This source code is released under the New BSD License, (the "License").
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+ ******************************************************************************/
+
+#include "latencyhistogram.h"
+
+namespace MoleQueue {
+namespace Uit {
+
+namespace {
+/// Up to 2^20 ms, about 17 minutes.
+const int numberOfBuckets = 21;
+}
+
+LatencyHistogram::LatencyHistogram()
+  : m_buckets(numberOfBuckets, 0), m_count(0), m_total(0), m_min(0),
+    m_max(0)
+{
+}
+
+void LatencyHistogram::add(qint64 msecs)
+{
+  msecs = qMax(Q_INT64_C(0), msecs);
+
+  ++m_buckets[bucketIndex(msecs)];
+  m_min = m_count > 0 ? qMin(m_min, msecs) : msecs;
+  m_max = m_count > 0 ? qMax(m_max, msecs) : msecs;
+  m_total += msecs;
+  ++m_count;
+}
+
+double LatencyHistogram::mean() const
+{
+  if (m_count == 0)
+    return 0.0;
+
+  return static_cast<double>(m_total) / m_count;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+  return Q_INT64_C(1) << index;
+}
+
+qint64 LatencyHistogram::percentile(double fraction) const
+{
+  if (m_count == 0)
+    return -1;
+
+  qint64 rank = qMax(Q_INT64_C(1),
+                     static_cast<qint64>(fraction * m_count + 0.5));
+  qint64 seen = 0;
+  for (int i = 0; i < m_buckets.size(); ++i) {
+    seen += m_buckets[i];
+    if (seen >= rank)
+      return qMin(bucketUpperBound(i), m_max);
+  }
+
+  return m_max;
+}
+
+QString LatencyHistogram::toString() const
+{
+  if (m_count == 0)
+    return "n=0";
+
+  return QString("n=%1 min=%2 mean=%3 p50<=%4 p95<=%5 max=%6 ms")
+      .arg(m_count).arg(m_min).arg(mean(), 0, 'f', 1)
+      .arg(percentile(0.5)).arg(percentile(0.95)).arg(m_max);
+}
+
+int LatencyHistogram::bucketIndex(qint64 msecs)
+{
+  int index = 0;
+  while (msecs > 0 && index < numberOfBuckets - 1) {
+    msecs >>= 1;
+    ++index;
+  }
+
+  return index;
+}
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
@@ -0,0 +1,122 @@
+/******************************************************************************
+
+ This source file is part of the MoleQueue project.
+
+ Copyright 2012 Kitware, Inc.
+
+ This source code is released under the New BSD License, (the "License").
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+ ******************************************************************************/
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+namespace MoleQueue {
+namespace Uit {
+
+/**
+ * @class LatencyHistogram latencyhistogram.h
+ * <molequeue/queue/uit/latencyhistogram.h>
+ * @brief The LatencyHistogram class records request latencies in power of two
+ * millisecond buckets.
+ *
+ * Bucket 0 holds latencies under 1 ms, bucket i holds latencies in
+ * [2^(i-1), 2^i) ms. The last bucket also holds anything longer.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+
+  /**
+   * Record a latency.
+   *
+   * @param msecs The latency in milliseconds.
+   */
+  void add(qint64 msecs);
+
+  /**
+   * @return The number of latencies recorded.
+   */
+  qint64 count() const
+  {
+    return m_count;
+  }
+
+  /**
+   * @return The shortest latency recorded, or -1 if there are none.
+   */
+  qint64 min() const
+  {
+    return m_count > 0 ? m_min : -1;
+  }
+
+  /**
+   * @return The longest latency recorded, or -1 if there are none.
+   */
+  qint64 max() const
+  {
+    return m_count > 0 ? m_max : -1;
+  }
+
+  /**
+   * @return The mean latency in milliseconds, or 0 if there are none.
+   */
+  double mean() const;
+
+  /**
+   * @return The number of buckets.
+   */
+  int bucketCount() const
+  {
+    return m_buckets.size();
+  }
+
+  /**
+   * @return The number of latencies in bucket @a index.
+   */
+  qint64 bucket(int index) const
+  {
+    return m_buckets.value(index);
+  }
+
+  /**
+   * @return The exclusive upper bound of bucket @a index in milliseconds.
+   */
+  static qint64 bucketUpperBound(int index);
+
+  /**
+   * @param fraction The percentile as a fraction, e.g. 0.95.
+   * @return An upper bound on the latency at @a fraction, from the bucket it
+   * falls in and capped at max(). -1 if there are no latencies.
+   */
+  qint64 percentile(double fraction) const;
+
+  /**
+   * @return A one line summary, e.g. for the log.
+   */
+  QString toString() const;
+
+private:
+  static int bucketIndex(qint64 msecs);
+
+  QVector<qint64> m_buckets;
+  qint64 m_count;
+  qint64 m_total;
+  qint64 m_min;
+  qint64 m_max;
+};
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -0,0 +1,98 @@
+/******************************************************************************
+
+ This source file is part of the MoleQueue project.
+
+ Copyright 2012 Kitware, Inc.
+
+ This source code is released under the New BSD License, (the "License").
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+ ******************************************************************************/
+
+#include "mappedfiledevice.h"
+#include "logger.h"
+
+#include <cstring>
+
+namespace MoleQueue {
+namespace Uit {
+
+MappedFileDevice::MappedFileDevice(const QString &fileName,
+                                   QObject *parentObject)
+  : QIODevice(parentObject), m_file(fileName), m_data(NULL), m_size(0)
+{
+}
+
+bool MappedFileDevice::open(OpenMode mode)
+{
+  if (mode & QIODevice::WriteOnly) {
+    setErrorString(tr("MappedFileDevice is read only."));
+    return false;
+  }
+
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    setErrorString(tr("Unable to open file: %1").arg(m_file.fileName()));
+    return false;
+  }
+
+  m_size = m_file.size();
+  // A zero length mapping is an error, an empty file needs no mapping.
+  if (m_size > 0) {
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+      setErrorString(tr("Unable to map file %1: %2").arg(m_file.fileName())
+                     .arg(m_file.errorString()));
+      m_file.close();
+      m_size = 0;
+      return false;
+    }
+  }
+
+  // Reads are positioned by pos(), so QIODevice must not read ahead.
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void MappedFileDevice::close()
+{
+  if (m_data)
+    m_file.unmap(m_data);
+  m_data = NULL;
+  m_size = 0;
+  m_file.close();
+  QIODevice::close();
+}
+
+qint64 MappedFileDevice::size() const
+{
+  return m_size;
+}
+
+qint64 MappedFileDevice::readData(char *data, qint64 maxSize)
+{
+  qint64 position = pos();
+  qint64 count = qMin(maxSize, m_size - position);
+  if (count <= 0)
+    return 0;
+
+  memcpy(data, m_data + position, count);
+
+  return count;
+}
+
+qint64 MappedFileDevice::writeData(const char *data, qint64 maxSize)
+{
+  Q_UNUSED(data);
+  Q_UNUSED(maxSize);
+
+  Logger::logError("writeData not supported");
+
+  return -1;
+}
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
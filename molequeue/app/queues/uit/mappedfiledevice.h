@@ -0,0 +1,97 @@
+/******************************************************************************
+
+ This source file is part of the MoleQueue project.
+
+ Copyright 2012 Kitware, Inc.
+
+ This source code is released under the New BSD License, (the "License").
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+ ******************************************************************************/
+
+#ifndef MAPPEDFILEDEVICE_H_
+#define MAPPEDFILEDEVICE_H_
+
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+
+namespace MoleQueue {
+namespace Uit {
+
+/**
+ * @class MappedFileDevice mappedfiledevice.h
+ * <molequeue/queue/uit/mappedfiledevice.h>
+ * @brief The MappedFileDevice class is a read only QIODevice that serves a
+ * file from a memory mapping.
+ *
+ * Reads are copied straight from the mapping into the caller's buffer, with no
+ * system call per read. The mapping can also be accessed directly with
+ * data(). The file must not be modified while the device is open.
+ */
+class MappedFileDevice : public QIODevice
+{
+  Q_OBJECT
+public:
+  /**
+   * @param fileName The file to map.
+   * @param parentObject The parent object.
+   */
+  MappedFileDevice(const QString &fileName, QObject *parentObject = 0);
+
+  /**
+   * @return The file being mapped.
+   */
+  QString fileName() const
+  {
+    return m_file.fileName();
+  }
+
+  /**
+   * Open and map the file. Only QIODevice::ReadOnly is supported.
+   *
+   * @return false if the file cannot be opened or mapped, see errorString().
+   */
+  bool open(OpenMode mode);
+
+  void close();
+
+  /**
+   * @return The size of the file in bytes.
+   */
+  qint64 size() const;
+
+  /**
+   * @return The mapped file contents, size() bytes long, or NULL if the
+   * device is not open or the file is empty.
+   */
+  const char * data() const
+  {
+    return reinterpret_cast<const char *>(m_data);
+  }
+
+protected:
+  /**
+   * Copy from the mapping.
+   */
+  qint64 readData(char *data, qint64 maxSize);
+  /**
+   * Override superclass, write is not supported.
+   */
+  qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+  QFile m_file;
+  /// The mapping, NULL for an empty file.
+  uchar *m_data;
+  qint64 m_size;
+};
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
+
+#endif /* MAPPEDFILEDEVICE_H_ */
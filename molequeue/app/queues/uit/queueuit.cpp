@@ -37,7 +37,6 @@
 #include <QtCore/QTimer>
 #include <QtCore/QXmlStreamWriter>
 #include <QtCore/QSettings>
-#include <QtXmlPatterns/QAbstractMessageHandler>
 #include <QtGui/QApplication>
 #include <QtGui/QMessageBox>
 
@@ -30,17 +30,37 @@ Request::Request(Session *session,
 
 void Request::submit()
 {
+  // Don't send a request the server will reject, authenticate first.
+  if (m_session->isTokenExpired()) {
+    m_session->authenticate(this,
+                            SLOT(send()),
+                            this,
+                            SIGNAL(error(const QString)));
+    return;
+  }
+
+  send();
+}
+
+void Request::send()
+{
+  m_token = m_session->token();
+
   KDSoapJob *job = createJob();
 
   connect(job, SIGNAL(finished(KDSoapJob *)),
           this, SLOT(finished(KDSoapJob *)));
 
+  m_timer.start();
   job->start();
 }
 
 void Request::finished(KDSoapJob *job)
 {
   m_response = job->reply();
+  m_session->recordLatency(
+        QString(metaObject()->className()).section("::", -1),
+        m_timer.elapsed());
 
   // UIT error case
   if (job->isFault()) {
@@ -55,10 +75,11 @@ void Request::finished(KDSoapJob *job)
 void Request::processFault(const KDSoapMessage &fault)
 {
   if (isTokenError(fault)) {
-    m_session->authenticate(this,
-                            SLOT(submit()),
-                            this,
-                            SIGNAL(error(const QString)));
+    // If another request has already re-authenticated the session this
+    // resends with the new token, otherwise the authentication is shared
+    // with any other requests waiting on it.
+    m_session->tokenRejected(m_token);
+    submit();
   }
   else {
     emit error(fault.faultAsString());
@@ -192,12 +213,13 @@ KDSoapJob * GetJobsForHostForUserByNumDaysRequest::createJob()
 }
 
 JobEventList GetJobsForHostForUserByNumDaysRequest::jobEventList(
-  QList<qint64> jobIds)
+  QList<qint64> jobIds, qint64 minEventTime)
 {
   QString responseXml
     = m_response.value().value<QString>();
 
-  JobEventList list = JobEventList::fromXml(responseXml, m_searchUser, jobIds);
+  JobEventList list = JobEventList::fromXml(responseXml, m_searchUser, jobIds,
+                                            minEventTime);
 
   return list;
 }
@@ -340,5 +362,49 @@ bool StatFileRequest::exists()
   return output().contains("No such file or directory");
 }
 
+namespace {
+const QString commandSucceededMarker = "MOLEQUEUE_COMMAND_SUCCEEDED";
+}
+
+RunSimpleCommandRequest::RunSimpleCommandRequest(Session *session,
+                                                 QObject *parentObject)
+  : Request(session, parentObject)
+{
+
+}
+
+KDSoapJob * RunSimpleCommandRequest::createJob()
+{
+  RunSimpleCommandJob *soapJob
+    = new RunSimpleCommandJob(m_session->uitService(), this);
+
+  soapJob->setToken(m_session->token());
+  soapJob->setHostID(m_hostID);
+  soapJob->setUsername(m_userName);
+  soapJob->setCommand(QString("( %1 ) && echo %2").arg(m_command,
+                                                       commandSucceededMarker));
+
+  return soapJob;
+}
+
+QString RunSimpleCommandRequest::output()
+{
+  QString commandOutput = m_response.value().value<QString>();
+
+  return commandOutput.remove(commandSucceededMarker).trimmed();
+}
+
+bool RunSimpleCommandRequest::succeeded()
+{
+  return m_response.value().value<QString>()
+      .contains(commandSucceededMarker);
+}
+
+QString RunSimpleCommandRequest::quote(const QString &arg)
+{
+  QString quoted = arg;
+  return "'" + quoted.replace("'", "'\\''") + "'";
+}
+
 } /* namespace Uit */
 } /* namespace MoleQueue */
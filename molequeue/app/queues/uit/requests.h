@@ -24,6 +24,7 @@
 #include "jobeventlist.h"
 #include "dirlistinginfo.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
 
 
@@ -51,7 +52,8 @@ public:
 
 public slots:
   /**
-   * Slot used to submit request to UIT server.
+   * Slot used to submit request to UIT server. If the session token has
+   * expired the session is authenticated first.
    */
   void submit();
 
@@ -106,6 +108,10 @@ protected:
   KDSoapMessage m_response;
   qint64 m_hostID;
   QString m_userName;
+  /// The token the request was last sent with.
+  QString m_token;
+  /// Started when the request is sent.
+  QElapsedTimer m_timer;
 
   /**
    * Overridden by subclasses to create appropriate KDSoapJob for this request.
@@ -120,6 +126,12 @@ protected slots:
    */
   void finished(KDSoapJob *job);
 
+private slots:
+  /**
+   * Send the request with the current session token.
+   */
+  void send();
+
 private:
   /**
    * @return true, if the fail was the result of a invalid token ( we need to
@@ -394,11 +406,12 @@ public:
    * UIT server.
    *
    * @param jobIds The list of job ID to filter the events on.
+   * @param minEventTime Events older than this are skipped.
    *
    * Note: Will only produce a populated JobEventList object after the
    * finished() signal has been emitted.
    */
-  JobEventList jobEventList(QList<qint64> jobIds);
+  JobEventList jobEventList(QList<qint64> jobIds, qint64 minEventTime = 0);
 
 protected:
   KDSoapJob *createJob();
@@ -647,6 +660,78 @@ private:
   QString m_filename;
 };
 
+/**
+ *  @brief Concrete Request class for runSimpleCommand message.
+ *
+ * The command is run by a shell on the host. A marker is echoed when it
+ * succeeds, so that the exit status can be told from the output.
+ */
+class RunSimpleCommandRequest: public Request
+{
+  Q_OBJECT
+public:
+  /**
+   * @param session The UIT session.
+   * @param parentObject The parent object.
+   */
+  RunSimpleCommandRequest(Session *session,
+                          QObject *parentObject = 0);
+
+  /**
+   * @return The job associated with this request.
+   */
+  Job job() const
+  {
+    return m_job;
+  }
+
+  /**
+   * @param j The job associated with this request.
+   */
+  void setJob(const Job& j)
+  {
+    m_job = j;
+  }
+
+  /**
+   * @return The shell command to run.
+   */
+  QString command() const
+  {
+    return m_command;
+  }
+
+  /**
+   * @param cmd The shell command to run.
+   */
+  void setCommand(const QString& cmd)
+  {
+    m_command = cmd;
+  }
+
+  /**
+   * @return The output of the command, without the success marker.
+   */
+  QString output();
+
+  /**
+   * @return true if the command exited with status 0.
+   */
+  bool succeeded();
+
+  /**
+   * @return @a arg quoted for use as a single shell word.
+   */
+  static QString quote(const QString &arg);
+
+protected:
+  KDSoapJob *createJob();
+
+private:
+  Job m_job;
+  QString m_command;
+};
+
 
 } /* namespace Uit */
 } /* namespace MoleQueue */
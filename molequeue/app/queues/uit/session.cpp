@@ -25,7 +25,8 @@ namespace Uit {
 Session::Session(const QString &username, const QString &realm,
                        QObject *parentObject)
   : QObject(parentObject), m_kerberosUserName(username), m_kerberosRealm(realm),
-    m_kerberosPrinciple(username + "@" + realm), m_authenticator(NULL)
+    m_kerberosPrinciple(username + "@" + realm), m_tokenLifetime(0),
+    m_authenticator(NULL)
 {
 
 }
@@ -45,6 +46,32 @@ QString Session::kerberosPrinciple()
   return m_kerberosPrinciple;
 }
 
+void Session::setToken(const QString &tok)
+{
+  m_token = tok;
+  m_tokenAge.start();
+}
+
+void Session::tokenRejected(const QString &tok)
+{
+  if (m_token == tok)
+    m_token.clear();
+}
+
+bool Session::isTokenExpired() const
+{
+  if (m_token.isEmpty())
+    return true;
+
+  return m_tokenLifetime > 0
+      && m_tokenAge.elapsed() >= m_tokenLifetime * Q_INT64_C(1000);
+}
+
+void Session::recordLatency(const QString &operation, qint64 msecs)
+{
+  m_latencies[operation].add(msecs);
+}
+
 void Session::authenticate(QObject *completeReciever,
                               const char *completeSlot,
                               QObject *errorReceiver,
@@ -81,7 +108,7 @@ void Session::authenticationCompleteInternal(const QString &tok)
 
   m_authenticator->deleteLater();
   m_authenticator = NULL;
-  m_token = tok;
+  setToken(tok);
 
   emit authenticationComplete(tok);
 
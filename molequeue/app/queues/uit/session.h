@@ -18,9 +18,13 @@
 #define SESSION_H_
 
 #include "wsdl_uitapi.h"
+#include "latencyhistogram.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMap>
 #include <QtCore/QObject>
 #include <QtCore/QMutex>
+#include <QtCore/QStringList>
 
 namespace MoleQueue {
 namespace Uit {
@@ -33,6 +37,9 @@ class Authenticator;
  * @brief The Session class encapsulates a UIT authentication token that can
  * be share across multiple requests.
  *
+ * All requests for a session go through the same UitapiService, so they share
+ * its HTTP keep-alive connections. The session also records the latency of
+ * each request, keyed on the request type.
  */
 class Session : public QObject
 {
@@ -66,6 +73,72 @@ public:
   QString token();
   UitapiService *uitService();
 
+  /**
+   * Set the session token, restarting its lifetime.
+   *
+   * @param tok The UIT session token.
+   */
+  void setToken(const QString &tok);
+
+  /**
+   * Called when the server rejects @a tok. The token is discarded, unless it
+   * has already been replaced by a newer one.
+   *
+   * @param tok The token the rejected request was sent with.
+   */
+  void tokenRejected(const QString &tok);
+
+  /**
+   * @return true if there is no token, or it is older than tokenLifetime().
+   * Requests authenticate before being sent when the token has expired,
+   * rather than waiting for the server to reject it.
+   */
+  bool isTokenExpired() const;
+
+  /**
+   * @return The number of seconds a token is used for before the session
+   * re-authenticates, 0 if tokens are only refreshed when rejected.
+   */
+  int tokenLifetime() const
+  {
+    return m_tokenLifetime;
+  }
+
+  /**
+   * @param seconds The number of seconds a token is used for before the
+   * session re-authenticates. This should be a little shorter than the
+   * lifetime the server gives tokens. 0, the default, refreshes tokens only
+   * when they are rejected.
+   */
+  void setTokenLifetime(int seconds)
+  {
+    m_tokenLifetime = seconds;
+  }
+
+  /**
+   * Record the latency of a request.
+   *
+   * @param operation The type of request, e.g. "StatFileRequest".
+   * @param msecs The time from submission to response in milliseconds.
+   */
+  void recordLatency(const QString &operation, qint64 msecs);
+
+  /**
+   * @return The latencies recorded for @a operation.
+   */
+  LatencyHistogram latency(const QString &operation) const
+  {
+    return m_latencies.value(operation);
+  }
+
+  /**
+   * @return The operations latencies have been recorded for.
+   */
+  QStringList latencyOperations() const
+  {
+    return m_latencies.keys();
+  }
+
 signals:
   void authenticationComplete(const QString &token);
   void authenticationError(const QString &errorString);
@@ -81,8 +154,13 @@ private:
   QString m_kerberosPrinciple;
   UitapiService m_uit;
   QString m_token;
+  /// Started when m_token is set.
+  QElapsedTimer m_tokenAge;
+  int m_tokenLifetime;
   Authenticator *m_authenticator;
   QMutex m_authMutex;
+  /// Map of request type to latencies.
+  QMap<QString, LatencyHistogram> m_latencies;
 };
 
 } /* namespace Uit */
@@ -0,0 +1,267 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "tararchivedevice.h"
+#include "logger.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+
+#include <cstring>
+
+namespace MoleQueue {
+namespace Uit {
+
+namespace {
+const qint64 blockSize = 512;
+
+qint64 paddedSize(qint64 size)
+{
+  return (size + blockSize - 1) / blockSize * blockSize;
+}
+
+/// Write @a value as a NUL terminated octal number filling @a width bytes.
+bool writeOctal(QByteArray &header, int offset, int width, qint64 value)
+{
+  QByteArray digits = QByteArray::number(value, 8);
+  if (value < 0 || digits.size() > width - 1)
+    return false;
+
+  digits = digits.rightJustified(width - 1, '0');
+  memcpy(header.data() + offset, digits.constData(), width - 1);
+  header[offset + width - 1] = '\0';
+  return true;
+}
+
+int unixMode(QFile::Permissions permissions)
+{
+  int mode = 0;
+  if (permissions & QFile::ReadOwner)  mode |= 0400;
+  if (permissions & QFile::WriteOwner) mode |= 0200;
+  if (permissions & QFile::ExeOwner)   mode |= 0100;
+  if (permissions & QFile::ReadGroup)  mode |= 0040;
+  if (permissions & QFile::WriteGroup) mode |= 0020;
+  if (permissions & QFile::ExeGroup)   mode |= 0010;
+  if (permissions & QFile::ReadOther)  mode |= 0004;
+  if (permissions & QFile::WriteOther) mode |= 0002;
+  if (permissions & QFile::ExeOther)   mode |= 0001;
+  return mode;
+}
+}
+
+TarArchiveDevice::TarArchiveDevice(const QString &directory,
+                                   QObject *parentObject)
+  : QIODevice(parentObject), m_directory(directory), m_size(0),
+    m_fileEntry(-1)
+{
+}
+
+bool TarArchiveDevice::open(OpenMode mode)
+{
+  if (mode & QIODevice::WriteOnly) {
+    setErrorString(tr("TarArchiveDevice is read only."));
+    return false;
+  }
+
+  m_entries.clear();
+  m_size = 0;
+
+  QDir dir(m_directory);
+  if (!dir.exists()) {
+    setErrorString(tr("Directory does not exist: %1").arg(m_directory));
+    return false;
+  }
+
+  // Parents are always listed before their contents.
+  QDirIterator it(m_directory,
+                  QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+                  QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+  while (it.hasNext()) {
+    it.next();
+    if (!addEntry(it.fileInfo(), dir.relativeFilePath(it.filePath())))
+      return false;
+  }
+
+  // The archive ends with two zero blocks.
+  m_size += 2 * blockSize;
+
+  // Reads are positioned by pos(), so QIODevice must not read ahead.
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void TarArchiveDevice::close()
+{
+  m_file.close();
+  m_fileEntry = -1;
+  QIODevice::close();
+}
+
+qint64 TarArchiveDevice::size() const
+{
+  return m_size;
+}
+
+qint64 TarArchiveDevice::readData(char *data, qint64 maxSize)
+{
+  qint64 position = pos();
+  qint64 bytesRead = 0;
+
+  while (bytesRead < maxSize && position < m_size) {
+    qint64 wanted = maxSize - bytesRead;
+    int index = entryAt(position);
+
+    // End of archive blocks.
+    if (index < 0) {
+      qint64 count = qMin(wanted, m_size - position);
+      memset(data + bytesRead, 0, count);
+      bytesRead += count;
+      position += count;
+      continue;
+    }
+
+    const Entry &entry = m_entries[index];
+    qint64 offset = position - entry.offset;
+    qint64 count = 0;
+
+    if (offset < blockSize) {
+      count = qMin(wanted, blockSize - offset);
+      memcpy(data + bytesRead, entry.header.constData() + offset, count);
+    }
+    else if (offset - blockSize < entry.dataSize) {
+      if (m_fileEntry != index) {
+        m_file.close();
+        m_file.setFileName(entry.filePath);
+        if (!m_file.open(QIODevice::ReadOnly)) {
+          setErrorString(tr("Unable to open file: %1").arg(entry.filePath));
+          m_fileEntry = -1;
+          return -1;
+        }
+        m_fileEntry = index;
+      }
+
+      qint64 fileOffset = offset - blockSize;
+      count = qMin(wanted, entry.dataSize - fileOffset);
+      if (m_file.pos() != fileOffset)
+        m_file.seek(fileOffset);
+      if (m_file.read(data + bytesRead, count) != count) {
+        // The size is already in the header, so a file that shrinks after
+        // open() cannot be archived.
+        setErrorString(tr("Unable to read file: %1").arg(entry.filePath));
+        return -1;
+      }
+    }
+    else {
+      // Zero padding up to the next block.
+      qint64 end = entry.offset + blockSize + paddedSize(entry.dataSize);
+      count = qMin(wanted, end - position);
+      memset(data + bytesRead, 0, count);
+    }
+
+    bytesRead += count;
+    position += count;
+  }
+
+  return bytesRead;
+}
+
+qint64 TarArchiveDevice::writeData(const char *data, qint64 maxSize)
+{
+  Q_UNUSED(data);
+  Q_UNUSED(maxSize);
+
+  Logger::logError("writeData not supported");
+
+  return -1;
+}
+
+bool TarArchiveDevice::addEntry(const QFileInfo &info, const QString &name)
+{
+  bool isDir = info.isDir();
+  QByteArray path = name.toUtf8();
+  if (isDir)
+    path += '/';
+
+  // Names longer than 100 bytes are split into a prefix and a name at a '/'.
+  QByteArray prefix;
+  if (path.size() > 100) {
+    int split = path.lastIndexOf('/', isDir ? path.size() - 2 : -1);
+    while (split > 155)
+      split = path.lastIndexOf('/', split - 1);
+    if (split <= 0 || path.size() - split - 1 > 100) {
+      setErrorString(tr("Path is too long for a tar archive: %1").arg(name));
+      return false;
+    }
+    prefix = path.left(split);
+    path = path.mid(split + 1);
+  }
+
+  Entry entry;
+  entry.filePath = isDir ? QString() : info.absoluteFilePath();
+  entry.dataSize = isDir ? 0 : info.size();
+  entry.offset = m_size;
+
+  QByteArray &header = entry.header;
+  header.fill('\0', blockSize);
+  memcpy(header.data(), path.constData(), path.size());
+  bool ok = writeOctal(header, 100, 8, unixMode(info.permissions()))
+      && writeOctal(header, 108, 8, 0)
+      && writeOctal(header, 116, 8, 0)
+      && writeOctal(header, 124, 12, entry.dataSize)
+      && writeOctal(header, 136, 12, info.lastModified().toTime_t());
+  if (!ok) {
+    setErrorString(tr("File is too large for a tar archive: %1").arg(name));
+    return false;
+  }
+  header[156] = isDir ? '5' : '0';
+  memcpy(header.data() + 257, "ustar\0" "00", 8);
+  memcpy(header.data() + 345, prefix.constData(), prefix.size());
+
+  // The checksum is computed with its own field set to spaces.
+  memset(header.data() + 148, ' ', 8);
+  qint64 checksum = 0;
+  for (int i = 0; i < blockSize; ++i)
+    checksum += static_cast<unsigned char>(header[i]);
+  writeOctal(header, 148, 7, checksum);
+
+  m_entries.append(entry);
+  m_size += blockSize + paddedSize(entry.dataSize);
+
+  return true;
+}
+
+int TarArchiveDevice::entryAt(qint64 position) const
+{
+  if (m_entries.isEmpty()
+      || position >= m_size - 2 * blockSize)
+    return -1;
+
+  // Binary search for the last entry starting at or before position.
+  int low = 0;
+  int high = m_entries.size() - 1;
+  while (low < high) {
+    int mid = (low + high + 1) / 2;
+    if (m_entries[mid].offset <= position)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+
+  return low;
+}
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
@@ -0,0 +1,113 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef TARARCHIVEDEVICE_H_
+#define TARARCHIVEDEVICE_H_
+
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+#include <QtCore/QVector>
+
+class QFileInfo;
+
+namespace MoleQueue {
+namespace Uit {
+
+/**
+ * @class TarArchiveDevice tararchivedevice.h
+ * <molequeue/queue/uit/tararchivedevice.h>
+ * @brief The TarArchiveDevice class is a read only QIODevice that generates a
+ * ustar archive of a local directory on the fly.
+ *
+ * The directory is scanned when the device is opened so that size() is known
+ * up front. File contents are read as the archive is read, so the archive is
+ * never held in memory or written to disk. The device is seekable.
+ */
+class TarArchiveDevice : public QIODevice
+{
+  Q_OBJECT
+public:
+  /**
+   * @param directory The local directory to archive. Entries are named
+   * relative to it.
+   * @param parentObject The parent object.
+   */
+  TarArchiveDevice(const QString &directory, QObject *parentObject = 0);
+
+  /**
+   * @return The directory being archived.
+   */
+  QString directory() const
+  {
+    return m_directory;
+  }
+
+  /**
+   * Scan the directory. Only QIODevice::ReadOnly is supported.
+   *
+   * @return false if the directory cannot be read or contains an entry that
+   * cannot be represented in a ustar archive, see errorString().
+   */
+  bool open(OpenMode mode);
+
+  void close();
+
+  /**
+   * @return The size of the archive in bytes.
+   */
+  qint64 size() const;
+
+  /**
+   * @return The number of files and directories in the archive.
+   */
+  int entryCount() const
+  {
+    return m_entries.size();
+  }
+
+protected:
+  qint64 readData(char *data, qint64 maxSize);
+
+  /**
+   * Override superclass, write is not supported.
+   */
+  qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+  struct Entry
+  {
+    /// Absolute path of a regular file, empty for directories.
+    QString filePath;
+    QByteArray header;
+    qint64 offset;
+    qint64 dataSize;
+  };
+
+  bool addEntry(const QFileInfo &info, const QString &name);
+  int entryAt(qint64 position) const;
+
+  QString m_directory;
+  QVector<Entry> m_entries;
+  qint64 m_size;
+  /// The file of the entry currently being read.
+  QFile m_file;
+  int m_fileEntry;
+};
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
+
+#endif /* TARARCHIVEDEVICE_H_ */
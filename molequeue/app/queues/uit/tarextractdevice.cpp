@@ -0,0 +1,306 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "tarextractdevice.h"
+#include "logger.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+
+#include <cstring>
+
+namespace MoleQueue {
+namespace Uit {
+
+namespace {
+const qint64 blockSize = 512;
+/// Upper bound for GNU long name and pax header contents, which are buffered.
+const qint64 maxMetadataSize = 1024 * 1024;
+
+/// Read a NUL or space terminated octal field, or a GNU base-256 number.
+qint64 readNumber(const char *field, int width)
+{
+  qint64 value = 0;
+  if (field[0] & 0x80) {
+    for (int i = 1; i < width; ++i)
+      value = (value << 8) | static_cast<unsigned char>(field[i]);
+    return value;
+  }
+
+  for (int i = 0; i < width; ++i) {
+    if (field[i] == ' ' && value == 0)
+      continue;
+    if (field[i] < '0' || field[i] > '7')
+      break;
+    value = value * 8 + (field[i] - '0');
+  }
+  return value;
+}
+
+QString readString(const char *field, int width)
+{
+  return QString::fromUtf8(field, static_cast<int>(qstrnlen(field, width)));
+}
+
+QFile::Permissions permissionsFromMode(int mode)
+{
+  QFile::Permissions permissions;
+  if (mode & 0400) permissions |= QFile::ReadOwner | QFile::ReadUser;
+  if (mode & 0200) permissions |= QFile::WriteOwner | QFile::WriteUser;
+  if (mode & 0100) permissions |= QFile::ExeOwner | QFile::ExeUser;
+  if (mode & 0040) permissions |= QFile::ReadGroup;
+  if (mode & 0020) permissions |= QFile::WriteGroup;
+  if (mode & 0010) permissions |= QFile::ExeGroup;
+  if (mode & 0004) permissions |= QFile::ReadOther;
+  if (mode & 0002) permissions |= QFile::WriteOther;
+  if (mode & 0001) permissions |= QFile::ExeOther;
+  return permissions;
+}
+}
+
+TarExtractDevice::TarExtractDevice(const QString &directory,
+                                   QObject *parentObject)
+  : QIODevice(parentObject), m_directory(directory), m_state(Header),
+    m_entryType('0'), m_entryMode(0), m_remaining(0), m_padding(0),
+    m_complete(false), m_entryCount(0)
+{
+}
+
+bool TarExtractDevice::open(OpenMode mode)
+{
+  if (mode & QIODevice::ReadOnly) {
+    setErrorString(tr("TarExtractDevice is write only."));
+    return false;
+  }
+
+  if (!QDir().mkpath(m_directory)) {
+    setErrorString(tr("Unable to create directory: %1").arg(m_directory));
+    return false;
+  }
+
+  m_state = Header;
+  m_header.clear();
+  m_contents.clear();
+  m_nextName.clear();
+  m_remaining = 0;
+  m_padding = 0;
+  m_complete = false;
+  m_entryCount = 0;
+
+  return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+void TarExtractDevice::close()
+{
+  m_file.close();
+  QIODevice::close();
+}
+
+qint64 TarExtractDevice::readData(char *data, qint64 maxSize)
+{
+  Q_UNUSED(data);
+  Q_UNUSED(maxSize);
+
+  Logger::logError("readData not supported");
+
+  return -1;
+}
+
+qint64 TarExtractDevice::writeData(const char *data, qint64 maxSize)
+{
+  qint64 written = 0;
+
+  while (written < maxSize) {
+    qint64 available = maxSize - written;
+    qint64 count = 0;
+
+    switch (m_state) {
+    case Header:
+      count = qMin(available, blockSize - m_header.size());
+      m_header.append(data + written, static_cast<int>(count));
+      if (m_header.size() == blockSize && !processHeader())
+        return -1;
+      break;
+    case Contents:
+      count = qMin(available, m_remaining);
+      if (m_file.isOpen()) {
+        if (m_file.write(data + written, count) != count) {
+          setErrorString(tr("Unable to write file: %1")
+                         .arg(m_file.fileName()));
+          return -1;
+        }
+      }
+      else if (m_entryType == 'L' || m_entryType == 'x') {
+        m_contents.append(data + written, static_cast<int>(count));
+      }
+      m_remaining -= count;
+      if (m_remaining == 0 && !finishEntry())
+        return -1;
+      break;
+    case Padding:
+      count = qMin(available, m_padding);
+      m_padding -= count;
+      if (m_padding == 0)
+        m_state = Header;
+      break;
+    case End:
+      // Ignore the zero blocks that fill the last record.
+      count = available;
+      break;
+    }
+
+    written += count;
+  }
+
+  return written;
+}
+
+bool TarExtractDevice::processHeader()
+{
+  const char *header = m_header.constData();
+
+  // A zero block marks the end of the archive.
+  if (m_header.count('\0') == blockSize) {
+    m_header.clear();
+    m_state = End;
+    m_complete = true;
+    return true;
+  }
+
+  qint64 checksum = 0;
+  for (int i = 0; i < blockSize; ++i) {
+    if (i >= 148 && i < 156)
+      checksum += ' ';
+    else
+      checksum += static_cast<unsigned char>(header[i]);
+  }
+  if (checksum != readNumber(header + 148, 8)) {
+    setErrorString(tr("Invalid tar header checksum."));
+    return false;
+  }
+
+  m_entryType = header[156];
+  m_entryMode = static_cast<int>(readNumber(header + 100, 8));
+  m_remaining = readNumber(header + 124, 12);
+  m_padding = (blockSize - m_remaining % blockSize) % blockSize;
+
+  if (!m_nextName.isEmpty()) {
+    m_entryName = m_nextName;
+    m_nextName.clear();
+  }
+  else {
+    m_entryName = readString(header, 100);
+    QString prefix = readString(header + 345, 155);
+    if (memcmp(header + 257, "ustar", 5) == 0 && !prefix.isEmpty())
+      m_entryName = prefix + "/" + m_entryName;
+  }
+  m_header.clear();
+
+  QString path;
+  switch (m_entryType) {
+  case '0':
+  case '\0':
+  case '7':
+    if (!localPath(m_entryName, path))
+      return false;
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+      setErrorString(tr("Unable to create directory: %1")
+                     .arg(QFileInfo(path).path()));
+      return false;
+    }
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+      setErrorString(tr("Unable to open file for write: %1").arg(path));
+      return false;
+    }
+    ++m_entryCount;
+    break;
+  case '5':
+    if (!localPath(m_entryName, path))
+      return false;
+    if (!QDir().mkpath(path)) {
+      setErrorString(tr("Unable to create directory: %1").arg(path));
+      return false;
+    }
+    ++m_entryCount;
+    break;
+  case 'L':
+  case 'x':
+    if (m_remaining > maxMetadataSize) {
+      setErrorString(tr("Tar header for %1 is too large.").arg(m_entryName));
+      return false;
+    }
+    m_contents.clear();
+    break;
+  default:
+    Logger::logDebugMessage(tr("Skipping tar entry %1 of type '%2'.")
+                            .arg(m_entryName, QString(QChar(m_entryType))));
+    break;
+  }
+
+  if (m_remaining == 0)
+    return finishEntry();
+
+  m_state = Contents;
+  return true;
+}
+
+bool TarExtractDevice::finishEntry()
+{
+  if (m_file.isOpen()) {
+    m_file.close();
+    m_file.setPermissions(permissionsFromMode(m_entryMode));
+  }
+
+  if (m_entryType == 'L') {
+    m_nextName = readString(m_contents.constData(), m_contents.size());
+  }
+  else if (m_entryType == 'x') {
+    // pax records are "<length> <key>=<value>\n".
+    int pos = 0;
+    while (pos < m_contents.size()) {
+      int space = m_contents.indexOf(' ', pos);
+      int length = m_contents.mid(pos, space - pos).toInt();
+      if (space < 0 || length <= 0)
+        break;
+      QByteArray record = m_contents.mid(space + 1, pos + length - space - 2);
+      if (record.startsWith("path="))
+        m_nextName = QString::fromUtf8(record.mid(5));
+      pos += length;
+    }
+  }
+  m_contents.clear();
+
+  m_state = m_padding > 0 ? Padding : Header;
+  return true;
+}
+
+bool TarExtractDevice::localPath(const QString &name, QString &path)
+{
+  QString cleaned = QDir::cleanPath(name);
+  if (QDir::isAbsolutePath(cleaned) || cleaned == ".."
+      || cleaned.startsWith("../")) {
+    setErrorString(tr("Refusing to extract %1 outside of %2.")
+                   .arg(name, m_directory));
+    return false;
+  }
+
+  path = cleaned == "." ? m_directory : m_directory + "/" + cleaned;
+  return true;
+}
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
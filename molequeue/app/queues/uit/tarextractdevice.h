@@ -0,0 +1,123 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef TAREXTRACTDEVICE_H_
+#define TAREXTRACTDEVICE_H_
+
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+
+namespace MoleQueue {
+namespace Uit {
+
+/**
+ * @class TarExtractDevice tarextractdevice.h
+ * <molequeue/queue/uit/tarextractdevice.h>
+ * @brief The TarExtractDevice class is a write only QIODevice that unpacks a
+ * tar archive into a local directory as the archive is written to it.
+ *
+ * ustar, GNU long name and pax path headers are understood. Regular files and
+ * directories are extracted, other entry types (links, devices) are skipped.
+ * Entries with absolute paths or ".." components are rejected.
+ */
+class TarExtractDevice : public QIODevice
+{
+  Q_OBJECT
+public:
+  /**
+   * @param directory The local directory to unpack into.
+   * @param parentObject The parent object.
+   */
+  TarExtractDevice(const QString &directory, QObject *parentObject = 0);
+
+  /**
+   * @return The directory being unpacked into.
+   */
+  QString directory() const
+  {
+    return m_directory;
+  }
+
+  /**
+   * Start a new extraction, creating directory() if needed. Only
+   * QIODevice::WriteOnly is supported.
+   */
+  bool open(OpenMode mode);
+
+  void close();
+
+  bool isSequential() const
+  {
+    return true;
+  }
+
+  /**
+   * @return true once the end of archive marker has been written.
+   */
+  bool isComplete() const
+  {
+    return m_complete;
+  }
+
+  /**
+   * @return The number of files and directories extracted so far.
+   */
+  int entryCount() const
+  {
+    return m_entryCount;
+  }
+
+protected:
+  /**
+   * Override superclass, read is not supported.
+   */
+  qint64 readData(char *data, qint64 maxSize);
+
+  qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+  enum State {
+    Header,
+    Contents,
+    Padding,
+    End
+  };
+
+  bool processHeader();
+  bool finishEntry();
+  bool localPath(const QString &name, QString &path);
+
+  QString m_directory;
+  State m_state;
+  QByteArray m_header;
+  /// Contents of the entry being written, unless it is a file.
+  QByteArray m_contents;
+  char m_entryType;
+  int m_entryMode;
+  QString m_entryName;
+  qint64 m_remaining;
+  qint64 m_padding;
+  /// Name set by a GNU long name or pax header for the next entry.
+  QString m_nextName;
+  QFile m_file;
+  bool m_complete;
+  int m_entryCount;
+};
+
+} /* namespace Uit */
+} /* namespace MoleQueue */
+
+#endif /* TAREXTRACTDEVICE_H_ */
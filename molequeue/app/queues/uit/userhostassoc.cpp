@@ -15,10 +15,6 @@
  ******************************************************************************/
 
 #include "userhostassoc.h"
-#include "messagehandler.h"
-
-#include <QtXmlPatterns/QXmlQuery>
-#include <QtXmlPatterns/QAbstractMessageHandler>
 
 namespace MoleQueue {
 namespace Uit {
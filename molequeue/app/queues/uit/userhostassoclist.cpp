@@ -15,10 +15,43 @@
  ******************************************************************************/
 
 #include "userhostassoclist.h"
-#include "messagehandler.h"
+#include "xmlreaderutils.h"
 
-#include <QtCore/QStringList>
-#include <QtXmlPatterns/QXmlQuery>
+#include <QtCore/QXmlStreamReader>
+
+namespace {
+
+/**
+ * Read a PublicHostPlusUser element. @a reader must be at its start element,
+ * and is left at its end element.
+ */
+MoleQueue::Uit::UserHostAssoc readUserHostAssoc(QXmlStreamReader &reader)
+{
+  using MoleQueue::Uit::XmlReaderUtils::readText;
+
+  MoleQueue::Uit::UserHostAssoc userHostAssoc;
+  while (reader.readNextStartElement()) {
+    const QStringRef name = reader.name();
+    if (name == QLatin1String("hostID"))
+      userHostAssoc.setHostId(readText(reader).trimmed().toLongLong());
+    else if (name == QLatin1String("account"))
+      userHostAssoc.setAccount(readText(reader).trimmed());
+    else if (name == QLatin1String("systemName"))
+      userHostAssoc.setSystemName(readText(reader).trimmed());
+    else if (name == QLatin1String("transportMethod"))
+      userHostAssoc.setTransportMethod(readText(reader).trimmed());
+    else if (name == QLatin1String("description"))
+      userHostAssoc.setDescription(readText(reader).trimmed());
+    else if (name == QLatin1String("hostName"))
+      userHostAssoc.setHostName(readText(reader).trimmed());
+    else
+      reader.skipCurrentElement();
+  }
+
+  return userHostAssoc;
+}
+
+} /* namespace anonymous */
 
 namespace MoleQueue {
 namespace Uit {
@@ -33,85 +66,21 @@ UserHostAssocList::UserHostAssocList()
 void UserHostAssocList::setContent(const QString &content)
 {
   m_xml = content;
-  m_valid = true;
-
-  MessageHandler handler;
-  QXmlQuery query;
-  query.setMessageHandler(&handler);
-  m_valid = query.setFocus(m_xml);
-
-  if (!m_valid)
-    return;
-
-  // First get the list of hostIDs
-  query.setQuery("/list/PublicHostPlusUser/hostID/string()");
-  QStringList hostIDs;
-  m_valid = query.evaluateTo(&hostIDs);
-
-  if (!m_valid)
-    return;
 
   QList<UserHostAssoc> assocs;
-
-  foreach (const QString &id, hostIDs) {
-    UserHostAssoc userHostAssoc;
-    userHostAssoc.setHostId(id.toULongLong());
-    query.bindVariable("id", QVariant(id));
-    // Get the account
-    QString user;
-    query.setQuery("/list/PublicHostPlusUser[hostID=$id]/account/string()");
-    m_valid = query.evaluateTo(&user);
-
-    if (!m_valid)
-      return;
-
-    userHostAssoc.setAccount(user.trimmed());
-
-    // Get the systemName
-    QString system;
-    query.setQuery("/list/PublicHostPlusUser[hostID=$id]/systemName/string()");
-    m_valid = query.evaluateTo(&system);
-
-    if (!m_valid)
-      return;
-
-    userHostAssoc.setSystemName(system.trimmed());
-
-    // Get the transportMethod
-    QString transport;
-    query.setQuery(
-      "/list/PublicHostPlusUser[hostID=$id]/transportMethod/string()");
-    m_valid = query.evaluateTo(&transport);
-
-    if (!m_valid)
-      return;
-
-    userHostAssoc.setTransportMethod(transport.trimmed());
-
-    // Get the description
-    QString des;
-    query.setQuery("/list/PublicHostPlusUser[hostID=$id]/description/string()");
-    m_valid = query.evaluateTo(&des);
-
-    if (!m_valid)
-      return;
-
-    userHostAssoc.setDescription(des.trimmed());
-
-    // Get the hostName
-    QString host;
-    query.setQuery("/list/PublicHostPlusUser[hostID=$id]/hostName/string()");
-    m_valid = query.evaluateTo(&host);
-
-    if (!m_valid)
-      return;
-
-    userHostAssoc.setHostName(host.trimmed());
-
-    assocs.append(userHostAssoc);
+  QXmlStreamReader reader(m_xml);
+  if (reader.readNextStartElement() && reader.name() == QLatin1String("list")) {
+    while (reader.readNextStartElement()) {
+      if (reader.name() == QLatin1String("PublicHostPlusUser"))
+        assocs.append(readUserHostAssoc(reader));
+      else
+        reader.skipCurrentElement();
+    }
   }
 
-  m_userHostAssocs = assocs;
+  m_valid = XmlReaderUtils::finish(reader);
+  if (m_valid)
+    m_userHostAssocs = assocs;
 }
 
 UserHostAssocList UserHostAssocList::fromXml(const QString &xml)
@@ -14,27 +14,34 @@
 
  ******************************************************************************/
 
-#include "messagehandler.h"
+#include "xmlreaderutils.h"
 #include "logger.h"
 
+#include <QtCore/QXmlStreamReader>
+
 namespace MoleQueue {
 namespace Uit {
+namespace XmlReaderUtils {
 
-MessageHandler::MessageHandler(QObject *parentObject)
-  : QAbstractMessageHandler(parentObject)
+QString readText(QXmlStreamReader &reader)
 {
-
+  return reader.readElementText(QXmlStreamReader::IncludeChildElements);
 }
 
-void MessageHandler::handleMessage(QtMsgType type, const QString &description,
-                                   const QUrl &identifier,
-                                   const QSourceLocation &sourceLocation)
+bool finish(QXmlStreamReader &reader)
 {
-  Q_UNUSED(type);
-  Q_UNUSED(identifier);
-  Q_UNUSED(sourceLocation);
-  Logger::logError("UIT XML parse error: " + description);
+  while (!reader.atEnd())
+    reader.readNext();
+
+  if (!reader.hasError())
+    return true;
+
+  Logger::logError(QString("UIT XML parse error: %1 (line %2, column %3)")
+                   .arg(reader.errorString()).arg(reader.lineNumber())
+                   .arg(reader.columnNumber()));
+  return false;
 }
 
-} /* namespace MoleQueue */
+} /* namespace XmlReaderUtils */
+} /* namespace Uit */
 } /* namespace MoleQueue */
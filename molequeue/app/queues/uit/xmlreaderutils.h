@@ -14,30 +14,38 @@
 
  ******************************************************************************/
 
-#ifndef MESSAGEHANDLER_H_
-#define MESSAGEHANDLER_H_
+#ifndef XMLREADERUTILS_H_
+#define XMLREADERUTILS_H_
 
-#include <QtXmlPatterns/QAbstractMessageHandler>
+#include <QtCore/QString>
+
+class QXmlStreamReader;
 
 namespace MoleQueue {
 namespace Uit {
 
 /**
- * Concrete QAbstractMessageHandler implementation used to report errors
- * associated with parsing XML content past QXmlQuery objects.
+ * Helpers shared by the single pass QXmlStreamReader parsers of the UIT
+ * responses.
+ */
+namespace XmlReaderUtils {
+
+/**
+ * Read the text of the current element, including the text of any child
+ * elements, and leave @a reader at its end element.
  */
-class MessageHandler : public QAbstractMessageHandler
-{
-public:
-  MessageHandler(QObject *parentObject = 0);
+QString readText(QXmlStreamReader &reader);
 
-protected:
-  virtual void handleMessage(QtMsgType type, const QString &description,
-                             const QUrl &identifier,
-                             const QSourceLocation &sourceLocation);
-};
+/**
+ * Read the rest of the document, so that errors after the parsed elements are
+ * found too, and log the error if there is one.
+ *
+ * @return true if the document is well formed, false otherwise.
+ */
+bool finish(QXmlStreamReader &reader);
 
+} /* namespace XmlReaderUtils */
 } /* namespace Uit */
 } /* namespace MoleQueue */
 
-#endif /* MESSAGEHANDLER_H_ */
+#endif /* XMLREADERUTILS_H_ */
@@ -20,11 +20,21 @@
 #include "abstractqueuesettingswidget.h"
 #include "logger.h"
 #include "importprogramdialog.h"
+#include "localqueuewidget.h"
+#include "molequeueconfig.h"
 #include "queue.h"
 #include "queuemanager.h"
 #include "queueprogramitemmodel.h"
+#include "queues/local.h"
+#include "queues/remotessh.h"
 #include "program.h"
 #include "programconfiguredialog.h"
+#include "remotequeuewidget.h"
+
+#ifdef MoleQueue_USE_EZHPC_UIT
+#include "queues/queueuit.h"
+#include "uitqueuewidget.h"
+#endif
 
 #include <QtGui/QCloseEvent>
 #include <QtWidgets/QFileDialog>
@@ -44,7 +54,7 @@ QueueSettingsDialog::QueueSettingsDialog(Queue *queue, QWidget *parentObject)
     ui(new Ui::QueueSettingsDialog),
     m_queue(queue),
     m_model(new QueueProgramItemModel (m_queue, this)),
-    m_settingsWidget(m_queue->settingsWidget()),
+    m_settingsWidget(createSettingsWidget(m_queue)),
     m_dirty(true)
 {
   ui->setupUi(this);
@@ -233,6 +243,20 @@ QList<Program *> QueueSettingsDialog::getSelectedPrograms()
   return selectedPrograms;
 }
 
+AbstractQueueSettingsWidget *
+QueueSettingsDialog::createSettingsWidget(Queue *queue)
+{
+  if (QueueLocal *local = qobject_cast<QueueLocal*>(queue))
+    return new LocalQueueWidget(local);
+  if (QueueRemoteSsh *ssh = qobject_cast<QueueRemoteSsh*>(queue))
+    return new RemoteQueueWidget(ssh);
+#ifdef MoleQueue_USE_EZHPC_UIT
+  if (QueueUit *uit = qobject_cast<QueueUit*>(queue))
+    return new UitQueueWidget(uit);
+#endif
+  return NULL;
+}
+
 void QueueSettingsDialog::removeProgramDialog()
 {
   ProgramConfigureDialog *dialog =
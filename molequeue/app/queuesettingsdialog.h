@@ -76,6 +76,10 @@ protected:
   QList<int> getSelectedRows();
   QList<Program*> getSelectedPrograms();
 
+  /// @return A new widget to configure the type specific settings of @a queue,
+  /// or NULL if it has none.
+  static AbstractQueueSettingsWidget *createSettingsWidget(Queue *queue);
+
   Ui::QueueSettingsDialog *ui;
   Queue *m_queue;
   QueueProgramItemModel *m_model;
@@ -0,0 +1,112 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_RINGBUFFER_H
+#define MOLEQUEUE_RINGBUFFER_H
+
+#include <QtCore/QList>
+
+namespace MoleQueue
+{
+
+/**
+ * @class RingBuffer ringbuffer.h <molequeue/ringbuffer.h>
+ * @brief Fixed capacity container that drops its oldest item when full.
+ *
+ * Items are indexed from the oldest (0) to the newest (size() - 1). Appending
+ * to a full buffer overwrites the oldest item in constant time.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+  explicit RingBuffer(int capacity_ = 0)
+    : m_capacity(qMax(0, capacity_)), m_head(0) {}
+
+  /// @return The maximum number of items held.
+  int capacity() const { return m_capacity; }
+
+  /// Change the maximum number of items held. If the buffer holds more than
+  /// @a capacity_ items, the oldest are dropped.
+  void setCapacity(int capacity_)
+  {
+    capacity_ = qMax(0, capacity_);
+    if (capacity_ == m_capacity)
+      return;
+    QList<T> items = toList();
+    if (items.size() > capacity_)
+      items = items.mid(items.size() - capacity_);
+    m_items = items;
+    m_head = 0;
+    m_capacity = capacity_;
+  }
+
+  /// @return The number of items held.
+  int size() const { return m_items.size(); }
+
+  /// @return True if no items are held.
+  bool isEmpty() const { return m_items.isEmpty(); }
+
+  /// @return True if size() == capacity().
+  bool isFull() const { return m_items.size() == m_capacity; }
+
+  /// Add @a item as the newest item, dropping the oldest if full.
+  void append(const T &item)
+  {
+    if (m_capacity == 0)
+      return;
+    if (m_items.size() < m_capacity) {
+      m_items.append(item);
+      return;
+    }
+    m_items[m_head] = item;
+    m_head = (m_head + 1) % m_capacity;
+  }
+
+  /// @return The item at @a i, counting from the oldest.
+  const T & at(int i) const { return m_items.at((m_head + i) % m_items.size()); }
+
+  /// @return The oldest item. The buffer must not be empty.
+  const T & first() const { return at(0); }
+
+  /// @return The newest item. The buffer must not be empty.
+  const T & last() const { return at(m_items.size() - 1); }
+
+  /// Remove all items.
+  void clear()
+  {
+    m_items.clear();
+    m_head = 0;
+  }
+
+  /// @return All items, oldest first.
+  QList<T> toList() const
+  {
+    if (m_head == 0)
+      return m_items;
+    return m_items.mid(m_head) + m_items.mid(0, m_head);
+  }
+
+private:
+  int m_capacity;
+  /// Index of the oldest item once the buffer is full.
+  int m_head;
+  QList<T> m_items;
+};
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_RINGBUFFER_H
@@ -16,14 +16,15 @@
 
 #include "server.h"
 
-#include "actionfactorymanager.h"
+#include "blobstore.h"
 #include "job.h"
+#include "jobfilter.h"
 #include "jobmanager.h"
+#include "jobsubscriptionmanager.h"
 #include "logger.h"
 #include "queue.h"
 #include "queuemanager.h"
 #include "pluginmanager.h"
-#include "jobactionfactories/openwithactionfactory.h"
 
 #include <molequeue/servercore/connectionlistenerfactory.h>
 
@@ -34,8 +35,9 @@
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
 #include <QtCore/QList>
+#include <QtCore/QSet>
 #include <QtCore/QSettings>
-#include <QtCore/QStringBuilder>
+#include <QtCore/QStringList>
 #include <QtCore/QTimerEvent>
 
 namespace MoleQueue
@@ -44,6 +46,7 @@ namespace MoleQueue
 Server::Server(QObject *parentObject, QString serverName_)
   : QObject(parentObject),
     m_jobManager(new JobManager (this)),
+    m_jobSubscriptionManager(new JobSubscriptionManager(m_jobManager, this)),
     m_queueManager(new QueueManager (this)),
     m_jsonrpc(new JsonRpc(this)),
     m_moleQueueIdCounter(0),
@@ -122,16 +125,51 @@ void Server::readSettings(QSettings &settings)
   m_moleQueueIdCounter =
       settings.value("moleQueueIdCounter", 0).value<IdType>();
 
+  BlobStore *blobStore = BlobStore::instance();
+  blobStore->setDirectory(m_workingDirectoryBase + "/blobs");
+  blobStore->setThreshold(
+        settings.value("blobThreshold", DEFAULT_BLOB_THRESHOLD).toLongLong());
+
+  m_jobSubscriptionManager->setCoalesceInterval(
+        settings.value("subscriptionCoalesceInterval", 250).toInt());
+  m_jobSubscriptionManager->setMaxPendingJobs(
+        settings.value("subscriptionMaxPendingJobs", 1000).toInt());
+  m_jobSubscriptionManager->setMaxUnsentBytes(
+        settings.value("subscriptionMaxUnsentBytes", 1024 * 1024).toLongLong());
+
   m_queueManager->readSettings();
   const QString jobsDir = m_workingDirectoryBase + "/jobs";
   dir.mkpath(jobsDir);
   m_jobManager->loadJobState(jobsDir);
+
+  // Drop blobs left behind by jobs that have since been removed.
+  QSet<QString> referencedBlobs;
+  for (int i = 0; i < m_jobManager->count(); ++i) {
+    Job job = m_jobManager->jobAt(i);
+    FileSpecification inputFile = job.inputFile();
+    if (inputFile.isStored())
+      referencedBlobs.insert(inputFile.contentsHash());
+    foreach (const FileSpecification &spec, job.additionalInputFiles()) {
+      if (spec.isStored())
+        referencedBlobs.insert(spec.contentsHash());
+    }
+    foreach (const QString &hash, job.inputFileHashes())
+      referencedBlobs.insert(hash);
+  }
+  blobStore->removeUnreferenced(referencedBlobs);
 }
 
 void Server::writeSettings(QSettings &settings) const
 {
   settings.setValue("workingDirectoryBase", m_workingDirectoryBase);
   settings.setValue("moleQueueIdCounter", m_moleQueueIdCounter);
+  settings.setValue("blobThreshold", BlobStore::instance()->threshold());
+  settings.setValue("subscriptionCoalesceInterval",
+                    m_jobSubscriptionManager->coalesceInterval());
+  settings.setValue("subscriptionMaxPendingJobs",
+                    m_jobSubscriptionManager->maxPendingJobs());
+  settings.setValue("subscriptionMaxUnsentBytes",
+                    m_jobSubscriptionManager->maxUnsentBytes());
 
   m_queueManager->writeSettings();
   m_jobManager->syncJobState();
@@ -171,6 +209,7 @@ void Server::stop(bool force) {
 
   m_connections.clear();
   m_connectionListeners.clear();
+  m_jobSubscriptionManager->clear();
 
 }
 
@@ -181,7 +220,8 @@ void Server::stop() {
 void Server::dispatchJobStateChange(const Job &job, JobState oldState,
                                     JobState newState)
 {
-  Connection *connection = m_connectionLUT.value(job.moleQueueId());
+  Connection *connection =
+      static_cast<Connection*>(m_jobManager->jobOwner(job.moleQueueId()));
   EndpointIdType endpoint = m_endpointLUT.value(job.moleQueueId());
 
   if (connection == NULL)
@@ -205,6 +245,7 @@ void Server::jobAboutToBeAdded(Job job)
   settings.setValue("moleQueueIdCounter", m_moleQueueIdCounter);
 
   job.setMoleQueueId(nextMoleQueueId);
+  job.setSubmissionTime(QDateTime::currentDateTime());
   job.setLocalWorkingDirectory(m_workingDirectoryBase + "/jobs/" +
                                 idTypeToString(nextMoleQueueId));
 
@@ -241,22 +282,19 @@ void Server::clientDisconnected()
                           .arg(conn->connectionString()));
 
   m_connections.removeOne(conn);
+  m_jobSubscriptionManager->removeConnection(conn);
 
-  // Remove connection from look up table and any endpoints key on molequeueids
-  // associated with that connection.
-  QList<IdType> moleQueueIds = m_connectionLUT.keys(conn);
-
-  foreach(IdType moleQueueId, moleQueueIds) {
-    m_connectionLUT.remove(moleQueueId);
+  // Forget the jobs owned by the connection and their reply endpoints.
+  foreach(IdType moleQueueId, m_jobManager->jobsOwnedBy(conn))
     m_endpointLUT.remove(moleQueueId);
-  }
+  m_jobManager->removeJobOwner(conn);
 
   conn->deleteLater();
 }
 
 void Server::jobRemoved(MoleQueue::IdType moleQueueId)
 {
-  m_connectionLUT.remove(moleQueueId);
+  // The job manager forgets the owner of removed jobs itself.
   m_endpointLUT.remove(moleQueueId);
 }
 
@@ -267,9 +305,11 @@ void Server::handleMessage(const Message &message)
     handleRequest(message);
     break;
   default:
-    Logger::logDebugMessage(tr("Unhandled message; no handler for type: %1\n%2")
-                            .arg(message.type())
-                            .arg(QString(message.toJson())));
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(
+            tr("Unhandled message; no handler for type: %1\n%2")
+            .arg(message.type()).arg(QString(message.toJson())));
+    }
     break;
   }
 }
@@ -285,14 +325,14 @@ void Server::handleRequest(const Message &message)
     handleCancelJobRequest(message);
   else if (method == "lookupJob")
     handleLookupJobRequest(message);
-  else if (method == "registerOpenWith")
-    handleRegisterOpenWithRequest(message);
-  else if (method == "listOpenWithNames")
-    handleListOpenWithNamesRequest(message);
-  else if (method == "unregisterOpenWith")
-    handleUnregisterOpenWithRequest(message);
+  else if (method == "listJobs")
+    handleListJobsRequest(message);
   else if (method == "rpcKill")
     handleRpcKillRequest(message);
+  else if (method == "subscribe")
+    handleSubscribeRequest(message);
+  else if (method == "unsubscribe")
+    handleUnsubscribeRequest(message);
   else
     handleUnknownMethod(message);
 }
@@ -307,9 +347,11 @@ void Server::handleUnknownMethod(const Message &message)
   errorMessage.setErrorData(errorDataObject);
   errorMessage.send();
 
-  Logger::logDebugMessage(
-        tr("Received JSON-RPC request with invalid method '%1':\n%2")
-        .arg(message.method()).arg(QString(message.toJson())));
+  if (Logger::isEnabled(LogEntry::DebugMessage)) {
+    Logger::logDebugMessage(
+          tr("Received JSON-RPC request with invalid method '%1':\n%2")
+          .arg(message.method()).arg(QString(message.toJson())));
+  }
 }
 
 void Server::handleInvalidParams(const Message &message,
@@ -324,9 +366,11 @@ void Server::handleInvalidParams(const Message &message,
   errorMessage.setErrorData(errorDataObject);
   errorMessage.send();
 
-  Logger::logDebugMessage(
-        tr("Received JSON-RPC request with invalid parameters (%1):\n%2")
-        .arg(description).arg(QString(message.toJson())));
+  if (Logger::isEnabled(LogEntry::DebugMessage)) {
+    Logger::logDebugMessage(
+          tr("Received JSON-RPC request with invalid parameters (%1):\n%2")
+          .arg(description).arg(QString(message.toJson())));
+  }
 }
 
 void Server::handleListQueuesRequest(const Message &message)
@@ -390,9 +434,11 @@ void Server::handleSubmitJobRequest(const Message &message)
     errorMessage.setErrorData(errorDataObject);
     errorMessage.send();
 
-    Logger::logDebugMessage(
-          tr("Received submitJob request with invalid queue (%1):\n%2")
-          .arg(queueString).arg(QString(message.toJson())));
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(
+            tr("Received submitJob request with invalid queue (%1):\n%2")
+            .arg(queueString).arg(QString(message.toJson())));
+    }
     return;
   }
   Program *program = queue->lookupProgram(programString);
@@ -409,16 +455,21 @@ void Server::handleSubmitJobRequest(const Message &message)
     errorMessage.setErrorData(errorDataObject);
     errorMessage.send();
 
-    Logger::logDebugMessage(
-          tr("Received submitJob request with invalid program (%1/%2):\n%3")
-          .arg(queueString).arg(programString).arg(QString(message.toJson())));
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(
+            tr("Received submitJob request with invalid program (%1/%2):\n%3")
+            .arg(queueString).arg(programString)
+            .arg(QString(message.toJson())));
+    }
     return;
   }
 
   // Everything checks out -- Create the job and send the response.
   Job job = m_jobManager->newJob(paramsObject);
-  Logger::logDebugMessage(tr("Job submission requested:\n%1")
-                          .arg(QString(message.toJson())), job.moleQueueId());
+  if (Logger::isEnabled(LogEntry::DebugMessage)) {
+    Logger::logDebugMessage(tr("Job submission requested:\n%1")
+                            .arg(QString(message.toJson())), job.moleQueueId());
+  }
 
   Message response = message.generateResponse();
   QJsonObject resultObject;
@@ -427,7 +478,7 @@ void Server::handleSubmitJobRequest(const Message &message)
   response.setResult(resultObject);
   response.send();
 
-  m_connectionLUT.insert(job.moleQueueId(), message.connection());
+  m_jobManager->setJobOwner(job.moleQueueId(), message.connection());
   m_endpointLUT.insert(job.moleQueueId(), message.endpoint());
 
   // Submit the job after sending the response -- otherwise the client can
@@ -464,10 +515,12 @@ void Server::handleCancelJobRequest(const Message &message)
     errorMessage.setErrorData(errorDataObject);
     errorMessage.send();
 
-    Logger::logDebugMessage(
-          tr("Received cancelJob request with invalid MoleQueue ID (%1):\n%2")
-          .arg(idTypeToString(moleQueueId)).arg(QString(message.toJson())),
-          moleQueueId);
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(
+            tr("Received cancelJob request with invalid MoleQueue ID (%1):\n%2")
+            .arg(idTypeToString(moleQueueId)).arg(QString(message.toJson())),
+            moleQueueId);
+    }
     return;
   }
 
@@ -496,12 +549,14 @@ void Server::handleCancelJobRequest(const Message &message)
     errorMessage.setErrorData(errorDataObject);
     errorMessage.send();
 
-    Logger::logDebugMessage(
-          tr("Received cancelJob request for non-running job (%1, %2):\n%3")
-          .arg(idTypeToString(moleQueueId))
-          .arg(jobStateToGuiString(state))
-          .arg(QString(message.toJson())),
-          moleQueueId);
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(
+            tr("Received cancelJob request for non-running job (%1, %2):\n%3")
+            .arg(idTypeToString(moleQueueId))
+            .arg(jobStateToGuiString(state))
+            .arg(QString(message.toJson())),
+            moleQueueId);
+    }
     return;
   }
 
@@ -516,11 +571,13 @@ void Server::handleCancelJobRequest(const Message &message)
     errorMessage.setErrorData(errorDataObject);
     errorMessage.send();
 
-    Logger::logDebugMessage(
-          tr("Received cancelJob request for deleted queue (%1, %2):\n%3")
-          .arg(idTypeToString(moleQueueId))
-          .arg(job.queue())
-          .arg(QString(message.toJson())));
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(
+            tr("Received cancelJob request for deleted queue (%1, %2):\n%3")
+            .arg(idTypeToString(moleQueueId))
+            .arg(job.queue())
+            .arg(QString(message.toJson())));
+    }
     return;
   }
 
@@ -561,231 +618,168 @@ void Server::handleLookupJobRequest(const Message &message)
     errorMessage.setErrorData(errorDataObject);
     errorMessage.send();
 
-    Logger::logDebugMessage(
-          tr("Received lookupJob request with invalid MoleQueue ID (%1):\n%2")
-          .arg(idTypeToString(moleQueueId)).arg(QString(message.toJson())),
-          moleQueueId);
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(
+            tr("Received lookupJob request with invalid MoleQueue ID (%1):\n%2")
+            .arg(idTypeToString(moleQueueId)).arg(QString(message.toJson())),
+            moleQueueId);
+    }
     return;
   }
 
+  // Large input file contents are only sent when explicitly requested.
+  bool includeContents = paramsObject.value("includeContents").toBool(false);
+
   // Send reply
   Message response = message.generateResponse();
-  response.setResult(job.toJsonObject());
+  response.setResult(job.toJsonObject(includeContents));
   response.send();
 }
 
-void Server::handleRegisterOpenWithRequest(const Message &message)
+void Server::handleListJobsRequest(const Message &message)
 {
-  // validate request
-  if (!message.params().isObject()) {
-    handleInvalidParams(message,
-                        "registerOpenWith params member must be an object.");
-    return;
-  }
-
-  QJsonObject paramsObject = message.params().toObject();
-
-  // At a minimum, name and method must be specified:
-  if (!paramsObject["name"].isString() ||
-      !paramsObject["method"].isObject()) {
-    handleInvalidParams(message, "\"params.name\" (string) and "
-                        "\"params.method\" (object) must both be present.");
-    return;
-  }
-
-  const QString name(paramsObject["name"].toString());
-  const QJsonObject methodObject(paramsObject["method"].toObject());
-
-  OpenWithActionFactory::HandlerType handlerType;
-  QString executable;
-  QString rpcServer;
-  QString rpcMethod;
-
-  if (methodObject["executable"].isString()) {
-    handlerType = OpenWithActionFactory::ExecutableHandler;
-    executable = methodObject["executable"].toString();
-  }
-  else if (methodObject["rpcServer"].isString() &&
-           methodObject["rpcMethod"].isString()) {
-    handlerType = OpenWithActionFactory::RpcHandler;
-    rpcServer = methodObject["rpcServer"].toString();
-    rpcMethod = methodObject["rpcMethod"].toString();
+  // Validate request
+  QJsonObject paramsObject;
+  if (message.params().isObject()) {
+    paramsObject = message.params().toObject();
   }
-  else {
-    handleInvalidParams(message, "\"params.method\" invalid.");
+  else if (!message.params().isUndefined() && !message.params().isNull()) {
+    handleInvalidParams(message, "listJobs params member must be an object.");
     return;
   }
 
-  if (name.isEmpty()) {
-    handleInvalidParams(message, "\"params.name\" must be a non-empty string.");
+  JobFilter filter;
+  QString error;
+  if (!filter.fromJsonObject(paramsObject, &error)) {
+    handleInvalidParams(message, error);
     return;
   }
 
-  // Validate and extract patterns.
-  QList<QRegExp> patterns;
-  if (paramsObject.contains("patterns")) {
-    if (!paramsObject["patterns"].isArray()) {
-      handleInvalidParams(message, "\"params.patterns\" member must be a JSON "
-                          "array.");
+  QStringList fields;
+  if (paramsObject.contains("fields")) {
+    if (!paramsObject.value("fields").isArray()) {
+      handleInvalidParams(message, "fields must be an array of strings.");
       return;
     }
-
-    foreach (const QJsonValue &pattern, paramsObject["patterns"].toArray()) {
-      if (!pattern.isObject()) {
-        handleInvalidParams(message, "\"params.patterns\" array entries must "
-                            "be JSON objects.");
-        return;
-      }
-
-      const QJsonObject patternObject = pattern.toObject();
-      QRegExp regexp;
-      if (patternObject["regexp"].isString()) {
-        regexp.setPatternSyntax(QRegExp::RegExp2);
-        regexp.setPattern(patternObject["regexp"].toString());
-      }
-      else if (patternObject["wildcard"].isString()) {
-        regexp.setPatternSyntax(QRegExp::WildcardUnix);
-        regexp.setPattern(patternObject["wildcard"].toString());
-      }
-      else {
-        handleInvalidParams(message, "\"params.patterns\" contains an entry "
-                            "that is not a regexp or wildcard.");
-        return;
-      }
-
-      if (patternObject.contains("caseSensitive")) {
-        bool caseSensitive(patternObject.value("caseSensitive").toBool(true));
-        regexp.setCaseSensitivity(caseSensitive ? Qt::CaseSensitive
-                                                : Qt::CaseInsensitive);
-      }
-
-      patterns << regexp;
+    foreach (const QJsonValue &field, paramsObject.value("fields").toArray())
+      fields << field.toString();
+    // The id is always returned so that projected jobs can be matched up.
+    if (!fields.isEmpty() && !fields.contains("moleQueueId"))
+      fields.prepend("moleQueueId");
+  }
+
+  int limit = 100;
+  if (paramsObject.contains("limit")) {
+    limit = static_cast<int>(paramsObject.value("limit").toDouble(-1));
+    if (limit < 1 || limit > 1000) {
+      handleInvalidParams(message, "limit must be between 1 and 1000.");
+      return;
     }
   }
 
-  // If no patterns are specified, match all files:
-  if (patterns.empty())
-    patterns << QRegExp("*", Qt::CaseSensitive, QRegExp::WildcardUnix);
-
-  // Get existing open-with handlers
-  ActionFactoryManager *afm = ActionFactoryManager::instance();
-  QList<OpenWithActionFactory*> factories =
-      afm->factoriesOfType<OpenWithActionFactory>();
-
-  // Check for name conflicts:
-  foreach (const OpenWithActionFactory *factory, factories) {
-    if (factory->name() == name) {
-      Message error = message.generateErrorResponse();
-      error.setErrorCode(1);
-      error.setErrorMessage(
-            QLatin1Literal("Name conflict: An open-with handler named '") % name
-            % QLatin1Literal("' already exists."));
-      error.send();
+  // The cursor is the MoleQueue id of the last job on the previous page.
+  IdType cursor = 0;
+  if (paramsObject.contains("cursor") &&
+      !paramsObject.value("cursor").isNull()) {
+    cursor = toIdType(paramsObject.value("cursor"));
+    if (cursor == InvalidId) {
+      handleInvalidParams(message, "cursor must be a MoleQueue id.");
       return;
     }
   }
 
-  // Create a new handler:
-  OpenWithActionFactory *newFactory(new OpenWithActionFactory);
-  newFactory->setName(name);
-  newFactory->setFilePatterns(patterns);
+  bool more = false;
+  QList<Job> jobs = m_jobManager->findJobs(filter, cursor, limit, &more);
 
-  switch (handlerType) {
-  case OpenWithActionFactory::ExecutableHandler:
-    newFactory->setExecutable(executable);
-    break;
-  case OpenWithActionFactory::RpcHandler:
-    newFactory->setRpcDetails(rpcServer, rpcMethod);
-    break;
-  default:
-  case OpenWithActionFactory::NoHandler:
-    break;
+  QJsonArray jobsArray;
+  foreach (const Job &job, jobs) {
+    jobsArray.append(fields.isEmpty() ? job.toJsonObject()
+                                      : job.toJsonObject(fields));
   }
 
-  afm->addFactory(newFactory);
-
+  // Send reply
   Message response = message.generateResponse();
-  response.setResult(QLatin1String("success"));
+  QJsonObject resultObject;
+  resultObject.insert("jobs", jobsArray);
+  resultObject.insert("nextCursor",
+                      idTypeToJson(more ? jobs.last().moleQueueId()
+                                        : InvalidId));
+  response.setResult(resultObject);
   response.send();
 }
 
-void Server::handleListOpenWithNamesRequest(const Message &message)
+void Server::handleRpcKillRequest(const Message &message)
 {
-  // Build result object
-  ActionFactoryManager *afm = ActionFactoryManager::instance();
-  QList<OpenWithActionFactory*> handlers(
-        afm->factoriesOfType<OpenWithActionFactory>());
-  QJsonArray result;
-  foreach (OpenWithActionFactory *handler, handlers)
-    result.append(handler->name());
+  QSettings settings;
+  bool enabled = settings.value("enableRpcKill", false).toBool();
 
-  // Create response message
   Message response = message.generateResponse();
-  response.setResult(result);
+  QJsonObject resultObject;
+  resultObject.insert("success", enabled);
+  response.setResult(resultObject);
   response.send();
+
+  if (enabled) {
+    qApp->processEvents(QEventLoop::AllEvents, 1000);
+    // Quit from the application's thread; we may run in a ServerThread.
+    QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+  }
 }
 
-void Server::handleUnregisterOpenWithRequest(const Message &message)
+void Server::handleSubscribeRequest(const Message &message)
 {
-  // Validate
-  if (!message.params().isObject()) {
-    handleInvalidParams(message, "params value must be an object.");
-    return;
+  // Validate request
+  QJsonObject paramsObject;
+  if (message.params().isObject()) {
+    paramsObject = message.params().toObject();
   }
-
-  QJsonObject paramsObject(message.params().toObject());
-  if (!paramsObject["name"].isString()) {
-    handleInvalidParams(message, "\"params.name\" value must be a string.");
+  else if (!message.params().isUndefined() && !message.params().isNull()) {
+    handleInvalidParams(message, "subscribe params member must be an object.");
     return;
   }
 
-  QString handlerName(paramsObject["name"].toString());
-
-  // Search for matching handler
-  ActionFactoryManager *afm = ActionFactoryManager::instance();
-  QList<OpenWithActionFactory*> handlers =
-      afm->factoriesOfType<OpenWithActionFactory>();
-  OpenWithActionFactory *handler;
-  foreach (OpenWithActionFactory *h, handlers) {
-    if (handlerName == h->name()) {
-      handler = h;
-      break;
-    }
-  }
-
-  if (!handler) {
-    Message error = message.generateErrorResponse();
-    error.setErrorCode(1);
-    error.setErrorMessage(QString("File handler '%1'' not found!")
-                          .arg(handlerName));
-    error.send();
+  JobFilter filter;
+  QString error;
+  if (!filter.fromJsonObject(paramsObject, &error)) {
+    handleInvalidParams(message, error);
     return;
   }
 
-  // Remove handler
-  afm->removeFactory(handler);
+  IdType subscriptionId =
+      m_jobSubscriptionManager->subscribe(message.connection(),
+                                          message.endpoint(), filter);
 
-  // Send response
   Message response = message.generateResponse();
-  response.setResult(QLatin1String("success"));
+  QJsonObject resultObject;
+  resultObject.insert("subscriptionId", idTypeToJson(subscriptionId));
+  response.setResult(resultObject);
   response.send();
 }
 
-void Server::handleRpcKillRequest(const Message &message)
+void Server::handleUnsubscribeRequest(const Message &message)
 {
-  QSettings settings;
-  bool enabled = settings.value("enableRpcKill", false).toBool();
+  // Validate request
+  if (!message.params().isObject()) {
+    handleInvalidParams(message, "unsubscribe params member must be an object.");
+    return;
+  }
+
+  QJsonObject paramsObject = message.params().toObject();
+  if (!paramsObject.contains("subscriptionId")) {
+    handleInvalidParams(message,
+                        "Required params.subscriptionId member missing.");
+    return;
+  }
+
+  IdType subscriptionId = toIdType(paramsObject.value("subscriptionId"));
+  bool success = m_jobSubscriptionManager->unsubscribe(message.connection(),
+                                                       subscriptionId);
 
   Message response = message.generateResponse();
   QJsonObject resultObject;
-  resultObject.insert("success", enabled);
+  resultObject.insert("success", success);
   response.setResult(resultObject);
   response.send();
-
-  if (enabled) {
-    qApp->processEvents(QEventLoop::AllEvents, 1000);
-    qApp->quit();
-  }
 }
 
 void Server::timerEvent(QTimerEvent *e)
@@ -34,6 +34,7 @@ namespace MoleQueue
 class Connection;
 class Job;
 class JobManager;
+class JobSubscriptionManager;
 class QueueManager;
 class JsonRpc;
 
@@ -81,6 +82,14 @@ public:
    */
   const QueueManager *queueManager() const {return m_queueManager;}
 
+  /**
+   * @return A pointer to the Server JobSubscriptionManager.
+   */
+  JobSubscriptionManager *jobSubscriptionManager()
+  {
+    return m_jobSubscriptionManager;
+  }
+
   /// @param settings QSettings object to write state to.
   void readSettings(QSettings &settings);
   /// @param settings QSettings object to read state from.
@@ -182,21 +191,29 @@ private:
    * Handlers for different message types.
    */
   void handleRequest(const MoleQueue::Message &message);
-  void handleUnknownMethod(const MoleQueue::Message &message);
-  void handleInvalidParams(const MoleQueue::Message &message,
-                           const QString &description);
   void handleListQueuesRequest(const MoleQueue::Message &message);
   void handleSubmitJobRequest(const MoleQueue::Message &message);
   void handleCancelJobRequest(const MoleQueue::Message &message);
   void handleLookupJobRequest(const MoleQueue::Message &message);
-  void handleRegisterOpenWithRequest(const MoleQueue::Message &message);
-  void handleListOpenWithNamesRequest(const MoleQueue::Message &message);
-  void handleUnregisterOpenWithRequest(const MoleQueue::Message &message);
+  void handleListJobsRequest(const MoleQueue::Message &message);
   void handleRpcKillRequest(const MoleQueue::Message &message);
+  void handleSubscribeRequest(const MoleQueue::Message &message);
+  void handleUnsubscribeRequest(const MoleQueue::Message &message);
   /**@}*/
 
 protected:
 
+  /**
+   * Called for requests whose method is not handled by the Server. Subclasses
+   * reimplement this to add methods; the default implementation replies with
+   * a "Method not found" error.
+   */
+  virtual void handleUnknownMethod(const MoleQueue::Message &message);
+
+  /// Reply to @a message with an "Invalid params" error.
+  void handleInvalidParams(const MoleQueue::Message &message,
+                           const QString &description);
+
   /**
    * @brief timerEvent Reimplemented from QObject.
    */
@@ -208,6 +225,9 @@ protected:
   /// The JobManager for this Server.
   JobManager *m_jobManager;
 
+  /// Pushes job changes to subscribed connections.
+  JobSubscriptionManager *m_jobSubscriptionManager;
+
   /// The QueueManager for this Server.
   QueueManager *m_queueManager;
 
@@ -220,9 +240,6 @@ protected:
   /// Counter for MoleQueue job ids.
   IdType m_moleQueueIdCounter;
 
-  // job id --> connection for notifications.
-  QMap<IdType, Connection*> m_connectionLUT;
-
   // job id --> reply to endpoint for notifications
   QMap<IdType, EndpointIdType> m_endpointLUT;
 
@@ -0,0 +1,438 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+// molequeue-server: the MoleQueue server without a user interface. It runs on
+// a QCoreApplication and links neither QtWidgets nor the GUI library, so it
+// can be used on machines without a display.
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QSettings>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+
+#include <QtNetwork/QLocalSocket>
+
+#include "program.h"
+#include "queue.h"
+#include "queuemanager.h"
+#include "server.h"
+#include "workdir.h"
+
+#include <cstdio>
+
+#ifdef Q_OS_UNIX
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using MoleQueue::ConnectionListener;
+
+/// Starts the server once the event loop runs, and quits if it cannot listen.
+class ServerLauncher : public QObject
+{
+  Q_OBJECT
+public:
+  ServerLauncher(MoleQueue::Server *server, bool forceStart)
+    : m_server(server), m_forceStart(forceStart)
+  {
+    connect(m_server,
+            SIGNAL(connectionError(MoleQueue::ConnectionListener::Error,
+                                   QString)),
+            SLOT(handleConnectionError(MoleQueue::ConnectionListener::Error,
+                                       QString)));
+  }
+
+public slots:
+  void start()
+  {
+    if (m_forceStart)
+      m_server->forceStart();
+    else
+      m_server->start();
+  }
+
+  void handleConnectionError(MoleQueue::ConnectionListener::Error err,
+                             const QString &str)
+  {
+    qWarning("%s", qPrintable(tr("Server error: %1").arg(str)));
+    if (err == ConnectionListener::AddressInUseError) {
+      qWarning("%s", qPrintable(tr("Another MoleQueue server appears to be "
+                                   "running. If it is not, restart with "
+                                   "--force-start to replace its socket.")));
+    }
+    // Calls made before the event loop starts are ignored, hence start().
+    QCoreApplication::exit(EXIT_FAILURE);
+  }
+
+private:
+  MoleQueue::Server *m_server;
+  bool m_forceStart;
+};
+
+namespace {
+// Written to by the signal handler, read through a QSocketNotifier.
+int signalFds[2] = { -1, -1 };
+} // end anon namespace
+
+/// Quits the event loop on SIGINT and SIGTERM, so that the server is stopped
+/// and its settings are written as on any other exit.
+class SignalHandler : public QObject
+{
+  Q_OBJECT
+public:
+  SignalHandler() : m_notifier(NULL) {}
+
+  /// @return False if the handlers could not be installed.
+  bool install()
+  {
+#ifdef Q_OS_UNIX
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFds) != 0)
+      return false;
+    m_notifier = new QSocketNotifier(signalFds[1], QSocketNotifier::Read,
+                                     this);
+    connect(m_notifier, SIGNAL(activated(int)), SLOT(handleSignal()));
+
+    struct sigaction action;
+    action.sa_handler = SignalHandler::signalReceived;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (::sigaction(SIGINT, &action, NULL) != 0 ||
+        ::sigaction(SIGTERM, &action, NULL) != 0) {
+      return false;
+    }
+#endif
+    return true;
+  }
+
+private slots:
+  void handleSignal()
+  {
+#ifdef Q_OS_UNIX
+    m_notifier->setEnabled(false);
+    char byte;
+    if (::read(signalFds[1], &byte, sizeof(byte)) != sizeof(byte))
+      qWarning("Cannot read from the signal socket.");
+    // A second signal kills a server that hangs while shutting down.
+    ::signal(SIGINT, SIG_DFL);
+    ::signal(SIGTERM, SIG_DFL);
+#endif
+    QCoreApplication::quit();
+  }
+
+private:
+  static void signalReceived(int)
+  {
+#ifdef Q_OS_UNIX
+    // Only async-signal-safe calls are allowed here.
+    char byte = 1;
+    if (::write(signalFds[0], &byte, sizeof(byte)) != sizeof(byte))
+      return;
+#endif
+  }
+
+  QSocketNotifier *m_notifier;
+};
+
+/// A configuration change requested on the command line.
+struct ImportRequest
+{
+  QString queueName;
+  QString programName; // Empty for queue imports.
+  QString fileName;
+};
+
+void printVersion();
+void printUsage();
+bool serverIsRunning(const QString &socketName);
+bool importQueue(MoleQueue::QueueManager *queueManager,
+                 const ImportRequest &request);
+bool importProgram(MoleQueue::QueueManager *queueManager,
+                   const ImportRequest &request);
+void listQueues(const MoleQueue::QueueManager *queueManager);
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication::setOrganizationName("OpenChemistry");
+  QCoreApplication::setOrganizationDomain("openchemistry.org");
+  QCoreApplication::setApplicationName("MoleQueue");
+  QCoreApplication::setApplicationVersion("0.2.0");
+
+  QCoreApplication app(argc, argv);
+
+  bool customWorkDirSet = false;
+  bool enableRpcKill = false;
+  bool forceStart = false;
+  bool list = false;
+  QList<ImportRequest> imports;
+  QString socketName("MoleQueue");
+
+  QStringList args = QCoreApplication::arguments();
+  for (QStringList::const_iterator it = args.constBegin() + 1,
+       itEnd = args.constEnd(); it != itEnd; ++it) {
+    if (*it == "-w" || *it == "--workdir") {
+      if (customWorkDirSet) {
+        qWarning("%s",
+                 qPrintable(QObject::tr("More than one -w option set. Cannot "
+                                        "run in multiple working "
+                                        "directories!")));
+        return EXIT_FAILURE;
+      }
+      if (!MoleQueue::setWorkDir(it + 1 == itEnd ? QString() : *(++it)))
+        return EXIT_FAILURE;
+      customWorkDirSet = true;
+    }
+    else if (*it == "-s" || *it == "--socketname") {
+      if (it + 1 == itEnd || (it+1)->isEmpty()) {
+        qWarning("%s", qPrintable(QObject::tr("Missing socket name!")));
+        return EXIT_FAILURE;
+      }
+      socketName = (*++it);
+    }
+    else if (*it == "-f" || *it == "--force-start") {
+      forceStart = true;
+    }
+    else if (*it == "--rpc-kill") {
+      enableRpcKill = true;
+    }
+    else if (*it == "--import-queue") {
+      if (itEnd - it < 3) {
+        qWarning("%s", qPrintable(QObject::tr("--import-queue needs a queue "
+                                              "name and a file name!")));
+        return EXIT_FAILURE;
+      }
+      ImportRequest request;
+      request.queueName = *(++it);
+      request.fileName = *(++it);
+      imports << request;
+    }
+    else if (*it == "--import-program") {
+      if (itEnd - it < 4) {
+        qWarning("%s", qPrintable(QObject::tr("--import-program needs a queue "
+                                              "name, a program name and a "
+                                              "file name!")));
+        return EXIT_FAILURE;
+      }
+      ImportRequest request;
+      request.queueName = *(++it);
+      request.programName = *(++it);
+      request.fileName = *(++it);
+      imports << request;
+    }
+    else if (*it == "--list-queues") {
+      list = true;
+    }
+    else if (*it == "-v" || *it == "--version") {
+      printVersion();
+      return EXIT_SUCCESS;
+    }
+    else if (*it == "-h" || *it == "--help") {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+    else {
+      qWarning(qPrintable(QObject::tr("Unrecognized command line option: %s")),
+               qPrintable(*it));
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A running server keeps its own copy of the configuration and writes it
+  // back when it exits, so it would undo the changes.
+  const bool configOnly = !imports.isEmpty() || list;
+  if (configOnly && serverIsRunning(socketName)) {
+    qWarning(qPrintable(QObject::tr("A MoleQueue server is listening on '%s'. "
+                                    "Stop it before using --import-queue, "
+                                    "--import-program or --list-queues.")),
+             qPrintable(socketName));
+    return EXIT_FAILURE;
+  }
+
+  QSettings settings;
+  settings.setValue("socketName", socketName);
+  settings.setValue("enableRpcKill", enableRpcKill);
+
+  MoleQueue::Server server(NULL, socketName);
+  server.readSettings(settings);
+
+  // Configuration only: apply the imports, save and exit.
+  if (configOnly) {
+    bool ok = true;
+    foreach (const ImportRequest &request, imports) {
+      if (request.programName.isEmpty())
+        ok = importQueue(server.queueManager(), request) && ok;
+      else
+        ok = importProgram(server.queueManager(), request) && ok;
+    }
+    server.writeSettings(settings);
+
+    if (list)
+      listQueues(server.queueManager());
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  SignalHandler signalHandler;
+  if (!signalHandler.install()) {
+    qWarning("%s", qPrintable(QObject::tr("Cannot handle SIGINT and SIGTERM: "
+                                          "the server will not shut down "
+                                          "cleanly when stopped.")));
+  }
+
+  ServerLauncher launcher(&server, forceStart);
+  QTimer::singleShot(0, &launcher, SLOT(start()));
+
+  int result = app.exec();
+  server.stop();
+  server.writeSettings(settings);
+  return result;
+}
+
+bool importQueue(MoleQueue::QueueManager *queueManager,
+                 const ImportRequest &request)
+{
+  QString type = MoleQueue::Queue::queueTypeFromFile(request.fileName);
+  if (!MoleQueue::QueueManager::queueTypeIsValid(type)) {
+    qWarning(qPrintable(QObject::tr("Cannot import queue from '%s': Queue type "
+                                    "not recognized (%s).")),
+             qPrintable(request.fileName), qPrintable(type));
+    return false;
+  }
+
+  MoleQueue::Queue *queue = queueManager->addQueue(request.queueName, type);
+  if (!queue) {
+    qWarning(qPrintable(QObject::tr("Cannot import queue '%s': A queue with "
+                                    "this name already exists.")),
+             qPrintable(request.queueName));
+    return false;
+  }
+
+  if (!queue->importSettings(request.fileName, true)) {
+    qWarning(qPrintable(QObject::tr("Cannot import queue from '%s'. Check the "
+                                    "log for details.")),
+             qPrintable(request.fileName));
+    queueManager->removeQueue(queue);
+    return false;
+  }
+
+  return true;
+}
+
+bool importProgram(MoleQueue::QueueManager *queueManager,
+                   const ImportRequest &request)
+{
+  MoleQueue::Queue *queue = queueManager->lookupQueue(request.queueName);
+  if (!queue) {
+    qWarning(qPrintable(QObject::tr("Cannot import program '%s': No queue "
+                                    "named '%s'.")),
+             qPrintable(request.programName), qPrintable(request.queueName));
+    return false;
+  }
+
+  MoleQueue::Program *program = new MoleQueue::Program(queue);
+  program->setName(request.programName);
+  if (!program->importSettings(request.fileName)) {
+    qWarning(qPrintable(QObject::tr("Cannot import program from '%s': Bad "
+                                    "format.")), qPrintable(request.fileName));
+    delete program;
+    return false;
+  }
+
+  if (!queue->addProgram(program, false)) {
+    qWarning(qPrintable(QObject::tr("Cannot import program '%s': Queue '%s' "
+                                    "already has a program with this name.")),
+             qPrintable(request.programName), qPrintable(request.queueName));
+    delete program;
+    return false;
+  }
+
+  return true;
+}
+
+bool serverIsRunning(const QString &socketName)
+{
+  // A socket left behind by a crashed server does not accept connections.
+  QLocalSocket socket;
+  socket.connectToServer(socketName);
+  return socket.waitForConnected(1000);
+}
+
+void listQueues(const MoleQueue::QueueManager *queueManager)
+{
+  foreach (const MoleQueue::Queue *queue, queueManager->queues()) {
+    printf("%s (%s)\n", qPrintable(queue->name()),
+           qPrintable(queue->typeName()));
+    foreach (const QString &programName, queue->programNames())
+      printf("    %s\n", qPrintable(programName));
+  }
+}
+
+void printVersion()
+{
+  qWarning("%s %s", qPrintable(qApp->applicationName()),
+           qPrintable(qApp->applicationVersion()));
+}
+
+void printUsage()
+{
+  printVersion();
+  qWarning("%s\n\n%s",
+           qPrintable(QObject::tr("Usage: molequeue-server [options]")),
+           qPrintable(QObject::tr("Options:")));
+
+  const char *format = "      %3s %-37s   %s";
+
+  qWarning(format, "-f,", "--force-start",
+           qPrintable(QObject::tr("Replace the socket of a server that did "
+                                  "not shut down cleanly.")));
+  qWarning(format, "-h,", "--help",
+           qPrintable(QObject::tr("Print version and usage information and "
+                                  "exit.")));
+  qWarning(format, "", "--import-program [queue] [name] [file]",
+           qPrintable(QObject::tr("Add a program to a queue from a .mqp "
+                                  "file.")));
+  qWarning(format, "", "--import-queue [name] [file]",
+           qPrintable(QObject::tr("Add a queue and its programs from a .mqq "
+                                  "file.")));
+  qWarning(format, "", "--list-queues",
+           qPrintable(QObject::tr("Print the configured queues and "
+                                  "programs.")));
+  qWarning(format, "", "--rpc-kill",
+           qPrintable(QObject::tr("Allow the server to be killed by a special "
+                                  "RPC call (testing only).")));
+  qWarning(format, "-s,", "--socketname [name]",
+           qPrintable(QObject::tr("Name of the socket on which to listen.")));
+  qWarning(format, "-v,", "--version",
+           qPrintable(QObject::tr("Print version information and exit.")));
+  qWarning(format, "-w,", "--workdir [path]",
+           qPrintable(QObject::tr("Run MoleQueue in a custom working "
+                                  "directory.")));
+  qWarning("\n%s\n\n%s",
+           qPrintable(QObject::tr("With --import-queue, --import-program or "
+                                  "--list-queues the configuration is updated "
+                                  "and the server exits without listening. "
+                                  "These options are refused while a server "
+                                  "is listening on the socket name.")),
+           qPrintable(QObject::tr("ezHPC UIT queues ask for credentials in "
+                                  "dialogs and are only available in the "
+                                  "molequeue GUI: this server neither loads "
+                                  "nor lists them, and cannot import them. "
+                                  "Their configuration is left untouched.")));
+}
+
+#include "servermain.moc"
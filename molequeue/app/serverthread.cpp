@@ -0,0 +1,171 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "serverthread.h"
+
+#include "logger.h"
+#include "queue.h"
+#include "queuemanager.h"
+#include "server.h"
+
+namespace MoleQueue
+{
+
+/// Receives the queued pause requests of a ServerThread in that thread.
+class ServerThreadPause : public QObject
+{
+  Q_OBJECT
+public:
+  explicit ServerThreadPause(ServerThread *serverThread)
+    : m_serverThread(serverThread) {}
+
+public slots:
+  void pause() { m_serverThread->pause(); }
+
+private:
+  ServerThread *m_serverThread;
+};
+
+ServerThread::ServerThread(Server *server, QObject *parentObject)
+  : QThread(parentObject),
+    m_server(server),
+    m_homeThread(server->thread()),
+    m_pauser(new ServerThreadPause(this)),
+    m_lockCount(0),
+    m_paused(false),
+    m_released(false)
+{
+  m_pauser->moveToThread(this);
+}
+
+ServerThread::~ServerThread()
+{
+  stopServer();
+  delete m_pauser;
+}
+
+bool ServerThread::canRun() const
+{
+  foreach (const Queue *queue, m_server->queueManager()->queues()) {
+    if (queue->requiresGuiThread())
+      return false;
+  }
+  return true;
+}
+
+bool ServerThread::startServer()
+{
+  if (isRunning())
+    return true;
+
+  if (!canRun()) {
+    Logger::logWarning(tr("A configured queue requires the GUI thread; the "
+                          "server will not be run on its own thread."));
+    return false;
+  }
+
+  m_server->moveToThread(this);
+  start();
+  return true;
+}
+
+void ServerThread::stopServer()
+{
+  if (!isRunning())
+    return;
+
+  m_homeThread = QThread::currentThread();
+  quit();
+  wait();
+}
+
+void ServerThread::lock()
+{
+  if (m_lockCount++ > 0 || !isRunning())
+    return;
+
+  QMutexLocker locker(&m_pauseMutex);
+  m_released = false;
+  QMetaObject::invokeMethod(m_pauser, "pause", Qt::QueuedConnection);
+  while (!m_paused)
+    m_pauseChanged.wait(&m_pauseMutex);
+}
+
+void ServerThread::unlock()
+{
+  if (m_lockCount == 0 || --m_lockCount > 0)
+    return;
+
+  QMutexLocker locker(&m_pauseMutex);
+  if (!m_paused)
+    return;
+
+  // Wait until the server thread has left pause(), so the next lock() cannot
+  // be mistaken for this one.
+  m_released = true;
+  m_pauseChanged.wakeAll();
+  while (m_paused)
+    m_pauseChanged.wait(&m_pauseMutex);
+}
+
+ServerThread *ServerThread::forObject(const QObject *coreObject)
+{
+  if (!coreObject)
+    return NULL;
+
+  ServerThread *serverThread =
+      qobject_cast<ServerThread*>(coreObject->thread());
+  // Already on the server's thread.
+  if (serverThread == QThread::currentThread())
+    return NULL;
+  return serverThread;
+}
+
+void ServerThread::run()
+{
+  exec();
+
+  // Only the thread an object lives in can push it to another one.
+  m_server->moveToThread(m_homeThread);
+}
+
+void ServerThread::pause()
+{
+  QMutexLocker locker(&m_pauseMutex);
+  m_paused = true;
+  m_pauseChanged.wakeAll();
+  while (!m_released)
+    m_pauseChanged.wait(&m_pauseMutex);
+  m_paused = false;
+  m_pauseChanged.wakeAll();
+}
+
+ServerThreadLocker::ServerThreadLocker(const QObject *coreObject)
+  : m_thread(ServerThread::forObject(coreObject))
+{
+  if (m_thread)
+    m_thread->lock();
+}
+
+ServerThreadLocker::~ServerThreadLocker()
+{
+  if (m_thread)
+    m_thread->unlock();
+}
+
+} // namespace MoleQueue
+
+#include "serverthread.moc"
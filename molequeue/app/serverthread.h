@@ -0,0 +1,145 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_SERVERTHREAD_H
+#define MOLEQUEUE_SERVERTHREAD_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+namespace MoleQueue
+{
+class Server;
+
+/**
+ * @class ServerThread serverthread.h <molequeue/serverthread.h>
+ * @brief Runs a Server, and everything it owns, on a dedicated thread.
+ *
+ * The Server, its JsonRpc, JobManager, QueueManager and connections are moved
+ * to this thread by start(), so that handling RPC requests does not wait for
+ * the GUI to repaint. The boundary between the two threads is:
+ *
+ * - Core to GUI: signals only. Connections made with Qt::AutoConnection
+ *   become queued, so the arguments must not refer to core objects that the
+ *   receiver then reads. JobItemModel is fed by JobManager::jobsChanged(),
+ *   which carries copies of the displayed job data.
+ * - GUI to core: changes are queued calls into the server thread, e.g.
+ *   QMetaObject::invokeMethod(jobManager, "removeJobs", ...). To read core
+ *   objects (jobs, queues, ...) the GUI holds a ServerThreadLocker, which
+ *   pauses the server thread in a blocking call until it is released. The
+ *   server never leaves its thread, so keep the locked sections short and
+ *   never show a dialog while holding one. The queue manager dialog, which
+ *   edits the queues for as long as it is open, stops the thread instead.
+ *
+ * Queues that need the GUI thread (see Queue::requiresGuiThread()) keep the
+ * whole server on the GUI thread.
+ */
+class ServerThread : public QThread
+{
+  Q_OBJECT
+public:
+  /// The @a server must not have a parent.
+  explicit ServerThread(Server *server, QObject *parentObject = 0);
+
+  /// Stops the thread. The server is returned to the thread that created
+  /// this object.
+  ~ServerThread();
+
+  /// @return The server run by this thread.
+  Server *server() const { return m_server; }
+
+  /// @return True if the server may be moved to this thread, i.e. none of its
+  /// queues requires the GUI thread.
+  bool canRun() const;
+
+  /**
+   * Move the server to this thread and start the thread. Must be called from
+   * the thread the server lives in. Does nothing if canRun() is false.
+   * @return True if the server is running on this thread.
+   */
+  bool startServer();
+
+  /// Stop the thread and move the server back to the calling thread.
+  void stopServer();
+
+  /// Pause the server thread until unlock() is called, so that the calling
+  /// thread may read the core objects. The server stays on its thread. Calls
+  /// nest. Use ServerThreadLocker rather than calling this directly.
+  void lock();
+
+  /// Undo a call to lock(). The last one lets the server thread continue.
+  void unlock();
+
+  /// @return The ServerThread running @a coreObject, or NULL if it is not run
+  /// by one.
+  static ServerThread *forObject(const QObject *coreObject);
+
+protected:
+  void run();
+
+private:
+  friend class ServerThreadPause;
+
+  /// Called in this thread by lock(): wait until unlock() releases it.
+  void pause();
+
+  Server *m_server;
+  QThread *m_homeThread;
+  /// Lives in this thread and receives the queued pause() calls.
+  QObject *m_pauser;
+  int m_lockCount;
+
+  /// Guard m_paused and m_released, which are shared by both threads.
+  QMutex m_pauseMutex;
+  QWaitCondition m_pauseChanged;
+  bool m_paused;
+  bool m_released;
+};
+
+/**
+ * @class ServerThreadLocker serverthread.h <molequeue/serverthread.h>
+ * @brief Pauses the server thread so the GUI thread may read the core for
+ * the lifetime of the locker.
+ *
+ * Construct it with any object owned by the server before reading core
+ * objects (jobs, queues, programs, ...) from the GUI thread. Changes are
+ * still made by queued calls, once the locker is gone:
+ * @code
+ * QList<IdType> ids;
+ * {
+ *   ServerThreadLocker locker(m_jobManager);
+ *   ids = ...;
+ * }
+ * QMetaObject::invokeMethod(m_jobManager, "removeJobs",
+ *                           Q_ARG(QList<IdType>, ids));
+ * @endcode
+ * Does nothing when the server is not run by a ServerThread.
+ */
+class ServerThreadLocker
+{
+public:
+  explicit ServerThreadLocker(const QObject *coreObject);
+  ~ServerThreadLocker();
+
+private:
+  Q_DISABLE_COPY(ServerThreadLocker)
+  ServerThread *m_thread;
+};
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_SERVERTHREAD_H
@@ -125,6 +125,21 @@ bool SshCommand::copyDirTo(const QString &localDir, const QString &remoteDir)
   return true;
 }
 
+bool SshCommand::copyFilesTo(const QStringList &localPaths,
+                             const QString &remoteDir)
+{
+  if (!isValid() || localPaths.isEmpty())
+    return false;
+
+  QStringList args = scpArgs();
+  QString remoteDirSpec = remoteSpec() + ":" + remoteDir;
+  args << "-r" << localPaths << remoteDirSpec;
+
+  sendRequest(m_scpCommand, args);
+
+  return true;
+}
+
 bool SshCommand::copyDirFrom(const QString &remoteDir, const QString &localDir)
 {
   if (!isValid())
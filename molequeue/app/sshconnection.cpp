@@ -78,6 +78,11 @@ bool SshConnection::copyDirTo(const QString &, const QString &)
   return false;
 }
 
+bool SshConnection::copyFilesTo(const QStringList &, const QString &)
+{
+  return false;
+}
+
 bool SshConnection::copyDirFrom(const QString &, const QString &)
 {
   return false;
@@ -18,6 +18,7 @@
 #define SSHCONNECTION_H
 
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
 #include <QtCore/QVariant>
 
 namespace MoleQueue {
@@ -176,6 +177,22 @@ public slots:
    */
   virtual bool copyDirTo(const QString &localDir, const QString &remoteDir);
 
+  /**
+   * Copy several local files or directories (recursively) into an existing
+   * directory on the remote system.
+   *
+   * \note The command is executed asynchronously, see requestComplete() or
+   * waitForCompletion() for results.
+   *
+   * \sa requestSent() requestCompleted() waitForCompeletion()
+   *
+   * \param localPaths The paths of the local files and directories.
+   * \param remoteDir The path of the directory on the remote system.
+   * \return True on success, false on failure.
+   */
+  virtual bool copyFilesTo(const QStringList &localPaths,
+                           const QString &remoteDir);
+
   /**
    * Copy a remote directory recursively to the local system.
    *
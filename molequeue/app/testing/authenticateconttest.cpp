@@ -15,7 +15,6 @@
  ******************************************************************************/
 
 #include <QtTest>
-#include <QtXmlPatterns/QXmlQuery>
 
 #include "queues/uit/authenticatecont.h"
 #include "queues/uit/authenticateresponse.h"
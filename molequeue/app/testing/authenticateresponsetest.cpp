@@ -15,7 +15,6 @@
  ******************************************************************************/
 
 #include <QtTest>
-#include <QtXmlPatterns/QXmlQuery>
 
 #include "queues/uit/authenticateresponse.h"
 #include "referencestring.h"
@@ -28,7 +27,8 @@ private slots:
   void initTestCase();
 
   void testFromXml();
-  void testXpathExpressions();
+  void testIndentedXml();
+  void testMalformedXml();
 
 private:
   QString m_authenticateResponseXml;
@@ -60,37 +60,35 @@ void AuthenticateResponseTest::testFromXml()
   QCOMPARE(response.prompts()[1].prompt(), QString("Password"));
 }
 
-void AuthenticateResponseTest::testXpathExpressions()
+void AuthenticateResponseTest::testIndentedXml()
 {
-  QXmlQuery query;
-  query.setFocus(m_authenticateResponseXml);
-  query.setQuery("/AuthenticateResponse/success/string()");
-  QString result;
-  query.evaluateTo(&result);
-  QCOMPARE(result.trimmed(), QString("false"));
+  // The reference file as sent, with indentation and line breaks.
+  MoleQueue::Uit::AuthenticateResponse response =
+    MoleQueue::Uit::AuthenticateResponse::fromXml(
+        ReferenceString("authenticateresponse-ref/authenticateresponse.xml"));
 
-  QStringList expectedIds;
-  expectedIds << "0" << "2";
+  QVERIFY(response.isValid());
+  QVERIFY(!response.success());
+  QCOMPARE(response.authSessionId(),
+           QString("FE09938C-84BC-E75A-D767-84B85F48C4DB"));
 
   QStringList expectedPrompts;
   expectedPrompts << "SecurID Passcode" << "Password";
 
-  QStringList ids;
-  query.setQuery("/AuthenticateResponse/prompts/Prompt/id/string()");
-  int index = 0;
-  foreach (const QString &id, ids) {
-
-    QCOMPARE(id, expectedIds[index]);
-
-    query.bindVariable("id", QVariant(id));
-    query.setQuery(
-      QString("/AuthenticateResponse/prompts/Prompt[id=$id]/prompt/string()"));
+  QCOMPARE(response.prompts().size(), 2);
+  QCOMPARE(response.prompts()[0].id(), 0);
+  QCOMPARE(response.prompts()[1].id(), 2);
+  for (int i = 0; i < expectedPrompts.size(); ++i)
+    QCOMPARE(response.prompts()[i].prompt(), expectedPrompts[i]);
+}
 
-    QString prompt;
-    query.evaluateTo(&prompt);
+void AuthenticateResponseTest::testMalformedXml()
+{
+  MoleQueue::Uit::AuthenticateResponse response =
+    MoleQueue::Uit::AuthenticateResponse::fromXml(
+        "<AuthenticateResponse><success>true</success>");
 
-    QCOMPARE(prompt, expectedPrompts[index++]);
-  }
+  QVERIFY(!response.isValid());
 }
 
 QTEST_MAIN(AuthenticateResponseTest)
@@ -0,0 +1,179 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#include "benchconnection.h"
+
+#include <molequeue/client/jsonrpcclient.h>
+
+#ifdef USE_ZERO_MQ
+#include <molequeue/zeromq/zeromqconnection.h>
+#endif
+
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+
+BenchConnection::BenchConnection(QObject *parentObject)
+  : QObject(parentObject),
+    m_nextId(0)
+{
+}
+
+BenchConnection *BenchConnection::create(const QString &transport,
+                                         const QString &serverName,
+                                         QObject *parentObject)
+{
+  if (transport == "local")
+    return new LocalSocketBenchConnection(serverName, parentObject);
+#ifdef USE_ZERO_MQ
+  if (transport == "zeromq")
+    return new ZeroMqBenchConnection(serverName, parentObject);
+#endif
+  return NULL;
+}
+
+QStringList BenchConnection::availableTransports()
+{
+  QStringList transports;
+  transports << "local";
+#ifdef USE_ZERO_MQ
+  transports << "zeromq";
+#endif
+  return transports;
+}
+
+QString BenchConnection::listenerFactoryClassName(const QString &transport)
+{
+  if (transport == "local")
+    return "MoleQueue::LocalSocketConnectionListenerFactory";
+  if (transport == "zeromq")
+    return "MoleQueue::ZeroMqConnectionListenerFactory";
+  return QString();
+}
+
+qint64 BenchConnection::now()
+{
+  static QElapsedTimer clock;
+  if (!clock.isValid())
+    clock.start();
+  return clock.nsecsElapsed();
+}
+
+int BenchConnection::send(const QString &method, const QJsonObject &params)
+{
+  int id = m_nextId++;
+  QJsonObject request;
+  request["jsonrpc"] = QLatin1String("2.0");
+  request["id"] = id;
+  request["method"] = method;
+  if (!params.isEmpty())
+    request["params"] = params;
+
+  m_sent.insert(id, now());
+  sendMessage(request);
+  return id;
+}
+
+void BenchConnection::handleMessage(const QJsonObject &message)
+{
+  QJsonValue idValue = message.value("id");
+  if (idValue.isDouble()) {
+    int id = static_cast<int>(idValue.toDouble());
+    QHash<int, qint64>::iterator it = m_sent.find(id);
+    if (it != m_sent.end()) {
+      qint64 latency = now() - it.value();
+      m_sent.erase(it);
+      emit responseReceived(id, message, latency);
+    }
+  }
+  else if (message.contains("method")) {
+    emit notificationReceived(message);
+  }
+}
+
+//==============================================================================
+LocalSocketBenchConnection::LocalSocketBenchConnection(
+    const QString &serverName, QObject *parentObject)
+  : BenchConnection(parentObject),
+    m_serverName(serverName),
+    m_client(new MoleQueue::JsonRpcClient(this))
+{
+  connect(m_client, SIGNAL(resultReceived(QJsonObject)),
+          this, SLOT(handleMessage(QJsonObject)));
+  connect(m_client, SIGNAL(errorReceived(QJsonObject)),
+          this, SLOT(handleMessage(QJsonObject)));
+  connect(m_client, SIGNAL(notificationReceived(QJsonObject)),
+          this, SLOT(handleMessage(QJsonObject)));
+}
+
+bool LocalSocketBenchConnection::open()
+{
+  return m_client->connectToServer(m_serverName);
+}
+
+void LocalSocketBenchConnection::flush()
+{
+  m_client->flush();
+}
+
+void LocalSocketBenchConnection::sendMessage(const QJsonObject &message)
+{
+  m_client->sendRequest(message);
+}
+
+//==============================================================================
+#ifdef USE_ZERO_MQ
+ZeroMqBenchConnection::ZeroMqBenchConnection(const QString &serverName,
+                                             QObject *parentObject)
+  : BenchConnection(parentObject),
+    m_connection(NULL)
+{
+  // The address ZeroMqConnectionListenerFactory binds for serverName.
+  QString address = "ipc://" + QDir::temp().path() + "/"
+      + MoleQueue::ZeroMqConnection::zeroMqPrefix + "_" + serverName;
+  m_connection = new MoleQueue::ZeroMqConnection(this, address);
+  connect(m_connection, SIGNAL(packetReceived(MoleQueue::PacketType,
+                                              MoleQueue::EndpointIdType)),
+          this, SLOT(readPacket(MoleQueue::PacketType)));
+}
+
+bool ZeroMqBenchConnection::open()
+{
+  m_connection->open();
+  m_connection->start();
+  return m_connection->isOpen();
+}
+
+void ZeroMqBenchConnection::sendMessage(const QJsonObject &message)
+{
+  m_connection->send(QJsonDocument(message).toJson(QJsonDocument::Compact),
+                     MoleQueue::EndpointIdType());
+}
+
+void ZeroMqBenchConnection::readPacket(const MoleQueue::PacketType &packet)
+{
+  QJsonDocument document = QJsonDocument::fromJson(packet);
+  if (document.isObject()) {
+    handleMessage(document.object());
+  }
+  else if (document.isArray()) {
+    foreach (const QJsonValue &value, document.array())
+      handleMessage(value.toObject());
+  }
+}
+#endif // USE_ZERO_MQ
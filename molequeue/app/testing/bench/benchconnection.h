@@ -0,0 +1,138 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#ifndef BENCHCONNECTION_H
+#define BENCHCONNECTION_H
+
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+
+#ifdef USE_ZERO_MQ
+#include <molequeue/servercore/servercoreglobal.h>
+#endif
+
+namespace MoleQueue
+{
+class Connection;
+class JsonRpcClient;
+}
+
+/**
+ * @brief A client connection used by molequeue-bench.
+ *
+ * Assigns request ids, remembers when each request was sent and reports the
+ * round trip time with its response. Subclasses carry the packets over a
+ * particular transport.
+ */
+class BenchConnection : public QObject
+{
+  Q_OBJECT
+public:
+  explicit BenchConnection(QObject *parentObject = 0);
+
+  /**
+   * Create a connection for @a transport ("local" or "zeromq") to the server
+   * listening as @a serverName.
+   * @return The connection, or NULL if the transport is not available.
+   */
+  static BenchConnection *create(const QString &transport,
+                                 const QString &serverName,
+                                 QObject *parentObject = 0);
+
+  /// @return The names of the transports this build supports.
+  static QStringList availableTransports();
+
+  /// @return The class name of the listener plugin the server needs to
+  /// accept connections over @a transport.
+  static QString listenerFactoryClassName(const QString &transport);
+
+  /// @return Nanoseconds on a clock shared by all connections.
+  static qint64 now();
+
+  virtual bool open() = 0;
+
+  /**
+   * Send a request for @a method.
+   * @return The request id, matched by responseReceived().
+   */
+  int send(const QString &method, const QJsonObject &params = QJsonObject());
+
+  /// Write any buffered requests.
+  virtual void flush() {}
+
+  /// @return The number of requests without a response.
+  int pending() const { return m_sent.size(); }
+
+signals:
+  /// @param latency Nanoseconds since the request was sent.
+  void responseReceived(int id, const QJsonObject &response, qint64 latency);
+  void notificationReceived(const QJsonObject &notification);
+
+protected slots:
+  void handleMessage(const QJsonObject &message);
+
+protected:
+  virtual void sendMessage(const QJsonObject &message) = 0;
+
+private:
+  int m_nextId;
+  QHash<int, qint64> m_sent;
+};
+
+/// Bench connection over the local socket, using the client library.
+class LocalSocketBenchConnection : public BenchConnection
+{
+  Q_OBJECT
+public:
+  LocalSocketBenchConnection(const QString &serverName,
+                             QObject *parentObject = 0);
+
+  bool open();
+  void flush();
+
+protected:
+  void sendMessage(const QJsonObject &message);
+
+private:
+  QString m_serverName;
+  MoleQueue::JsonRpcClient *m_client;
+};
+
+#ifdef USE_ZERO_MQ
+/// Bench connection over the ZeroMQ ipc socket.
+class ZeroMqBenchConnection : public BenchConnection
+{
+  Q_OBJECT
+public:
+  ZeroMqBenchConnection(const QString &serverName, QObject *parentObject = 0);
+
+  bool open();
+
+protected:
+  void sendMessage(const QJsonObject &message);
+
+private slots:
+  void readPacket(const MoleQueue::PacketType &packet);
+
+private:
+  MoleQueue::Connection *m_connection;
+};
+#endif // USE_ZERO_MQ
+
+#endif // BENCHCONNECTION_H
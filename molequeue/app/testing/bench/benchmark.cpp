@@ -0,0 +1,361 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#include "benchmark.h"
+
+#include "benchconnection.h"
+
+#include "molequeueglobal.h"
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QJsonArray>
+#include <QtCore/QTimer>
+
+#include <cstdlib>
+
+const char *Benchmark::nullQueueName = "null";
+const char *Benchmark::remoteQueueName = "remote";
+const char *Benchmark::programName = "bench";
+
+namespace {
+double randomFraction()
+{
+  return qrand() / (static_cast<double>(RAND_MAX) + 1.0);
+}
+
+qint64 toId(const QJsonValue &value)
+{
+  return static_cast<qint64>(value.toDouble(-1));
+}
+}
+
+Workload::Workload()
+  : jobs(10000),
+    submitRate(0.0),
+    window(256),
+    mixedRequests(10000),
+    lookupFraction(0.9),
+    subscribers(4),
+    fanoutJobs(1000),
+    remoteFraction(0.0),
+    timeout(300),
+    seed(1)
+{
+}
+
+QJsonObject Workload::toJson() const
+{
+  QJsonObject json;
+  json.insert("jobs", jobs);
+  json.insert("submitRate", submitRate);
+  json.insert("window", window);
+  json.insert("mixedRequests", mixedRequests);
+  json.insert("lookupFraction", lookupFraction);
+  json.insert("subscribers", subscribers);
+  json.insert("fanoutJobs", fanoutJobs);
+  json.insert("remoteFraction", remoteFraction);
+  json.insert("timeout", timeout);
+  json.insert("seed", static_cast<double>(seed));
+  return json;
+}
+
+Benchmark::Benchmark(const Workload &workload, const QString &transport,
+                     const QString &serverName, QObject *parentObject)
+  : QObject(parentObject),
+    m_workload(workload),
+    m_transport(transport),
+    m_serverName(serverName),
+    m_succeeded(false),
+    m_driver(NULL),
+    m_phase(Idle),
+    m_stats(NULL),
+    m_loop(NULL),
+    m_target(0),
+    m_sent(0),
+    m_completed(0),
+    m_phaseStart(0),
+    m_pumpScheduled(false),
+    m_deliveries(0)
+{
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+QJsonObject Benchmark::run()
+{
+  QJsonObject report;
+  report.insert("transport", m_transport);
+  m_succeeded = false;
+
+  m_driver = BenchConnection::create(m_transport, m_serverName, this);
+  if (!m_driver || !m_driver->open()) {
+    report.insert("error", QString("Unable to connect to '%1' over %2.")
+                  .arg(m_serverName).arg(m_transport));
+    return report;
+  }
+  connect(m_driver, SIGNAL(responseReceived(int,QJsonObject,qint64)),
+          this, SLOT(responseReceived(int,QJsonObject,qint64)));
+
+  for (int i = 0; i < m_workload.subscribers; ++i) {
+    BenchConnection *subscriber =
+        BenchConnection::create(m_transport, m_serverName, this);
+    if (!subscriber->open()) {
+      report.insert("error", QString("Unable to connect subscriber %1.")
+                    .arg(i));
+      return report;
+    }
+    connect(subscriber, SIGNAL(responseReceived(int,QJsonObject,qint64)),
+            this, SLOT(responseReceived(int,QJsonObject,qint64)));
+    connect(subscriber, SIGNAL(notificationReceived(QJsonObject)),
+            this, SLOT(notificationReceived(QJsonObject)));
+    m_subscribers.append(subscriber);
+  }
+
+  qsrand(m_workload.seed);
+  m_succeeded = true;
+  QJsonArray phases;
+
+  PhaseStats submit("submit");
+  runPhase(submit, Submit, m_workload.jobs);
+  phases.append(submit.toJson());
+
+  PhaseStats mixed("mixed");
+  runPhase(mixed, Mixed, m_workload.mixedRequests);
+  phases.append(mixed.toJson());
+
+  if (!m_subscribers.isEmpty()) {
+    PhaseStats subscribe("subscribe");
+    runPhase(subscribe, Subscribe, m_subscribers.size());
+    phases.append(subscribe.toJson());
+
+    PhaseStats fanout("fanout");
+    runPhase(fanout, Fanout, m_workload.fanoutJobs);
+    fanout.setCounter("subscribers", m_subscribers.size());
+    fanout.setCounter("deliveries", m_deliveries);
+    fanout.setCounter("resyncs", m_resynced.size());
+    phases.append(fanout.toJson());
+  }
+
+  report.insert("phases", phases);
+  return report;
+}
+
+void Benchmark::runPhase(PhaseStats &stats, Phase phase, int operations)
+{
+  m_phase = phase;
+  m_stats = &stats;
+  m_target = operations;
+  m_sent = 0;
+  m_completed = 0;
+
+  QEventLoop loop;
+  m_loop = &loop;
+  QTimer timer;
+  timer.setSingleShot(true);
+  connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+
+  stats.start();
+  m_phaseStart = BenchConnection::now();
+  timer.start(m_workload.timeout * 1000);
+  pump();
+  if (!isDone())
+    loop.exec();
+  stats.stop();
+
+  stats.setTimedOut(!isDone());
+  if (stats.timedOut() || stats.errors() > 0)
+    m_succeeded = false;
+
+  m_loop = NULL;
+  m_stats = NULL;
+  m_phase = Idle;
+}
+
+void Benchmark::pump()
+{
+  m_pumpScheduled = false;
+  if (m_phase == Idle)
+    return;
+
+  if (m_phase == Subscribe) {
+    while (m_sent < m_target) {
+      BenchConnection *subscriber = m_subscribers.at(m_sent++);
+      subscriber->send("subscribe");
+      subscriber->flush();
+    }
+    return;
+  }
+
+  int allowed = m_target;
+  if (m_workload.submitRate > 0.0) {
+    double elapsed = (BenchConnection::now() - m_phaseStart) / 1e9;
+    allowed = static_cast<int>(qMin(static_cast<double>(m_target),
+                                    elapsed * m_workload.submitRate + 1.0));
+  }
+
+  while (m_sent < allowed && m_driver->pending() < m_workload.window)
+    sendNext();
+  m_driver->flush();
+
+  // Come back when the rate allows the next request.
+  if (m_sent < m_target && m_sent >= allowed && !m_pumpScheduled) {
+    m_pumpScheduled = true;
+    QTimer::singleShot(1, this, SLOT(pump()));
+  }
+}
+
+void Benchmark::sendNext()
+{
+  ++m_sent;
+  switch (m_phase) {
+  case Submit:
+    sendSubmit(true);
+    break;
+  case Mixed:
+    if (!m_jobIds.isEmpty() && randomFraction() < m_workload.lookupFraction) {
+      QJsonObject params;
+      params["moleQueueId"] =
+          static_cast<double>(m_jobIds.at(qrand() % m_jobIds.size()));
+      m_driver->send("lookupJob", params);
+    }
+    else {
+      sendSubmit(true);
+    }
+    break;
+  case Fanout:
+    // Only jobs in the null queue finish, so all of these go there.
+    m_fanoutRequests.insert(sendSubmit(false), BenchConnection::now());
+    break;
+  default:
+    break;
+  }
+}
+
+int Benchmark::sendSubmit(bool allowRemote)
+{
+  bool remote = allowRemote && randomFraction() < m_workload.remoteFraction;
+
+  QJsonObject params;
+  params["queue"] = QLatin1String(remote ? remoteQueueName : nullQueueName);
+  params["program"] = QLatin1String(programName);
+  params["description"] = QLatin1String("molequeue-bench job");
+  params["popupOnStateChange"] = false;
+
+  int id = m_driver->send("submitJob", params);
+  m_submitRequests.insert(id);
+  return id;
+}
+
+void Benchmark::responseReceived(int id, const QJsonObject &response,
+                                 qint64 latency)
+{
+  // A straggler from a phase that timed out.
+  if (!m_stats)
+    return;
+
+  BenchConnection *connection = static_cast<BenchConnection *>(sender());
+  bool error = response.contains("error");
+  if (error)
+    m_stats->addError();
+
+  if (connection == m_driver && m_submitRequests.remove(id) && !error) {
+    qint64 moleQueueId =
+        toId(response.value("result").toObject().value("moleQueueId"));
+    if (m_phase == Fanout) {
+      qint64 sent = m_fanoutRequests.take(id);
+      m_fanoutJobs.insert(moleQueueId, sent);
+      foreach (qint64 arrival, m_earlyDeliveries.take(moleQueueId)) {
+        m_stats->addLatency(arrival - sent);
+        ++m_deliveries;
+      }
+    }
+    else {
+      m_jobIds.append(moleQueueId);
+    }
+  }
+
+  // Fan-out latency is measured to delivery instead.
+  if (m_phase != Fanout)
+    m_stats->addLatency(latency);
+
+  ++m_completed;
+  checkDone();
+  if (m_phase != Idle && !m_pumpScheduled)
+    pump();
+}
+
+void Benchmark::notificationReceived(const QJsonObject &notification)
+{
+  if (m_phase != Fanout
+      || notification.value("method").toString() != "jobsChanged") {
+    return;
+  }
+
+  BenchConnection *connection = static_cast<BenchConnection *>(sender());
+  QJsonObject params = notification.value("params").toObject();
+  if (params.value("resyncNeeded").toBool())
+    m_resynced.insert(connection);
+
+  static const QString finished =
+      QLatin1String(MoleQueue::jobStateToString(MoleQueue::Finished));
+  qint64 arrival = BenchConnection::now();
+  QSet<qint64> &seen = m_seen[connection];
+  foreach (const QJsonValue &value, params.value("jobs").toArray()) {
+    QJsonObject job = value.toObject();
+    if (job.value("jobState").toString() != finished)
+      continue;
+
+    qint64 moleQueueId = toId(job.value("moleQueueId"));
+    if (seen.contains(moleQueueId))
+      continue;
+    seen.insert(moleQueueId);
+
+    if (m_fanoutJobs.contains(moleQueueId)) {
+      m_stats->addLatency(arrival - m_fanoutJobs.value(moleQueueId));
+      ++m_deliveries;
+    }
+    else {
+      m_earlyDeliveries[moleQueueId].append(arrival);
+    }
+  }
+
+  checkDone();
+}
+
+bool Benchmark::isDone() const
+{
+  if (m_completed < m_target)
+    return false;
+  if (m_phase != Fanout)
+    return true;
+
+  foreach (BenchConnection *subscriber, m_subscribers) {
+    if (!m_resynced.contains(subscriber)
+        && m_seen.value(subscriber).size() < m_target) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Benchmark::checkDone()
+{
+  if (m_loop && isDone())
+    m_loop->quit();
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "phasestats.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+
+class BenchConnection;
+class QEventLoop;
+
+/// The configurable parts of a molequeue-bench run.
+struct Workload
+{
+  Workload();
+
+  /// Jobs submitted in the submit phase.
+  int jobs;
+  /// Requests per second sent by the driver, 0 for as fast as window allows.
+  double submitRate;
+  /// Most requests the driver has in flight at once.
+  int window;
+  /// Requests sent in the mixed phase.
+  int mixedRequests;
+  /// Fraction of the mixed phase requests that are lookupJob, the rest are
+  /// submitJob.
+  double lookupFraction;
+  /// Connections subscribed to all job changes in the fan-out phase.
+  int subscribers;
+  /// Jobs submitted in the fan-out phase.
+  int fanoutJobs;
+  /// Fraction of submitted jobs sent to the DummyQueueRemote queue rather than
+  /// the null queue. These are staged but never finish.
+  double remoteFraction;
+  /// Seconds before a phase is abandoned.
+  int timeout;
+  /// Seed for choosing lookups and queues.
+  uint seed;
+
+  QJsonObject toJson() const;
+};
+
+/**
+ * @brief Drives one transport of a running server through the phases of a
+ * Workload.
+ *
+ * - "submit": Workload::jobs submitJob requests.
+ * - "mixed": lookupJob of the submitted jobs mixed with more submissions.
+ * - "subscribe": every subscriber connection subscribes to all jobs.
+ * - "fanout": jobs are submitted while the subscribers listen. The latency is
+ *   from sending submitJob to a subscriber seeing the job Finished.
+ *
+ * Request latencies are round trip times measured by the driver connection.
+ */
+class Benchmark : public QObject
+{
+  Q_OBJECT
+public:
+  Benchmark(const Workload &workload, const QString &transport,
+            const QString &serverName, QObject *parentObject = 0);
+  ~Benchmark();
+
+  /// Run all phases.
+  /// @return The report for this transport.
+  QJsonObject run();
+
+  /// @return True if every phase finished in time and without errors.
+  bool succeeded() const { return m_succeeded; }
+
+  /// The names of the queues and program that jobs are submitted to.
+  static const char *nullQueueName;
+  static const char *remoteQueueName;
+  static const char *programName;
+
+private slots:
+  void pump();
+  void responseReceived(int id, const QJsonObject &response, qint64 latency);
+  void notificationReceived(const QJsonObject &notification);
+
+private:
+  enum Phase {
+    Idle,
+    Submit,
+    Mixed,
+    Subscribe,
+    Fanout
+  };
+
+  void runPhase(PhaseStats &stats, Phase phase, int operations);
+  void sendNext();
+  int sendSubmit(bool allowRemote);
+  void checkDone();
+  bool isDone() const;
+
+  Workload m_workload;
+  QString m_transport;
+  QString m_serverName;
+  bool m_succeeded;
+
+  BenchConnection *m_driver;
+  QList<BenchConnection *> m_subscribers;
+
+  Phase m_phase;
+  PhaseStats *m_stats;
+  QEventLoop *m_loop;
+  int m_target;
+  int m_sent;
+  int m_completed;
+  qint64 m_phaseStart;
+  bool m_pumpScheduled;
+  /// Driver request ids that are submitJob requests.
+  QSet<int> m_submitRequests;
+
+  /// Jobs accepted by the server, for lookups.
+  QList<qint64> m_jobIds;
+  /// Fan-out: submitJob request id -> send time.
+  QHash<int, qint64> m_fanoutRequests;
+  /// Fan-out: MoleQueue id -> send time of its submitJob.
+  QHash<qint64, qint64> m_fanoutJobs;
+  /// Fan-out: arrival times of Finished changes for jobs whose submitJob
+  /// response is still outstanding.
+  QHash<qint64, QList<qint64> > m_earlyDeliveries;
+  /// Fan-out: jobs each subscriber has seen finish.
+  QHash<BenchConnection *, QSet<qint64> > m_seen;
+  /// Fan-out: subscribers told to resync, which will not see every job.
+  QSet<BenchConnection *> m_resynced;
+  int m_deliveries;
+};
+
+#endif // BENCHMARK_H
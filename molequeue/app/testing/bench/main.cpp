@@ -0,0 +1,266 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#include "benchconnection.h"
+#include "benchmark.h"
+#include "dummyqueueremote.h"
+#include "nullqueue.h"
+#include "phasestats.h"
+
+#include "pluginmanager.h"
+#include "program.h"
+#include "queuemanager.h"
+#include "server.h"
+#include "serverthread.h"
+
+#include <molequeue/servercore/connectionlistenerfactory.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSettings>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+
+#include <cstdio>
+#include <cstdlib>
+
+void printUsage();
+
+MoleQueue::Queue *createDummyQueue(MoleQueue::QueueManager *parentManager)
+{
+  return new DummyQueueRemote("Dummy", parentManager);
+}
+
+bool listenerLoaded(const QString &transport)
+{
+  QString className = BenchConnection::listenerFactoryClassName(transport);
+  foreach (MoleQueue::ConnectionListenerFactory *factory,
+           MoleQueue::PluginManager::instance()->connectionListenerFactories()) {
+    QObject *object = dynamic_cast<QObject *>(factory);
+    if (object && className == object->metaObject()->className())
+      return true;
+  }
+  return false;
+}
+
+MoleQueue::Queue *addBenchQueue(MoleQueue::Server &server,
+                                const QString &name, const QString &type)
+{
+  MoleQueue::Queue *queue = server.queueManager()->addQueue(name, type);
+  if (queue) {
+    MoleQueue::Program *program = new MoleQueue::Program(queue);
+    program->setName(Benchmark::programName);
+    queue->addProgram(program);
+  }
+  return queue;
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication::setOrganizationName("OpenChemistry");
+  QCoreApplication::setOrganizationDomain("openchemistry.org");
+  QCoreApplication::setApplicationName("molequeue-bench");
+
+  QCoreApplication app(argc, argv);
+
+  Workload workload;
+  QStringList transports = BenchConnection::availableTransports();
+  QString outputFile;
+
+  QStringList args = QCoreApplication::arguments();
+  for (QStringList::const_iterator it = args.constBegin() + 1,
+       itEnd = args.constEnd(); it != itEnd; ++it) {
+    if (*it == "-h" || *it == "--help") {
+      printUsage();
+      return EXIT_SUCCESS;
+    }
+    if (it + 1 == itEnd) {
+      qWarning("Missing value for option %s", qPrintable(*it));
+      return EXIT_FAILURE;
+    }
+    QString option = *it;
+    QString value = *(++it);
+    bool ok = true;
+    if (option == "--jobs")
+      workload.jobs = value.toInt(&ok);
+    else if (option == "--submit-rate")
+      workload.submitRate = value.toDouble(&ok);
+    else if (option == "--window")
+      workload.window = value.toInt(&ok);
+    else if (option == "--mixed-requests")
+      workload.mixedRequests = value.toInt(&ok);
+    else if (option == "--lookup-fraction")
+      workload.lookupFraction = value.toDouble(&ok);
+    else if (option == "--subscribers")
+      workload.subscribers = value.toInt(&ok);
+    else if (option == "--fanout-jobs")
+      workload.fanoutJobs = value.toInt(&ok);
+    else if (option == "--remote-fraction")
+      workload.remoteFraction = value.toDouble(&ok);
+    else if (option == "--timeout")
+      workload.timeout = value.toInt(&ok);
+    else if (option == "--seed")
+      workload.seed = value.toUInt(&ok);
+    else if (option == "--transports")
+      transports = value.split(',', QString::SkipEmptyParts);
+    else if (option == "--output")
+      outputFile = value;
+    else {
+      qWarning("Unrecognized command line option: %s", qPrintable(option));
+      printUsage();
+      return EXIT_FAILURE;
+    }
+    if (!ok || workload.window < 1) {
+      qWarning("Invalid value '%s' for option %s", qPrintable(value),
+               qPrintable(option));
+      return EXIT_FAILURE;
+    }
+  }
+
+  foreach (const QString &transport, transports) {
+    if (!BenchConnection::availableTransports().contains(transport)) {
+      qWarning("Transport '%s' is not available in this build.",
+               qPrintable(transport));
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Keep the server's settings and job files out of the user's configuration.
+  QTemporaryDir workDir(QDir::tempPath() + "/molequeue-bench-XXXXXX");
+  if (!workDir.isValid()) {
+    qWarning("Unable to create a temporary working directory.");
+    return EXIT_FAILURE;
+  }
+  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+                     workDir.path() + "/config");
+  QSettings settings;
+  settings.setValue("workingDirectoryBase", workDir.path());
+
+  MoleQueue::QueueManager::registerQueueType("Null", &NullQueue::create);
+  MoleQueue::QueueManager::registerQueueType("Dummy", &createDummyQueue);
+
+  QString serverName = QString("molequeue-bench-%1")
+      .arg(QCoreApplication::applicationPid());
+  MoleQueue::Server server(NULL, serverName);
+
+  // The server loads its listeners as plugins, relative to the executable.
+  foreach (const QString &transport, transports) {
+    if (!listenerLoaded(transport)) {
+      qWarning("No '%s' listener plugin found in %s.", qPrintable(transport),
+               qPrintable(MoleQueue::PluginManager::instance()->pluginDirList()
+                          .join(", ")));
+      return EXIT_FAILURE;
+    }
+  }
+
+  NullQueue *nullQueue = qobject_cast<NullQueue *>(
+        addBenchQueue(server, Benchmark::nullQueueName, "Null"));
+  if (!nullQueue
+      || !addBenchQueue(server, Benchmark::remoteQueueName, "Dummy")) {
+    qWarning("Unable to create the benchmark queues.");
+    return EXIT_FAILURE;
+  }
+  // Jobs finish at once, so that every state change is notified.
+  nullQueue->setCompleteJobs(true);
+  server.start();
+
+  // Requests are handled on the server's own thread, as in the application.
+  MoleQueue::ServerThread serverThread(&server);
+  if (!serverThread.startServer()) {
+    qWarning("Unable to start the server thread.");
+    return EXIT_FAILURE;
+  }
+
+  bool succeeded = true;
+  QJsonArray results;
+  foreach (const QString &transport, transports) {
+    Benchmark benchmark(workload, transport, serverName);
+    results.append(benchmark.run());
+    succeeded = succeeded && benchmark.succeeded();
+  }
+
+  serverThread.stopServer();
+
+  QJsonObject report;
+  report.insert("benchmark", QLatin1String("molequeue-bench"));
+  report.insert("succeeded", succeeded);
+  report.insert("workload", workload.toJson());
+  report.insert("transports", results);
+  report.insert("peakRssKiB", static_cast<double>(PhaseStats::peakRssKiB()));
+  QByteArray json = QJsonDocument(report).toJson();
+
+  if (outputFile.isEmpty()) {
+    fwrite(json.constData(), 1, json.size(), stdout);
+  }
+  else {
+    QFile file(outputFile);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)
+        || file.write(json) != json.size()) {
+      qWarning("Unable to write %s", qPrintable(outputFile));
+      return EXIT_FAILURE;
+    }
+  }
+
+  return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void printUsage()
+{
+  Workload defaults;
+  qWarning("%s\n\n%s\n%s",
+           "Usage: molequeue-bench [options]",
+           "Runs an in-process MoleQueue server with a null queue and a "
+           "DummyQueueRemote queue,\nand reports its performance as JSON.",
+           "Options:");
+
+  const char *format = "  %-20s %s";
+  qWarning(format, "--jobs N", qPrintable(
+             QString("Jobs submitted in the submit phase (%1).")
+             .arg(defaults.jobs)));
+  qWarning(format, "--submit-rate R",
+           "Requests per second, 0 for no limit (0).");
+  qWarning(format, "--window N", qPrintable(
+             QString("Requests in flight at once (%1).")
+             .arg(defaults.window)));
+  qWarning(format, "--mixed-requests N", qPrintable(
+             QString("Requests in the mixed phase (%1).")
+             .arg(defaults.mixedRequests)));
+  qWarning(format, "--lookup-fraction F", qPrintable(
+             QString("Fraction of mixed requests that are lookups (%1).")
+             .arg(defaults.lookupFraction)));
+  qWarning(format, "--subscribers N", qPrintable(
+             QString("Subscribed connections, 0 to skip fan-out (%1).")
+             .arg(defaults.subscribers)));
+  qWarning(format, "--fanout-jobs N", qPrintable(
+             QString("Jobs submitted in the fan-out phase (%1).")
+             .arg(defaults.fanoutJobs)));
+  qWarning(format, "--remote-fraction F",
+           "Fraction of jobs sent to the DummyQueueRemote queue (0).");
+  qWarning(format, "--timeout S", qPrintable(
+             QString("Seconds before a phase is abandoned (%1).")
+             .arg(defaults.timeout)));
+  qWarning(format, "--seed N", "Random seed (1).");
+  qWarning(format, "--transports LIST", qPrintable(
+             QString("Comma separated transports to run (%1).")
+             .arg(BenchConnection::availableTransports().join(","))));
+  qWarning(format, "--output FILE", "Write the report to FILE, not stdout.");
+  qWarning("\nExits with a non-zero status if a phase timed out or a request "
+           "failed.");
+}
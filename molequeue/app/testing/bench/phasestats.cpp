@@ -0,0 +1,148 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#include "phasestats.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+
+namespace {
+// Nearest rank percentile of the sorted @a values, in microseconds.
+double percentile(const QVector<qint64> &values, double fraction)
+{
+  if (values.isEmpty())
+    return 0.0;
+  int index = static_cast<int>(fraction * values.size() + 0.5) - 1;
+  index = qBound(0, index, values.size() - 1);
+  return values.at(index) / 1000.0;
+}
+}
+
+PhaseStats::PhaseStats(const QString &name_)
+  : m_name(name_),
+    m_wallNanoseconds(0),
+    m_userStart(0.0),
+    m_systemStart(0.0),
+    m_user(0.0),
+    m_system(0.0),
+    m_errors(0),
+    m_timedOut(false)
+{
+}
+
+void PhaseStats::start()
+{
+  cpuTimes(&m_userStart, &m_systemStart);
+  m_timer.start();
+}
+
+void PhaseStats::stop()
+{
+  m_wallNanoseconds = m_timer.nsecsElapsed();
+  double userNow;
+  double systemNow;
+  cpuTimes(&userNow, &systemNow);
+  m_user = userNow - m_userStart;
+  m_system = systemNow - m_systemStart;
+}
+
+void PhaseStats::setCounter(const QString &key, double value)
+{
+  m_counters.insert(key, value);
+}
+
+QJsonObject PhaseStats::toJson() const
+{
+  QVector<qint64> sorted(m_latencies);
+  std::sort(sorted.begin(), sorted.end());
+
+  double wall = m_wallNanoseconds / 1e9;
+  double total = 0.0;
+  foreach (qint64 latency, sorted)
+    total += latency;
+
+  QJsonObject latency;
+  latency.insert("count", sorted.size());
+  latency.insert("mean", sorted.isEmpty() ? 0.0
+                                          : total / sorted.size() / 1000.0);
+  latency.insert("min", percentile(sorted, 0.0));
+  latency.insert("p50", percentile(sorted, 0.50));
+  latency.insert("p90", percentile(sorted, 0.90));
+  latency.insert("p99", percentile(sorted, 0.99));
+  latency.insert("p999", percentile(sorted, 0.999));
+  latency.insert("max", percentile(sorted, 1.0));
+
+  QJsonObject cpu;
+  cpu.insert("userSeconds", m_user);
+  cpu.insert("systemSeconds", m_system);
+  cpu.insert("utilization", wall > 0.0 ? (m_user + m_system) / wall : 0.0);
+
+  QJsonObject result(m_counters);
+  result.insert("name", m_name);
+  result.insert("operations", sorted.size());
+  result.insert("errors", m_errors);
+  result.insert("timedOut", m_timedOut);
+  result.insert("wallSeconds", wall);
+  result.insert("throughput", wall > 0.0 ? sorted.size() / wall : 0.0);
+  result.insert("latencyMicroseconds", latency);
+  result.insert("cpu", cpu);
+  result.insert("peakRssKiB", static_cast<double>(peakRssKiB()));
+  return result;
+}
+
+void PhaseStats::cpuTimes(double *user, double *system)
+{
+#ifdef Q_OS_WIN
+  FILETIME creation, exit, kernel, userTime;
+  GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &userTime);
+  // 100 ns units.
+  *user = (static_cast<quint64>(userTime.dwHighDateTime) << 32
+           | userTime.dwLowDateTime) / 1e7;
+  *system = (static_cast<quint64>(kernel.dwHighDateTime) << 32
+             | kernel.dwLowDateTime) / 1e7;
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  *user = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+  *system = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+qint64 PhaseStats::peakRssKiB()
+{
+#ifdef Q_OS_WIN
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef Q_OS_MAC
+  // Bytes on OS X, KiB elsewhere.
+  return static_cast<qint64>(usage.ru_maxrss / 1024);
+#else
+  return static_cast<qint64>(usage.ru_maxrss);
+#endif
+#endif
+}
@@ -0,0 +1,77 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#ifndef PHASESTATS_H
+#define PHASESTATS_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonObject>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+/**
+ * @brief Measurements for one phase of molequeue-bench.
+ *
+ * Wall time and the CPU time used by the whole process (server and client
+ * threads together) are taken between start() and stop(). Latencies are
+ * added in nanoseconds and reported as percentiles in microseconds.
+ */
+class PhaseStats
+{
+public:
+  explicit PhaseStats(const QString &name = QString());
+
+  QString name() const { return m_name; }
+
+  void start();
+  void stop();
+
+  /// Record a completed operation that took @a nanoseconds.
+  void addLatency(qint64 nanoseconds) { m_latencies.append(nanoseconds); }
+
+  void addError() { ++m_errors; }
+  int errors() const { return m_errors; }
+
+  /// Set a phase specific counter, reported alongside the standard fields.
+  void setCounter(const QString &key, double value);
+
+  void setTimedOut(bool timedOut) { m_timedOut = timedOut; }
+  bool timedOut() const { return m_timedOut; }
+
+  QJsonObject toJson() const;
+
+  /// Get the user and system CPU time used by the process so far, in seconds.
+  static void cpuTimes(double *user, double *system);
+
+  /// @return The peak resident set size of the process so far, in KiB.
+  static qint64 peakRssKiB();
+
+private:
+  QString m_name;
+  QElapsedTimer m_timer;
+  qint64 m_wallNanoseconds;
+  double m_userStart;
+  double m_systemStart;
+  double m_user;
+  double m_system;
+  QVector<qint64> m_latencies;
+  int m_errors;
+  bool m_timedOut;
+  QJsonObject m_counters;
+};
+
+#endif // PHASESTATS_H
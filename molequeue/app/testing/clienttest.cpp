@@ -0,0 +1,299 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "molequeuetestconfig.h"
+
+#include "job.h"
+#include "nullqueue.h"
+#include "program.h"
+#include "queue.h"
+#include "queuemanager.h"
+#include "server.h"
+#include "serverthread.h"
+#include "testing/testserver.h"
+
+#include <molequeue/client/client.h>
+#include <molequeue/client/clientreply.h>
+#include <molequeue/client/jobobject.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonDocument>
+
+using MoleQueue::Client;
+using MoleQueue::ClientReply;
+
+class ClientTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  MoleQueue::Server *m_server;
+  MoleQueue::ServerThread *m_serverThread;
+  QString m_socketName;
+
+  MoleQueue::JobObject testJob(int index) const;
+
+private slots:
+  /// Called before the first test function is executed.
+  void initTestCase();
+  /// Called after the last test function is executed.
+  void cleanupTestCase();
+
+  void testCall();
+  void testServerError();
+  void testSubmitLookupCancel();
+  void testBatching();
+  void testAbort();
+  void testTimeout();
+  void testNotConnected();
+  void benchmarkSubmitJobs();
+};
+
+MoleQueue::JobObject ClientTest::testJob(int index) const
+{
+  MoleQueue::JobObject job;
+  job.setQueue("nullQueue");
+  job.setProgram("testProgram");
+  job.setDescription(QString("ClientTest job %1").arg(index));
+  return job;
+}
+
+void ClientTest::initTestCase()
+{
+  // Change qsettings so that we don't overwrite the installed configuration:
+  QString workDir = MoleQueue_BINARY_DIR "/Testing/Temporary/ClientTest";
+  QDir dir;
+  dir.mkpath(workDir);
+  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+                     workDir + "/config");
+  QSettings settings;
+  settings.setValue("workingDirectoryBase", workDir);
+
+  MoleQueue::QueueManager::registerQueueType("Null", &NullQueue::create);
+
+  m_socketName = TestServer::getRandomSocketName();
+  m_server = new MoleQueue::Server(NULL, m_socketName);
+  MoleQueue::Queue *queue =
+      m_server->queueManager()->addQueue("nullQueue", "Null");
+  QVERIFY(queue);
+  MoleQueue::Program *program = new MoleQueue::Program(queue);
+  program->setName("testProgram");
+  queue->addProgram(program);
+  m_server->start();
+
+  // The server answers from its own thread, as it does in the application.
+  m_serverThread = new MoleQueue::ServerThread(m_server);
+  QVERIFY(m_serverThread->startServer());
+}
+
+void ClientTest::cleanupTestCase()
+{
+  delete m_serverThread;
+  delete m_server;
+}
+
+void ClientTest::testCall()
+{
+  Client client;
+  QVERIFY(client.connectToServer(m_socketName));
+
+  ClientReply *reply = client.call("listQueues");
+  QVERIFY(!reply->isFinished());
+  QSignalSpy finishedSpy(reply, SIGNAL(finished()));
+  QSignalSpy clientSpy(&client, SIGNAL(replyFinished(MoleQueue::ClientReply*)));
+
+  QVERIFY(reply->waitForFinished(5000));
+  QCOMPARE(finishedSpy.count(), 1);
+  QCOMPARE(clientSpy.count(), 1);
+  QCOMPARE(reply->error(), ClientReply::NoError);
+  QCOMPARE(reply->method(), QString("listQueues"));
+  QVERIFY(reply->result().toObject().contains("nullQueue"));
+  delete reply;
+}
+
+void ClientTest::testServerError()
+{
+  Client client;
+  QVERIFY(client.connectToServer(m_socketName));
+
+  QSignalSpy legacySpy(&client, SIGNAL(errorReceived(int,int,QString,
+                                                     QJsonValue)));
+  ClientReply *reply = client.call("notARealMethod");
+  QVERIFY(reply->waitForFinished(5000));
+  QCOMPARE(reply->error(), ClientReply::ServerError);
+  QCOMPARE(reply->errorCode(), -32601);
+  QVERIFY(!reply->errorMessage().isEmpty());
+
+  // Errors for replies are not also reported through the int API.
+  QCOMPARE(legacySpy.count(), 0);
+}
+
+void ClientTest::testSubmitLookupCancel()
+{
+  Client client;
+  QVERIFY(client.connectToServer(m_socketName));
+
+  ClientReply *submit = client.submitJobAsync(testJob(0));
+  QVERIFY(submit->waitForFinished(5000));
+  QCOMPARE(submit->error(), ClientReply::NoError);
+  unsigned int moleQueueId = submit->moleQueueId();
+  QVERIFY(moleQueueId != 0);
+
+  // Pipelined: both are in flight together.
+  ClientReply *lookup = client.lookupJobAsync(moleQueueId);
+  ClientReply *cancel = client.cancelJobAsync(moleQueueId);
+  QVERIFY(cancel->waitForFinished(5000));
+  QVERIFY(lookup->isFinished());
+  QCOMPARE(lookup->error(), ClientReply::NoError);
+  QCOMPARE(lookup->result().toObject().value("description").toString(),
+           QString("ClientTest job 0"));
+  QCOMPARE(cancel->error(), ClientReply::NoError);
+  QCOMPARE(cancel->moleQueueId(), moleQueueId);
+}
+
+void ClientTest::testBatching()
+{
+  MoleQueue::PacketType packet;
+  TestServer server(&packet);
+  Client client;
+  QVERIFY(client.connectToServer(server.socketName()));
+  QVERIFY(server.waitForConnection());
+
+  // Calls made in the same pass of the event loop share a packet.
+  ClientReply *first = client.call("listQueues");
+  ClientReply *second = client.lookupJobAsync(1);
+  ClientReply *third = client.call("listQueues");
+  QVERIFY(server.waitForPacket());
+
+  QJsonDocument doc = QJsonDocument::fromJson(packet);
+  QVERIFY(doc.isArray());
+  QJsonArray batch = doc.array();
+  QCOMPARE(batch.size(), 3);
+  QCOMPARE(static_cast<int>(batch[0].toObject().value("id").toDouble()),
+           first->localId());
+  QCOMPARE(batch[1].toObject().value("method").toString(),
+           QString("lookupJob"));
+  QCOMPARE(static_cast<int>(batch[2].toObject().value("id").toDouble()),
+           third->localId());
+  QVERIFY(first->localId() != second->localId());
+
+  // A single call is sent as a plain request.
+  packet.clear();
+  client.call("listQueues");
+  QVERIFY(server.waitForPacket());
+  QVERIFY(QJsonDocument::fromJson(packet).isObject());
+
+  // flush() sends without waiting for the event loop.
+  packet.clear();
+  client.call("listQueues");
+  client.call("listQueues");
+  client.flush();
+  QVERIFY(server.waitForPacket());
+  QCOMPARE(QJsonDocument::fromJson(packet).array().size(), 2);
+}
+
+void ClientTest::testAbort()
+{
+  MoleQueue::PacketType packet;
+  TestServer server(&packet);
+  Client client;
+  QVERIFY(client.connectToServer(server.socketName()));
+  QVERIFY(server.waitForConnection());
+
+  ClientReply *aborted = client.call("listQueues");
+  ClientReply *kept = client.call("lookupJob");
+  QSignalSpy spy(aborted, SIGNAL(finished()));
+  aborted->abort();
+  QCOMPARE(spy.count(), 1);
+  QVERIFY(aborted->isFinished());
+  QCOMPARE(aborted->error(), ClientReply::CanceledError);
+
+  // The aborted request is never sent.
+  QVERIFY(server.waitForPacket());
+  QJsonObject request = QJsonDocument::fromJson(packet).object();
+  QCOMPARE(static_cast<int>(request.value("id").toDouble()), kept->localId());
+
+  // Aborting after the fact is harmless.
+  kept->abort();
+  kept->abort();
+  QCOMPARE(kept->error(), ClientReply::CanceledError);
+}
+
+void ClientTest::testTimeout()
+{
+  // The test server never answers.
+  MoleQueue::PacketType packet;
+  TestServer server(&packet);
+  Client client;
+  QVERIFY(client.connectToServer(server.socketName()));
+  QVERIFY(server.waitForConnection());
+
+  client.setReplyTimeout(50);
+  ClientReply *reply = client.call("listQueues");
+  QVERIFY(reply->waitForFinished(5000));
+  QCOMPARE(reply->error(), ClientReply::TimeoutError);
+}
+
+void ClientTest::testNotConnected()
+{
+  Client client;
+  ClientReply *reply = client.call("listQueues");
+  QSignalSpy spy(reply, SIGNAL(finished()));
+
+  // Reported from the event loop, after the caller has connected.
+  QVERIFY(!reply->isFinished());
+  QVERIFY(reply->waitForFinished(5000));
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(reply->error(), ClientReply::ConnectionError);
+}
+
+// End-to-end submission throughput: 10k jobs from one client, batched and
+// pipelined, to a server running on its own thread.
+void ClientTest::benchmarkSubmitJobs()
+{
+  const int jobCount = 10000;
+
+  Client client;
+  QVERIFY(client.connectToServer(m_socketName));
+  QSignalSpy spy(&client, SIGNAL(replyFinished(MoleQueue::ClientReply*)));
+
+  QElapsedTimer timer;
+  timer.start();
+
+  QList<ClientReply *> replies;
+  for (int i = 0; i < jobCount; ++i)
+    replies << client.submitJobAsync(testJob(i));
+
+  QTRY_COMPARE_WITH_TIMEOUT(spy.count(), jobCount, 120000);
+  qint64 elapsed = qMax(Q_INT64_C(1), timer.elapsed());
+
+  QSet<unsigned int> ids;
+  foreach (ClientReply *reply, replies) {
+    QCOMPARE(reply->error(), ClientReply::NoError);
+    ids.insert(reply->moleQueueId());
+  }
+  QCOMPARE(ids.size(), jobCount);
+  qDeleteAll(replies);
+
+  qDebug() << "Submitted" << jobCount << "jobs in" << elapsed << "ms:"
+           << jobCount * 1000 / elapsed << "jobs/s";
+}
+
+QTEST_MAIN(ClientTest)
+
+#include "clienttest.moc"
@@ -17,6 +17,7 @@
 #include <QtTest>
 
 #include "queues/uit/compositeiodevice.h"
+#include "queues/uit/mappedfiledevice.h"
 #include "referencestring.h"
 #include "molequeuetestconfig.h"
 
@@ -35,6 +36,9 @@ private slots:
   void testReadBytes();
   void testSize();
   void testUploadPattern();
+  void testSeek();
+  void testEmptyDevices();
+  void testMappedFile();
 
 private:
   MoleQueue::Uit::CompositeIODevice *m_comp;
@@ -155,6 +159,100 @@ void CompositeIODeviceTest::testUploadPattern()
 
 }
 
+void CompositeIODeviceTest::testSeek()
+{
+  QVERIFY(!m_comp->isSequential());
+
+  QVERIFY(m_comp->seek(4));
+  QCOMPARE(m_comp->pos(), Q_INT64_C(4));
+  QCOMPARE(m_comp->bytesAvailable(), Q_INT64_C(2));
+  QCOMPARE(QString(m_comp->readAll()), QString("ef"));
+
+  // Back across a device boundary.
+  QVERIFY(m_comp->seek(1));
+  QCOMPARE(QString(m_comp->read(4)), QString("bcde"));
+
+  // Exactly on a boundary.
+  QVERIFY(m_comp->seek(3));
+  QCOMPARE(QString(m_comp->read(1)), QString("d"));
+
+  // Retrying an upload rewinds the whole stream.
+  QVERIFY(m_comp->reset());
+  QCOMPARE(QString(m_comp->readAll()), QString("abcdef"));
+  QVERIFY(m_comp->reset());
+  QCOMPARE(QString(m_comp->readAll()), QString("abcdef"));
+
+  QVERIFY(!m_comp->seek(7));
+  QVERIFY(!m_comp->seek(-1));
+}
+
+void CompositeIODeviceTest::testEmptyDevices()
+{
+  MoleQueue::Uit::CompositeIODevice composite;
+  composite.open(QIODevice::ReadOnly);
+
+  QBuffer empty1;
+  empty1.open(QIODevice::ReadOnly);
+  QBuffer data;
+  data.setData("xyz");
+  data.open(QIODevice::ReadOnly);
+  QBuffer empty2;
+  empty2.open(QIODevice::ReadOnly);
+
+  composite.addDevice(&empty1);
+  composite.addDevice(&data);
+  composite.addDevice(&empty2);
+
+  QCOMPARE(composite.size(), Q_INT64_C(3));
+  QCOMPARE(QString(composite.readAll()), QString("xyz"));
+  QVERIFY(composite.seek(0));
+  QCOMPARE(QString(composite.read(2)), QString("xy"));
+  QVERIFY(composite.seek(3));
+  QVERIFY(composite.atEnd());
+}
+
+void CompositeIODeviceTest::testMappedFile()
+{
+  QString dir = MoleQueue_BINARY_DIR
+      "/Testing/Temporary/CompositeIODeviceTest";
+  QDir().mkpath(dir);
+
+  QByteArray contents;
+  for (int i = 0; i < 100000; ++i)
+    contents.append(static_cast<char>(i % 251));
+
+  QFile file(dir + "/mapped.bin");
+  QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+  file.write(contents);
+  file.close();
+
+  MoleQueue::Uit::MappedFileDevice mapped(file.fileName());
+  QVERIFY(mapped.open(QIODevice::ReadOnly));
+  QCOMPARE(mapped.size(), static_cast<qint64>(contents.size()));
+  QVERIFY(memcmp(mapped.data(), contents.constData(), contents.size()) == 0);
+
+  m_comp->addDevice(&mapped);
+  QCOMPARE(m_comp->size(), static_cast<qint64>(contents.size() + 6));
+
+  // One large read spanning all the devices.
+  QByteArray all = m_comp->read(m_comp->size());
+  QCOMPARE(all, QByteArray("abcdef") + contents);
+
+  QVERIFY(m_comp->seek(50006));
+  QCOMPARE(m_comp->read(10), contents.mid(50000, 10));
+
+  mapped.close();
+  QVERIFY(mapped.data() == NULL);
+
+  // Empty files need no mapping.
+  QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+  file.close();
+  MoleQueue::Uit::MappedFileDevice empty(file.fileName());
+  QVERIFY(empty.open(QIODevice::ReadOnly));
+  QCOMPARE(empty.size(), Q_INT64_C(0));
+  QVERIFY(empty.readAll().isEmpty());
+}
+
 QTEST_MAIN(CompositeIODeviceTest)
 
 #include "compositeiodevicetest.moc"
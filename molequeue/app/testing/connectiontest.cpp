@@ -0,0 +1,186 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "testing/testserver.h"
+
+#include <molequeue/servercore/localsocketconnection.h>
+#include <molequeue/servercore/localsocketconnectionlistener.h>
+#include <molequeue/servercore/message.h>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+
+using namespace MoleQueue;
+
+Q_DECLARE_METATYPE(MoleQueue::PacketEncoding)
+
+class ConnectionTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  /// A lookupJob-like reply carrying a job with many keywords.
+  Message largeMessage() const;
+
+  LocalSocketConnectionListener *m_listener;
+  LocalSocketConnection *m_client;
+  Connection *m_server;
+
+private slots:
+  void initTestCase();
+  void cleanupTestCase();
+
+  void packetSize_data();
+  void packetSize();
+
+  void benchmarkThroughput_data();
+  void benchmarkThroughput();
+
+protected slots:
+  void newConnection(MoleQueue::Connection *conn);
+};
+
+Message ConnectionTest::largeMessage() const
+{
+  QJsonObject keywords;
+  for (int i = 0; i < 50; ++i)
+    keywords.insert(QString("keyword%1").arg(i), QString("value %1").arg(i));
+
+  QJsonObject job;
+  job.insert("moleQueueId", 1234);
+  job.insert("queue", QString("Some big cluster"));
+  job.insert("program", QString("Quantum chemistry package"));
+  job.insert("jobState", QString("RunningRemote"));
+  job.insert("description", QString("A job with a long description ") +
+             QString(200, QChar('x')));
+  job.insert("numberOfCores", 16);
+  job.insert("maxWallTime", 1440);
+  job.insert("keywords", keywords);
+
+  Message message(Message::Response);
+  message.setId(MessageIdType(17));
+  message.setMethod("lookupJob");
+  message.setResult(job);
+  return message;
+}
+
+void ConnectionTest::initTestCase()
+{
+  qRegisterMetaType<PacketType>("MoleQueue::PacketType");
+  qRegisterMetaType<EndpointIdType>("MoleQueue::EndpointIdType");
+
+  m_server = NULL;
+  QString socketName = TestServer::getRandomSocketName();
+  m_listener = new LocalSocketConnectionListener(this, socketName);
+  connect(m_listener, SIGNAL(newConnection(MoleQueue::Connection*)),
+          this, SLOT(newConnection(MoleQueue::Connection*)));
+  m_listener->start();
+
+  m_client = new LocalSocketConnection(this, socketName);
+  m_client->open();
+  m_client->start();
+
+  QTime timer;
+  timer.start();
+  while (m_server == NULL && timer.elapsed() < 5000)
+    qApp->processEvents(QEventLoop::AllEvents, 100);
+  QVERIFY(m_server != NULL);
+}
+
+void ConnectionTest::cleanupTestCase()
+{
+  m_client->close();
+  m_listener->stop();
+}
+
+void ConnectionTest::newConnection(Connection *conn)
+{
+  m_server = conn;
+  m_server->start();
+}
+
+void ConnectionTest::packetSize_data()
+{
+  QTest::addColumn<PacketEncoding>("encoding");
+  QTest::newRow("json") << JsonEncoding;
+  if (Message::isEncodingSupported(CborEncoding))
+    QTest::newRow("cbor") << CborEncoding;
+}
+
+void ConnectionTest::packetSize()
+{
+  QFETCH(PacketEncoding, encoding);
+  Message message(largeMessage());
+  PacketType packet = message.toPacket(encoding);
+
+  // Wire packets are always smaller than the indented representation.
+  QVERIFY(packet.size() < message.toJson().size());
+  qDebug() << Message::encodingName(encoding) << packet.size() << "bytes,"
+           << "indented JSON" << message.toJson().size() << "bytes";
+
+  QJsonParseError error;
+  QJsonValue decoded = Message::fromPacket(packet, &error);
+  QCOMPARE(error.error, QJsonParseError::NoError);
+  QCOMPARE(decoded.toObject(), message.toJsonObject());
+}
+
+void ConnectionTest::benchmarkThroughput_data()
+{
+  QTest::addColumn<bool>("indented");
+  QTest::addColumn<PacketEncoding>("encoding");
+  QTest::newRow("indented json") << true << JsonEncoding;
+  QTest::newRow("compact json") << false << JsonEncoding;
+  if (Message::isEncodingSupported(CborEncoding))
+    QTest::newRow("cbor") << false << CborEncoding;
+}
+
+void ConnectionTest::benchmarkThroughput()
+{
+  QFETCH(bool, indented);
+  QFETCH(PacketEncoding, encoding);
+  QVERIFY(m_server != NULL);
+
+  const int numPackets = 200;
+  Message message(largeMessage());
+  QSignalSpy spy(m_server, SIGNAL(packetReceived(MoleQueue::PacketType,
+                                                 MoleQueue::EndpointIdType)));
+
+  QBENCHMARK {
+    spy.clear();
+    for (int i = 0; i < numPackets; ++i) {
+      PacketType packet = indented ? message.toJson()
+                                   : message.toPacket(encoding);
+      m_client->send(packet, EndpointIdType());
+    }
+    m_client->flush();
+
+    QTime timer;
+    timer.start();
+    while (spy.size() < numPackets && timer.elapsed() < 10000)
+      qApp->processEvents(QEventLoop::AllEvents, 10);
+  }
+
+  QCOMPARE(spy.size(), numPackets);
+  QJsonValue decoded =
+      Message::fromPacket(spy.last().first().value<PacketType>());
+  QCOMPARE(decoded.toObject(), message.toJsonObject());
+}
+
+QTEST_MAIN(ConnectionTest)
+
+#include "connectiontest.moc"
@@ -21,7 +21,8 @@
 #include <qjsondocument.h>
 
 DummyConnection::DummyConnection(QObject *parent_) :
-  MoleQueue::Connection(parent_)
+  MoleQueue::Connection(parent_),
+  m_bytesToWrite(0)
 {
 }
 
@@ -56,8 +57,9 @@ QString DummyConnection::connectionString() const
 bool DummyConnection::send(const MoleQueue::PacketType &packet,
                            const MoleQueue::EndpointIdType &endpoint)
 {
+  m_lastPacket = packet;
   MoleQueue::Message message(
-        QJsonDocument::fromJson(QByteArray(packet)).object(), this, endpoint);
+        MoleQueue::Message::fromPacket(packet).toObject(), this, endpoint);
   message.parse();
   m_messageQueue.append(message);
   return true;
@@ -50,8 +50,13 @@ public:
   bool send(const MoleQueue::PacketType &packet,
             const MoleQueue::EndpointIdType &endpoint);
   void flush();
+  qint64 bytesToWrite() const { return m_bytesToWrite; }
 
   QList<MoleQueue::Message> m_messageQueue;
+  /// Returned by bytesToWrite(), to simulate a slow peer.
+  qint64 m_bytesToWrite;
+  /// The most recent packet sent.
+  MoleQueue::PacketType m_lastPacket;
 
 };
 
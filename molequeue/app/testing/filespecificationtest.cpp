@@ -16,11 +16,13 @@
 
 #include <QtTest>
 
+#include "blobstore.h"
 #include "filespecification.h"
 #include "molequeuetestconfig.h"
 
 #include <qjsonobject.h>
 
+#include <QtCore/QTemporaryDir>
 #include <QtCore/QTemporaryFile>
 
 using namespace MoleQueue;
@@ -61,6 +63,7 @@ private slots:
   void fileHasExtension();
   void fileBaseName();
   void fileExtension();
+  void blobStore();
 
 };
 
@@ -315,6 +318,69 @@ void FileSpecificationTest::fileExtension()
   QVERIFY(contSpec.fileExtension().isNull());
 }
 
+void FileSpecificationTest::blobStore()
+{
+  QTemporaryDir storeDir;
+  QVERIFY(storeDir.isValid());
+  BlobStore *store = BlobStore::instance();
+  store->setDirectory(storeDir.path());
+  store->setThreshold(16);
+
+  // Small contents stay in memory
+  FileSpecification smallSpec("small.in", "contents\n");
+  QVERIFY(!smallSpec.isStored());
+  QCOMPARE(smallSpec.toJsonObject()["contents"].toString(),
+           QString("contents\n"));
+
+  // Large contents are spilled and referenced by hash
+  QString content("I'm a rather large input file, honest!\n");
+  FileSpecification spec("large.in", content);
+  QVERIFY(spec.isStored());
+  QCOMPARE(spec.format(), FileSpecification::ContentsFileSpecification);
+  QCOMPARE(spec.contentsHash(), BlobStore::hash(content.toLocal8Bit()));
+  QVERIFY(store->contains(spec.contentsHash()));
+  QCOMPARE(spec.contents(), content);
+
+  QJsonObject json = spec.toJsonObject();
+  QVERIFY(!json.contains("contents"));
+  QCOMPARE(json["contentsHash"].toString(), spec.contentsHash());
+  QCOMPARE(static_cast<int>(json["contentsSize"].toDouble()), content.size());
+
+  QJsonObject inlined = spec.toJsonObject(true);
+  QCOMPARE(inlined["filename"].toString(), QString("large.in"));
+  QCOMPARE(inlined["contents"].toString(), content);
+  QVERIFY(!inlined.contains("contentsHash"));
+
+  // Round trip through the reference, and spill on receipt of inline JSON
+  FileSpecification fromRef(json);
+  QCOMPARE(fromRef.contents(), content);
+  FileSpecification fromInline(inlined);
+  QVERIFY(fromInline.isStored());
+  QCOMPARE(fromInline.contentsHash(), spec.contentsHash());
+
+  // Write out the stored contents
+  QTemporaryDir outDir;
+  QVERIFY(spec.writeFile(QDir(outDir.path())));
+  QFile outFile(outDir.path() + "/large.in");
+  QVERIFY(outFile.open(QFile::ReadOnly | QFile::Text));
+  QCOMPARE(QString(outFile.readAll()), content);
+  outFile.close();
+
+  // Large files are streamed into the store
+  QFile largeFile(outDir.path() + "/large.in");
+  FileSpecification fileSpec(&largeFile,
+                             FileSpecification::ContentsFileSpecification);
+  QVERIFY(fileSpec.isStored());
+  QCOMPARE(fileSpec.contentsHash(), spec.contentsHash());
+
+  // Unreferenced blobs are removed
+  store->removeUnreferenced(QSet<QString>());
+  QVERIFY(!store->contains(spec.contentsHash()));
+
+  store->setDirectory(QString());
+  store->setThreshold(DEFAULT_BLOB_THRESHOLD);
+}
+
 QTEST_MAIN(FileSpecificationTest)
 
 #include "filespecificationtest.moc"
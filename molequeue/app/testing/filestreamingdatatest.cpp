@@ -15,7 +15,6 @@
  ******************************************************************************/
 
 #include <QtTest>
-#include <QtXmlPatterns/QXmlQuery>
 
 #include "queues/uit/filestreamingdata.h"
 #include "referencestring.h"
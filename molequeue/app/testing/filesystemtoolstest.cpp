@@ -0,0 +1,276 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "directoryoperation.h"
+#include "filesystemtools.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+using namespace MoleQueue;
+
+class FileSystemToolsTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  /// Create @a numFiles small files spread over @a numDirs subdirectories of
+  /// @a path.
+  void createTree(const QString &path, int numDirs, int numFiles);
+
+  /// @return Sorted, relative paths of all files below @a path.
+  QStringList listTree(const QString &path);
+
+  QTemporaryDir *m_tmpDir;
+
+private slots:
+  /// Called before each test function is executed.
+  void init();
+  /// Called after every test function.
+  void cleanup();
+
+  void copyFile();
+  void recursiveCopyDirectory();
+  void recursiveRemoveDirectory();
+  void asyncCopy();
+  void asyncRemove();
+  void asyncRemoveContentsOnly();
+  void asyncCancel();
+
+  void benchmarkSyncCopy();
+  void benchmarkAsyncCopy();
+};
+
+void FileSystemToolsTest::createTree(const QString &path, int numDirs,
+                                     int numFiles)
+{
+  QDir dir(path);
+  for (int i = 0; i < numDirs; ++i)
+    QVERIFY(dir.mkpath(QString("dir%1/sub").arg(i)));
+
+  for (int i = 0; i < numFiles; ++i) {
+    QString fileName = (numDirs > 0)
+        ? QString("dir%1/sub/file%2.out").arg(i % numDirs).arg(i)
+        : QString("file%1.out").arg(i);
+    QFile file(dir.absoluteFilePath(fileName));
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write(QString("Output of file %1\n").arg(i).toLatin1());
+  }
+}
+
+QStringList FileSystemToolsTest::listTree(const QString &path)
+{
+  QStringList result;
+  QDir dir(path);
+  QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::System,
+                  QDirIterator::Subdirectories);
+  while (it.hasNext())
+    result << dir.relativeFilePath(it.next());
+  result.sort();
+  return result;
+}
+
+void FileSystemToolsTest::init()
+{
+  m_tmpDir = new QTemporaryDir;
+  QVERIFY(m_tmpDir->isValid());
+}
+
+void FileSystemToolsTest::cleanup()
+{
+  delete m_tmpDir;
+  m_tmpDir = NULL;
+}
+
+void FileSystemToolsTest::copyFile()
+{
+  QString source = m_tmpDir->path() + "/source.txt";
+  QString target = m_tmpDir->path() + "/target.txt";
+  QFile file(source);
+  QVERIFY(file.open(QFile::WriteOnly));
+  file.write("I'm output file text!\n");
+  file.close();
+
+  QVERIFY(FileSystemTools::copyFile(source, target));
+  QFile copy(target);
+  QVERIFY(copy.open(QFile::ReadOnly));
+  QCOMPARE(copy.readAll(), QByteArray("I'm output file text!\n"));
+  copy.close();
+
+  // Existing targets are not overwritten.
+  QVERIFY(!FileSystemTools::copyFile(source, target));
+  // Missing sources fail.
+  QVERIFY(!FileSystemTools::copyFile(source + ".missing", target + ".new"));
+  QVERIFY(!QFile::exists(target + ".new"));
+}
+
+void FileSystemToolsTest::recursiveCopyDirectory()
+{
+  QString source = m_tmpDir->path() + "/source";
+  QString target = m_tmpDir->path() + "/target";
+  createTree(source, 4, 40);
+
+  QVERIFY(FileSystemTools::recursiveCopyDirectory(source, target));
+  QCOMPARE(listTree(target), listTree(source));
+}
+
+void FileSystemToolsTest::recursiveRemoveDirectory()
+{
+  QString source = m_tmpDir->path() + "/source";
+  createTree(source, 4, 40);
+
+  QVERIFY(FileSystemTools::recursiveRemoveDirectory(source, true));
+  QVERIFY(QDir(source).exists());
+  QCOMPARE(QDir(source).entryList(QDir::NoDotAndDotDot | QDir::AllEntries),
+           QStringList());
+
+  QVERIFY(FileSystemTools::recursiveRemoveDirectory(source));
+  QVERIFY(!QDir(source).exists());
+}
+
+void FileSystemToolsTest::asyncCopy()
+{
+  QString source = m_tmpDir->path() + "/source";
+  QString target = m_tmpDir->path() + "/target";
+  createTree(source, 8, 500);
+
+  DirectoryOperation *op = DirectoryOperation::copyDirectory(source, target);
+  QSignalSpy progressSpy(op, SIGNAL(progress(int,int)));
+  QSignalSpy finishedSpy(op, SIGNAL(finished(bool)));
+  op->start();
+  QVERIFY(op->isRunning());
+
+  QTRY_COMPARE(finishedSpy.size(), 1);
+  QCOMPARE(finishedSpy.first().first().toBool(), true);
+  QVERIFY(!op->isRunning());
+  QVERIFY(progressSpy.size() > 0);
+  QCOMPARE(progressSpy.last().at(0).toInt(), 500);
+  QCOMPARE(progressSpy.last().at(1).toInt(), 500);
+  QCOMPARE(op->filesProcessed(), 500);
+  QCOMPARE(listTree(target), listTree(source));
+  delete op;
+
+  // Missing source directory
+  op = DirectoryOperation::copyDirectory(source + "/missing", target + "2");
+  QSignalSpy failedSpy(op, SIGNAL(finished(bool)));
+  op->start();
+  QTRY_COMPARE(failedSpy.size(), 1);
+  QCOMPARE(failedSpy.first().first().toBool(), false);
+  QVERIFY(!op->errorString().isEmpty());
+  delete op;
+}
+
+void FileSystemToolsTest::asyncRemove()
+{
+  QString source = m_tmpDir->path() + "/source";
+  createTree(source, 8, 500);
+
+  DirectoryOperation *op = DirectoryOperation::removeDirectory(source);
+  QSignalSpy finishedSpy(op, SIGNAL(finished(bool)));
+  op->start();
+
+  QTRY_COMPARE(finishedSpy.size(), 1);
+  QCOMPARE(finishedSpy.first().first().toBool(), true);
+  QVERIFY(!QDir(source).exists());
+  delete op;
+
+  // Removing a missing directory is not an error.
+  op = DirectoryOperation::removeDirectory(source);
+  QSignalSpy missingSpy(op, SIGNAL(finished(bool)));
+  op->start();
+  QTRY_COMPARE(missingSpy.size(), 1);
+  QCOMPARE(missingSpy.first().first().toBool(), true);
+  delete op;
+}
+
+void FileSystemToolsTest::asyncRemoveContentsOnly()
+{
+  QString source = m_tmpDir->path() + "/source";
+  createTree(source, 8, 100);
+
+  DirectoryOperation *op = DirectoryOperation::removeDirectory(source, true);
+  QSignalSpy finishedSpy(op, SIGNAL(finished(bool)));
+  op->start();
+
+  QTRY_COMPARE(finishedSpy.size(), 1);
+  QCOMPARE(finishedSpy.first().first().toBool(), true);
+  QVERIFY(QDir(source).exists());
+  QCOMPARE(QDir(source).entryList(QDir::NoDotAndDotDot | QDir::AllEntries),
+           QStringList());
+  delete op;
+}
+
+void FileSystemToolsTest::asyncCancel()
+{
+  QString source = m_tmpDir->path() + "/source";
+  QString target = m_tmpDir->path() + "/target";
+  createTree(source, 8, 2000);
+
+  DirectoryOperation *op = DirectoryOperation::copyDirectory(source, target);
+  QSignalSpy finishedSpy(op, SIGNAL(finished(bool)));
+  op->start();
+  op->cancel();
+  QVERIFY(op->isCanceled());
+
+  QTRY_COMPARE(finishedSpy.size(), 1);
+  QCOMPARE(finishedSpy.first().first().toBool(), false);
+  QVERIFY(op->filesProcessed() <= 2000);
+  delete op;
+
+  // Deleting a running operation must be safe.
+  op = DirectoryOperation::copyDirectory(source, target + "2");
+  op->start();
+  delete op;
+}
+
+void FileSystemToolsTest::benchmarkSyncCopy()
+{
+  QString source = m_tmpDir->path() + "/source";
+  createTree(source, 100, 10000);
+
+  int iteration = 0;
+  QBENCHMARK {
+    QString target = QString("%1/target%2").arg(m_tmpDir->path())
+        .arg(iteration++);
+    QVERIFY(FileSystemTools::recursiveCopyDirectory(source, target));
+  }
+}
+
+void FileSystemToolsTest::benchmarkAsyncCopy()
+{
+  QString source = m_tmpDir->path() + "/source";
+  createTree(source, 100, 10000);
+
+  int iteration = 0;
+  QBENCHMARK {
+    QString target = QString("%1/target%2").arg(m_tmpDir->path())
+        .arg(iteration++);
+    DirectoryOperation *op = DirectoryOperation::copyDirectory(source, target);
+    QSignalSpy finishedSpy(op, SIGNAL(finished(bool)));
+    op->start();
+    QVERIFY(finishedSpy.wait(60000));
+    QCOMPARE(finishedSpy.first().first().toBool(), true);
+    delete op;
+  }
+}
+
+QTEST_MAIN(FileSystemToolsTest)
+
+#include "filesystemtoolstest.moc"
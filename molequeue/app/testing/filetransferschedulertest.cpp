@@ -0,0 +1,346 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "queues/uit/filetransferscheduler.h"
+
+#include "molequeuetestconfig.h"
+
+#include <QtCore/QPointer>
+#include <QtCore/QXmlStreamReader>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+using MoleQueue::Uit::FileStreamingData;
+using MoleQueue::Uit::FileTransferScheduler;
+
+/// Minimal HTTP stand-in for the UIT streaming endpoint. Uploads are stored by
+/// remote file name and answered with "DONE", downloads return the stored
+/// contents. Responses are delayed so that concurrent requests overlap.
+class StreamingEndpoint : public QTcpServer
+{
+  Q_OBJECT
+public:
+  StreamingEndpoint()
+    : m_responseDelay(20), m_inFlight(0), m_maxInFlight(0)
+  {
+    connect(this, SIGNAL(newConnection()), SLOT(acceptConnection()));
+  }
+
+  QUrl url() const
+  {
+    return QUrl(QString("http://127.0.0.1:%1/").arg(serverPort()));
+  }
+
+  /// Remote file name -> contents.
+  QHash<QString, QByteArray> files;
+  /// Remote file name -> number of requests still to answer with an error.
+  QHash<QString, int> failures;
+
+  int maxInFlight() const { return m_maxInFlight; }
+  void resetMaxInFlight() { m_maxInFlight = 0; }
+
+private slots:
+  void acceptConnection()
+  {
+    while (QTcpSocket *socket = nextPendingConnection())
+      connect(socket, SIGNAL(readyRead()), SLOT(readRequest()));
+  }
+
+  void readRequest()
+  {
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    // Connections are kept alive, so one buffer may hold several requests.
+    forever {
+      int headerEnd = buffer.indexOf("\r\n\r\n");
+      if (headerEnd < 0)
+        return;
+
+      int contentLength = 0;
+      foreach (const QByteArray &line, buffer.left(headerEnd).split('\n')) {
+        if (line.toLower().startsWith("content-length:"))
+          contentLength = line.mid(15).trimmed().toInt();
+      }
+      if (buffer.size() < headerEnd + 4 + contentLength)
+        return;
+
+      QByteArray body = buffer.mid(headerEnd + 4, contentLength);
+      buffer.remove(0, headerEnd + 4 + contentLength);
+
+      ++m_inFlight;
+      m_maxInFlight = qMax(m_maxInFlight, m_inFlight);
+      m_responses.enqueue(qMakePair(QPointer<QTcpSocket>(socket),
+                                    handle(body)));
+      QTimer::singleShot(m_responseDelay, this, SLOT(sendResponse()));
+    }
+  }
+
+  void sendResponse()
+  {
+    QPair<QPointer<QTcpSocket>, QByteArray> response = m_responses.dequeue();
+    --m_inFlight;
+    if (response.first)
+      response.first->write(response.second);
+  }
+
+private:
+  QByteArray handle(const QByteArray &body)
+  {
+    // "<xml size>|<xml>" followed by "<file size>|<contents>" for uploads.
+    int separator = body.indexOf('|');
+    int xmlSize = body.left(separator).toInt();
+    QByteArray xml = body.mid(separator + 1, xmlSize);
+    QByteArray rest = body.mid(separator + 1 + xmlSize);
+
+    QString fileName;
+    QXmlStreamReader reader(xml);
+    while (reader.readNextStartElement()) {
+      if (reader.name() == "filename")
+        fileName = reader.readElementText();
+      else if (reader.name() != "FileStreamingData")
+        reader.skipCurrentElement();
+    }
+
+    if (failures.value(fileName) > 0) {
+      --failures[fileName];
+      return "HTTP/1.1 500 Internal Server Error\r\n"
+             "Content-Length: 0\r\n\r\n";
+    }
+
+    QByteArray content;
+    if (rest.isEmpty()) {
+      content = files.value(fileName);
+    }
+    else {
+      files.insert(fileName, rest.mid(rest.indexOf('|') + 1));
+      content = "DONE";
+    }
+
+    return "HTTP/1.1 200 OK\r\nContent-Length: "
+        + QByteArray::number(content.size()) + "\r\n\r\n" + content;
+  }
+
+  int m_responseDelay;
+  int m_inFlight;
+  int m_maxInFlight;
+  QHash<QTcpSocket *, QByteArray> m_buffers;
+  QQueue<QPair<QPointer<QTcpSocket>, QByteArray> > m_responses;
+};
+
+class FileTransferSchedulerTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  StreamingEndpoint m_endpoint;
+  QString m_workDir;
+
+  FileStreamingData remoteFile(const QString &name) const;
+  QByteArray fileContents(int index) const;
+
+private slots:
+  /// Called before the first test function is executed.
+  void initTestCase();
+
+  void testUpload();
+  void testDownload();
+  void testRetry();
+  void testRetryExhausted();
+  void testDeviceTransfers();
+};
+
+FileStreamingData FileTransferSchedulerTest::remoteFile(
+    const QString &name) const
+{
+  FileStreamingData fileData;
+  fileData.setToken("TOKENDATA");
+  fileData.setFileName("/remote/" + name);
+  fileData.setHostID(1);
+  fileData.setUserName("username");
+  return fileData;
+}
+
+QByteArray FileTransferSchedulerTest::fileContents(int index) const
+{
+  // Include one file large enough to arrive in several chunks.
+  if (index == 0)
+    return QByteArray(1024 * 1024, 'x');
+  return QByteArray::number(index).repeated(index * 100);
+}
+
+void FileTransferSchedulerTest::initTestCase()
+{
+  m_workDir = MoleQueue_BINARY_DIR
+      "/Testing/Temporary/FileTransferSchedulerTest";
+  QDir dir;
+  dir.mkpath(m_workDir + "/upload");
+  dir.mkpath(m_workDir + "/download");
+
+  for (int i = 0; i < 12; ++i) {
+    QFile file(m_workDir + QString("/upload/file%1").arg(i));
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+    file.write(fileContents(i));
+  }
+
+  QVERIFY(m_endpoint.listen(QHostAddress::LocalHost));
+}
+
+void FileTransferSchedulerTest::testUpload()
+{
+  FileTransferScheduler scheduler;
+  scheduler.setUrl(m_endpoint.url());
+  scheduler.setMaxConcurrentTransfers(3);
+  QSignalSpy progressSpy(&scheduler, SIGNAL(progress(int,int,qint64)));
+  QSignalSpy finishedSpy(&scheduler, SIGNAL(finished()));
+
+  qint64 totalBytes = 0;
+  for (int i = 0; i < 12; ++i) {
+    scheduler.addUpload(m_workDir + QString("/upload/file%1").arg(i),
+                        remoteFile(QString("file%1").arg(i)));
+    totalBytes += fileContents(i).size();
+  }
+  scheduler.close();
+
+  QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+
+  for (int i = 0; i < 12; ++i) {
+    QCOMPARE(m_endpoint.files.value(QString("/remote/file%1").arg(i)),
+             fileContents(i));
+  }
+
+  // Bounded, but actually concurrent.
+  QVERIFY(m_endpoint.maxInFlight() <= 3);
+  QVERIFY(m_endpoint.maxInFlight() > 1);
+
+  QCOMPARE(progressSpy.count(), 12);
+  QList<QVariant> last = progressSpy.last();
+  QCOMPARE(last.at(0).toInt(), 12);
+  QCOMPARE(last.at(1).toInt(), 12);
+  QCOMPARE(last.at(2).toLongLong(), totalBytes);
+  QCOMPARE(scheduler.filesTransferred(), 12);
+  QCOMPARE(scheduler.bytesTransferred(), totalBytes);
+  QCOMPARE(scheduler.retryCount(), 0);
+  QVERIFY(scheduler.throughput() > 0.0);
+}
+
+void FileTransferSchedulerTest::testDownload()
+{
+  m_endpoint.resetMaxInFlight();
+
+  FileTransferScheduler scheduler;
+  scheduler.setUrl(m_endpoint.url());
+  QSignalSpy finishedSpy(&scheduler, SIGNAL(finished()));
+
+  for (int i = 0; i < 12; ++i) {
+    scheduler.addDownload(remoteFile(QString("file%1").arg(i)),
+                          m_workDir + QString("/download/file%1").arg(i));
+  }
+  scheduler.close();
+
+  QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+
+  for (int i = 0; i < 12; ++i) {
+    QFile file(m_workDir + QString("/download/file%1").arg(i));
+    QVERIFY(file.open(QFile::ReadOnly));
+    QCOMPARE(file.readAll(), fileContents(i));
+  }
+
+  QVERIFY(m_endpoint.maxInFlight() <= scheduler.maxConcurrentTransfers());
+  QCOMPARE(scheduler.filesTransferred(), 12);
+}
+
+void FileTransferSchedulerTest::testRetry()
+{
+  m_endpoint.files.remove("/remote/file3");
+  m_endpoint.failures.insert("/remote/file3", 2);
+
+  FileTransferScheduler scheduler;
+  scheduler.setUrl(m_endpoint.url());
+  scheduler.setMaxAttempts(3);
+  QSignalSpy finishedSpy(&scheduler, SIGNAL(finished()));
+  QSignalSpy errorSpy(&scheduler, SIGNAL(error(QString)));
+
+  scheduler.addUpload(m_workDir + "/upload/file3", remoteFile("file3"));
+  scheduler.addUpload(m_workDir + "/upload/file4", remoteFile("file4"));
+  scheduler.close();
+
+  QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+  QCOMPARE(errorSpy.count(), 0);
+  QCOMPARE(scheduler.retryCount(), 2);
+  QCOMPARE(m_endpoint.files.value("/remote/file3"), fileContents(3));
+}
+
+void FileTransferSchedulerTest::testRetryExhausted()
+{
+  m_endpoint.failures.insert("/remote/file5", 5);
+
+  FileTransferScheduler scheduler;
+  scheduler.setUrl(m_endpoint.url());
+  scheduler.setMaxAttempts(2);
+  QSignalSpy finishedSpy(&scheduler, SIGNAL(finished()));
+  QSignalSpy errorSpy(&scheduler, SIGNAL(error(QString)));
+
+  scheduler.addDownload(remoteFile("file5"), m_workDir + "/download/file5");
+  scheduler.close();
+
+  QTRY_COMPARE_WITH_TIMEOUT(errorSpy.count(), 1, 10000);
+  QCOMPARE(finishedSpy.count(), 0);
+  QCOMPARE(scheduler.retryCount(), 1);
+  QCOMPARE(m_endpoint.failures.value("/remote/file5"), 3);
+
+  m_endpoint.failures.clear();
+}
+
+void FileTransferSchedulerTest::testDeviceTransfers()
+{
+  QByteArray contents = fileContents(7);
+  m_endpoint.failures.insert("/remote/device", 1);
+
+  FileTransferScheduler scheduler;
+  scheduler.setUrl(m_endpoint.url());
+  QSignalSpy finishedSpy(&scheduler, SIGNAL(finished()));
+
+  // The source is rewound for the retry.
+  QBuffer source(&contents);
+  scheduler.addUpload(&source, remoteFile("device"));
+  scheduler.close();
+
+  QTRY_COMPARE_WITH_TIMEOUT(finishedSpy.count(), 1, 10000);
+  QCOMPARE(scheduler.retryCount(), 1);
+  QCOMPARE(m_endpoint.files.value("/remote/device"), contents);
+
+  FileTransferScheduler downloader;
+  downloader.setUrl(m_endpoint.url());
+  QSignalSpy downloadedSpy(&downloader, SIGNAL(finished()));
+
+  QBuffer sink;
+  downloader.addDownload(remoteFile("device"), &sink);
+  downloader.close();
+
+  QTRY_COMPARE_WITH_TIMEOUT(downloadedSpy.count(), 1, 10000);
+  QVERIFY(!sink.isOpen());
+  QCOMPARE(sink.data(), contents);
+  QCOMPARE(downloader.bytesTransferred(),
+           static_cast<qint64>(contents.size()));
+}
+
+QTEST_MAIN(FileTransferSchedulerTest)
+
+#include "filetransferschedulertest.moc"
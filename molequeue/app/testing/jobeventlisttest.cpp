@@ -15,8 +15,6 @@
  ******************************************************************************/
 
 #include <QtTest>
-#include <QtXmlPatterns/QXmlQuery>
-#include <QtXmlPatterns/QAbstractXmlReceiver>
 #include <QtCore/QList>
 #include "queues/queueuit.h"
 
@@ -38,7 +36,9 @@ private slots:
   void testFromXmlWithJobId();
   void testFromXmlWithJobIdsUser();
   void testFromXmlWithJobIds();
-
+  void testMalformedXml();
+  void benchmarkFromXml_data();
+  void benchmarkFromXml();
 
 private:
   QString m_jobEventXml;
@@ -122,6 +122,60 @@ void JobEventTest::testFromXmlWithJobIds()
   QCOMPARE(list.jobEvents().size(),  3);
 }
 
+void JobEventTest::testMalformedXml()
+{
+  QString xml = m_jobEventXml;
+  xml.remove(xml.lastIndexOf("</list>"), 7);
+
+  MoleQueue::Uit::JobEventList list
+    = MoleQueue::Uit::JobEventList::fromXml(xml);
+
+  QVERIFY(!list.isValid());
+}
+
+void JobEventTest::benchmarkFromXml_data()
+{
+  QTest::addColumn<int>("eventCount");
+  QTest::addColumn<bool>("filtered");
+
+  QTest::newRow("1000 events") << 1000 << false;
+  QTest::newRow("1000 events, 10 jobs") << 1000 << true;
+  QTest::newRow("20000 events") << 20000 << false;
+  QTest::newRow("20000 events, 10 jobs") << 20000 << true;
+}
+
+void JobEventTest::benchmarkFromXml()
+{
+  QFETCH(int, eventCount);
+  QFETCH(bool, filtered);
+
+  // A day of activity on a busy host: many users, one event per job.
+  QString eventTemplate
+    = ReferenceString("jobeventlist-ref/jobevent-template.xml");
+  QString xml("<list>\n");
+  xml.reserve(eventTemplate.size() * eventCount + 16);
+  for (int i = 0; i < eventCount; ++i)
+    xml += eventTemplate.arg(200000 + i).arg(QString("user%1").arg(i % 50));
+  xml += "</list>\n";
+
+  QList<qint64> jobIds;
+  if (filtered) {
+    // The jobs of "user0".
+    for (int i = 0; i < 10; ++i)
+      jobIds << 200000 + i * 50;
+  }
+  QString userName(filtered ? "user0" : "");
+
+  MoleQueue::Uit::JobEventList list;
+  QBENCHMARK {
+    list = MoleQueue::Uit::JobEventList::fromXml(xml, userName, jobIds);
+  }
+
+  QVERIFY(list.isValid());
+  QCOMPARE(list.jobEvents().size(), filtered ? 10 : eventCount);
+  QCOMPARE(list.jobEvents().first().jobId(), static_cast<qint64>(200000));
+}
+
 QTEST_MAIN(JobEventTest)
 
 #include "jobeventlisttest.moc"
@@ -0,0 +1,175 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "jobitemmodel.h"
+
+#include "molequeuetestconfig.h"
+
+#include "job.h"
+#include "jobmanager.h"
+#include "jobtableproxymodel.h"
+
+using MoleQueue::Job;
+using MoleQueue::JobItemModel;
+
+class JobItemModelTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  MoleQueue::JobManager m_jobManager;
+  JobItemModel m_model;
+  QList<Job> m_jobs;
+
+private slots:
+  /// Called before the first test function is executed.
+  void initTestCase();
+
+  // Set MoleQueue id to the current count()+1
+  void setNewJobIds(MoleQueue::Job);
+
+  void testAddJobs();
+  void testDataChangedRanges();
+  void testRemoveJobs();
+  void testProxyFilter();
+};
+
+void JobItemModelTest::initTestCase()
+{
+  // The proxy model saves its filter in QSettings.
+  QString workDir = MoleQueue_BINARY_DIR "/Testing/Temporary/JobItemModelTest";
+  QDir dir;
+  dir.mkpath(workDir);
+  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+                     workDir + "/config");
+
+  connect(&m_jobManager, SIGNAL(jobAboutToBeAdded(MoleQueue::Job)),
+          this, SLOT(setNewJobIds(MoleQueue::Job)),
+          Qt::DirectConnection);
+  m_model.setJobManager(&m_jobManager);
+}
+
+void JobItemModelTest::setNewJobIds(MoleQueue::Job job)
+{
+  job.setMoleQueueId(static_cast<MoleQueue::IdType>(m_jobManager.count() + 1));
+}
+
+void JobItemModelTest::testAddJobs()
+{
+  QSignalSpy spy(&m_model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+  for (int i = 0; i < 10; ++i) {
+    Job job = m_jobManager.newJob();
+    job.setJobState(MoleQueue::Accepted);
+    job.setQueue(i % 2 == 0 ? "evenQueue" : "oddQueue");
+    m_jobs << job;
+  }
+
+  // All new jobs arrive in one batch.
+  QTRY_COMPARE(m_model.rowCount(), 10);
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(m_model.data(m_model.index(3, JobItemModel::MOLEQUEUE_ID)),
+           QVariant(m_jobs.at(3).moleQueueId()));
+  QCOMPARE(m_model.jobState(3), MoleQueue::Accepted);
+  QVERIFY(m_model.filterText(3).contains("oddqueue"));
+}
+
+void JobItemModelTest::testDataChangedRanges()
+{
+  QSignalSpy spy(&m_model, SIGNAL(dataChanged(QModelIndex,QModelIndex)));
+
+  m_jobs[2].setJobState(MoleQueue::RunningLocal);
+  m_jobs[3].setJobState(MoleQueue::RunningLocal);
+  m_jobs[4].setJobState(MoleQueue::RunningLocal);
+  m_jobs[3].setJobState(MoleQueue::Finished);
+  m_jobs[7].setJobState(MoleQueue::Error);
+
+  // Rows 2-4 and row 7, state column only.
+  QTRY_COMPARE(spy.count(), 2);
+  QModelIndex topLeft = spy.at(0).at(0).value<QModelIndex>();
+  QModelIndex bottomRight = spy.at(0).at(1).value<QModelIndex>();
+  QCOMPARE(topLeft.row(), 2);
+  QCOMPARE(bottomRight.row(), 4);
+  QCOMPARE(topLeft.column(), static_cast<int>(JobItemModel::JOB_STATE));
+  QCOMPARE(bottomRight.column(), static_cast<int>(JobItemModel::JOB_STATE));
+  topLeft = spy.at(1).at(0).value<QModelIndex>();
+  bottomRight = spy.at(1).at(1).value<QModelIndex>();
+  QCOMPARE(topLeft.row(), 7);
+  QCOMPARE(bottomRight.row(), 7);
+
+  QCOMPARE(m_model.data(m_model.index(3, JobItemModel::JOB_STATE)).toString(),
+           MoleQueue::jobStateToGuiString(MoleQueue::Finished));
+  QCOMPARE(m_model.jobState(3), MoleQueue::Finished);
+
+  // Changes that end where they started are not reported.
+  spy.clear();
+  m_jobs[5].setQueue("otherQueue");
+  m_jobs[5].setQueue("oddQueue");
+  QTest::qWait(50);
+  QCOMPARE(spy.count(), 0);
+}
+
+void JobItemModelTest::testRemoveJobs()
+{
+  QSignalSpy spy(&m_model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+  // Two ranges: rows 5-6 and row 8.
+  QList<Job> jobsToRemove;
+  jobsToRemove << m_jobs.at(8) << m_jobs.at(5) << m_jobs.at(6);
+  m_jobManager.removeJobs(jobsToRemove);
+  m_jobs.removeAt(8);
+  m_jobs.removeAt(6);
+  m_jobs.removeAt(5);
+
+  QTRY_COMPARE(m_model.rowCount(), 7);
+  QCOMPARE(spy.count(), 2);
+
+  for (int row = 0; row < m_model.rowCount(); ++row) {
+    QCOMPARE(m_model.data(m_model.index(row, JobItemModel::MOLEQUEUE_ID)),
+             QVariant(m_jobs.at(row).moleQueueId()));
+  }
+}
+
+void JobItemModelTest::testProxyFilter()
+{
+  MoleQueue::JobTableProxyModel proxy;
+  proxy.setFilterString(QString());
+  proxy.setShowStatusFinished(true);
+  proxy.setShowStatusError(true);
+  proxy.setShowHiddenJobs(true);
+  proxy.setDynamicSortFilter(true);
+  proxy.setSourceModel(&m_model);
+  QCOMPARE(proxy.rowCount(), 7);
+
+  proxy.setShowStatusFinished(false);
+  QCOMPARE(proxy.rowCount(), 6);
+
+  proxy.setFilterString("EVENQUEUE");
+  QCOMPARE(proxy.rowCount(), 3);
+
+  proxy.setFilterString("-evenqueue -error");
+  QCOMPARE(proxy.rowCount(), 2);
+
+  // Only the changed row is re-filtered.
+  proxy.setFilterString(QString());
+  m_jobs[0].setJobState(MoleQueue::Finished);
+  QTRY_COMPARE(proxy.rowCount(), 5);
+}
+
+QTEST_MAIN(JobItemModelTest)
+
+#include "jobitemmodeltest.moc"
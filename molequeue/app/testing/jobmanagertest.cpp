@@ -17,6 +17,7 @@
 #include "jobmanager.h"
 
 #include "job.h"
+#include "jobfilter.h"
 
 #include <QtTest>
 
@@ -44,6 +45,12 @@ private slots:
 
   void testJobAboutToBeAdded();
   void testLookupMoleQueueId();
+  void testFindJobs();
+  void testJobOwners();
+  void testStaleReferences();
+  void testInputFileHashes();
+  void testJsonProjection();
+  void benchmarkJobAccessors();
 
 };
 
@@ -99,6 +106,212 @@ void JobManagerTest::testLookupMoleQueueId()
   QCOMPARE(job2, lookupJob2);
 }
 
+void JobManagerTest::testFindJobs()
+{
+  // Jobs 3-22, alternating between two queues.
+  QList<Job> jobs;
+  for (int i = 0; i < 20; ++i) {
+    Job job = m_jobManager.newJob();
+    job.setQueue(i % 2 == 0 ? "even" : "odd");
+    job.setJobState(i < 5 ? MoleQueue::Finished : MoleQueue::RunningLocal);
+    jobs << job;
+  }
+
+  QCOMPARE(m_jobManager.jobsWithJobState(MoleQueue::Finished).size(), 5);
+  QCOMPARE(m_jobManager.jobsWithJobState(MoleQueue::RunningLocal).size(), 15);
+
+  MoleQueue::JobFilter filter;
+  filter.queues.insert("even");
+  QCOMPARE(m_jobManager.findJobs(filter).size(), 10);
+
+  filter.states.insert(MoleQueue::Finished);
+  QList<Job> result = m_jobManager.findJobs(filter);
+  QCOMPARE(result.size(), 3);
+  QCOMPARE(result[0], jobs[0]);
+  QCOMPARE(result[1], jobs[2]);
+  QCOMPARE(result[2], jobs[4]);
+
+  // Pages
+  bool more = false;
+  filter.states.clear();
+  result = m_jobManager.findJobs(filter, 0, 4, &more);
+  QCOMPARE(result.size(), 4);
+  QVERIFY(more);
+  QCOMPARE(result.last(), jobs[6]);
+  result = m_jobManager.findJobs(filter, result.last().moleQueueId(), 4, &more);
+  QCOMPARE(result.size(), 4);
+  QCOMPARE(result.first(), jobs[8]);
+  result = m_jobManager.findJobs(filter, result.last().moleQueueId(), 4, &more);
+  QCOMPARE(result.size(), 2);
+  QVERIFY(!more);
+
+  // Several states and queues are merged in id order.
+  filter.queues.insert("odd");
+  filter.states.insert(MoleQueue::Finished);
+  filter.states.insert(MoleQueue::RunningLocal);
+  result = m_jobManager.findJobs(filter, jobs[3].moleQueueId(), 3, &more);
+  QCOMPARE(result.size(), 3);
+  QCOMPARE(result[0], jobs[4]);
+  QCOMPARE(result[1], jobs[5]);
+  QCOMPARE(result[2], jobs[6]);
+  QVERIFY(more);
+
+  // The indexes follow queue and state changes, and removals.
+  jobs[1].setQueue("even");
+  jobs[1].setJobState(MoleQueue::Error);
+  filter = MoleQueue::JobFilter();
+  filter.queues.insert("even");
+  QCOMPARE(m_jobManager.findJobs(filter).size(), 11);
+  QCOMPARE(m_jobManager.jobsWithJobState(MoleQueue::Finished).size(), 4);
+  QCOMPARE(m_jobManager.jobsWithJobState(MoleQueue::Error).size(), 1);
+
+  // So do changes made by setFromJson(), which cannot change the id.
+  QJsonObject state;
+  state.insert("moleQueueId", 1000.0);
+  state.insert("queue", QString("odd"));
+  state.insert("jobState",
+               QString(MoleQueue::jobStateToString(MoleQueue::Error)));
+  MoleQueue::IdType moleQueueId = jobs[2].moleQueueId();
+  jobs[2].setFromJson(state);
+  QCOMPARE(jobs[2].moleQueueId(), moleQueueId);
+  QCOMPARE(m_jobManager.findJobs(filter).size(), 10);
+  QCOMPARE(m_jobManager.jobsWithJobState(MoleQueue::Finished).size(), 3);
+  QCOMPARE(m_jobManager.jobsWithJobState(MoleQueue::Error).size(), 2);
+  QString error;
+  QVERIFY2(m_jobManager.checkIndexes(&error), qPrintable(error));
+  m_jobManager.removeJobs(jobs);
+  QCOMPARE(m_jobManager.findJobs(filter).size(), 0);
+  QCOMPARE(m_jobManager.jobsWithJobState(MoleQueue::Error).size(), 0);
+  QVERIFY2(m_jobManager.checkIndexes(&error), qPrintable(error));
+}
+
+void JobManagerTest::testJobOwners()
+{
+  QObject owner1;
+  QObject owner2;
+  QList<Job> jobs;
+  for (int i = 0; i < 6; ++i) {
+    Job job = m_jobManager.newJob();
+    job.setQueue("queue");
+    m_jobManager.setJobOwner(job.moleQueueId(), i < 4 ? &owner1 : &owner2);
+    jobs << job;
+  }
+
+  QCOMPARE(m_jobManager.jobsOwnedBy(&owner1).size(), 4);
+  QCOMPARE(m_jobManager.jobsOwnedBy(&owner2).size(), 2);
+  QCOMPARE(m_jobManager.jobOwner(jobs[0].moleQueueId()),
+           static_cast<QObject*>(&owner1));
+  QString error;
+  QVERIFY2(m_jobManager.checkIndexes(&error), qPrintable(error));
+
+  // Changing owners and removing jobs keep the index in sync.
+  m_jobManager.setJobOwner(jobs[0].moleQueueId(), &owner2);
+  m_jobManager.removeJob(jobs[1]);
+  QCOMPARE(m_jobManager.jobsOwnedBy(&owner1).size(), 2);
+  QCOMPARE(m_jobManager.jobsOwnedBy(&owner2).size(), 3);
+  QVERIFY(!m_jobManager.contains(jobs[1].moleQueueId()));
+  QVERIFY2(m_jobManager.checkIndexes(&error), qPrintable(error));
+
+  m_jobManager.removeJobOwner(&owner2);
+  QVERIFY(m_jobManager.jobsOwnedBy(&owner2).isEmpty());
+  QVERIFY(m_jobManager.jobOwner(jobs[0].moleQueueId()) == NULL);
+  QCOMPARE(m_jobManager.jobsOwnedBy(&owner1).size(), 2);
+  QVERIFY2(m_jobManager.checkIndexes(&error), qPrintable(error));
+
+  m_jobManager.removeJobs(jobs);
+  QVERIFY(m_jobManager.jobsOwnedBy(&owner1).isEmpty());
+  QVERIFY2(m_jobManager.checkIndexes(&error), qPrintable(error));
+}
+
+void JobManagerTest::testStaleReferences()
+{
+  Job job = m_jobManager.newJob();
+  const Job copy = job;
+  const MoleQueue::IdType moleQueueId = job.moleQueueId();
+  QVERIFY(job.isValid());
+  QVERIFY(m_jobManager.lookupJobByMoleQueueId(moleQueueId).isValid());
+
+  m_jobManager.removeJob(job);
+  QVERIFY(!job.isValid());
+  QVERIFY(!copy.isValid());
+
+  // The next job reuses the slot, but not the generation.
+  Job newJob = m_jobManager.newJob();
+  QVERIFY(newJob.isValid());
+  QVERIFY(!copy.isValid());
+  QVERIFY(!(newJob == copy));
+  QCOMPARE(m_jobManager.indexOf(newJob), m_jobManager.count() - 1);
+  m_jobManager.removeJob(newJob);
+}
+
+void JobManagerTest::testInputFileHashes()
+{
+  QTemporaryDir jobsDir;
+  QVERIFY(jobsDir.isValid());
+  QDir(jobsDir.path()).mkdir("1");
+
+  QMap<QString, QString> hashes;
+  hashes.insert("basis.dat", "0123456789abcdef");
+  {
+    MoleQueue::JobManager manager;
+    Job job = manager.newJob();
+    job.setMoleQueueId(1);
+    job.setLocalWorkingDirectory(jobsDir.path() + "/1");
+    job.setInputFileHashes(hashes);
+    manager.syncJobState();
+
+    // The hashes are internal to the server.
+    QVERIFY(!job.toJsonObject().contains("inputFileHashes"));
+  }
+
+  // ...but kept with the job state.
+  MoleQueue::JobManager manager;
+  manager.loadJobState(jobsDir.path());
+  QCOMPARE(manager.count(), 1);
+  QCOMPARE(manager.jobAt(0).inputFileHashes(), hashes);
+}
+
+void JobManagerTest::testJsonProjection()
+{
+  MoleQueue::JobManager manager;
+  Job job = manager.newJob();
+  job.setQueue("Some queue");
+  job.setNumberOfCores(4);
+
+  // Each requested member matches the full serialization...
+  QJsonObject full = job.toJsonObject();
+  QStringList members = full.keys();
+  members << "keywords" << "notAMember";
+  QJsonObject projection = job.toJsonObject(members);
+  QCOMPARE(projection, full);
+
+  // ...and nothing else is built.
+  projection = job.toJsonObject(QStringList() << "numberOfCores" << "queue");
+  QCOMPARE(projection.keys(),
+           QStringList() << "numberOfCores" << "queue");
+  QCOMPARE(projection.value("queue"), full.value("queue"));
+  QCOMPARE(projection.value("numberOfCores"), full.value("numberOfCores"));
+}
+
+void JobManagerTest::benchmarkJobAccessors()
+{
+  QList<Job> jobs;
+  for (int i = 0; i < 100; ++i)
+    jobs << m_jobManager.newJob();
+
+  // Each accessor validates the reference.
+  qint64 total = 0;
+  QBENCHMARK {
+    foreach (const Job &job, jobs) {
+      total += job.numberOfCores() + static_cast<int>(job.jobState()) +
+          job.queue().size() + static_cast<qint64>(job.moleQueueId());
+    }
+  }
+  QVERIFY(total > 0);
+
+  m_jobManager.removeJobs(jobs);
+}
+
 QTEST_MAIN(JobManagerTest)
 
 #include "jobmanagertest.moc"
@@ -0,0 +1,352 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "jobsubscriptionmanager.h"
+
+#include "idtypeutils.h"
+#include "job.h"
+#include "jobdata.h"
+#include "jobmanager.h"
+#include "testing/dummyconnection.h"
+
+#include <QtCore/QJsonArray>
+
+using namespace MoleQueue;
+
+class JobSubscriptionManagerTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  /// Create a job in @a queue.
+  Job newJob(const QString &queue);
+
+  JobManager *m_jobManager;
+  JobSubscriptionManager *m_subscriptions;
+  DummyConnection *m_connection;
+
+private slots:
+  void init();
+  void cleanup();
+
+  void setNewJobIds(MoleQueue::Job);
+
+  void filter();
+  void coalesce();
+  void changedMembers();
+  void filteredJobs();
+  void leavingState();
+  void removedJob();
+  void overflow();
+  void backpressure();
+  void unsubscribe();
+  void timer();
+};
+
+Job JobSubscriptionManagerTest::newJob(const QString &queue)
+{
+  Job job = m_jobManager->newJob();
+  job.setQueue(queue);
+  job.setProgram("Program");
+  return job;
+}
+
+void JobSubscriptionManagerTest::init()
+{
+  m_jobManager = new JobManager;
+  connect(m_jobManager, SIGNAL(jobAboutToBeAdded(MoleQueue::Job)),
+          this, SLOT(setNewJobIds(MoleQueue::Job)),
+          Qt::DirectConnection);
+  m_subscriptions = new JobSubscriptionManager(m_jobManager);
+  m_connection = new DummyConnection;
+}
+
+void JobSubscriptionManagerTest::cleanup()
+{
+  delete m_subscriptions;
+  delete m_jobManager;
+  delete m_connection;
+}
+
+void JobSubscriptionManagerTest::setNewJobIds(Job job)
+{
+  job.setMoleQueueId(static_cast<IdType>(m_jobManager->count()));
+}
+
+void JobSubscriptionManagerTest::filter()
+{
+  QJsonObject json;
+  json.insert("queues", QJsonArray() << QString("Queue"));
+  json.insert("states", QJsonArray() << QString("RunningRemote")
+              << QString("Finished"));
+  json.insert("descriptionContains", QString("benzene"));
+  json.insert("submittedAfter", QString("2012-06-01T00:00:00"));
+  json.insert("minMoleQueueId", 2);
+  json.insert("maxMoleQueueId", 3);
+
+  JobFilter filter;
+  QVERIFY(filter.fromJsonObject(json));
+
+  Job job = newJob("Queue");
+  job.setDescription("Optimize Benzene");
+  job.setSubmissionTime(QDateTime::fromString("2012-06-02T00:00:00",
+                                              Qt::ISODate));
+  // moleQueueId 1 is out of range
+  QVERIFY(!filter.matches(*job.jobData(), Finished));
+
+  job = newJob("Queue");
+  job.setDescription("Optimize Benzene");
+  job.setSubmissionTime(QDateTime::fromString("2012-06-02T00:00:00",
+                                              Qt::ISODate));
+  const JobData &jobdata = *job.jobData();
+  QVERIFY(filter.matches(jobdata, Finished));
+  QVERIFY(!filter.matches(jobdata, Submitted));
+  QVERIFY(!filter.matches(jobdata)); // None
+  job.setQueue("Other");
+  QVERIFY(!filter.matches(jobdata, Finished));
+  job.setQueue("Queue");
+  job.setDescription("Water");
+  QVERIFY(!filter.matches(jobdata, Finished));
+  job.setDescription("benzene");
+  job.setSubmissionTime(QDateTime());
+  QVERIFY(!filter.matches(jobdata, Finished));
+  job.setSubmissionTime(QDateTime::fromString("2012-05-31T00:00:00",
+                                              Qt::ISODate));
+  QVERIFY(!filter.matches(jobdata, Finished));
+
+  // Empty filters match everything
+  QVERIFY(JobFilter().matches(jobdata));
+
+  QString error;
+  json.insert("states", QJsonArray() << QString("NotAState"));
+  QVERIFY(!JobFilter().fromJsonObject(json, &error));
+  QVERIFY(error.contains("NotAState"));
+
+  json.insert("states", QString("Finished"));
+  QVERIFY(!JobFilter().fromJsonObject(json, &error));
+
+  json.remove("states");
+  json.insert("submittedAfter", QString("yesterday"));
+  QVERIFY(!JobFilter().fromJsonObject(json, &error));
+}
+
+void JobSubscriptionManagerTest::coalesce()
+{
+  JobFilter filter;
+  filter.queues.insert("Queue");
+  IdType id = m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                                         filter);
+
+  Job job = newJob("Queue");
+  job.setJobState(Submitted);
+  job.setJobState(QueuedRemote);
+  job.setJobState(RunningRemote);
+  QCOMPARE(m_connection->messageCount(), 0);
+
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  Message message = m_connection->popMessage();
+  QCOMPARE(message.method(), QString("jobsChanged"));
+  QJsonObject params = message.params().toObject();
+  QCOMPARE(toIdType(params.value("subscriptionId")), id);
+  QJsonArray jobs = params.value("jobs").toArray();
+  QCOMPARE(jobs.size(), 1);
+  QJsonObject change = jobs.first().toObject();
+  QCOMPARE(toIdType(change.value("moleQueueId")), job.moleQueueId());
+  QCOMPARE(change.value("oldState").toString(), QString("None"));
+  QCOMPARE(change.value("jobState").toString(), QString("RunningRemote"));
+
+  // Nothing pending, nothing sent.
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 0);
+}
+
+void JobSubscriptionManagerTest::changedMembers()
+{
+  m_subscriptions->subscribe(m_connection, EndpointIdType(), JobFilter());
+
+  Job job = newJob("Queue");
+  job.setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  QJsonObject change = m_connection->popMessage().params().toObject()
+      .value("jobs").toArray().first().toObject();
+  // The whole job the first time...
+  QCOMPARE(change.value("queue").toString(), QString("Queue"));
+  QCOMPARE(change.value("program").toString(), QString("Program"));
+
+  // ...and only what changed after that.
+  job.setJobState(RunningRemote);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  change = m_connection->popMessage().params().toObject()
+      .value("jobs").toArray().first().toObject();
+  QCOMPARE(toIdType(change.value("moleQueueId")), job.moleQueueId());
+  QCOMPARE(change.value("oldState").toString(), QString("Submitted"));
+  QCOMPARE(change.value("jobState").toString(), QString("RunningRemote"));
+  QVERIFY(!change.contains("queue"));
+  QVERIFY(!change.contains("program"));
+}
+
+void JobSubscriptionManagerTest::filteredJobs()
+{
+  JobFilter filter;
+  filter.queues.insert("Queue");
+  m_subscriptions->subscribe(m_connection, EndpointIdType(), filter);
+
+  newJob("Other").setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 0);
+
+  // A second subscription on the same connection gets its own notification.
+  m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                             JobFilter());
+  newJob("Other").setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+}
+
+void JobSubscriptionManagerTest::leavingState()
+{
+  JobFilter filter;
+  filter.states.insert(RunningRemote);
+  m_subscriptions->subscribe(m_connection, EndpointIdType(), filter);
+
+  Job job = newJob("Queue");
+  job.setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 0);
+
+  job.setJobState(RunningRemote);
+  job.setJobState(Finished);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  QJsonObject change = m_connection->popMessage().params().toObject()
+      .value("jobs").toArray().first().toObject();
+  QCOMPARE(change.value("oldState").toString(), QString("Submitted"));
+  QCOMPARE(change.value("jobState").toString(), QString("Finished"));
+}
+
+void JobSubscriptionManagerTest::removedJob()
+{
+  m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                             JobFilter());
+  Job job = newJob("Queue");
+  IdType moleQueueId = job.moleQueueId();
+  job.setJobState(Submitted);
+  m_jobManager->removeJob(moleQueueId);
+
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  QJsonArray jobs = m_connection->popMessage().params().toObject()
+      .value("jobs").toArray();
+  QCOMPARE(jobs.size(), 1);
+  QCOMPARE(toIdType(jobs.first().toObject().value("moleQueueId")),
+           moleQueueId);
+  QCOMPARE(jobs.first().toObject().value("removed").toBool(), true);
+}
+
+void JobSubscriptionManagerTest::overflow()
+{
+  m_subscriptions->setMaxPendingJobs(2);
+  m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                             JobFilter());
+
+  for (int i = 0; i < 3; ++i)
+    newJob("Queue").setJobState(Submitted);
+
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  QJsonObject params = m_connection->popMessage().params().toObject();
+  QCOMPARE(params.value("resyncNeeded").toBool(), true);
+  QVERIFY(!params.contains("jobs"));
+
+  // Back to normal after the resync marker was sent.
+  newJob("Queue").setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  params = m_connection->popMessage().params().toObject();
+  QVERIFY(!params.contains("resyncNeeded"));
+  QCOMPARE(params.value("jobs").toArray().size(), 1);
+}
+
+void JobSubscriptionManagerTest::backpressure()
+{
+  m_subscriptions->setMaxUnsentBytes(100);
+  m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                             JobFilter());
+
+  // Nothing is sent while the client is behind on reading...
+  m_connection->m_bytesToWrite = 101;
+  newJob("Queue").setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 0);
+  newJob("Queue").setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 0);
+
+  // ...and once it has caught up, it is told to look the jobs up again.
+  m_connection->m_bytesToWrite = 0;
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 1);
+  QJsonObject params = m_connection->popMessage().params().toObject();
+  QCOMPARE(params.value("resyncNeeded").toBool(), true);
+  QVERIFY(!params.contains("jobs"));
+}
+
+void JobSubscriptionManagerTest::unsubscribe()
+{
+  IdType id = m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                                         JobFilter());
+  DummyConnection other;
+  QVERIFY(!m_subscriptions->unsubscribe(&other, id));
+  QVERIFY(m_subscriptions->unsubscribe(m_connection, id));
+  QVERIFY(!m_subscriptions->unsubscribe(m_connection, id));
+
+  m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                             JobFilter());
+  m_subscriptions->subscribe(&other, EndpointIdType(),
+                             JobFilter());
+  QCOMPARE(m_subscriptions->subscriptionCount(), 2);
+  m_subscriptions->removeConnection(m_connection);
+  QCOMPARE(m_subscriptions->subscriptionCount(), 1);
+
+  newJob("Queue").setJobState(Submitted);
+  m_subscriptions->flush();
+  QCOMPARE(m_connection->messageCount(), 0);
+  QCOMPARE(other.messageCount(), 1);
+}
+
+void JobSubscriptionManagerTest::timer()
+{
+  m_subscriptions->setCoalesceInterval(10);
+  m_subscriptions->subscribe(m_connection, EndpointIdType(),
+                             JobFilter());
+  newJob("Queue").setJobState(Submitted);
+  QCOMPARE(m_connection->messageCount(), 0);
+
+  QTime timer;
+  timer.start();
+  while (m_connection->messageCount() == 0 && timer.elapsed() < 5000)
+    qApp->processEvents(QEventLoop::AllEvents, 50);
+  QCOMPARE(m_connection->messageCount(), 1);
+}
+
+QTEST_MAIN(JobSubscriptionManagerTest)
+
+#include "jobsubscriptionmanagertest.moc"
@@ -0,0 +1,208 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "testing/testserver.h"
+
+#include <molequeue/client/jsonrpcclient.h>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QJsonDocument>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+using MoleQueue::JsonRpcClient;
+
+class JsonRpcClientTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  QLocalServer *m_server;
+  QLocalSocket *m_serverSocket;
+  JsonRpcClient *m_client;
+
+  /// Frame @a packet as LocalSocketConnection does.
+  static QByteArray frame(const QByteArray &packet);
+  static QByteArray response(int id, const QJsonValue &result);
+  void writeRaw(const QByteArray &bytes);
+
+private slots:
+  /// Called before each test function is executed.
+  void init();
+  /// Called after every test function.
+  void cleanup();
+
+  void testSplitFrame();
+  void testSeveralFramesPerRead();
+  void testNullFrame();
+  void testCoalescedWrites();
+  void testInvalidLength();
+};
+
+QByteArray JsonRpcClientTest::frame(const QByteArray &packet)
+{
+  QByteArray bytes;
+  QDataStream stream(&bytes, QIODevice::WriteOnly);
+  stream.setVersion(QDataStream::Qt_4_8);
+  stream << packet;
+  return bytes;
+}
+
+QByteArray JsonRpcClientTest::response(int id, const QJsonValue &result)
+{
+  QJsonObject object;
+  object["jsonrpc"] = QLatin1String("2.0");
+  object["id"] = id;
+  object["result"] = result;
+  return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+void JsonRpcClientTest::writeRaw(const QByteArray &bytes)
+{
+  m_serverSocket->write(bytes);
+  m_serverSocket->flush();
+  while (m_serverSocket->bytesToWrite() > 0)
+    QVERIFY(m_serverSocket->waitForBytesWritten(5000));
+}
+
+void JsonRpcClientTest::init()
+{
+  m_server = new QLocalServer;
+  QVERIFY(m_server->listen(TestServer::getRandomSocketName()));
+
+  m_client = new JsonRpcClient;
+  m_client->connectToServer(m_server->serverName());
+  QVERIFY(m_server->waitForNewConnection(5000));
+  m_serverSocket = m_server->nextPendingConnection();
+  QVERIFY(m_serverSocket);
+}
+
+void JsonRpcClientTest::cleanup()
+{
+  delete m_client;
+  delete m_server;
+}
+
+void JsonRpcClientTest::testSplitFrame()
+{
+  QSignalSpy resultSpy(m_client, SIGNAL(resultReceived(QJsonObject)));
+  QSignalSpy badSpy(m_client, SIGNAL(badPacketReceived(QString)));
+
+  // A 1 MiB response, delivered a few KiB at a time.
+  QString big(1024 * 1024, QLatin1Char('x'));
+  QByteArray bytes = frame(response(7, big));
+  for (int i = 0; i < bytes.size(); i += 4093) {
+    writeRaw(bytes.mid(i, 4093));
+    qApp->processEvents();
+    QVERIFY(resultSpy.isEmpty() || i + 4093 >= bytes.size());
+  }
+
+  QTRY_COMPARE(resultSpy.size(), 1);
+  QCOMPARE(badSpy.size(), 0);
+  QJsonObject result = resultSpy.first().first().toJsonObject();
+  QCOMPARE(result.value("id").toInt(), 7);
+  QCOMPARE(result.value("result").toString().size(), big.size());
+
+  // Splitting inside the length header too.
+  QByteArray small = frame(response(8, true));
+  writeRaw(small.left(2));
+  qApp->processEvents();
+  writeRaw(small.mid(2));
+  QTRY_COMPARE(resultSpy.size(), 2);
+  QCOMPARE(badSpy.size(), 0);
+}
+
+void JsonRpcClientTest::testSeveralFramesPerRead()
+{
+  QSignalSpy resultSpy(m_client, SIGNAL(resultReceived(QJsonObject)));
+
+  QByteArray bytes;
+  for (int i = 0; i < 10; ++i)
+    bytes += frame(response(i, i * i));
+  // And the start of an eleventh.
+  QByteArray last = frame(response(10, 100));
+  writeRaw(bytes + last.left(10));
+
+  QTRY_COMPARE(resultSpy.size(), 10);
+  for (int i = 0; i < 10; ++i) {
+    QJsonObject result = resultSpy.at(i).first().toJsonObject();
+    QCOMPARE(result.value("id").toInt(), i);
+    QCOMPARE(result.value("result").toInt(), i * i);
+  }
+
+  writeRaw(last.mid(10));
+  QTRY_COMPARE(resultSpy.size(), 11);
+}
+
+void JsonRpcClientTest::testNullFrame()
+{
+  QSignalSpy resultSpy(m_client, SIGNAL(resultReceived(QJsonObject)));
+  QSignalSpy badSpy(m_client, SIGNAL(badPacketReceived(QString)));
+
+  writeRaw(frame(QByteArray()) + frame(response(1, 1)));
+  QTRY_COMPARE(resultSpy.size(), 1);
+  QCOMPARE(badSpy.size(), 0);
+}
+
+void JsonRpcClientTest::testCoalescedWrites()
+{
+  QList<QJsonObject> requests;
+  QByteArray expected;
+  for (int i = 0; i < 3; ++i) {
+    QJsonObject request(m_client->emptyRequest());
+    request["method"] = QLatin1String("listQueues");
+    QVERIFY(m_client->sendRequest(request));
+    requests << request;
+    expected += frame(QJsonDocument(request).toJson(QJsonDocument::Compact));
+  }
+
+  // Nothing is written until control returns to the event loop or flush().
+  QVERIFY(!m_serverSocket->waitForReadyRead(100));
+  m_client->flush();
+
+  QByteArray received;
+  while (received.size() < expected.size()
+         && m_serverSocket->waitForReadyRead(5000)) {
+    received += m_serverSocket->readAll();
+  }
+  QCOMPARE(received, expected);
+
+  // Read back as LocalSocketConnection does.
+  QDataStream stream(received);
+  stream.setVersion(QDataStream::Qt_4_8);
+  for (int i = 0; i < 3; ++i) {
+    QByteArray packet;
+    stream >> packet;
+    QCOMPARE(stream.status(), QDataStream::Ok);
+    QCOMPARE(QJsonDocument::fromJson(packet).object(), requests.at(i));
+  }
+  QVERIFY(stream.atEnd());
+}
+
+void JsonRpcClientTest::testInvalidLength()
+{
+  QSignalSpy badSpy(m_client, SIGNAL(badPacketReceived(QString)));
+
+  writeRaw(QByteArray("\x80\x00\x00\x00garbage", 11));
+  QTRY_COMPARE(badSpy.size(), 1);
+  QVERIFY(!m_client->isConnected());
+}
+
+QTEST_MAIN(JsonRpcClientTest)
+
+#include "jsonrpcclienttest.moc"
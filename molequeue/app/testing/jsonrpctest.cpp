@@ -23,6 +23,7 @@
 #include <molequeue/servercore/message.h>
 #include <molequeue/servercore/jsonrpc.h>
 
+#include <qjsonarray.h>
 #include <qjsondocument.h>
 #include <qjsonvalue.h>
 
@@ -55,6 +56,7 @@ private slots:
   void removeConnection();
   void removeConnectionListener();
   void internalPing();
+  void negotiateEncoding();
 };
 
 void JsonRpcTest::initTestCase()
@@ -141,6 +143,51 @@ void JsonRpcTest::internalPing()
            QString(response.toString().toLatin1()));
 }
 
+void JsonRpcTest::negotiateEncoding()
+{
+  DummyConnection connection;
+  QCOMPARE(connection.packetEncoding(), MoleQueue::JsonEncoding);
+
+  // Unknown encodings are skipped.
+  QJsonObject request;
+  request.insert("jsonrpc", QLatin1String("2.0"));
+  request.insert("id", 1);
+  request.insert("method", QLatin1String("negotiateEncoding"));
+  QJsonObject params;
+  params.insert("encodings",
+                QJsonArray() << QLatin1String("xml") << QLatin1String("cbor")
+                << QLatin1String("json"));
+  request.insert("params", params);
+
+  m_jsonRpc.handleJsonValue(&connection, MoleQueue::EndpointIdType(), request);
+  QCOMPARE(connection.messageCount(), 1);
+  MoleQueue::Message response = connection.popMessage();
+  QCOMPARE(response.type(), MoleQueue::Message::Response);
+
+  MoleQueue::PacketEncoding expected =
+      MoleQueue::Message::isEncodingSupported(MoleQueue::CborEncoding)
+      ? MoleQueue::CborEncoding : MoleQueue::JsonEncoding;
+  QCOMPARE(response.result().toObject().value("encoding").toString(),
+           MoleQueue::Message::encodingName(expected));
+  QCOMPARE(connection.packetEncoding(), expected);
+
+  // The reply is sent before switching, and later packets use the new
+  // encoding.
+  QVERIFY(connection.m_lastPacket.startsWith('{'));
+  request.insert("method", QLatin1String("internalPing"));
+  request.remove("params");
+  m_jsonRpc.handleJsonValue(&connection, MoleQueue::EndpointIdType(), request);
+  QCOMPARE(connection.popMessage().result().toString(), QString("pong"));
+  QCOMPARE(connection.m_lastPacket.startsWith('{'),
+           expected == MoleQueue::JsonEncoding);
+
+  // Invalid params
+  request.insert("method", QLatin1String("negotiateEncoding"));
+  request.insert("params", QJsonObject());
+  m_jsonRpc.handleJsonValue(&connection, MoleQueue::EndpointIdType(), request);
+  QCOMPARE(connection.popMessage().errorCode(), -32602);
+}
+
 QTEST_MAIN(JsonRpcTest)
 
 #include "jsonrpctest.moc"
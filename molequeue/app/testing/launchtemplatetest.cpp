@@ -0,0 +1,231 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "launchtemplate.h"
+
+#include <QtCore/QRegExp>
+
+using namespace MoleQueue;
+
+class LaunchTemplateTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  /// A PBS-like script with a few hundred lines and keywords.
+  QString benchmarkTemplate() const;
+  /// Keyword values for benchmarkTemplate().
+  QHash<QString, QString> benchmarkKeywords() const;
+
+private slots:
+  void keywords();
+  void lineKeywords();
+  void nestedKeywords();
+  void unhandledKeywords();
+  void literalDollars();
+
+  void benchmarkReplace();
+  void benchmarkRender();
+};
+
+QString LaunchTemplateTest::benchmarkTemplate() const
+{
+  QStringList lines;
+  lines << "#!/bin/sh"
+        << "#PBS -l walltime=$$$maxWallTime$$$"
+        << "#PBS -l nodes=1:ppn=$$numberOfCores$$"
+        << "#PBS -N MoleQueueJob-$$moleQueueId$$";
+  for (int i = 0; i < 100; ++i) {
+    lines << QString("echo \"Step %1 of job $$moleQueueId$$\" >> log.$$$$")
+             .arg(i)
+          << QString("cp $$inputFileName$$ step%1-$$inputFileBaseName$$.in")
+             .arg(i)
+          << QString("run --cores $$numberOfCores$$ step%1 > $$outputFileName$$")
+             .arg(i);
+  }
+  return lines.join("\n") + "\n";
+}
+
+QHash<QString, QString> LaunchTemplateTest::benchmarkKeywords() const
+{
+  QHash<QString, QString> keywords;
+  keywords.insert("moleQueueId", "1234");
+  keywords.insert("numberOfCores", "16");
+  keywords.insert("inputFileName", "input.inp");
+  keywords.insert("inputFileBaseName", "input");
+  keywords.insert("outputFileName", "$$inputFileBaseName$$.out");
+  keywords.insert("customKeyword1", "value1");
+  keywords.insert("customKeyword2", "value2");
+  return keywords;
+}
+
+void LaunchTemplateTest::keywords()
+{
+  QHash<QString, QString> keywords;
+  keywords.insert("moleQueueId", "17");
+  keywords.insert("numberOfCores", "4");
+
+  LaunchTemplate launchTemplate("$$moleQueueId$$ at start\n"
+                                "In middle $$numberOfCores$$ of line\n"
+                                "At end $$moleQueueId$$");
+  QCOMPARE(launchTemplate.render(keywords),
+           QString("17 at start\nIn middle 4 of line\nAt end 17"));
+
+  // Rendering is repeatable, and does not depend on the previous values.
+  keywords.insert("moleQueueId", "18");
+  QCOMPARE(launchTemplate.render(keywords),
+           QString("18 at start\nIn middle 4 of line\nAt end 18"));
+
+  // setSource reparses
+  launchTemplate.setSource("$$numberOfCores$$$$moleQueueId$$");
+  QCOMPARE(launchTemplate.source(), QString("$$numberOfCores$$$$moleQueueId$$"));
+  QCOMPARE(launchTemplate.render(keywords), QString("418"));
+
+  QVERIFY(LaunchTemplate().isEmpty());
+  QCOMPARE(LaunchTemplate().render(keywords), QString());
+}
+
+void LaunchTemplateTest::lineKeywords()
+{
+  QStringList list;
+  list << "$$$maxWallTime$$$ at start"
+       << "Test second line"
+       << "In middle $$$maxWallTime$$$ of line"
+       << "In middle $$$maxWallTime$$$ of adjacent line"
+       << "Test fifth line"
+       << "Safe maxWallTime=$$maxWallTime$$"
+       << "At end $$$maxWallTime$$$";
+  LaunchTemplate launchTemplate(list.join("\n"));
+
+  QHash<QString, QString> keywords;
+  keywords.insert("maxWallTime", "24:00:00");
+  QHash<QString, QString> lineKeywords;
+  lineKeywords.insert("maxWallTime", "01:30:00");
+
+  QCOMPARE(launchTemplate.render(keywords, lineKeywords),
+           QString("01:30:00 at start\nTest second line\n"
+                   "In middle 01:30:00 of line\n"
+                   "In middle 01:30:00 of adjacent line\n"
+                   "Test fifth line\nSafe maxWallTime=24:00:00\n"
+                   "At end 01:30:00"));
+
+  // A null value removes the lines.
+  lineKeywords.insert("maxWallTime", QString());
+  QStringList unhandled;
+  QCOMPARE(launchTemplate.render(keywords, lineKeywords, &unhandled),
+           QString("Test second line\nTest fifth line\n"
+                   "Safe maxWallTime=24:00:00\n"));
+  QCOMPARE(unhandled, QStringList());
+
+  // An empty value does not.
+  lineKeywords.insert("maxWallTime", QString(""));
+  QCOMPARE(LaunchTemplate("a\nb $$$maxWallTime$$$\nc")
+           .render(keywords, lineKeywords), QString("a\nb \nc"));
+}
+
+void LaunchTemplateTest::nestedKeywords()
+{
+  QHash<QString, QString> keywords;
+  keywords.insert("inputFileBaseName", "job");
+  keywords.insert("outputFileName", "$$inputFileBaseName$$.out");
+
+  LaunchTemplate launchTemplate("run < $$inputFileBaseName$$.in > "
+                                "$$outputFileName$$");
+  QCOMPARE(launchTemplate.render(keywords),
+           QString("run < job.in > job.out"));
+
+  // Self referencing values terminate and the keyword is dropped.
+  keywords.insert("loop", "x$$loop$$");
+  QStringList unhandled;
+  QCOMPARE(LaunchTemplate("$$loop$$").render(keywords, QHash<QString, QString>(),
+                                             &unhandled),
+           QString("xxxxxxxxx"));
+  QCOMPARE(unhandled, QStringList() << "$$loop$$");
+}
+
+void LaunchTemplateTest::unhandledKeywords()
+{
+  QHash<QString, QString> keywords;
+  keywords.insert("known", "K");
+
+  QStringList unhandled;
+  QCOMPARE(LaunchTemplate("a $$unknown$$ b $$known$$ c $$$other$$$ d\n")
+           .render(keywords, QHash<QString, QString>(), &unhandled),
+           QString("a  b K c  d\n"));
+  QCOMPARE(unhandled, QStringList() << "$$unknown$$" << "$$$other$$$");
+}
+
+void LaunchTemplateTest::literalDollars()
+{
+  QHash<QString, QString> keywords;
+  keywords.insert("id", "7");
+  keywords.insert("a", "A");
+
+  // Shell variables and the shell pid are not keywords.
+  QString shell("echo $$ > pid.$$\nexport X=$HOME\necho ${PATH}$$ $\n");
+  QCOMPARE(LaunchTemplate(shell).render(keywords), shell);
+
+  // Surplus delimiters are kept as text.
+  QCOMPARE(LaunchTemplate("$$$$id$$").render(keywords), QString("$$7"));
+  QCOMPARE(LaunchTemplate("$$id$$$").render(keywords), QString("7$"));
+  QCOMPARE(LaunchTemplate("$$$id$$").render(keywords), QString("$7"));
+  QCOMPARE(LaunchTemplate("$$a$$$$id$$").render(keywords), QString("A7"));
+  QCOMPARE(LaunchTemplate("$$a b$$").render(keywords), QString("$$a b$$"));
+  QCOMPARE(LaunchTemplate("$$a$b$$").render(keywords), QString("$$a$b$$"));
+}
+
+void LaunchTemplateTest::benchmarkReplace()
+{
+  // The previous implementation: one replace pass per keyword, then strip
+  // the leftovers one regexp match at a time.
+  QString source = benchmarkTemplate();
+  QHash<QString, QString> keywords = benchmarkKeywords();
+  QString script;
+  QBENCHMARK {
+    script = source;
+    script.replace("$$$maxWallTime$$$", "24:00:00");
+    script.replace("$$outputFileName$$", keywords.value("outputFileName"));
+    foreach (const QString &key, keywords.keys())
+      script.replace(QString("$$%1$$").arg(key), keywords.value(key));
+    QRegExp expr("[^\\$]?(\\${2,3}[^\\$\\s]+\\${2,3})[^\\$]?");
+    while (expr.indexIn(script) != -1)
+      script.remove(expr.cap(1));
+  }
+
+  QHash<QString, QString> lineKeywords;
+  lineKeywords.insert("maxWallTime", "24:00:00");
+  QCOMPARE(script, LaunchTemplate(source).render(keywords, lineKeywords));
+}
+
+void LaunchTemplateTest::benchmarkRender()
+{
+  LaunchTemplate launchTemplate(benchmarkTemplate());
+  QHash<QString, QString> keywords = benchmarkKeywords();
+  QHash<QString, QString> lineKeywords;
+  lineKeywords.insert("maxWallTime", "24:00:00");
+  QString script;
+  QBENCHMARK {
+    script = launchTemplate.render(keywords, lineKeywords);
+  }
+  QVERIFY(!script.contains("$$moleQueueId$$"));
+  QVERIFY(script.contains("log.$$"));
+}
+
+QTEST_MAIN(LaunchTemplateTest)
+
+#include "launchtemplatetest.moc"
@@ -0,0 +1,397 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "logger.h"
+#include "ringbuffer.h"
+
+#include "molequeuetestconfig.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSettings>
+#include <QtCore/QTemporaryDir>
+
+using namespace MoleQueue;
+
+class LoggerTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  /// Log @a count notifications "Entry [first]" ... "Entry [first+count-1]".
+  void logEntries(int first, int count);
+  /// @return The messages of @a entries.
+  QStringList messages(const QList<LogEntry> &entries);
+  /// @return The messages "Entry [first]" ... "Entry [first+count-1]".
+  QStringList expectedMessages(int first, int count);
+  /// @return The log files in the log directory.
+  QStringList logFiles();
+
+  QTemporaryDir *m_tmpDir;
+
+private slots:
+  /// Called before the first test function is executed.
+  void initTestCase();
+  /// Called after the last test function is executed.
+  void cleanupTestCase();
+  /// Called before each test function is executed.
+  void init();
+  /// Called after every test function.
+  void cleanup();
+
+  void ringBuffer();
+  void appendAndReload();
+  void rotation();
+  void olderEntries();
+  void incompleteLine();
+  void legacyLog();
+  void clear();
+  void logLevel();
+
+  void benchmarkLogEntry();
+  void benchmarkSuppressedEntry();
+};
+
+void LoggerTest::logEntries(int first, int count)
+{
+  for (int i = first; i < first + count; ++i)
+    Logger::logNotification(QString("Entry %1").arg(i), i);
+}
+
+QStringList LoggerTest::messages(const QList<LogEntry> &entries)
+{
+  QStringList result;
+  foreach (const LogEntry &entry, entries)
+    result << entry.message();
+  return result;
+}
+
+QStringList LoggerTest::expectedMessages(int first, int count)
+{
+  QStringList result;
+  for (int i = first; i < first + count; ++i)
+    result << QString("Entry %1").arg(i);
+  return result;
+}
+
+QStringList LoggerTest::logFiles()
+{
+  return QDir(m_tmpDir->path()).entryList(QStringList("log-*.jsonl"),
+                                          QDir::Files, QDir::Name);
+}
+
+void LoggerTest::initTestCase()
+{
+  // The logger saves its limits and level with QSettings: don't overwrite
+  // the installed configuration.
+  QString workDir = MoleQueue_BINARY_DIR "/Testing/Temporary/LoggerTest";
+  QDir dir;
+  dir.mkpath(workDir);
+  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+                     workDir + "/config");
+}
+
+void LoggerTest::cleanupTestCase()
+{
+  // init() lowers the level to Notification; leave the default behind.
+  Logger::setLogLevel(LogEntry::DebugMessage);
+}
+
+void LoggerTest::init()
+{
+  m_tmpDir = new QTemporaryDir;
+  QVERIFY(m_tmpDir->isValid());
+  Logger::setMaxEntries(1000);
+  Logger::setMaxLogFileSize(1024 * 1024);
+  Logger::setMaxLogFiles(5);
+  Logger::setLogLevel(LogEntry::Notification);
+  Logger::setPrintDebugMessages(false);
+  Logger::resetSuppressedCount();
+  Logger::setLogDirectory(m_tmpDir->path());
+}
+
+void LoggerTest::cleanup()
+{
+  Logger::setLogDirectory(QString());
+  delete m_tmpDir;
+  m_tmpDir = NULL;
+}
+
+void LoggerTest::ringBuffer()
+{
+  RingBuffer<int> buffer(3);
+  QVERIFY(buffer.isEmpty());
+  QCOMPARE(buffer.capacity(), 3);
+
+  buffer.append(1);
+  buffer.append(2);
+  QCOMPARE(buffer.toList(), QList<int>() << 1 << 2);
+  QVERIFY(!buffer.isFull());
+
+  // Wraps around, dropping the oldest.
+  buffer.append(3);
+  buffer.append(4);
+  buffer.append(5);
+  QVERIFY(buffer.isFull());
+  QCOMPARE(buffer.size(), 3);
+  QCOMPARE(buffer.first(), 3);
+  QCOMPARE(buffer.at(1), 4);
+  QCOMPARE(buffer.last(), 5);
+  QCOMPARE(buffer.toList(), QList<int>() << 3 << 4 << 5);
+
+  // Shrinking keeps the newest items.
+  buffer.setCapacity(2);
+  QCOMPARE(buffer.toList(), QList<int>() << 4 << 5);
+  buffer.append(6);
+  QCOMPARE(buffer.toList(), QList<int>() << 5 << 6);
+
+  buffer.setCapacity(4);
+  buffer.append(7);
+  QCOMPARE(buffer.toList(), QList<int>() << 5 << 6 << 7);
+
+  buffer.clear();
+  QVERIFY(buffer.isEmpty());
+
+  // A zero capacity buffer holds nothing.
+  RingBuffer<int> empty;
+  empty.append(1);
+  QVERIFY(empty.isEmpty());
+}
+
+void LoggerTest::appendAndReload()
+{
+  logEntries(0, 10);
+  QCOMPARE(messages(Logger::log()), expectedMessages(0, 10));
+
+  // Every entry is on disk as soon as it is logged.
+  QCOMPARE(logFiles(), QStringList() << "log-0.jsonl");
+  QFile file(QDir(m_tmpDir->path()).absoluteFilePath("log-0.jsonl"));
+  QVERIFY(file.open(QFile::ReadOnly));
+  QCOMPARE(file.readAll().count('\n'), 10);
+  file.close();
+
+  // Reopening loads the tail.
+  Logger::setLogDirectory(m_tmpDir->path());
+  QList<LogEntry> log = Logger::log();
+  QCOMPARE(messages(log), expectedMessages(0, 10));
+  QCOMPARE(log.last().moleQueueId(), static_cast<IdType>(9));
+  QCOMPARE(log.last().entryType(), LogEntry::Notification);
+
+  // New entries are appended after the loaded ones.
+  logEntries(10, 5);
+  Logger::setLogDirectory(m_tmpDir->path());
+  QCOMPARE(messages(Logger::log()), expectedMessages(0, 15));
+}
+
+void LoggerTest::rotation()
+{
+  Logger::setMaxLogFileSize(1024);
+  Logger::setMaxLogFiles(3);
+
+  logEntries(0, 200);
+
+  QStringList files = logFiles();
+  QCOMPARE(files.size(), 3);
+  foreach (const QString &fileName, files) {
+    QFileInfo info(QDir(m_tmpDir->path()).absoluteFilePath(fileName));
+    // Files are rotated once they pass the limit, so may exceed it by one
+    // entry.
+    QVERIFY(info.size() < 2048);
+  }
+
+  // The entries in memory are not affected by rotation.
+  QCOMPARE(messages(Logger::log()), expectedMessages(0, 200));
+
+  // Reloading finds the newest entries that are still on disk.
+  Logger::setLogDirectory(m_tmpDir->path());
+  QStringList reloaded = messages(Logger::log());
+  QVERIFY(!reloaded.isEmpty());
+  QVERIFY(reloaded.size() < 200);
+  QCOMPARE(reloaded, expectedMessages(200 - reloaded.size(), reloaded.size()));
+}
+
+void LoggerTest::olderEntries()
+{
+  // Use a small block of entries in memory, and several files so that paging
+  // crosses file boundaries.
+  Logger::setMaxLogFileSize(2048);
+  Logger::setMaxLogFiles(100);
+  logEntries(0, 200);
+  QVERIFY(logFiles().size() > 2);
+
+  Logger::setMaxEntries(20);
+  Logger::setLogDirectory(m_tmpDir->path());
+  QCOMPARE(messages(Logger::log()), expectedMessages(180, 20));
+
+  LogFilePosition position = Logger::oldestPosition();
+  QVERIFY(position.isValid());
+
+  QList<LogEntry> older = Logger::readOlderEntries(position, 30);
+  QCOMPARE(messages(older), expectedMessages(150, 30));
+  QVERIFY(position.isValid());
+
+  older = Logger::readOlderEntries(position, 100);
+  QCOMPARE(messages(older), expectedMessages(50, 100));
+
+  older = Logger::readOlderEntries(position, 100);
+  QCOMPARE(messages(older), expectedMessages(0, 50));
+  QVERIFY(!position.isValid());
+
+  older = Logger::readOlderEntries(position, 100);
+  QVERIFY(older.isEmpty());
+
+  Logger::setMaxEntries(1000);
+}
+
+void LoggerTest::incompleteLine()
+{
+  logEntries(0, 3);
+  Logger::setLogDirectory(QString());
+
+  // Simulate a crash while writing an entry.
+  QFile file(QDir(m_tmpDir->path()).absoluteFilePath("log-0.jsonl"));
+  QVERIFY(file.open(QFile::WriteOnly | QFile::Append));
+  file.write("{\"message\":\"Trunc");
+  file.close();
+
+  Logger::setLogDirectory(m_tmpDir->path());
+  QCOMPARE(messages(Logger::log()), expectedMessages(0, 3));
+
+  logEntries(3, 2);
+  Logger::setLogDirectory(m_tmpDir->path());
+  QCOMPARE(messages(Logger::log()), expectedMessages(0, 5));
+}
+
+void LoggerTest::legacyLog()
+{
+  Logger::setLogDirectory(QString());
+
+  QJsonArray entries;
+  for (int i = 0; i < 5; ++i) {
+    QJsonObject entryObject;
+    LogEntry(LogEntry::Warning, QString("Entry %1").arg(i), i)
+        .writeSettings(entryObject);
+    entries.append(entryObject);
+  }
+  QJsonObject root;
+  root.insert("maxEntries", 1000);
+  root.insert("entries", entries);
+
+  QFile file(QDir(m_tmpDir->path()).absoluteFilePath("log.json"));
+  QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+  file.write(QJsonDocument(root).toJson());
+  file.close();
+
+  Logger::setLogDirectory(m_tmpDir->path());
+  QCOMPARE(messages(Logger::log()), expectedMessages(0, 5));
+  QVERIFY(!file.exists());
+  QCOMPARE(logFiles(), QStringList() << "log-0.jsonl");
+}
+
+void LoggerTest::clear()
+{
+  Logger::setMaxLogFileSize(1024);
+  logEntries(0, 50);
+  QVERIFY(logFiles().size() > 1);
+
+  Logger::clear();
+  QVERIFY(Logger::log().isEmpty());
+  LogFilePosition position = Logger::oldestPosition();
+  QVERIFY(Logger::readOlderEntries(position, 10).isEmpty());
+  QVERIFY(!position.isValid());
+
+  logEntries(50, 1);
+  Logger::setLogDirectory(m_tmpDir->path());
+  QCOMPARE(messages(Logger::log()), expectedMessages(50, 1));
+}
+
+void LoggerTest::logLevel()
+{
+  QCOMPARE(Logger::logLevel(), LogEntry::Notification);
+  QVERIFY(!Logger::isEnabled(LogEntry::DebugMessage));
+  QCOMPARE(Logger::suppressedCount(), 0);
+  QVERIFY(Logger::isEnabled(LogEntry::Notification));
+  QVERIFY(Logger::isEnabled(LogEntry::Error));
+
+  // Entries below the level are dropped and counted.
+  Logger::logDebugMessage("Dropped");
+  Logger::logNotification("Kept");
+  Logger::logError("Kept too");
+  QCOMPARE(messages(Logger::log()), QStringList() << "Kept" << "Kept too");
+  QCOMPARE(Logger::suppressedCount(), 1);
+
+  // Printing a type to qDebug enables it.
+  Logger::setPrintDebugMessages(true);
+  QVERIFY(Logger::isEnabled(LogEntry::DebugMessage));
+  Logger::setPrintDebugMessages(false);
+
+  Logger::setLogLevel(LogEntry::DebugMessage);
+  Logger::logDebugMessage("Recorded");
+  QCOMPARE(Logger::log().last().message(), QString("Recorded"));
+
+  Logger::setLogLevel(LogEntry::Error);
+  Logger::logWarning("Dropped");
+  QCOMPARE(Logger::log().last().message(), QString("Recorded"));
+  QCOMPARE(Logger::suppressedCount(), 2);
+
+  Logger::resetSuppressedCount();
+  QCOMPARE(Logger::suppressedCount(), 0);
+  Logger::setLogLevel(LogEntry::Notification);
+}
+
+void LoggerTest::benchmarkLogEntry()
+{
+  // Logging used to trim a linked list and rewrite the whole log at exit;
+  // now each entry is a ring buffer append plus one line written to the file.
+  Logger::setMaxEntries(100);
+  int i = 0;
+  QBENCHMARK {
+    Logger::logNotification(QString("Benchmark entry %1").arg(i++));
+  }
+  QCOMPARE(Logger::log().size(), qMin(i, 100));
+  Logger::setMaxEntries(1000);
+}
+
+void LoggerTest::benchmarkSuppressedEntry()
+{
+  // A disabled debug message with an expensive argument costs only the
+  // level check.
+  QJsonObject request;
+  for (int i = 0; i < 50; ++i)
+    request.insert(QString("key%1").arg(i), QString("Value %1").arg(i));
+
+  int i = 0;
+  QBENCHMARK {
+    if (Logger::isEnabled(LogEntry::DebugMessage)) {
+      Logger::logDebugMessage(QString("Request %1:\n%2").arg(i)
+                              .arg(QString(QJsonDocument(request).toJson())));
+    }
+    ++i;
+  }
+  QVERIFY(Logger::log().isEmpty());
+  // Skipped before reaching the Logger, so not counted either.
+  QCOMPARE(Logger::suppressedCount(), 0);
+}
+
+QTEST_MAIN(LoggerTest)
+
+#include "loggertest.moc"
@@ -50,6 +50,7 @@ private slots:
 
   // Test public methods
   void toJson(); // This indirectly (and more easily) tests toJsonObject().
+  void toPacket();
   void send();
   void generateResponse();
   void generateErrorResponse();
@@ -241,6 +242,46 @@ void MessageTest::toJson()
            QString(ReferenceString("message-ref/errorJson-arrayData.json")));
 }
 
+void MessageTest::toPacket()
+{
+  QJsonObject params;
+  params.insert("contents", QString("line 1\nline 2\n"));
+  params.insert("numberOfCores", 4);
+  Message request(Message::Request);
+  request.setMethod("submitJob");
+  request.setId(MoleQueue::MessageIdType(7));
+  request.setParams(params);
+
+  // Compact JSON carries no formatting whitespace.
+  MoleQueue::PacketType packet = request.toPacket();
+  QVERIFY(!packet.contains('\n'));
+  QVERIFY(packet.size() < request.toJson().size());
+  QCOMPARE(Message::fromPacket(packet).toObject(), request.toJsonObject());
+
+  // Whatever the encoding, the packet decodes to the same object.
+  if (Message::isEncodingSupported(MoleQueue::CborEncoding)) {
+    packet = request.toPacket(MoleQueue::CborEncoding);
+    QVERIFY(packet.at(0) != '{');
+    QCOMPARE(Message::fromPacket(packet).toObject(), request.toJsonObject());
+  }
+
+  // Indented JSON is still accepted.
+  QCOMPARE(Message::fromPacket(request.toJson()).toObject(),
+           request.toJsonObject());
+
+  QJsonParseError error;
+  QVERIFY(Message::fromPacket("{\"id\": ", &error).isNull());
+  QVERIFY(error.error != QJsonParseError::NoError);
+
+  // Encoding names
+  bool ok;
+  QCOMPARE(Message::encodingFromName("cbor", &ok), MoleQueue::CborEncoding);
+  QVERIFY(ok);
+  QCOMPARE(Message::encodingName(MoleQueue::JsonEncoding), QString("json"));
+  Message::encodingFromName("xml", &ok);
+  QVERIFY(!ok);
+}
+
 void MessageTest::send()
 {
   QCOMPARE(m_conn.messageCount(), 0);
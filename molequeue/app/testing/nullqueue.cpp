@@ -0,0 +1,47 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#include "nullqueue.h"
+
+#include "job.h"
+
+NullQueue::NullQueue(MoleQueue::QueueManager *parentManager)
+  : MoleQueue::Queue("Null", parentManager),
+    m_completeJobs(false)
+{
+}
+
+MoleQueue::Queue *NullQueue::create(MoleQueue::QueueManager *parentManager)
+{
+  return new NullQueue(parentManager);
+}
+
+bool NullQueue::submitJob(MoleQueue::Job job)
+{
+  job.setJobState(MoleQueue::Accepted);
+  if (m_completeJobs) {
+    job.setJobState(MoleQueue::QueuedLocal);
+    job.setJobState(MoleQueue::RunningLocal);
+    job.setJobState(MoleQueue::Finished);
+  }
+  return true;
+}
+
+void NullQueue::killJob(MoleQueue::Job job)
+{
+  job.setJobState(MoleQueue::Canceled);
+}
@@ -0,0 +1,48 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#ifndef NULLQUEUE_H
+#define NULLQUEUE_H
+
+#include "queue.h"
+
+/// Queue that accepts jobs without running anything, so that only the server
+/// and RPC overhead is measured. With setCompleteJobs(), submitted jobs are
+/// moved straight through to Finished, producing the usual notifications.
+class NullQueue : public MoleQueue::Queue
+{
+  Q_OBJECT
+public:
+  explicit NullQueue(MoleQueue::QueueManager *parentManager);
+
+  QString typeName() const { return "Null"; }
+
+  bool completeJobs() const { return m_completeJobs; }
+  void setCompleteJobs(bool complete) { m_completeJobs = complete; }
+
+  /// For QueueManager::registerQueueType().
+  static MoleQueue::Queue *create(MoleQueue::QueueManager *parentManager);
+
+public slots:
+  bool submitJob(MoleQueue::Job job);
+  void killJob(MoleQueue::Job job);
+
+private:
+  bool m_completeJobs;
+};
+
+#endif // NULLQUEUE_H
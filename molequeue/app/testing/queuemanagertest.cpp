@@ -33,6 +33,12 @@ public:
 public slots:
   bool submitJob(MoleQueue::Job) { return false; }
   void killJob(MoleQueue::Job) { }
+
+public:
+  static MoleQueue::Queue *create(MoleQueue::QueueManager *parentManager)
+  {
+    return new QueueDummy(parentManager);
+  }
 };
 
 class QueueManagerTest : public QObject
@@ -58,6 +64,7 @@ private slots:
   void testToQueueList();
   void testRemoveQueue();
   void testCleanup();
+  void testRegisterQueueType();
 };
 
 void QueueManagerTest::initTestCase()
@@ -138,6 +145,21 @@ void QueueManagerTest::testCleanup()
   QCOMPARE(q.data(), static_cast<MoleQueue::Queue*>(NULL));
 }
 
+void QueueManagerTest::testRegisterQueueType()
+{
+  MoleQueue::QueueManager manager;
+  QVERIFY(!MoleQueue::QueueManager::queueTypeIsValid("Dummy"));
+  QVERIFY(manager.addQueue("Dummy Queue", "Dummy") == NULL);
+
+  MoleQueue::QueueManager::registerQueueType("Dummy", &QueueDummy::create);
+  QVERIFY(MoleQueue::QueueManager::availableQueues().contains("Dummy"));
+  QVERIFY(MoleQueue::QueueManager::queueTypeIsValid("Dummy"));
+
+  MoleQueue::Queue *queue = manager.addQueue("Dummy Queue", "Dummy");
+  QVERIFY(qobject_cast<QueueDummy*>(queue) != NULL);
+  QCOMPARE(queue->name(), QString("Dummy Queue"));
+}
+
 QTEST_MAIN(QueueManagerTest)
 
 #include "queuemanagertest.moc"
@@ -18,6 +18,7 @@
 
 #include "dummyqueueremote.h"
 
+#include "blobstore.h"
 #include "dummyqueuemanager.h"
 #include "dummyserver.h"
 #include "filesystemtools.h"
@@ -27,6 +28,8 @@
 
 #include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
 
 using namespace MoleQueue;
 
@@ -56,6 +59,7 @@ private slots:
   void testKillPipeline();
   void testQueueUpdate();
   void testReplaceKeywords();
+  void testInputCachePipeline();
 };
 
 void QueueRemoteTest::initTestCase()
@@ -366,24 +370,24 @@ void QueueRemoteTest::testFinalizePipeline()
   ////////////////////////////////////////   and finalizeJobCleanup)
 
   ////////////////////////////
-  // recursiveCopyDirectory //
+  // recursiveCopyDirectory // (asynchronous, via DirectoryOperation)
   ////////////////////////////
-  QCOMPARE(QDir(job.outputDirectory()).entryList(),
-           QStringList() << "." << ".." << "input.in" << "launcher.dummy"
-           << "mqjobinfo.json");
+  QTRY_COMPARE(QDir(job.outputDirectory()).entryList(),
+               QStringList() << "." << ".." << "input.in" << "launcher.dummy"
+               << "mqjobinfo.json");
 
   ////////////////////////
   // finalizeJobCleanup // (calls cleanLocalDirectory
   ////////////////////////   and cleanRemoteDirectory)
 
-  QCOMPARE(job.jobState(), Finished);
+  QTRY_COMPARE(job.jobState(), Finished);
 
   /////////////////////////
-  // cleanLocalDirectory //
+  // cleanLocalDirectory // (asynchronous, via DirectoryOperation)
   /////////////////////////
 
-  QCOMPARE(QDir(job.localWorkingDirectory()).entryList(),
-           QStringList() << "." << "..");
+  QTRY_COMPARE(QDir(job.localWorkingDirectory()).entryList(),
+               QStringList() << "." << "..");
 
   //////////////////////////
   // cleanRemoteDirectory //
@@ -537,6 +541,91 @@ void QueueRemoteTest::testReplaceKeywords()
                    "Test sixth line\nSafe maxWallTime=24:00:00\n"));
 }
 
+void QueueRemoteTest::testInputCachePipeline()
+{
+  QTemporaryDir blobDir;
+  QVERIFY(blobDir.isValid());
+  BlobStore *store = BlobStore::instance();
+  store->setDirectory(blobDir.path());
+  int hits = store->hits();
+
+  QString basis("shared basis set");
+  QString basisHash = BlobStore::hash(basis.toLocal8Bit());
+  QString cacheFile = "/some/path/.molequeue-cache/" + basisHash;
+
+  for (int i = 0; i < 2; ++i) {
+    bool cached = (i == 1);
+    Job job = m_server.jobManager()->newJob();
+    job.setQueue("Dummy");
+    job.setProgram("DummyProgram");
+    job.setInputFile(FileSpecification("input.in", QString("job %1").arg(i)));
+    job.setAdditionalInputFiles(QList<FileSpecification>()
+                                << FileSpecification("basis.dat", basis));
+    m_queue->submitJob(job);
+    m_queue->submitPendingJobs();
+    QString remoteDir = "/some/path/" + idTypeToString(job.moleQueueId());
+
+    // The additional input file is a writable copy from the blob store
+    QFile basisFile(job.localWorkingDirectory() + "/basis.dat");
+    QVERIFY(basisFile.open(QFile::ReadOnly | QFile::Text));
+    QCOMPARE(QString(basisFile.readAll()), basis);
+    QVERIFY(basisFile.permissions() & QFile::WriteOwner);
+    QCOMPARE(store->hits(), hits + i);
+    QCOMPARE(job.inputFileHashes().value("basis.dat"), basisHash);
+
+    // checkRemoteInputCache
+    DummySshCommand *ssh = m_queue->getDummySshCommand();
+    QCOMPARE(ssh->getDummyCommand(), QString("ssh"));
+    QCOMPARE(ssh->getDummyArgs(), QStringList()
+             << "-q"
+             << "-p" << "6887"
+             << "aUser@some.host.somewhere"
+             << QString("mkdir -p %1 /some/path/.molequeue-cache && cd %1 && "
+                        "{ if [ -f %2 ]; then cp %2 'basis.dat' && "
+                        "chmod u+w 'basis.dat'; else echo %3; fi; }")
+             .arg(remoteDir, cacheFile, basisHash));
+    ssh->setDummyExitCode(0);
+    ssh->setDummyOutput(cached ? QString() : basisHash + "\n");
+    ssh->emitDummyRequestComplete(); // triggers remoteInputCacheChecked
+
+    // Upload everything but the cached files
+    ssh = m_queue->getDummySshCommand();
+    QCOMPARE(ssh->getDummyCommand(), QString("scp"));
+    QStringList dummyArgs = ssh->getDummyArgs();
+    QCOMPARE(dummyArgs.last(),
+             QString("aUser@some.host.somewhere:%1").arg(remoteDir));
+    QStringList uploads;
+    foreach (const QString &arg, dummyArgs.mid(6, dummyArgs.size() - 7))
+      uploads << QFileInfo(arg).fileName();
+    QStringList expectedUploads;
+    if (!cached)
+      expectedUploads << "basis.dat";
+    expectedUploads << "input.in" << "launcher.dummy";
+    QCOMPARE(uploads, expectedUploads);
+    ssh->setDummyExitCode(0);
+    ssh->emitDummyRequestComplete(); // triggers inputFilesCopied
+
+    // updateRemoteInputCache, only if something was uploaded
+    if (!cached) {
+      ssh = m_queue->getDummySshCommand();
+      QCOMPARE(ssh->getDummyCommand(), QString("ssh"));
+      QCOMPARE(ssh->getDummyArgs().last(),
+               QString("cd %1 && cp 'basis.dat' %2 && chmod a-w %2")
+               .arg(remoteDir, cacheFile));
+      ssh->setDummyExitCode(0);
+      ssh->emitDummyRequestComplete(); // triggers remoteInputCacheUpdated
+    }
+
+    // submitJobToRemoteQueue
+    ssh = m_queue->getDummySshCommand();
+    QCOMPARE(ssh->getDummyArgs().last(),
+             QString("cd %1 && subComm launcher.dummy").arg(remoteDir));
+    QCOMPARE(ssh->data().value<Job>(), job);
+  }
+
+  store->setDirectory(QString());
+}
+
 QTEST_MAIN(QueueRemoteTest)
 
 #include "queueremotetest.moc"
@@ -16,13 +16,15 @@
 
 #include <QtTest>
 
-#include "server.h"
+#include "guiserver.h"
 
 #include "molequeuetestconfig.h"
 
 #include "actionfactorymanager.h"
 #include "jobactionfactories/openwithactionfactory.h"
+#include "idtypeutils.h"
 #include "jobmanager.h"
+#include "logger.h"
 #include "program.h"
 #include <molequeue/servercore/localsocketconnectionlistener.h>
 #include "testing/dummyconnection.h"
@@ -36,6 +38,7 @@
 #include <QtNetwork/QLocalServer>
 #include <QtNetwork/QLocalSocket>
 
+#include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QVariantList>
 
@@ -75,6 +78,10 @@ private slots:
   void handleMessage();
 
   void verifyOpenWithHandler();
+
+  void listJobs();
+
+  void benchmarkSubmitJob();
 };
 
 void ServerTest::initTestCase()
@@ -89,7 +96,7 @@ void ServerTest::initTestCase()
   settings.setValue("workingDirectoryBase", workDir);
 
   m_connectionString = TestServer::getRandomSocketName();
-  m_server = new Server(this, m_connectionString);
+  m_server = new GuiServer(this, m_connectionString);
 
   // Setup some fake queues/programs for rpc testing
   Queue *testQueue = m_server->queueManager()->addQueue("testQueue", "Local");
@@ -379,6 +386,110 @@ void ServerTest::verifyOpenWithHandler()
   QCOMPARE(patterns[1].caseSensitivity(), Qt::CaseInsensitive);
 }
 
+void ServerTest::listJobs()
+{
+  QJsonObject jobState;
+  jobState.insert("queue", QString("listJobsQueue"));
+  jobState.insert("program", QString("fakeProgram1"));
+  QList<IdType> ids;
+  for (int i = 0; i < 3; ++i) {
+    jobState.insert("description", QString("listJobs %1").arg(i));
+    Job job = m_server->jobManager()->newJob(jobState);
+    job.setJobState(i == 1 ? MoleQueue::Finished : MoleQueue::QueuedLocal);
+    ids << job.moleQueueId();
+    QVERIFY(job.submissionTime().isValid());
+  }
+
+  DummyConnection conn;
+  Message request(Message::Request, &conn);
+  request.setMethod("listJobs");
+  request.setId(MessageIdType(1));
+  QJsonObject params;
+  params.insert("queues", QJsonArray() << QString("listJobsQueue"));
+  params.insert("fields", QJsonArray() << QString("jobState"));
+  params.insert("limit", 2);
+  request.setParams(params);
+
+  // First page
+  m_server->handleMessage(request);
+  QCOMPARE(conn.messageCount(), 1);
+  QJsonObject result = conn.popMessage().result().toObject();
+  QJsonArray jobs = result.value("jobs").toArray();
+  QCOMPARE(jobs.size(), 2);
+  QCOMPARE(toIdType(jobs[0].toObject().value("moleQueueId")), ids[0]);
+  QCOMPARE(toIdType(jobs[1].toObject().value("moleQueueId")), ids[1]);
+  QCOMPARE(jobs[1].toObject().value("jobState").toString(),
+           QString("Finished"));
+  // Only the requested fields are sent
+  QCOMPARE(jobs[0].toObject().keys(),
+           QStringList() << "jobState" << "moleQueueId");
+  QCOMPARE(toIdType(result.value("nextCursor")), ids[1]);
+
+  // Second page
+  params.insert("cursor", result.value("nextCursor"));
+  request.setParams(params);
+  m_server->handleMessage(request);
+  QCOMPARE(conn.messageCount(), 1);
+  result = conn.popMessage().result().toObject();
+  jobs = result.value("jobs").toArray();
+  QCOMPARE(jobs.size(), 1);
+  QCOMPARE(toIdType(jobs[0].toObject().value("moleQueueId")), ids[2]);
+  QVERIFY(result.value("nextCursor").isNull());
+
+  // State and description filters
+  params.remove("cursor");
+  params.insert("states", QJsonArray() << QString("QueuedLocal"));
+  params.insert("descriptionContains", QString("LISTJOBS 2"));
+  request.setParams(params);
+  m_server->handleMessage(request);
+  jobs = conn.popMessage().result().toObject().value("jobs").toArray();
+  QCOMPARE(jobs.size(), 1);
+  QCOMPARE(toIdType(jobs[0].toObject().value("moleQueueId")), ids[2]);
+
+  // Invalid filters are rejected
+  params.insert("states", QJsonArray() << QString("NotAState"));
+  request.setParams(params);
+  m_server->handleMessage(request);
+  QCOMPARE(conn.popMessage().errorCode(), -32602);
+
+  m_server->jobManager()->removeJobs(ids);
+}
+
+// Submission throughput with debug logging disabled. The request is no longer
+// serialized for a debug message that is then dropped.
+void ServerTest::benchmarkSubmitJob()
+{
+  ReferenceString requestString("server-ref/submitJob-request.json");
+  QJsonDocument doc =
+      QJsonDocument::fromJson(requestString.toString().toLatin1());
+  QVERIFY(doc.isObject());
+
+  DummyConnection conn;
+  Message message(doc.object(), &conn);
+  QVERIFY(message.parse());
+
+  // The level is saved to QSettings; put it back for the other tests.
+  const LogEntry::LogEntryType logLevel = Logger::logLevel();
+  const bool printDebugMessages = Logger::printDebugMessages();
+  Logger::setLogLevel(LogEntry::Notification);
+  Logger::setPrintDebugMessages(false);
+  QSignalSpy debugMessages(Logger::getInstance(),
+                           SIGNAL(newDebugMessage(MoleQueue::LogEntry)));
+
+  int submitted = 0;
+  QBENCHMARK {
+    m_server->handleMessage(message);
+    conn.popMessage();
+    ++submitted;
+  }
+
+  Logger::setLogLevel(logLevel);
+  Logger::setPrintDebugMessages(printDebugMessages);
+
+  QVERIFY(submitted > 0);
+  QCOMPARE(debugMessages.count(), 0);
+}
+
 QTEST_MAIN(ServerTest)
 
 #include "servertest.moc"
@@ -0,0 +1,250 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "serverthread.h"
+
+#include "molequeuetestconfig.h"
+
+#include "jobmanager.h"
+#include "queuemanager.h"
+#include "server.h"
+#include "testing/testserver.h"
+
+#include <QtNetwork/QLocalSocket>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDataStream>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+
+#include <algorithm>
+
+using namespace MoleQueue;
+
+/// Sends listQueues requests one at a time and records how long each reply
+/// takes to arrive.
+class LatencyClient : public QThread
+{
+public:
+  LatencyClient(const QString &socketName, int requests)
+    : m_socketName(socketName), m_requests(requests), m_failed(false)
+  {
+  }
+
+  QList<qint64> latencies() const { return m_latencies; }
+  bool failed() const { return m_failed; }
+
+protected:
+  void run()
+  {
+    QLocalSocket socket;
+    socket.connectToServer(m_socketName);
+    if (!socket.waitForConnected(5000)) {
+      m_failed = true;
+      return;
+    }
+
+    QElapsedTimer timer;
+    for (int i = 0; i < m_requests; ++i) {
+      QByteArray request = QString("{\"jsonrpc\":\"2.0\",\"id\":%1,"
+                                   "\"method\":\"listQueues\"}")
+          .arg(i).toLatin1();
+      QByteArray packet;
+      QDataStream stream(&packet, QIODevice::WriteOnly);
+      stream.setVersion(QDataStream::Qt_4_8);
+      stream << request;
+
+      timer.start();
+      socket.write(packet);
+      socket.flush();
+      if (!readReply(socket)) {
+        m_failed = true;
+        return;
+      }
+      m_latencies << timer.elapsed();
+    }
+
+    socket.disconnectFromServer();
+  }
+
+private:
+  /// Read one QDataStream-framed QByteArray from @a socket.
+  bool readReply(QLocalSocket &socket)
+  {
+    QByteArray buffer;
+    quint32 size = 0;
+    forever {
+      buffer += socket.readAll();
+      if (size == 0 && buffer.size() >= 4) {
+        QDataStream header(buffer);
+        header.setVersion(QDataStream::Qt_4_8);
+        header >> size;
+      }
+      if (size != 0 && static_cast<quint32>(buffer.size()) >= size + 4)
+        return true;
+      if (!socket.waitForReadyRead(5000))
+        return false;
+    }
+  }
+
+  QString m_socketName;
+  int m_requests;
+  bool m_failed;
+  QList<qint64> m_latencies;
+};
+
+/// Counts the calls to touch(), made in whatever thread it lives in.
+class ThreadProbe : public QObject
+{
+  Q_OBJECT
+public:
+  int touches() const { return m_touches.load(); }
+
+public slots:
+  void touch() { m_touches.ref(); }
+
+private:
+  QAtomicInt m_touches;
+};
+
+class ServerThreadTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  Server *m_server;
+  QString m_socketName;
+
+private slots:
+  /// Called before the first test function is executed.
+  void initTestCase();
+  /// Called after the last test function is executed.
+  void cleanupTestCase();
+
+  void testStartStop();
+  void testLocker();
+  void testLatencyWhileGuiBusy();
+};
+
+void ServerThreadTest::initTestCase()
+{
+  // Change qsettings so that we don't overwrite the installed configuration:
+  QString workDir = MoleQueue_BINARY_DIR "/Testing/Temporary/ServerThreadTest";
+  QDir dir;
+  dir.mkpath(workDir);
+  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+                     workDir + "/config");
+  QSettings settings;
+  settings.setValue("workingDirectoryBase", workDir);
+
+  m_socketName = TestServer::getRandomSocketName();
+  m_server = new Server(NULL, m_socketName);
+  m_server->queueManager()->addQueue("testQueue", "Local");
+  m_server->start();
+}
+
+void ServerThreadTest::cleanupTestCase()
+{
+  delete m_server;
+}
+
+void ServerThreadTest::testStartStop()
+{
+  ServerThread thread(m_server);
+  QVERIFY(thread.canRun());
+  QVERIFY(thread.startServer());
+  QVERIFY(thread.isRunning());
+  QCOMPARE(m_server->thread(), static_cast<QThread*>(&thread));
+  QCOMPARE(m_server->jobManager()->thread(), static_cast<QThread*>(&thread));
+
+  thread.stopServer();
+  QVERIFY(!thread.isRunning());
+  QCOMPARE(m_server->thread(), QThread::currentThread());
+  QCOMPARE(m_server->jobManager()->thread(), QThread::currentThread());
+}
+
+void ServerThreadTest::testLocker()
+{
+  ThreadProbe probe;
+  ServerThread thread(m_server);
+  QVERIFY(thread.startServer());
+  QCOMPARE(ServerThread::forObject(m_server->queueManager()), &thread);
+  probe.moveToThread(&thread);
+
+  {
+    ServerThreadLocker locker(m_server->queueManager());
+    // The server stays on its thread, which is paused.
+    QVERIFY(thread.isRunning());
+    QCOMPARE(m_server->thread(), static_cast<QThread*>(&thread));
+    QMetaObject::invokeMethod(&probe, "touch", Qt::QueuedConnection);
+    QTest::qWait(100);
+    QCOMPARE(probe.touches(), 0);
+
+    // Nested lockers are no-ops.
+    ServerThreadLocker nested(m_server->jobManager());
+  }
+
+  QTRY_COMPARE(probe.touches(), 1);
+  QCOMPARE(m_server->thread(), static_cast<QThread*>(&thread));
+
+  // Explicit locks nest.
+  thread.lock();
+  thread.lock();
+  thread.unlock();
+  QMetaObject::invokeMethod(&probe, "touch", Qt::QueuedConnection);
+  QTest::qWait(100);
+  QCOMPARE(probe.touches(), 1);
+  thread.unlock();
+  QTRY_COMPARE(probe.touches(), 2);
+
+  // The destructor brings the server home.
+}
+
+void ServerThreadTest::testLatencyWhileGuiBusy()
+{
+  const int requests = 200;
+  ServerThread thread(m_server);
+  QVERIFY(thread.startServer());
+
+  LatencyClient client(m_socketName, requests);
+  client.start();
+
+  // Keep this (the "GUI") thread busy without processing events. Requests must
+  // still be answered by the server thread.
+  QElapsedTimer timer;
+  timer.start();
+  while (!client.isFinished() && timer.elapsed() < 30000)
+    QTest::qSleep(100);
+
+  QVERIFY(client.wait(5000));
+  QVERIFY(!client.failed());
+
+  QList<qint64> latencies = client.latencies();
+  QCOMPARE(latencies.size(), requests);
+  std::sort(latencies.begin(), latencies.end());
+  qDebug() << "listQueues latency with a busy GUI thread (ms): median"
+           << latencies.at(latencies.size() / 2)
+           << "max" << latencies.last();
+
+  thread.stopServer();
+  QCOMPARE(m_server->thread(), QThread::currentThread());
+}
+
+QTEST_MAIN(ServerThreadTest)
+
+#include "serverthreadtest.moc"
@@ -0,0 +1,223 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <QtTest>
+
+#include "queues/uit/tararchivedevice.h"
+#include "queues/uit/tarextractdevice.h"
+
+#include "molequeuetestconfig.h"
+
+#include <QtCore/QProcess>
+#include <QtCore/QStandardPaths>
+
+using MoleQueue::Uit::TarArchiveDevice;
+using MoleQueue::Uit::TarExtractDevice;
+
+class TarArchiveTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  QString m_workDir;
+  QString m_sourceDir;
+  /// Relative path -> contents of the files in m_sourceDir.
+  QMap<QString, QByteArray> m_files;
+
+  void writeFile(const QString &name, const QByteArray &contents);
+  void compareTree(const QString &dir);
+  bool extract(const QByteArray &archive, const QString &dir,
+               int chunkSize = 1000);
+
+private slots:
+  /// Called before the first test function is executed.
+  void initTestCase();
+
+  void testRoundTrip();
+  void testSeek();
+  void testSystemTar();
+  void testRejectOutsidePaths();
+  void testTruncatedArchive();
+};
+
+void TarArchiveTest::writeFile(const QString &name, const QByteArray &contents)
+{
+  QString path = m_sourceDir + "/" + name;
+  QDir().mkpath(QFileInfo(path).path());
+  QFile file(path);
+  QVERIFY(file.open(QFile::WriteOnly | QFile::Truncate));
+  file.write(contents);
+  m_files.insert(name, contents);
+}
+
+void TarArchiveTest::compareTree(const QString &dir)
+{
+  foreach (const QString &name, m_files.keys()) {
+    QFile file(dir + "/" + name);
+    QVERIFY2(file.open(QFile::ReadOnly), qPrintable(name));
+    QCOMPARE(file.readAll(), m_files.value(name));
+  }
+  QVERIFY(QDir(dir + "/emptydir").exists());
+  QVERIFY(QFileInfo(dir + "/run.sh").permissions() & QFile::ExeOwner);
+}
+
+bool TarArchiveTest::extract(const QByteArray &archive, const QString &dir,
+                             int chunkSize)
+{
+  QDir(dir).removeRecursively();
+  TarExtractDevice extractor(dir);
+  if (!extractor.open(QIODevice::WriteOnly))
+    return false;
+
+  // Arbitrary chunks, as from the network.
+  for (int i = 0; i < archive.size(); i += chunkSize) {
+    QByteArray chunk = archive.mid(i, chunkSize);
+    if (extractor.write(chunk) != chunk.size())
+      return false;
+  }
+  extractor.close();
+
+  return extractor.isComplete();
+}
+
+void TarArchiveTest::initTestCase()
+{
+  m_workDir = MoleQueue_BINARY_DIR "/Testing/Temporary/TarArchiveTest";
+  m_sourceDir = m_workDir + "/source";
+  QDir(m_workDir).removeRecursively();
+  QDir().mkpath(m_sourceDir + "/emptydir");
+
+  QByteArray binary;
+  for (int i = 0; i < 70000; ++i)
+    binary.append(static_cast<char>((i * 7) % 256));
+
+  writeFile("input.txt", "Some input\n");
+  writeFile("sub/data.bin", binary);
+  writeFile("sub/empty", QByteArray());
+  writeFile("sub/block", QByteArray(512, 'b'));
+  // Longer than the 100 byte name field, so the ustar prefix is used.
+  writeFile(QString("a_rather_long_directory_name/").repeated(4) + "file.txt",
+            "deep\n");
+  writeFile("run.sh", "#!/bin/sh\necho hello\n");
+  QFile::setPermissions(m_sourceDir + "/run.sh",
+                        QFile::permissions(m_sourceDir + "/run.sh")
+                        | QFile::ExeOwner | QFile::ExeUser);
+}
+
+void TarArchiveTest::testRoundTrip()
+{
+  TarArchiveDevice archive(m_sourceDir);
+  QVERIFY(archive.open(QIODevice::ReadOnly));
+  QCOMPARE(archive.size() % 512, Q_INT64_C(0));
+
+  QByteArray bytes = archive.readAll();
+  QCOMPARE(static_cast<qint64>(bytes.size()), archive.size());
+  QVERIFY(archive.atEnd());
+
+  QVERIFY(extract(bytes, m_workDir + "/roundtrip"));
+  compareTree(m_workDir + "/roundtrip");
+
+  // Byte at a time exercises every state boundary.
+  QVERIFY(extract(bytes, m_workDir + "/bytewise", 1));
+  compareTree(m_workDir + "/bytewise");
+}
+
+void TarArchiveTest::testSeek()
+{
+  TarArchiveDevice archive(m_sourceDir);
+  QVERIFY(archive.open(QIODevice::ReadOnly));
+  QByteArray bytes = archive.readAll();
+
+  // Seek into a header, into file contents, and back to the start.
+  QVERIFY(archive.seek(100));
+  QCOMPARE(archive.read(50), bytes.mid(100, 50));
+  QVERIFY(archive.seek(bytes.size() / 2));
+  QCOMPARE(archive.read(5000), bytes.mid(bytes.size() / 2, 5000));
+  QVERIFY(archive.reset());
+  QCOMPARE(archive.readAll(), bytes);
+}
+
+void TarArchiveTest::testSystemTar()
+{
+  QString tar = QStandardPaths::findExecutable("tar");
+  if (tar.isEmpty())
+    QSKIP("tar is not available.");
+
+  // Our archive must be readable by tar...
+  TarArchiveDevice archive(m_sourceDir);
+  QVERIFY(archive.open(QIODevice::ReadOnly));
+  QFile archiveFile(m_workDir + "/ours.tar");
+  QVERIFY(archiveFile.open(QFile::WriteOnly | QFile::Truncate));
+  archiveFile.write(archive.readAll());
+  archiveFile.close();
+
+  QDir().mkpath(m_workDir + "/systemextract");
+  QProcess process;
+  process.start(tar, QStringList() << "-xf" << archiveFile.fileName()
+                << "-C" << m_workDir + "/systemextract");
+  QVERIFY(process.waitForFinished());
+  QCOMPARE(process.exitCode(), 0);
+  compareTree(m_workDir + "/systemextract");
+
+  // ...and we must read what tar writes on the remote host.
+  process.start(tar, QStringList() << "-cf" << m_workDir + "/theirs.tar"
+                << "-C" << m_sourceDir << ".");
+  QVERIFY(process.waitForFinished());
+  QCOMPARE(process.exitCode(), 0);
+
+  QFile theirs(m_workDir + "/theirs.tar");
+  QVERIFY(theirs.open(QFile::ReadOnly));
+  QVERIFY(extract(theirs.readAll(), m_workDir + "/fromsystem", 4096));
+  compareTree(m_workDir + "/fromsystem");
+}
+
+void TarArchiveTest::testRejectOutsidePaths()
+{
+  // A single file entry named "../evil".
+  QByteArray header(512, '\0');
+  memcpy(header.data(), "../evil", 7);
+  memcpy(header.data() + 100, "0000644", 7);
+  memcpy(header.data() + 124, "00000000000", 11);
+  header[156] = '0';
+  memset(header.data() + 148, ' ', 8);
+  int checksum = 0;
+  for (int i = 0; i < header.size(); ++i)
+    checksum += static_cast<unsigned char>(header[i]);
+  QByteArray field = QByteArray::number(checksum, 8).rightJustified(6, '0');
+  memcpy(header.data() + 148, field.constData(), 6);
+  header[154] = '\0';
+
+  TarExtractDevice extractor(m_workDir + "/jail");
+  QVERIFY(extractor.open(QIODevice::WriteOnly));
+  QCOMPARE(extractor.write(header), Q_INT64_C(-1));
+  QVERIFY(!QFile::exists(m_workDir + "/evil"));
+}
+
+void TarArchiveTest::testTruncatedArchive()
+{
+  TarArchiveDevice archive(m_sourceDir);
+  QVERIFY(archive.open(QIODevice::ReadOnly));
+  QByteArray bytes = archive.readAll();
+
+  TarExtractDevice extractor(m_workDir + "/truncated");
+  QVERIFY(extractor.open(QIODevice::WriteOnly));
+  extractor.write(bytes.left(bytes.size() / 2));
+  QVERIFY(!extractor.isComplete());
+}
+
+QTEST_MAIN(TarArchiveTest)
+
+#include "tararchivetest.moc"
@@ -0,0 +1,340 @@
+/******************************************************************************
+
+ This source file is part of the MoleQueue project.
+
+ Copyright 2012 Kitware, Inc.
+
+ This source code is released under the New BSD License, (the "License").
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+ ******************************************************************************/
+
+#include <QtTest>
+
+#include "queues/uit/latencyhistogram.h"
+#include "queues/uit/requests.h"
+#include "queues/uit/session.h"
+#include "queues/uit/sessionmanager.h"
+
+#include <QtCore/QPointer>
+#include <QtCore/QXmlStreamReader>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+using MoleQueue::Uit::GetUserHostAssocRequest;
+using MoleQueue::Uit::LatencyHistogram;
+using MoleQueue::Uit::Session;
+using MoleQueue::Uit::SessionManager;
+
+/// Minimal stand-in for the UIT SOAP endpoint. Each rpc/encoded call is
+/// answered with a "<operation>Response" element holding an empty
+/// "<operation>Return" string, as described by uitapi.wsdl. Calls made with a
+/// rejected token get the fault the UIT server uses for invalid tokens.
+/// Responses are delayed so that concurrent requests overlap.
+class UitEndpoint : public QTcpServer
+{
+  Q_OBJECT
+public:
+  UitEndpoint()
+    : m_responseDelay(20), connectionCount(0)
+  {
+    connect(this, SIGNAL(newConnection()), SLOT(acceptConnection()));
+  }
+
+  QString url() const
+  {
+    return QString("http://127.0.0.1:%1/UITAPIv3/uitapi.jws")
+        .arg(serverPort());
+  }
+
+  /// Tokens to answer with an "Invalid Token" fault.
+  QStringList rejectedTokens;
+  /// The operation and token of each call received, in order.
+  QStringList operations;
+  QStringList tokens;
+  /// The number of TCP connections accepted.
+  int connectionCount;
+
+private slots:
+  void acceptConnection()
+  {
+    while (QTcpSocket *socket = nextPendingConnection()) {
+      ++connectionCount;
+      connect(socket, SIGNAL(readyRead()), SLOT(readRequest()));
+    }
+  }
+
+  void readRequest()
+  {
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    QByteArray &buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    // Connections are kept alive, so one buffer may hold several requests.
+    forever {
+      int headerEnd = buffer.indexOf("\r\n\r\n");
+      if (headerEnd < 0)
+        return;
+
+      int contentLength = 0;
+      foreach (const QByteArray &line, buffer.left(headerEnd).split('\n')) {
+        if (line.toLower().startsWith("content-length:"))
+          contentLength = line.mid(15).trimmed().toInt();
+      }
+      if (buffer.size() < headerEnd + 4 + contentLength)
+        return;
+
+      QByteArray body = buffer.mid(headerEnd + 4, contentLength);
+      buffer.remove(0, headerEnd + 4 + contentLength);
+
+      m_responses.enqueue(qMakePair(QPointer<QTcpSocket>(socket),
+                                    handle(body)));
+      QTimer::singleShot(m_responseDelay, this, SLOT(sendResponse()));
+    }
+  }
+
+  void sendResponse()
+  {
+    QPair<QPointer<QTcpSocket>, QByteArray> response = m_responses.dequeue();
+    if (response.first)
+      response.first->write(response.second);
+  }
+
+private:
+  QByteArray handle(const QByteArray &body)
+  {
+    // The call is the first element in the SOAP body, the parameters are its
+    // children.
+    QString operation;
+    QString token;
+    QXmlStreamReader reader(body);
+    bool inBody = false;
+    while (!reader.atEnd()) {
+      reader.readNext();
+      if (!reader.isStartElement())
+        continue;
+      if (reader.name() == "Body")
+        inBody = true;
+      else if (inBody && operation.isEmpty())
+        operation = reader.name().toString();
+      else if (inBody && reader.name() == "token")
+        token = reader.readElementText();
+    }
+
+    operations << operation;
+    tokens << token;
+
+    QByteArray status = "200 OK";
+    QByteArray content;
+    if (rejectedTokens.contains(token)) {
+      status = "500 Internal Server Error";
+      content = "<soapenv:Fault>"
+                "<faultcode>soapenv:Server.userException</faultcode>"
+                "<faultstring>java.lang.Exception: Invalid Token</faultstring>"
+                "</soapenv:Fault>";
+    }
+    else {
+      content = QString("<ns1:%1Response soapenv:encodingStyle="
+                        "\"http://schemas.xmlsoap.org/soap/encoding/\" "
+                        "xmlns:ns1=\"https://www.uit.hpc.mil/UITAPIv3/"
+                        "uitapi.jws\">"
+                        "<%1Return xsi:type=\"xsd:string\"></%1Return>"
+                        "</ns1:%1Response>").arg(operation).toUtf8();
+    }
+
+    QByteArray envelope =
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+        "<soapenv:Envelope "
+        "xmlns:soapenv=\"http://schemas.xmlsoap.org/soap/envelope/\" "
+        "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" "
+        "xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">"
+        "<soapenv:Body>" + content + "</soapenv:Body></soapenv:Envelope>";
+
+    return "HTTP/1.1 " + status + "\r\n"
+        "Content-Type: text/xml; charset=utf-8\r\n"
+        "Content-Length: " + QByteArray::number(envelope.size()) + "\r\n\r\n"
+        + envelope;
+  }
+
+  int m_responseDelay;
+  QHash<QTcpSocket *, QByteArray> m_buffers;
+  QQueue<QPair<QPointer<QTcpSocket>, QByteArray> > m_responses;
+};
+
+class UitSessionTest : public QObject
+{
+  Q_OBJECT
+
+private:
+  UitEndpoint m_endpoint;
+
+private slots:
+  /// Called before the first test function is executed.
+  void initTestCase();
+  /// Called before each test function is executed.
+  void init();
+
+  void testSessionManager();
+  void testLatencyHistogram();
+  void testTokenExpiry();
+  void testConcurrentRequests();
+  void testRejectedToken();
+};
+
+void UitSessionTest::initTestCase()
+{
+  QVERIFY(m_endpoint.listen(QHostAddress::LocalHost));
+}
+
+void UitSessionTest::init()
+{
+  m_endpoint.rejectedTokens.clear();
+  m_endpoint.operations.clear();
+  m_endpoint.tokens.clear();
+}
+
+void UitSessionTest::testSessionManager()
+{
+  SessionManager *manager = SessionManager::instance();
+
+  // Queues for the same principal share a session, and so its token.
+  Session *session = manager->session("user", "REALM");
+  QCOMPARE(manager->session("user", "REALM"), session);
+  QCOMPARE(session->kerberosPrinciple(), QString("user@REALM"));
+  QVERIFY(manager->session("other", "REALM") != session);
+  QVERIFY(manager->session("user", "OTHER") != session);
+}
+
+void UitSessionTest::testLatencyHistogram()
+{
+  LatencyHistogram histogram;
+  QCOMPARE(histogram.count(), Q_INT64_C(0));
+  QCOMPARE(histogram.percentile(0.5), Q_INT64_C(-1));
+
+  // Buckets are [0, 1), [1, 2), [2, 4), [4, 8) ...
+  histogram.add(0);
+  histogram.add(1);
+  histogram.add(3);
+  histogram.add(3);
+  histogram.add(100);
+
+  QCOMPARE(histogram.count(), Q_INT64_C(5));
+  QCOMPARE(histogram.min(), Q_INT64_C(0));
+  QCOMPARE(histogram.max(), Q_INT64_C(100));
+  QCOMPARE(histogram.mean(), 107.0 / 5);
+  QCOMPARE(histogram.bucket(0), Q_INT64_C(1));
+  QCOMPARE(histogram.bucket(1), Q_INT64_C(1));
+  QCOMPARE(histogram.bucket(2), Q_INT64_C(2));
+  QCOMPARE(histogram.bucket(7), Q_INT64_C(1));
+  QCOMPARE(LatencyHistogram::bucketUpperBound(7), Q_INT64_C(128));
+
+  QCOMPARE(histogram.percentile(0.5), Q_INT64_C(4));
+  // Capped at the longest latency rather than the bucket bound.
+  QCOMPARE(histogram.percentile(1.0), Q_INT64_C(100));
+
+  // Very long latencies land in the last bucket.
+  histogram.add(Q_INT64_C(1) << 40);
+  QCOMPARE(histogram.bucket(histogram.bucketCount() - 1), Q_INT64_C(1));
+}
+
+void UitSessionTest::testTokenExpiry()
+{
+  Session session("user", "REALM");
+  QVERIFY(session.isTokenExpired());
+
+  session.setToken("token");
+  QVERIFY(!session.isTokenExpired());
+
+  // A rejection of an older token doesn't discard the current one.
+  session.tokenRejected("older");
+  QCOMPARE(session.token(), QString("token"));
+  session.tokenRejected("token");
+  QVERIFY(session.isTokenExpired());
+
+  session.setToken("token");
+  session.setTokenLifetime(1);
+  QVERIFY(!session.isTokenExpired());
+  QTest::qWait(1100);
+  QVERIFY(session.isTokenExpired());
+}
+
+void UitSessionTest::testConcurrentRequests()
+{
+  Session session("user", "REALM");
+  session.uitService()->setEndPoint(m_endpoint.url());
+  session.setToken("token");
+
+  int connections = m_endpoint.connectionCount;
+
+  QList<GetUserHostAssocRequest *> requests;
+  QList<QSignalSpy *> spies;
+  for (int i = 0; i < 10; ++i) {
+    GetUserHostAssocRequest *request = new GetUserHostAssocRequest(&session,
+                                                                   this);
+    requests << request;
+    spies << new QSignalSpy(request, SIGNAL(finished()));
+    request->submit();
+  }
+
+  for (int i = 0; i < spies.size(); ++i)
+    QTRY_COMPARE(spies[i]->count(), 1);
+
+  QCOMPARE(m_endpoint.operations.size(), 10);
+  QCOMPARE(m_endpoint.operations.count("getUserHostAssoc"), 10);
+  QCOMPARE(m_endpoint.tokens.count("token"), 10);
+
+  // The requests were sent concurrently, over a bounded number of
+  // connections.
+  int used = m_endpoint.connectionCount - connections;
+  QVERIFY(used > 1);
+  QVERIFY(used <= 6);
+
+  // Further requests reuse the kept alive connections.
+  for (int i = 0; i < 5; ++i) {
+    QSignalSpy spy(requests[i], SIGNAL(finished()));
+    requests[i]->submit();
+    QTRY_COMPARE(spy.count(), 1);
+  }
+  QCOMPARE(m_endpoint.connectionCount - connections, used);
+
+  LatencyHistogram histogram = session.latency("GetUserHostAssocRequest");
+  QCOMPARE(histogram.count(), Q_INT64_C(15));
+  // Responses are delayed by 20 ms.
+  QVERIFY(histogram.min() >= 19);
+  QCOMPARE(session.latencyOperations(),
+           QStringList() << "GetUserHostAssocRequest");
+
+  qDeleteAll(spies);
+  qDeleteAll(requests);
+}
+
+void UitSessionTest::testRejectedToken()
+{
+  Session session("user", "REALM");
+  session.uitService()->setEndPoint(m_endpoint.url());
+  session.setToken("old");
+  m_endpoint.rejectedTokens << "old";
+
+  GetUserHostAssocRequest request(&session);
+  QSignalSpy finishedSpy(&request, SIGNAL(finished()));
+  QSignalSpy errorSpy(&request, SIGNAL(error(const QString &)));
+  request.submit();
+
+  // Another request re-authenticates while this one is in flight, so the
+  // rejection is retried with the new token without authenticating again.
+  session.setToken("new");
+
+  QTRY_COMPARE(finishedSpy.count(), 1);
+  QCOMPARE(errorSpy.count(), 0);
+  QCOMPARE(m_endpoint.tokens, QStringList() << "old" << "new");
+  QCOMPARE(session.token(), QString("new"));
+}
+
+QTEST_MAIN(UitSessionTest)
+
+#include "uitsessiontest.moc"
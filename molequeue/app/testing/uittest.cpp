@@ -15,7 +15,6 @@
 ******************************************************************************/
 
 #include <QtTest>
-#include <QtXmlPatterns/QXmlQuery>
 #include <QtCore/QList>
 #include <QtNetwork/QSslSocket>
 #include <QtNetwork/QNetworkRequest>
@@ -38,6 +37,8 @@ private slots:
   void testSslSetup();
   void testJobIdRegex();
   void testHandleQueueUpdate();
+  void testIncrementalQueueUpdate();
+  void testJobAddedAfterNewerEvents();
 };
 
 void QueueUitTest::testSslSetup()
@@ -109,6 +110,127 @@ void QueueUitTest::testHandleQueueUpdate()
   QVERIFY(jobRunningRemote.jobState() == MoleQueue::RunningRemote);
 }
 
+void QueueUitTest::testIncrementalQueueUpdate()
+{
+  DummyServer server;
+
+  MoleQueue::JobManager *jobManager = server.jobManager();
+  MoleQueue::Job oldJob = jobManager->newJob();
+  oldJob.setMoleQueueId(100535);
+  oldJob.setQueueId(100535);
+  oldJob.setRetrieveOutput(false);
+
+  MoleQueue::Job newJob = jobManager->newJob();
+  newJob.setMoleQueueId(100536);
+  newJob.setQueueId(100536);
+
+  MoleQueue::QueueUit queue(server.queueManager());
+  queue.m_jobs[100535] = 100535;
+  queue.m_jobs[100536] = 100536;
+  QCOMPARE(queue.queueUpdateNumDays(), static_cast<qint64>(1));
+
+  QString jobEventXml
+    = XmlUtils::stripWhitespace(
+        ReferenceString("uit-ref/jobeventlist.xml"));
+  QList<qint64> jobIds;
+  jobIds << 100535 << 100536;
+
+  MoleQueue::Uit::JobEventList list
+    = MoleQueue::Uit::JobEventList::fromXml(jobEventXml, "", jobIds,
+                                            queue.m_lastEventTime);
+  queue.handleQueueUpdate(list.jobEvents());
+  QCOMPARE(queue.m_jobEvents.size(), 2);
+  QCOMPARE(queue.m_lastEventTime, static_cast<qint64>(2124393334));
+
+  // Events already processed are skipped by the next poll...
+  list = MoleQueue::Uit::JobEventList::fromXml(jobEventXml, "", jobIds,
+                                               queue.m_lastEventTime);
+  QCOMPARE(list.jobEvents().size(), 1);
+
+  // ...and jobs without new events keep their state.
+  MoleQueue::JobState oldState = oldJob.jobState();
+  queue.handleQueueUpdate(QList<MoleQueue::Uit::JobEvent>());
+  QCOMPARE(queue.m_jobs.size(), 2);
+  QCOMPARE(oldJob.jobState(), oldState);
+
+  // Jobs with no events in the requested period have finished.
+  queue.expireJobEvents(1124393335);
+  QCOMPARE(queue.m_jobEvents.size(), 1);
+  queue.handleQueueUpdate(QList<MoleQueue::Uit::JobEvent>());
+  QVERIFY(!queue.m_jobs.contains(100535));
+  QVERIFY(queue.m_jobs.contains(100536));
+  QCOMPARE(oldJob.jobState(), MoleQueue::Finished);
+
+  // A new host starts over.
+  queue.setHostID(42);
+  QVERIFY(queue.m_jobEvents.isEmpty());
+  QCOMPARE(queue.m_lastEventTime, static_cast<qint64>(0));
+}
+
+void QueueUitTest::testJobAddedAfterNewerEvents()
+{
+  DummyServer server;
+
+  MoleQueue::JobManager *jobManager = server.jobManager();
+  MoleQueue::Job newerJob = jobManager->newJob();
+  newerJob.setMoleQueueId(100536);
+  newerJob.setQueueId(100536);
+
+  MoleQueue::QueueUit queue(server.queueManager());
+  queue.m_jobs[100536] = 100536;
+
+  QString jobEventXml
+    = XmlUtils::stripWhitespace(
+        ReferenceString("uit-ref/jobeventlist.xml"));
+  QList<qint64> jobIds;
+  jobIds << 100535 << 100536;
+
+  MoleQueue::Uit::JobEventList list
+    = MoleQueue::Uit::JobEventList::fromXml(jobEventXml, "", jobIds,
+                                            queue.minEventTime());
+  queue.handleQueueUpdate(list.jobEvents());
+  QCOMPARE(queue.m_lastEventTime, static_cast<qint64>(2124393334));
+  QCOMPARE(queue.minEventTime(), queue.m_lastEventTime);
+
+  // A job submitted now, whose events are older than those already seen...
+  MoleQueue::Job olderJob = jobManager->newJob();
+  olderJob.setMoleQueueId(100535);
+  olderJob.setQueueId(100535);
+  olderJob.setSubmissionTime(QDateTime::fromTime_t(1124393000));
+  queue.watchJob(olderJob);
+  QCOMPARE(queue.minEventTime(), static_cast<qint64>(0));
+
+  // ...is not finalized by a response that does not cover its submission...
+  list = MoleQueue::Uit::JobEventList::fromXml(jobEventXml, "", jobIds,
+                                               queue.m_lastEventTime);
+  queue.handleQueueUpdate(list.jobEvents(), 2124393000);
+  QVERIFY(queue.m_jobs.contains(100535));
+  QVERIFY(olderJob.jobState() != MoleQueue::Finished);
+
+  // ...and gets its events from the next one.
+  list = MoleQueue::Uit::JobEventList::fromXml(jobEventXml, "", jobIds,
+                                               queue.minEventTime());
+  queue.handleQueueUpdate(list.jobEvents(), 1124390000);
+  QVERIFY(queue.m_jobEvents.contains(100535));
+  QVERIFY(queue.m_newJobs.isEmpty());
+  QCOMPARE(olderJob.jobState(), MoleQueue::QueuedRemote);
+  QCOMPARE(queue.minEventTime(), queue.m_lastEventTime);
+
+  // A new job without any event is finalized once a response covers its
+  // submission.
+  MoleQueue::Job lostJob = jobManager->newJob();
+  lostJob.setMoleQueueId(100537);
+  lostJob.setQueueId(100537);
+  lostJob.setRetrieveOutput(false);
+  lostJob.setSubmissionTime(QDateTime::fromTime_t(2124393000));
+  queue.watchJob(lostJob);
+  queue.handleQueueUpdate(QList<MoleQueue::Uit::JobEvent>(), 2124393100);
+  QVERIFY(queue.m_jobs.contains(100537));
+  queue.handleQueueUpdate(QList<MoleQueue::Uit::JobEvent>(), 2124390000);
+  QVERIFY(!queue.m_jobs.contains(100537));
+  QCOMPARE(lostJob.jobState(), MoleQueue::Finished);
+}
+
 QTEST_MAIN(QueueUitTest)
 
 #include "uittest.moc"
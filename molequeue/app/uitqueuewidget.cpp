@@ -54,6 +54,8 @@ UitQueueWidget::UitQueueWidget(QueueUit *queue,
           this, SLOT(setDirty()));
   connect(ui->wallTimeMinutes, SIGNAL(valueChanged(int)),
           this, SLOT(setDirty()));
+  connect(ui->archiveTransfersCheckBox, SIGNAL(toggled(bool)),
+          this, SLOT(setDirty()));
   connect(ui->pushTestConnection, SIGNAL(clicked()),
           this, SLOT(testConnection()));
   connect(ui->pushSleepTest, SIGNAL(clicked()),
@@ -85,6 +87,7 @@ void UitQueueWidget::save()
   int index = ui->hostNameComboBox->currentIndex();
   m_queue->setHostID(ui->hostNameComboBox->itemData(index).toULongLong());
   m_queue->setQueueUpdateInterval(ui->updateIntervalSpin->value());
+  m_queue->setArchiveTransfers(ui->archiveTransfersCheckBox->isChecked());
 
   QString text = ui->text_launchTemplate->document()->toPlainText();
   m_queue->setLaunchTemplate(text);
@@ -101,6 +104,7 @@ void UitQueueWidget::reset()
   ui->updateIntervalSpin->setValue(m_queue->queueUpdateInterval());
   ui->editKerberosRealm->setText(m_queue->kerberosRealm());
   ui->editKerberosUserName->setText(m_queue->kerberosUserName());
+  ui->archiveTransfersCheckBox->setChecked(m_queue->archiveTransfers());
 
   if (ui->hostNameComboBox->count() > 0) {
     int index = ui->hostNameComboBox->findText(m_queue->hostName());
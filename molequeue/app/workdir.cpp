@@ -0,0 +1,94 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#include "workdir.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QObject>
+#include <QtCore/QSettings>
+
+namespace MoleQueue {
+
+bool setWorkDir(const QString &workDir)
+{
+  if (workDir.isEmpty()) {
+    qWarning("%s", qPrintable(QObject::tr("No specified working directory!")));
+    return false;
+  }
+
+  QFileInfo dirInfo(QDir::cleanPath(workDir));
+  if (!dirInfo.exists()) {
+    qWarning(qPrintable(QObject::tr("Specified working directory does not "
+                                    "exist: '%s'")), qPrintable(workDir));
+    return false;
+  }
+  if (!dirInfo.isReadable()) {
+    qWarning(qPrintable(QObject::tr("Specified working directory is not "
+                                    "readable: '%s'")), qPrintable(workDir));
+    return false;
+  }
+  if (!dirInfo.isWritable()) {
+    qWarning(qPrintable(QObject::tr("Specified working directory is not "
+                                    "writable: '%s'")), qPrintable(workDir));
+    return false;
+  }
+
+  QDir dir(workDir);
+
+  if (dir.exists("config")) {
+    QFileInfo configInfo(dir, "config");
+    if (!configInfo.isDir()) {
+      qWarning(qPrintable(QObject::tr("Invalid working directory '%s': "
+                                      "'%s/config' exists and is not a "
+                                      "directory!")), qPrintable(workDir),
+                                      qPrintable(workDir));
+      return false;
+    }
+    if (!configInfo.isReadable()) {
+      qWarning(qPrintable(QObject::tr("Invalid working directory '%s': "
+                                      "'%s/config' is not readable!")),
+                                      qPrintable(workDir), qPrintable(workDir));
+      return false;
+    }
+    if (!configInfo.isWritable()) {
+      qWarning(qPrintable(QObject::tr("Invalid working directory '%s': "
+                                      "'%s/config' is not writable!")),
+                                      qPrintable(workDir), qPrintable(workDir));
+      return false;
+    }
+  }
+  else {
+    if (!dir.mkdir("config")) {
+      qWarning(qPrintable(QObject::tr("Cannot create directory '%s'. "
+                                      "Aborting.")), qPrintable(workDir));
+      return false;
+    }
+  }
+
+  qDebug(qPrintable(QObject::tr("Running in working directory '%s'...")),
+         qPrintable(dirInfo.absolutePath()));
+
+  QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+                     workDir + "/config/");
+  QSettings settings;
+  settings.setValue("workingDirectoryBase", workDir);
+
+  return true;
+}
+
+} // namespace MoleQueue
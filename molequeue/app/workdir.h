@@ -0,0 +1,36 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+
+#ifndef MOLEQUEUE_WORKDIR_H
+#define MOLEQUEUE_WORKDIR_H
+
+#include <QtCore/QString>
+
+namespace MoleQueue {
+
+/**
+ * Run MoleQueue in the working directory @a workDir: check that it is usable,
+ * create its config/ subdirectory if needed and point QSettings and the
+ * "workingDirectoryBase" setting at it. Problems are reported with qWarning().
+ * Used by the -w/--workdir option of the executables.
+ * @return True on success.
+ */
+bool setWorkDir(const QString &workDir);
+
+} // namespace MoleQueue
+
+#endif // MOLEQUEUE_WORKDIR_H
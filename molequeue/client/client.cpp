@@ -16,16 +16,22 @@
 
 #include "client.h"
 
+#include "clientreply.h"
 #include "jsonrpcclient.h"
 #include "jobobject.h"
 
 #include <QtCore/QJsonDocument>
+#include <QtCore/QTimer>
 
 namespace MoleQueue
 {
 
-Client::Client(QObject *parent_) : QObject(parent_), m_jsonRpcClient(NULL)
+Client::Client(QObject *parent_) : QObject(parent_), m_jsonRpcClient(NULL),
+  m_batchTimer(new QTimer(this)), m_replyTimeout(0)
 {
+  m_batchTimer->setSingleShot(true);
+  m_batchTimer->setInterval(0);
+  connect(m_batchTimer, SIGNAL(timeout()), SLOT(sendBatch()));
 }
 
 Client::~Client()
@@ -57,6 +63,56 @@ bool Client::connectToServer(const QString &serverName)
   return m_jsonRpcClient->connectToServer(serverName);
 }
 
+ClientReply * Client::call(const QString &method, const QJsonValue &params)
+{
+  QJsonObject packet;
+  if (m_jsonRpcClient) {
+    packet = m_jsonRpcClient->emptyRequest();
+  }
+  else {
+    packet["jsonrpc"] = QLatin1String("2.0");
+    packet["id"] = -1;
+  }
+  packet["method"] = method;
+  if (!params.isNull() && !params.isUndefined())
+    packet["params"] = params;
+
+  ClientReply *reply = new ClientReply(packet, m_replyTimeout, this);
+  connect(reply, SIGNAL(finished()), SLOT(replyFinishedInternal()));
+
+  // Replies that can't be sent fail with the rest of the batch, so that
+  // finished() is always emitted after the caller has connected to it.
+  if (m_jsonRpcClient)
+    m_replies.insert(reply->localId(), reply);
+  m_batch.append(reply);
+  if (!m_batchTimer->isActive())
+    m_batchTimer->start();
+
+  return reply;
+}
+
+ClientReply * Client::submitJobAsync(const JobObject &job)
+{
+  return call(QLatin1String("submitJob"), job.json());
+}
+
+ClientReply * Client::lookupJobAsync(unsigned int moleQueueId,
+                                     bool includeContents)
+{
+  QJsonObject params;
+  params["moleQueueId"] = static_cast<int>(moleQueueId);
+  if (includeContents)
+    params["includeContents"] = true;
+  return call(QLatin1String("lookupJob"), params);
+}
+
+ClientReply * Client::cancelJobAsync(unsigned int moleQueueId)
+{
+  QJsonObject params;
+  params["moleQueueId"] = static_cast<int>(moleQueueId);
+  return call(QLatin1String("cancelJob"), params);
+}
+
 int Client::requestQueueList()
 {
   if (!m_jsonRpcClient)
@@ -88,7 +144,7 @@ int Client::submitJob(const JobObject &job)
   return localId;
 }
 
-int Client::lookupJob(unsigned int moleQueueId)
+int Client::lookupJob(unsigned int moleQueueId, bool includeContents)
 {
   if (!m_jsonRpcClient)
     return -1;
@@ -97,6 +153,8 @@ int Client::lookupJob(unsigned int moleQueueId)
   packet["method"] = QLatin1String("lookupJob");
   QJsonObject params;
   params["moleQueueId"] = static_cast<int>(moleQueueId);
+  if (includeContents)
+    params["includeContents"] = true;
   packet["params"] = params;
   if (!m_jsonRpcClient->sendRequest(packet))
     return -1;
@@ -106,6 +164,29 @@ int Client::lookupJob(unsigned int moleQueueId)
   return localId;
 }
 
+int Client::listJobs(const QJsonObject &filter, const QStringList &fields,
+                     int limit, const QJsonValue &cursor)
+{
+  if (!m_jsonRpcClient)
+    return -1;
+
+  QJsonObject packet = m_jsonRpcClient->emptyRequest();
+  packet["method"] = QLatin1String("listJobs");
+  QJsonObject params(filter);
+  if (!fields.isEmpty())
+    params["fields"] = QJsonArray::fromStringList(fields);
+  params["limit"] = limit;
+  if (!cursor.isNull() && !cursor.isUndefined())
+    params["cursor"] = cursor;
+  packet["params"] = params;
+  if (!m_jsonRpcClient->sendRequest(packet))
+    return -1;
+
+  int localId = static_cast<int>(packet["id"].toDouble());
+  m_requests[localId] = ListJobs;
+  return localId;
+}
+
 int Client::cancelJob(unsigned int moleQueueId)
 {
   if (!m_jsonRpcClient)
@@ -197,14 +278,98 @@ int Client::unregisterOpenWith(const QString &handlerName)
   return localId;
 }
 
+int Client::requestBinaryEncoding()
+{
+  if (!m_jsonRpcClient || !JsonRpcClient::isBinaryEncodingSupported())
+    return -1;
+
+  QJsonObject packet = m_jsonRpcClient->emptyRequest();
+  packet["method"] = QLatin1String("negotiateEncoding");
+  QJsonObject params;
+  QJsonArray encodings;
+  encodings.append(QLatin1String("cbor"));
+  encodings.append(QLatin1String("json"));
+  params["encodings"] = encodings;
+  packet["params"] = params;
+  if (!m_jsonRpcClient->sendRequest(packet))
+    return -1;
+
+  int localId = static_cast<int>(packet["id"].toDouble());
+  m_requests[localId] = NegotiateEncoding;
+  return localId;
+}
+
 void Client::flush()
 {
+  sendBatch();
   if (m_jsonRpcClient)
     m_jsonRpcClient->flush();
 }
 
+void Client::sendBatch()
+{
+  m_batchTimer->stop();
+
+  // Large batches are split so that the server can start answering before
+  // it has parsed every request.
+  const int maxBatchSize = 256;
+
+  QList<ClientReply *> sent;
+  QJsonArray requests;
+  for (int i = 0; i < m_batch.size(); ++i) {
+    // Skip replies that were aborted or deleted before being sent.
+    ClientReply *reply = m_batch[i];
+    if (reply && !reply->isFinished()) {
+      requests.append(reply->takeRequest());
+      sent.append(reply);
+    }
+
+    if (requests.isEmpty()
+        || (requests.size() < maxBatchSize && i + 1 < m_batch.size())) {
+      continue;
+    }
+
+    bool ok = false;
+    if (isConnected()) {
+      ok = requests.size() == 1
+          ? m_jsonRpcClient->sendRequest(requests.first().toObject())
+          : m_jsonRpcClient->sendBatch(requests);
+    }
+
+    if (!ok) {
+      foreach (ClientReply *failed, sent) {
+        failed->setError(ClientReply::ConnectionError, -1,
+                         tr("Not connected to a server."));
+      }
+    }
+
+    requests = QJsonArray();
+    sent.clear();
+  }
+  m_batch.clear();
+}
+
+void Client::replyFinishedInternal()
+{
+  ClientReply *reply = qobject_cast<ClientReply*>(sender());
+  if (!reply)
+    return;
+
+  if (m_replies.value(reply->localId()) == reply)
+    m_replies.remove(reply->localId());
+  emit replyFinished(reply);
+}
+
 void Client::processResult(const QJsonObject &response)
 {
+  if (response["id"].isDouble()) {
+    int localId = static_cast<int>(response["id"].toDouble());
+    if (ClientReply *reply = m_replies.value(localId)) {
+      reply->setResult(response["result"]);
+      return;
+    }
+  }
+
   if (response["id"] != QJsonValue::Null
       && m_requests.contains(static_cast<int>(response["id"].toDouble()))) {
     int localId = static_cast<int>(response["id"].toDouble());
@@ -220,6 +385,12 @@ void Client::processResult(const QJsonObject &response)
     case LookupJob:
       emit lookupJobResponse(localId, response["result"].toObject());
       break;
+    case ListJobs: {
+      QJsonObject result = response["result"].toObject();
+      emit listJobsResponse(localId, result["jobs"].toArray(),
+                            result["nextCursor"]);
+      break;
+    }
     case CancelJob:
       emit cancelJobResponse(static_cast<unsigned int>(response["result"]
                              .toObject()["moleQueueId"].toDouble()));
@@ -233,6 +404,12 @@ void Client::processResult(const QJsonObject &response)
     case UnregisterOpenWith:
       emit unregisterOpenWithResponse(localId);
       break;
+    case NegotiateEncoding: {
+      QString encoding = response["result"].toObject()["encoding"].toString();
+      m_jsonRpcClient->setBinaryEncoding(encoding == QLatin1String("cbor"));
+      emit encodingNegotiated(localId, encoding);
+      break;
+    }
     default:
       break;
     }
@@ -252,6 +429,8 @@ void Client::processNotification(const QJsonObject &notification)
 void Client::processError(const QJsonObject &error)
 {
   int localId = static_cast<int>(error["id"].toDouble());
+  ClientReply *reply = error["id"].isDouble() ? m_replies.value(localId)
+                                              : NULL;
   int errorCode = -1;
   QString errorMessage = tr("No message specified.");
   QJsonValue errorData;
@@ -266,6 +445,13 @@ void Client::processError(const QJsonObject &error)
     if (errorObject.contains("data"))
       errorData = errorObject.value("data");
   }
+
+  if (reply) {
+    reply->setError(ClientReply::ServerError, errorCode, errorMessage,
+                    errorData);
+    return;
+  }
+
   emit errorReceived(localId, errorCode, errorMessage, errorData);
 }
 
@@ -24,10 +24,15 @@
 #include <QtCore/QObject>
 #include <QtCore/QRegExp>
 #include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QStringList>
+
+class QTimer;
 
 namespace MoleQueue
 {
 
+class ClientReply;
 class JsonRpcClient;
 class JobObject;
 
@@ -39,6 +44,21 @@ class JobObject;
  *
  * Provides a simple Qt C++ API to use the MoleQueue JSON-RPC calls to submit
  * and query the state of submitted jobs.
+ *
+ * Each request can be made in two ways. The methods returning an int send
+ * the request immediately and report the response through the signals below,
+ * keyed on the returned local ID. call() and the *Async() methods instead
+ * return a ClientReply that finishes when its response arrives. Replies made
+ * in the same pass of the event loop are sent together as one JSON-RPC batch,
+ * and any number of them may be outstanding at once:
+ *
+ @code
+ foreach (const MoleQueue::JobObject &job, jobs) {
+   MoleQueue::ClientReply *reply = client->submitJobAsync(job);
+   connect(reply, SIGNAL(finished()), this, SLOT(jobSubmitted()));
+ }
+ // The batch is sent when control returns to the event loop.
+ @endcode
  */
 
 class MOLEQUEUECLIENT_EXPORT Client : public QObject
@@ -55,6 +75,50 @@ public:
    */
   bool isConnected() const;
 
+  /**
+   * @return The time in milliseconds after which unanswered replies finish
+   * with ClientReply::TimeoutError, 0 if they never time out.
+   */
+  int replyTimeout() const { return m_replyTimeout; }
+
+  /**
+   * @param msecs The time in milliseconds after which replies created from
+   * now on finish with ClientReply::TimeoutError, 0 (the default) to wait
+   * indefinitely.
+   */
+  void setReplyTimeout(int msecs) { m_replyTimeout = msecs; }
+
+  /**
+   * Call a JSON-RPC method on the server. The request is queued and sent with
+   * any others made before control returns to the event loop, or when flush()
+   * is called.
+   * @param method The JSON-RPC method.
+   * @param params The parameters, omitted if undefined or null.
+   * @return The reply, owned by this client. It finishes with
+   * ClientReply::ConnectionError if the client is not connected when the
+   * batch is sent.
+   */
+  ClientReply * call(const QString &method,
+                     const QJsonValue &params = QJsonValue());
+
+  /**
+   * Submit a job, see submitJob(). The ClientReply::moleQueueId() of the
+   * reply is the MoleQueue ID of the new job.
+   */
+  ClientReply * submitJobAsync(const JobObject &job);
+
+  /**
+   * Request information about a job, see lookupJob(). The ClientReply::result()
+   * of the reply is the job information.
+   */
+  ClientReply * lookupJobAsync(unsigned int moleQueueId,
+                               bool includeContents = false);
+
+  /**
+   * Cancel a job, see cancelJob().
+   */
+  ClientReply * cancelJobAsync(unsigned int moleQueueId);
+
 public slots:
   /**
    * Connect to the server.
@@ -82,9 +146,37 @@ public slots:
    * Request information about a job. You should supply the MoleQueue ID that
    * was received in response to a job submission.
    * @param moleQueueId The MoleQueue ID for the job.
+   * @param includeContents If true, the contents of large input files that the
+   * server keeps in its blob store are included in the response. Otherwise
+   * such files are only referenced by "contentsHash" and "contentsSize".
    * @return The local ID of the job submission request.
    */
-  int lookupJob(unsigned int moleQueueId);
+  int lookupJob(unsigned int moleQueueId, bool includeContents = false);
+
+  /**
+   * Request the jobs known to the server that match @a filter, a page at a
+   * time. listJobsResponse() is emitted with the result.
+   * @param filter Optional criteria, e.g.
+~~~
+{
+  "states": [ "RunningRemote", "QueuedRemote" ],
+  "queues": [ "Some big cluster" ],
+  "programs": [ "GAMESS" ],
+  "descriptionContains": "benzene",
+  "submittedAfter": "2012-06-01T00:00:00",
+  "submittedBefore": "2012-07-01T00:00:00"
+}
+~~~
+   * @param fields The job members to return. All members except input file
+   * contents are returned if empty. "moleQueueId" is always returned.
+   * @param limit The maximum number of jobs to return (1 to 1000).
+   * @param cursor The "nextCursor" of the previous page, or a null value for
+   * the first page.
+   * @return The local ID of the request.
+   */
+  int listJobs(const QJsonObject &filter = QJsonObject(),
+               const QStringList &fields = QStringList(), int limit = 100,
+               const QJsonValue &cursor = QJsonValue());
 
   /**
    * Cancel a job that was submitted.
@@ -155,7 +247,19 @@ executable /absolute/path/to/selected/fileName
   int unregisterOpenWith(const QString &handlerName);
 
   /**
-   * @brief flush Flush all pending messages to the server.
+   * @brief Ask the server to send packets CBOR encoded rather than as JSON
+   * text, which is more compact for large job descriptions. Once the server
+   * agrees, requests are also sent CBOR encoded. encodingNegotiated() is
+   * emitted with the encoding chosen by the server.
+   * @return The local ID of the request, or -1 if not connected or CBOR is
+   * not available (requires Qt 5.12).
+   */
+  int requestBinaryEncoding();
+
+  /**
+   * @brief flush Flush all pending messages to the server, including the
+   * batch of replies that would otherwise be sent when control returns to the
+   * event loop.
    * @warning This should not need to be called if used in an event loop, as Qt
    * will start writing to the socket as soon as control returns to the event
    * loop.
@@ -192,6 +296,15 @@ signals:
    */
   void lookupJobResponse(int localId, QJsonObject jobInfo);
 
+  /**
+   * Emitted when a listJobs response is received.
+   * @param localId The local ID the response is in reply to.
+   * @param jobs The matching jobs.
+   * @param nextCursor The cursor for the next page, or null if this was the
+   * last page.
+   */
+  void listJobsResponse(int localId, QJsonArray jobs, QJsonValue nextCursor);
+
   /**
    * Emitted when a job is successfully cancelled.
    */
@@ -218,12 +331,23 @@ signals:
    */
   void unregisterOpenWithResponse(int localId);
 
+  /**
+   * Emitted when the server has replied to requestBinaryEncoding().
+   * @param encoding The encoding now used by the server, "cbor" or "json".
+   */
+  void encodingNegotiated(int localId, QString encoding);
+
   /**
    * Emitted when an error response is received.
    */
   void errorReceived(int localId, int errorCode, QString errorMessage,
                      QJsonValue errorData);
 
+  /**
+   * Emitted after a ClientReply emits ClientReply::finished().
+   */
+  void replyFinished(MoleQueue::ClientReply *reply);
+
 protected slots:
   /** Parse the response object and emit the appropriate signal(s). */
   void processResult(const QJsonObject &response);
@@ -234,6 +358,12 @@ protected slots:
   /** Parse an error object and emit the appropriate signal(s). */
   void processError(const QJsonObject &notification);
 
+  /** Send the replies queued since the last batch. */
+  void sendBatch();
+
+  /** Forget a reply once it has finished. */
+  void replyFinishedInternal();
+
 protected:
   enum MessageType {
     Invalid = -1,
@@ -241,14 +371,24 @@ protected:
     SubmitJob,
     CancelJob,
     LookupJob,
+    ListJobs,
     RegisterOpenWith,
     ListOpenWithNames,
-    UnregisterOpenWith
+    UnregisterOpenWith,
+    NegotiateEncoding
   };
 
   JsonRpcClient *m_jsonRpcClient;
   QHash<unsigned int, MessageType> m_requests;
 
+  /// Unfinished replies, by local ID.
+  QHash<int, QPointer<ClientReply> > m_replies;
+  /// Replies waiting to be sent in the next batch.
+  QList<QPointer<ClientReply> > m_batch;
+  /// Fires when control returns to the event loop to send m_batch.
+  QTimer *m_batchTimer;
+  int m_replyTimeout;
+
 private:
   QJsonObject buildRegisterOpenWithRequest(const QString &name,
                                            const QList<QRegExp> &filePatterns,
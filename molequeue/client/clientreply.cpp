@@ -0,0 +1,119 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "clientreply.h"
+
+#include "client.h"
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
+
+namespace MoleQueue
+{
+
+ClientReply::ClientReply(const QJsonObject &request, int timeout,
+                         Client *client)
+  : QObject(client),
+    m_request(request),
+    m_localId(static_cast<int>(request.value("id").toDouble())),
+    m_method(request.value("method").toString()),
+    m_finished(false),
+    m_error(NoError),
+    m_errorCode(-1),
+    m_timer(NULL)
+{
+  if (timeout > 0) {
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, SIGNAL(timeout()), SLOT(timedOut()));
+    m_timer->start(timeout);
+  }
+}
+
+ClientReply::~ClientReply()
+{
+}
+
+unsigned int ClientReply::moleQueueId() const
+{
+  return static_cast<unsigned int>(
+        m_result.toObject().value("moleQueueId").toDouble());
+}
+
+bool ClientReply::waitForFinished(int msecs)
+{
+  if (m_finished)
+    return true;
+
+  QEventLoop loop;
+  QTimer timer;
+  timer.setSingleShot(true);
+  connect(this, SIGNAL(finished()), &loop, SLOT(quit()));
+  connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+  timer.start(msecs);
+  loop.exec();
+
+  return m_finished;
+}
+
+void ClientReply::abort()
+{
+  setError(CanceledError, -1, tr("Request canceled."));
+}
+
+void ClientReply::timedOut()
+{
+  setError(TimeoutError, -1, tr("No response from the server."));
+}
+
+QJsonObject ClientReply::takeRequest()
+{
+  QJsonObject request = m_request;
+  m_request = QJsonObject();
+  return request;
+}
+
+void ClientReply::setResult(const QJsonValue &result)
+{
+  if (m_finished)
+    return;
+
+  m_result = result;
+  m_finished = true;
+  m_request = QJsonObject();
+  if (m_timer)
+    m_timer->stop();
+  emit finished();
+}
+
+void ClientReply::setError(Error error, int code, const QString &message,
+                           const QJsonValue &data)
+{
+  if (m_finished)
+    return;
+
+  m_error = error;
+  m_errorCode = code;
+  m_errorMessage = message;
+  m_errorData = data;
+  m_finished = true;
+  m_request = QJsonObject();
+  if (m_timer)
+    m_timer->stop();
+  emit finished();
+}
+
+} // End namespace MoleQueue
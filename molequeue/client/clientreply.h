@@ -0,0 +1,170 @@
+/******************************************************************************
+
+  This source file is part of the MoleQueue project.
+
+  Copyright 2012-2013 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef MOLEQUEUE_CLIENTREPLY_H
+#define MOLEQUEUE_CLIENTREPLY_H
+
+#include "molequeueclientexport.h"
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonValue>
+#include <QtCore/QObject>
+
+class QTimer;
+
+namespace MoleQueue
+{
+
+class Client;
+
+/**
+ * @class ClientReply clientreply.h <molequeue/client/clientreply.h>
+ * @brief The ClientReply class holds the outcome of a single request made
+ * with Client::call() or one of the Client::*Async() methods.
+ *
+ * A reply is created unfinished and emits finished() exactly once, when the
+ * response arrives, the request times out or abort() is called. It is owned
+ * by the Client; delete it (with deleteLater() from a slot connected to
+ * finished()) once the result has been read.
+ *
+ @code
+ MoleQueue::ClientReply *reply = client->submitJobAsync(job);
+ connect(reply, SIGNAL(finished()), this, SLOT(jobSubmitted()));
+ ...
+ void MyObject::jobSubmitted()
+ {
+   MoleQueue::ClientReply *reply =
+       qobject_cast<MoleQueue::ClientReply*>(sender());
+   if (reply->error() == MoleQueue::ClientReply::NoError)
+     m_ids << reply->moleQueueId();
+   reply->deleteLater();
+ }
+ @endcode
+ */
+class MOLEQUEUECLIENT_EXPORT ClientReply : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum Error {
+    /// The request succeeded, result() holds the response.
+    NoError = 0,
+    /// The server answered with an error, see errorCode().
+    ServerError,
+    /// No response arrived within the timeout.
+    TimeoutError,
+    /// abort() was called.
+    CanceledError,
+    /// The client is not connected, the request was not sent.
+    ConnectionError
+  };
+
+  ~ClientReply();
+
+  /**
+   * @return The JSON-RPC id of the request.
+   */
+  int localId() const { return m_localId; }
+
+  /**
+   * @return The JSON-RPC method of the request.
+   */
+  QString method() const { return m_method; }
+
+  /**
+   * @return True once finished() has been emitted.
+   */
+  bool isFinished() const { return m_finished; }
+
+  /**
+   * @return The reason the request failed, or NoError.
+   */
+  Error error() const { return m_error; }
+
+  /**
+   * @return The JSON-RPC error code if error() is ServerError, -1 otherwise.
+   */
+  int errorCode() const { return m_errorCode; }
+
+  /**
+   * @return A description of the error, if any.
+   */
+  QString errorMessage() const { return m_errorMessage; }
+
+  /**
+   * @return The "data" member of the JSON-RPC error, if any.
+   */
+  QJsonValue errorData() const { return m_errorData; }
+
+  /**
+   * @return The "result" member of the response.
+   */
+  QJsonValue result() const { return m_result; }
+
+  /**
+   * @return The "moleQueueId" member of the result, e.g. for submitJob, or 0.
+   */
+  unsigned int moleQueueId() const;
+
+  /**
+   * Block in a local event loop until the reply finishes or @a msecs pass.
+   * Prefer connecting to finished() in code that runs an event loop.
+   * @return True if the reply has finished.
+   */
+  bool waitForFinished(int msecs = 30000);
+
+public slots:
+  /**
+   * Give up on the request. It is not sent if it is still waiting for the
+   * current batch, and any response that arrives later is ignored.
+   */
+  void abort();
+
+signals:
+  /**
+   * Emitted once when the reply finishes, successfully or not.
+   */
+  void finished();
+
+private slots:
+  void timedOut();
+
+private:
+  friend class Client;
+
+  ClientReply(const QJsonObject &request, int timeout, Client *client);
+
+  /// The request, until it has been sent.
+  QJsonObject takeRequest();
+  void setResult(const QJsonValue &result);
+  void setError(Error error, int code, const QString &message,
+                const QJsonValue &data = QJsonValue());
+
+  QJsonObject m_request;
+  int m_localId;
+  QString m_method;
+  bool m_finished;
+  Error m_error;
+  int m_errorCode;
+  QString m_errorMessage;
+  QJsonValue m_errorData;
+  QJsonValue m_result;
+  QTimer *m_timer;
+};
+
+} // End namespace MoleQueue
+
+#endif // MOLEQUEUE_CLIENTREPLY_H
@@ -17,17 +17,35 @@
 #include "jsonrpcclient.h"
 
 #include <QtCore/QJsonDocument>
-#include <QtCore/QDataStream>
 #include <QtCore/QTimer>
+#include <QtCore/QtEndian>
 #include <QtNetwork/QLocalSocket>
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QtCore/QCborValue>
+#define MOLEQUEUE_HAS_CBOR
+#endif
+
 namespace MoleQueue
 {
 
+namespace {
+// Frames are written as QDataStream writes a QByteArray: a big-endian quint32
+// length, 0xFFFFFFFF for a null array, followed by the data.
+const int frameHeaderSize = 4;
+const quint32 nullFrameLength = 0xFFFFFFFF;
+const quint32 maxFrameLength = 0x7FFFFFFF - frameHeaderSize;
+
+// Write straight away rather than coalescing beyond this many bytes.
+const int maxPendingBytes = 64 * 1024;
+}
+
 JsonRpcClient::JsonRpcClient(QObject *parent_) :
   QObject(parent_),
   m_packetCounter(0),
-  m_socket(NULL)
+  m_socket(NULL),
+  m_binaryEncoding(false),
+  m_writeScheduled(false)
 {
   connect(this, SIGNAL(newPacket(QByteArray)), SLOT(readPacket(QByteArray)),
           Qt::QueuedConnection);
@@ -59,6 +77,10 @@ bool JsonRpcClient::connectToServer(const QString &serverName_)
     }
   }
 
+  // Partial frames from a previous connection are meaningless now.
+  m_readBuffer.clear();
+  m_writeBuffer.clear();
+
   // New connection.
   if (m_socket == NULL) {
     m_socket = new QLocalSocket(this);
@@ -82,8 +104,23 @@ QString JsonRpcClient::serverName() const
     return QString();
 }
 
+void JsonRpcClient::setBinaryEncoding(bool binary)
+{
+  m_binaryEncoding = binary && isBinaryEncodingSupported();
+}
+
+bool JsonRpcClient::isBinaryEncodingSupported()
+{
+#ifdef MOLEQUEUE_HAS_CBOR
+  return true;
+#else
+  return false;
+#endif
+}
+
 void JsonRpcClient::flush()
 {
+  writePending();
   if (m_socket)
     m_socket->flush();
 }
@@ -97,61 +134,174 @@ QJsonObject JsonRpcClient::emptyRequest()
 }
 
 bool JsonRpcClient::sendRequest(const QJsonObject &request)
+{
+  return sendJson(request);
+}
+
+bool JsonRpcClient::sendBatch(const QJsonArray &requests)
+{
+  if (requests.isEmpty())
+    return false;
+
+  return sendJson(requests);
+}
+
+bool JsonRpcClient::sendJson(const QJsonValue &json)
 {
   if (!m_socket)
     return false;
 
-  QJsonDocument document(request);
-  QDataStream stream(m_socket);
-  stream.setVersion(QDataStream::Qt_4_8);
-  stream << document.toJson();
+  QByteArray packet;
+#ifdef MOLEQUEUE_HAS_CBOR
+  if (m_binaryEncoding)
+    packet = QCborValue::fromJsonValue(json).toCbor();
+#endif
+  if (packet.isEmpty()) {
+    QJsonDocument document = json.isArray() ? QJsonDocument(json.toArray())
+                                            : QJsonDocument(json.toObject());
+    packet = document.toJson(QJsonDocument::Compact);
+  }
+
+  // Reserve the header, and fill in the length once the packet is appended.
+  int headerPos = m_writeBuffer.size();
+  m_writeBuffer.resize(headerPos + frameHeaderSize);
+  qToBigEndian<quint32>(static_cast<quint32>(packet.size()),
+                        reinterpret_cast<uchar *>(m_writeBuffer.data()
+                                                  + headerPos));
+  m_writeBuffer.append(packet);
+
+  if (m_writeBuffer.size() >= maxPendingBytes) {
+    writePending();
+  }
+  else if (!m_writeScheduled) {
+    m_writeScheduled = true;
+    QTimer::singleShot(0, this, SLOT(writePending()));
+  }
   return true;
 }
 
+void JsonRpcClient::writePending()
+{
+  m_writeScheduled = false;
+  if (m_writeBuffer.isEmpty())
+    return;
+
+  if (m_socket && m_socket->isOpen())
+    m_socket->write(m_writeBuffer);
+  m_writeBuffer.clear();
+}
+
 void JsonRpcClient::readPacket(const QByteArray message)
 {
   // Read packet into a Json value
   QJsonParseError error;
-  QJsonDocument reader = QJsonDocument::fromJson(message, &error);
+  error.error = QJsonParseError::NoError;
+  QJsonDocument reader;
+  bool decoded = false;
+
+#ifdef MOLEQUEUE_HAS_CBOR
+  // JSON packets start with '{' or '[', anything else is CBOR.
+  QByteArray trimmed = message.trimmed();
+  if (!trimmed.startsWith('{') && !trimmed.startsWith('[')) {
+    QCborParserError cborError;
+    QCborValue cbor = QCborValue::fromCbor(message, &cborError);
+    if (cborError.error != QCborError::NoError) {
+      emit badPacketReceived("Unparseable message received\n:"
+                             + cborError.errorString());
+      return;
+    }
+    if (cbor.isMap())
+      reader.setObject(cbor.toMap().toJsonObject());
+    else if (cbor.isArray())
+      reader.setArray(cbor.toArray().toJsonArray());
+    decoded = true;
+  }
+#endif
+
+  if (!decoded)
+    reader = QJsonDocument::fromJson(message, &error);
 
   if (error.error != QJsonParseError::NoError) {
     emit badPacketReceived("Unparseable message received\n:"
                            + error.errorString() + "\nContent: " + message);
     return;
   }
+  else if (reader.isArray()) {
+    // A batch response, each member is handled as if it arrived alone.
+    foreach (const QJsonValue &value, reader.array()) {
+      if (value.isObject())
+        processObject(value.toObject());
+      else
+        emit badPacketReceived("Batch member is not a valid JSON object.");
+    }
+  }
   else if (!reader.isObject()) {
     // We need a valid object, something bad happened.
     emit badPacketReceived("Packet did not contain a valid JSON object.");
     return;
   }
   else {
-    QJsonObject root = reader.object();
-    if (root["method"] != QJsonValue::Null) {
-      if (root["id"] != QJsonValue::Null)
-        emit badPacketReceived("Received a request packet for the client.");
-      else
-        emit notificationReceived(root);
-    }
-    if (root["result"] != QJsonValue::Null) {
-      // This is a result packet, and should emit a signal.
-      emit resultReceived(root);
-    }
-    else if (root["error"] != QJsonValue::Null) {
-      emit errorReceived(root);
-    }
+    processObject(reader.object());
+  }
+}
+
+namespace {
+bool hasMember(const QJsonObject &object, const QString &key)
+{
+  QJsonValue value = object.value(key);
+  return !value.isNull() && !value.isUndefined();
+}
+}
+
+void JsonRpcClient::processObject(const QJsonObject &root)
+{
+  if (hasMember(root, "method")) {
+    if (hasMember(root, "id"))
+      emit badPacketReceived("Received a request packet for the client.");
+    else
+      emit notificationReceived(root);
+  }
+  if (hasMember(root, "result")) {
+    // This is a result packet, and should emit a signal.
+    emit resultReceived(root);
+  }
+  else if (hasMember(root, "error")) {
+    emit errorReceived(root);
   }
 }
 
 void JsonRpcClient::readSocket()
 {
-  if (m_socket->bytesAvailable() > 0) {
-    QDataStream stream(m_socket);
-    QByteArray json;
-    stream >> json;
-    emit newPacket(json);
-    if (m_socket->bytesAvailable() > 0)
-      QTimer::singleShot(0, this, SLOT(readSocket()));
+  m_readBuffer.append(m_socket->readAll());
+
+  // Consume every complete frame, leaving any partial one for the next read.
+  int offset = 0;
+  while (m_readBuffer.size() - offset >= frameHeaderSize) {
+    quint32 length = qFromBigEndian<quint32>(
+          reinterpret_cast<const uchar *>(m_readBuffer.constData() + offset));
+    if (length == nullFrameLength) {
+      offset += frameHeaderSize;
+      continue;
+    }
+    if (length > maxFrameLength) {
+      // The stream cannot be resynchronized after a corrupt header.
+      emit badPacketReceived(QString("Invalid frame length %1 received, "
+                                     "closing the connection.").arg(length));
+      m_readBuffer.clear();
+      m_socket->abort();
+      return;
+    }
+    int available = m_readBuffer.size() - offset - frameHeaderSize;
+    if (static_cast<quint32>(available) < length)
+      break;
+
+    emit newPacket(m_readBuffer.mid(offset + frameHeaderSize,
+                                    static_cast<int>(length)));
+    offset += frameHeaderSize + static_cast<int>(length);
   }
+
+  if (offset > 0)
+    m_readBuffer.remove(0, offset);
 }
 
 } // End namespace MoleQueue
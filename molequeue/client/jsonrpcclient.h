@@ -19,6 +19,7 @@
 
 #include "molequeueclientexport.h"
 
+#include <QtCore/QJsonArray>
 #include <QtCore/QJsonObject>
 #include <QtCore/QObject>
 
@@ -49,6 +50,17 @@ namespace MoleQueue
  * You should connect to the appropriate signals in order to act on results,
  * notifications and errors received in response to requests set using the
  * client connection.
+ *
+ * Requests are sent as compact JSON. Once the server has agreed to a binary
+ * encoding (see Client::requestBinaryEncoding()), call setBinaryEncoding() to
+ * send CBOR instead. Incoming packets are decoded in either encoding.
+ *
+ * Each packet is framed as a big-endian 32 bit length followed by the packet,
+ * the same bytes QDataStream writes for a QByteArray, so the client talks to
+ * LocalSocketConnection unchanged. Incoming data is buffered until a complete
+ * frame has arrived, so packets split across several reads are reassembled.
+ * Outgoing packets are coalesced and written together when control returns to
+ * the event loop, or when flush() is called.
  */
 
 class MOLEQUEUECLIENT_EXPORT JsonRpcClient : public QObject
@@ -70,6 +82,22 @@ public:
    */
   QString serverName() const;
 
+  /**
+   * @return True if requests are sent CBOR encoded rather than as JSON text.
+   */
+  bool binaryEncoding() const { return m_binaryEncoding; }
+
+  /**
+   * Send requests CBOR encoded if @a binary is true. This should only be
+   * enabled after the server has agreed to the encoding.
+   */
+  void setBinaryEncoding(bool binary);
+
+  /**
+   * @return True if the CBOR encoding is available (requires Qt 5.12).
+   */
+  static bool isBinaryEncodingSupported();
+
 public slots:
   /**
    * Connect to the server.
@@ -78,10 +106,9 @@ public slots:
   bool connectToServer(const QString &serverName);
 
   /**
-   * @brief flush Flush all pending messages to the server.
-   * @warning This should not need to be called if used in an event loop, as Qt
-   * will start writing to the socket as soon as control returns to the event
-   * loop.
+   * @brief flush Write all coalesced packets to the socket and flush it.
+   * @warning This should not need to be called if used in an event loop, as
+   * pending packets are written as soon as control returns to the event loop.
    */
   void flush();
 
@@ -99,6 +126,14 @@ public slots:
    */
   bool sendRequest(const QJsonObject &request);
 
+  /**
+   * Send several requests as one JSON-RPC 2.0 batch. The responses are
+   * delivered individually through the usual signals.
+   * @param requests The JSON-RPC 2.0 request objects.
+   * @return True on success, false on failure.
+   */
+  bool sendBatch(const QJsonArray &requests);
+
 protected slots:
   /**
    * Read incoming packets of data from the server.
@@ -106,10 +141,15 @@ protected slots:
   void readPacket(const QByteArray message);
 
   /**
-   * Read incoming data, interpret JSON stream.
+   * Read incoming data, and emit newPacket() for each complete frame.
    */
   void readSocket();
 
+  /**
+   * Write the coalesced packets to the socket.
+   */
+  void writePending();
+
 signals:
   /**
    * Emitted when the connection state changes.
@@ -144,8 +184,20 @@ signals:
   void newPacket(const QByteArray &packet);
 
 protected:
+  /** Write @a json (an object or a batch array) to the socket. */
+  bool sendJson(const QJsonValue &json);
+
+  /** Emit the signal appropriate for a single response or notification. */
+  void processObject(const QJsonObject &root);
+
   unsigned int m_packetCounter;
   QLocalSocket *m_socket;
+  bool m_binaryEncoding;
+  /** Received bytes that do not yet form a complete frame. */
+  QByteArray m_readBuffer;
+  /** Framed packets waiting to be written to the socket. */
+  QByteArray m_writeBuffer;
+  bool m_writeScheduled;
 };
 
 } // End namespace MoleQueue
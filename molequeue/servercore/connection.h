@@ -40,7 +40,8 @@ public:
    *
    * @param parentObject parent
    */
-  explicit Connection(QObject *parentObject = 0 ) : QObject(parentObject) {}
+  explicit Connection(QObject *parentObject = 0 )
+    : QObject(parentObject), m_packetEncoding(JsonEncoding) {}
 
   /**
    * Open the connection
@@ -80,6 +81,27 @@ public:
    */
   virtual void flush() = 0;
 
+  /**
+   * @return The number of bytes sent on this connection that have not been
+   * written out to the peer yet, or 0 if the transport cannot tell.
+   */
+  virtual qint64 bytesToWrite() const { return 0; }
+
+  /**
+   * @return The encoding used by Message::send() for packets sent on this
+   * connection. This is set when the peer negotiates an encoding (see
+   * JsonRpc). Default: JsonEncoding
+   */
+  PacketEncoding packetEncoding() const { return m_packetEncoding; }
+
+  /**
+   * Set the encoding used for packets sent on this connection.
+   */
+  void setPacketEncoding(PacketEncoding encoding)
+  {
+    m_packetEncoding = encoding;
+  }
+
 signals:
   /**
    * Emitted when a new message has been received on this connection.
@@ -93,6 +115,9 @@ signals:
    * Emited when the connection is disconnected.
    */
   void disconnected();
+
+private:
+  PacketEncoding m_packetEncoding;
 };
 
 } // end namespace MoleQueue
@@ -15,6 +15,7 @@
 ******************************************************************************/
 
 #include "jsonrpc.h"
+#include "connection.h"
 #include "connectionlistener.h"
 
 #include <QtCore/QMetaType>
@@ -133,10 +134,10 @@ void JsonRpc::newPacket(const MoleQueue::PacketType &packet,
 
   // Parse the packet as JSON
   QJsonParseError error;
-  QJsonDocument doc = QJsonDocument::fromJson(QByteArray(packet), &error);
+  QJsonValue json = Message::fromPacket(packet, &error);
 
   // Send a server error and return if there was an issue parsing the packet.
-  if (error.error != QJsonParseError::NoError || doc.isNull()) {
+  if (error.error != QJsonParseError::NoError || json.isNull()) {
     Message errorMessage(Message::Error, conn, endpoint);
     errorMessage.setErrorCode(-32700);
     errorMessage.setErrorMessage("Parse error");
@@ -151,9 +152,7 @@ void JsonRpc::newPacket(const MoleQueue::PacketType &packet,
   }
 
   // Pass the JSON off for further processing. Must be an array or object.
-  handleJsonValue(conn, endpoint,
-                  doc.isArray() ? QJsonValue(doc.array())
-                                : QJsonValue(doc.object()));
+  handleJsonValue(conn, endpoint, json);
 }
 
 void JsonRpc::handleJsonValue(Connection *conn, const EndpointIdType &endpoint,
@@ -197,7 +196,52 @@ void JsonRpc::handleJsonValue(Connection *conn, const EndpointIdType &endpoint,
     return;
   }
 
+  // Handle encoding negotiation internally
+  if (message.type() == Message::Request
+      && message.method() == "negotiateEncoding") {
+    handleNegotiateEncoding(message);
+    return;
+  }
+
   emit messageReceived(message);
 }
 
+void JsonRpc::handleNegotiateEncoding(const Message &message)
+{
+  QJsonValue encodings = message.params().toObject().value("encodings");
+  if (!encodings.isArray()) {
+    Message errorMessage = message.generateErrorResponse();
+    errorMessage.setErrorCode(-32602);
+    errorMessage.setErrorMessage("Invalid params");
+    QJsonObject errorDataObject;
+    errorDataObject.insert("description",
+                           QLatin1String("'encodings' is not an array."));
+    errorDataObject.insert("request", message.toJsonObject());
+    errorMessage.setErrorData(errorDataObject);
+    errorMessage.send();
+    return;
+  }
+
+  // Use the first encoding requested that we support, falling back to JSON.
+  PacketEncoding encoding = JsonEncoding;
+  foreach (const QJsonValue &name, encodings.toArray()) {
+    bool ok;
+    PacketEncoding requested = Message::encodingFromName(name.toString(), &ok);
+    if (ok && Message::isEncodingSupported(requested)) {
+      encoding = requested;
+      break;
+    }
+  }
+
+  // Reply in the old encoding, then switch.
+  Message response = message.generateResponse();
+  QJsonObject resultObject;
+  resultObject.insert("encoding", Message::encodingName(encoding));
+  response.setResult(resultObject);
+  response.send();
+
+  if (Connection *conn = message.connection())
+    conn->setPacketEncoding(encoding);
+}
+
 } // namespace MoleQueue
@@ -61,6 +61,13 @@ class ConnectionListener;
  * to with result="pong". This can be used to test if a server is alive or not.
  * messageReceived will not be emitted in this case.
  *
+ * Packets are sent as compact JSON by default. A client may request a binary
+ * encoding with method="negotiateEncoding" and
+ * params={"encodings": ["cbor", "json"]}. The first supported encoding in the
+ * list is returned as result={"encoding": "cbor"}, and is used for all later
+ * packets sent on that connection. Incoming packets are accepted in any
+ * encoding. messageReceived is not emitted for these requests either.
+ *
  * Use Message::generateResponse() and Message::generateErrorResponse() to
  * easily create replies to incoming requests.
  */
@@ -152,6 +159,12 @@ private:
   void handleJsonValue(Connection *conn, const EndpointIdType &endpoint,
                        const QJsonValue &json);
 
+  /**
+   * Reply to a negotiateEncoding request and switch the connection to the
+   * chosen encoding.
+   */
+  void handleNegotiateEncoding(const Message &message);
+
   /// Container of all known connections and listeners.
   QMap<ConnectionListener*, QList<Connection*> > m_connections;
 };
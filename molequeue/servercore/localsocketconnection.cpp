@@ -176,6 +176,11 @@ void LocalSocketConnection::flush()
   m_socket->flush();
 }
 
+qint64 LocalSocketConnection::bytesToWrite() const
+{
+  return m_socket != NULL ? m_socket->bytesToWrite() : 0;
+}
+
 void LocalSocketConnection::socketDestroyed()
 {
   // Set to NULL so we know we don't need to clean up
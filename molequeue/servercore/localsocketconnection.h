@@ -97,6 +97,8 @@ public:
 
   void flush();
 
+  qint64 bytesToWrite() const;
+
 private slots:
 
   /**
@@ -24,6 +24,11 @@
 #include <QtCore/QStringList>
 #include <QtCore/QDebug>
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QtCore/QCborValue>
+#define MOLEQUEUE_HAS_CBOR
+#endif
+
 namespace MoleQueue {
 
 // Dummy value returned by *Ref() functions called with invalid types.
@@ -311,6 +316,99 @@ PacketType Message::toJson() const
   return PacketType(doc.toJson());
 }
 
+PacketType Message::toPacket(PacketEncoding encoding) const
+{
+#ifdef MOLEQUEUE_HAS_CBOR
+  if (encoding == CborEncoding)
+    return QCborValue::fromJsonValue(toJsonObject()).toCbor();
+#else
+  Q_UNUSED(encoding);
+#endif
+
+  QJsonDocument doc(toJsonObject());
+  return PacketType(doc.toJson(QJsonDocument::Compact));
+}
+
+QJsonValue Message::fromPacket(const PacketType &packet, QJsonParseError *error)
+{
+  QJsonParseError jsonError;
+
+  // JSON packets start with an object or array, possibly after whitespace.
+  // Anything else is taken to be CBOR.
+  int start = 0;
+  while (start < packet.size() && QChar(packet.at(start)).isSpace())
+    ++start;
+  bool isJson = start == packet.size() || packet.at(start) == '{' ||
+      packet.at(start) == '[';
+
+#ifdef MOLEQUEUE_HAS_CBOR
+  if (!isJson) {
+    QCborParserError cborError;
+    QCborValue cbor = QCborValue::fromCbor(packet, &cborError);
+    QJsonValue json = cbor.toJsonValue();
+    if (cborError.error != QCborError::NoError ||
+        !(json.isObject() || json.isArray())) {
+      jsonError.error = QJsonParseError::IllegalValue;
+      jsonError.offset = static_cast<int>(cborError.offset);
+      json = QJsonValue();
+    }
+    else {
+      jsonError.error = QJsonParseError::NoError;
+      jsonError.offset = 0;
+    }
+    if (error)
+      *error = jsonError;
+    return json;
+  }
+#else
+  Q_UNUSED(isJson);
+#endif
+
+  QJsonDocument doc = QJsonDocument::fromJson(QByteArray(packet), &jsonError);
+  if (error)
+    *error = jsonError;
+  if (jsonError.error != QJsonParseError::NoError || doc.isNull())
+    return QJsonValue();
+  return doc.isArray() ? QJsonValue(doc.array()) : QJsonValue(doc.object());
+}
+
+bool Message::isEncodingSupported(PacketEncoding encoding)
+{
+  switch (encoding) {
+  case JsonEncoding:
+    return true;
+  case CborEncoding:
+#ifdef MOLEQUEUE_HAS_CBOR
+    return true;
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+QString Message::encodingName(PacketEncoding encoding)
+{
+  switch (encoding) {
+  case JsonEncoding:
+    return QLatin1String("json");
+  case CborEncoding:
+    return QLatin1String("cbor");
+  }
+  return QString();
+}
+
+PacketEncoding Message::encodingFromName(const QString &name, bool *ok)
+{
+  if (ok)
+    *ok = true;
+  if (name == QLatin1String("cbor"))
+    return CborEncoding;
+  if (name != QLatin1String("json") && ok)
+    *ok = false;
+  return JsonEncoding;
+}
+
 bool Message::send()
 {
   if (m_type == Invalid || !m_connection || !m_connection->isOpen())
@@ -319,7 +417,8 @@ bool Message::send()
   if (m_type == Request)
     m_id = MessageIdManager::registerMethod(m_method);
 
-  return m_connection->send(toJson(), m_endpoint);
+  return m_connection->send(toPacket(m_connection->packetEncoding()),
+                            m_endpoint);
 }
 
 Message Message::generateResponse() const
@@ -20,6 +20,7 @@
 #include "molequeueservercoreexport.h"
 #include "servercoreglobal.h"
 
+#include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QByteArray>
 #include <QtCore/QFlags>
@@ -90,7 +91,9 @@ class JsonRpc;
  *
  * The JSON representation can be generated
  * and obtained by calling toJson(), and a QJsonObject representation is
- * available from the toJsonObject() method.
+ * available from the toJsonObject() method. toJson() is indented for
+ * readability; send() uses the more compact toPacket() instead, in the
+ * connection's packetEncoding().
  */
 class MOLEQUEUESERVERCORE_EXPORT Message
 {
@@ -235,10 +238,40 @@ public:
   QJsonObject toJsonObject() const;
 
   /**
-   * @return A string representation of the remote procedure call.
+   * @return An indented string representation of the remote procedure call.
    */
   PacketType toJson() const;
 
+  /**
+   * @return The remote procedure call encoded for transmission with
+   * @a encoding. JsonEncoding produces compact JSON. If @a encoding is not
+   * supported, JsonEncoding is used.
+   */
+  PacketType toPacket(PacketEncoding encoding = JsonEncoding) const;
+
+  /**
+   * Decode a packet in any supported encoding.
+   * @param packet The packet, as produced by toPacket().
+   * @param error If not NULL, set to the result of decoding.
+   * @return The JSON object or array held in the packet, or a null value on
+   * error.
+   */
+  static QJsonValue fromPacket(const PacketType &packet,
+                               QJsonParseError *error = NULL);
+
+  /// @return True if packets can be encoded with @a encoding.
+  static bool isEncodingSupported(PacketEncoding encoding);
+
+  /// @return The name of @a encoding used in encoding negotiation ("json",
+  /// "cbor").
+  static QString encodingName(PacketEncoding encoding);
+
+  /**
+   * @return The encoding named @a name (see encodingName()).
+   * @param ok If not NULL, set to false if @a name is not known.
+   */
+  static PacketEncoding encodingFromName(const QString &name, bool *ok = NULL);
+
   /**
    * @brief Send the message to the associated connection and endpoint.
    * @return True on success, false on failure.
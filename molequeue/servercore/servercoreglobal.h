@@ -32,6 +32,16 @@ typedef QJsonValue MessageIdType;
 /// Type for RPC packets
 typedef QByteArray PacketType;
 
+/// Encodings of RPC packets. Incoming packets are decoded regardless of the
+/// encoding, so a peer may switch encodings at any time.
+enum PacketEncoding {
+  /// Compact JSON text.
+  JsonEncoding = 0,
+  /// CBOR (RFC 7049) representation of the JSON value. Only available when
+  /// built against Qt 5.12 or later.
+  CborEncoding
+};
+
 }
 
 #endif // MOLEQUEUE_SERVERCORE_SERVERCOREGLOBAL_H
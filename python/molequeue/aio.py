@@ -0,0 +1,245 @@
+"""An asyncio client for MoleQueue, requires Python 3.6 and pyzmq 17.
+
+Talks JSON-RPC 2.0 to the ZeroMQ endpoint of a running server. Every request
+gets its own future, so any number of requests may be in flight at once and
+responses are matched up by id as they arrive:
+
+  async def main():
+    async with AsyncClient('MoleQueue') as client:
+      ids = await client.submit_jobs(jobs)
+      jobs = await asyncio.gather(*[client.lookup_job(i) for i in ids])
+      async for change in client.job_state_changes():
+        print(change['moleQueueId'], change['newState'])
+
+  asyncio.get_event_loop().run_until_complete(main())
+"""
+
+import asyncio
+import itertools
+import tempfile
+
+import zmq
+import zmq.asyncio
+
+from .client import JobException, JobInformationException
+from .utils import JsonRpc
+
+class AsyncClient:
+  # Requests are sent to the server in JSON-RPC batches of at most this many.
+  MAX_BATCH_SIZE = 256
+
+  def __init__(self, server=None):
+    self._server = server
+    self._packet_ids = itertools.count(1)
+    self._pending = {}
+    self._listeners = []
+    self._binary_encoding = False
+    self._context = None
+    self._socket = None
+    self._reader = None
+
+  async def __aenter__(self):
+    self.connect_to_server(self._server or 'MoleQueue')
+    return self
+
+  async def __aexit__(self, *exc_info):
+    await self.disconnect()
+
+  def connect_to_server(self, server='MoleQueue'):
+    self._server = server
+    self._context = zmq.asyncio.Context.instance()
+    self._socket = self._context.socket(zmq.DEALER)
+    # The server drops replies it cannot queue, so never limit the number
+    # of responses waiting to be read.
+    self._socket.setsockopt(zmq.RCVHWM, 0)
+    self._socket.setsockopt(zmq.LINGER, 0)
+
+    tmpdir = tempfile.gettempdir()
+    connection_string = 'ipc://%s/%s_%s' % (tmpdir, 'zmq', server)
+    self._socket.connect(connection_string)
+    self._reader = asyncio.ensure_future(self._read_packets())
+
+  async def disconnect(self):
+    if self._reader != None:
+      self._reader.cancel()
+      try:
+        await self._reader
+      except asyncio.CancelledError:
+        pass
+      self._reader = None
+
+    for future in self._pending.values():
+      if not future.done():
+        future.set_exception(ConnectionError('Disconnected from server'))
+    self._pending.clear()
+
+    for queue in self._listeners:
+      queue.put_nowait(None)
+
+    if self._socket != None:
+      self._socket.close()
+      self._socket = None
+
+  async def call(self, method, params=None, timeout=None):
+    """Send a single request and return the response packet. Raises
+    asyncio.TimeoutError if no response arrives within timeout seconds."""
+    responses = await self.call_batch([(method, params)], timeout)
+    return responses[0]
+
+  async def call_batch(self, requests, timeout=None):
+    """Send a list of (method, params) requests as JSON-RPC batches and
+    return their response packets, in the same order."""
+    futures = []
+    packets = []
+    for method, params in requests:
+      packet_id = next(self._packet_ids)
+      request = {'jsonrpc': '2.0', 'id': packet_id, 'method': method}
+      if params != None:
+        request['params'] = params
+      packets.append(request)
+      futures.append(self._expect(packet_id))
+
+    try:
+      # Sending waits too, until the server is reachable.
+      responses = self._send_batches(packets, futures)
+      if timeout != None:
+        return await asyncio.wait_for(responses, timeout)
+      return await responses
+    finally:
+      # Forget requests that were abandoned, e.g. on timeout or cancellation.
+      for packet in packets:
+        self._pending.pop(packet['id'], None)
+
+  async def request_queue_list_update(self, timeout=None):
+    response = await self.call('listQueues', None, timeout)
+    return JsonRpc.json_to_queues(response)
+
+  async def submit_job(self, job, timeout=None):
+    return (await self.submit_jobs([job], timeout))[0]
+
+  async def submit_jobs(self, jobs, timeout=None):
+    """Submit several jobs in one batch and return their MoleQueue ids. Raises
+    JobException for the first job the server rejects."""
+    requests = [('submitJob', JsonRpc.object_to_json_params(job))
+                for job in jobs]
+    responses = await self.call_batch(requests, timeout)
+    ids = []
+    for response in responses:
+      if 'error' in response:
+        raise JobException(response['id'],
+                           response['error']['code'],
+                           response['error']['message'])
+      ids.append(response['result']['moleQueueId'])
+    return ids
+
+  async def lookup_job(self, molequeue_id, include_contents=False,
+                       timeout=None):
+    return (await self.lookup_jobs([molequeue_id], include_contents,
+                                   timeout))[0]
+
+  async def lookup_jobs(self, molequeue_ids, include_contents=False,
+                        timeout=None):
+    """Look up several jobs in one batch. Raises JobInformationException for
+    the first id the server does not know."""
+    requests = []
+    for molequeue_id in molequeue_ids:
+      params = {'moleQueueId': molequeue_id}
+      # Large input files are only referenced by hash unless requested
+      if include_contents:
+        params['includeContents'] = True
+      requests.append(('lookupJob', params))
+
+    responses = await self.call_batch(requests, timeout)
+    jobs = []
+    for response in responses:
+      if 'error' in response:
+        raise JobInformationException(response['id'],
+                                      response['error'].get('data'),
+                                      response['error']['code'],
+                                      response['error']['message'])
+      jobs.append(JsonRpc.json_to_job(response))
+    return jobs
+
+  async def cancel_job(self, molequeue_id, timeout=None):
+    """Cancel a job, returning its MoleQueue id once the server has accepted
+    the request."""
+    response = await self.call('cancelJob', {'moleQueueId': molequeue_id},
+                               timeout)
+    if 'error' in response:
+      raise JobInformationException(response['id'],
+                                    response['error'].get('data'),
+                                    response['error']['code'],
+                                    response['error']['message'])
+    return response['result']['moleQueueId']
+
+  async def request_binary_encoding(self, timeout=None):
+    """As Client.request_binary_encoding()."""
+    if not JsonRpc.binary_encoding_supported():
+      return 'json'
+
+    response = await self.call('negotiateEncoding',
+                               {'encodings': ['cbor', 'json']}, timeout)
+    encoding = response['result']['encoding']
+    self._binary_encoding = encoding == 'cbor'
+    return encoding
+
+  async def job_state_changes(self, molequeue_ids=None):
+    """Iterate over the jobStateChanged notifications for jobs submitted by
+    this client, optionally only those in molequeue_ids. Each is the params
+    object, e.g. {'moleQueueId': 1, 'oldState': 'Accepted',
+    'newState': 'QueuedLocal'}. Only notifications arriving after iteration
+    has started are seen. Ends when the client disconnects."""
+    queue = asyncio.Queue()
+    self._listeners.append(queue)
+    try:
+      while True:
+        notification = await queue.get()
+        if notification == None:
+          return
+        if notification.get('method') != 'jobStateChanged':
+          continue
+        params = notification.get('params', {})
+        if molequeue_ids == None or params.get('moleQueueId') in molequeue_ids:
+          yield params
+    finally:
+      self._listeners.remove(queue)
+
+  async def _send_batches(self, packets, futures):
+    for i in range(0, len(packets), self.MAX_BATCH_SIZE):
+      chunk = packets[i:i + self.MAX_BATCH_SIZE]
+      await self._send(chunk[0] if len(chunk) == 1 else chunk)
+    return await asyncio.gather(*futures)
+
+  def _expect(self, packet_id):
+    future = asyncio.get_event_loop().create_future()
+    self._pending[packet_id] = future
+    return future
+
+  async def _send(self, packet):
+    if self._socket == None:
+      raise ConnectionError('Not connected to a server')
+    data = JsonRpc.encode_packet(packet, self._binary_encoding)
+    if isinstance(data, str):
+      data = data.encode('utf-8')
+    await self._socket.send(data)
+
+  async def _read_packets(self):
+    while True:
+      frames = await self._socket.recv_multipart()
+      try:
+        packet = JsonRpc.decode_packet(frames[-1])
+      except ValueError:
+        continue
+
+      # The server answers batch members individually, but accept either.
+      for message in packet if isinstance(packet, list) else [packet]:
+        self._dispatch(message)
+
+  def _dispatch(self, message):
+    if 'id' in message and message['id'] != None:
+      future = self._pending.pop(message['id'], None)
+      if future != None and not future.done():
+        future.set_result(message)
+    elif 'method' in message:
+      for queue in self._listeners:
+        queue.put_nowait(message)
@@ -11,9 +11,9 @@ import time
 import tempfile
 import sys
 
-from utils import underscore_to_camelcase
-from utils import camelcase_to_underscore
-from utils import JsonRpc
+from .utils import underscore_to_camelcase
+from .utils import camelcase_to_underscore
+from .utils import JsonRpc
 import threading
 
 class JobState:
@@ -116,6 +116,7 @@ class Client:
     self._new_response_condition = Condition()
     self._packet_id_lock = Lock()
     self._notification_callbacks = []
+    self._binary_encoding = False
 
   def connect_to_server(self, server):
     self.context = zmq.Context()
@@ -149,7 +150,8 @@ class Client:
 
     jsonrpc = JsonRpc.generate_request(packet_id,
                                        'listQueues',
-                                       None)
+                                       None,
+                                       self._binary_encoding)
 
     self._send_request(packet_id, jsonrpc)
     response = self._wait_for_response(packet_id, timeout)
@@ -168,7 +170,8 @@ class Client:
 
     jsonrpc = JsonRpc.generate_request(packet_id,
                                        'submitJob',
-                                       params)
+                                       params,
+                                       self._binary_encoding)
 
     self._send_request(packet_id, jsonrpc)
     response = self._wait_for_response(packet_id, timeout)
@@ -187,18 +190,42 @@ class Client:
     # otherwise return the molequeue id
     return response['result']['moleQueueId']
 
-  def cancel_job(self):
-    # TODO
-    pass
+  def cancel_job(self, molequeue_id, timeout=None):
+    params = {'moleQueueId': molequeue_id}
+    packet_id = self._next_packet_id()
+    jsonrpc = JsonRpc.generate_request(packet_id,
+                                       'cancelJob',
+                                       params,
+                                       self._binary_encoding)
+
+    self._send_request(packet_id, jsonrpc)
+    response = self._wait_for_response(packet_id, timeout)
+
+    # Timeout
+    if response == None:
+      return None
 
-  def lookup_job(self, molequeue_id, timeout=None):
+    if 'error' in response:
+      exception = JobInformationException(response['id'],
+                                          response['error'].get('data'),
+                                          response['error']['code'],
+                                          response['error']['message'])
+      raise exception
+
+    return response['result']['moleQueueId']
+
+  def lookup_job(self, molequeue_id, timeout=None, include_contents=False):
 
     params = {'moleQueueId': molequeue_id}
+    # Large input files are only referenced by hash unless requested
+    if include_contents:
+      params['includeContents'] = True
 
     packet_id = self._next_packet_id()
     jsonrpc = JsonRpc.generate_request(packet_id,
                                       'lookupJob',
-                                      params)
+                                      params,
+                                      self._binary_encoding)
 
     self._send_request(packet_id, jsonrpc)
     response = self._wait_for_response(packet_id, timeout)
@@ -219,6 +246,144 @@ class Client:
 
     return job
 
+  def list_jobs(self, queues=None, programs=None, states=None,
+                description_contains=None, submitted_after=None,
+                submitted_before=None, fields=None, limit=100, cursor=None,
+                timeout=None):
+    """Return a page of the jobs matching the given criteria, ordered by
+    MoleQueue id, as a (jobs, next_cursor) tuple. Pass next_cursor back to
+    fetch the following page; it is None on the last page. States are given
+    by name, e.g. 'RunningRemote'. Times may be datetime objects or ISO 8601
+    strings. If fields is given, only those job members (e.g. 'job_state')
+    are returned, plus the MoleQueue id. Returns None on timeout."""
+    params = {'limit': limit}
+    if queues != None:
+      params['queues'] = list(queues)
+    if programs != None:
+      params['programs'] = list(programs)
+    if states != None:
+      params['states'] = list(states)
+    if description_contains != None:
+      params['descriptionContains'] = description_contains
+    for name, value in (('submittedAfter', submitted_after),
+                        ('submittedBefore', submitted_before)):
+      if value != None:
+        if hasattr(value, 'isoformat'):
+          value = value.isoformat()
+        params[name] = value
+    if fields != None:
+      params['fields'] = [underscore_to_camelcase(f) for f in fields]
+    if cursor != None:
+      params['cursor'] = cursor
+
+    packet_id = self._next_packet_id()
+    jsonrpc = JsonRpc.generate_request(packet_id,
+                                       'listJobs',
+                                       params,
+                                       self._binary_encoding)
+
+    self._send_request(packet_id, jsonrpc)
+    response = self._wait_for_response(packet_id, timeout)
+
+    # Timeout
+    if response == None:
+      return None
+
+    if 'error' in response:
+      exception = JobException(response['id'],
+                               response['error']['code'],
+                               response['error']['message'])
+      raise exception
+
+    jobs = JsonRpc.json_to_jobs(response)
+
+    return (jobs, response['result']['nextCursor'])
+
+  def subscribe(self, queues=None, programs=None, states=None,
+                min_molequeue_id=None, max_molequeue_id=None, timeout=None):
+    """Ask the server to push changes of the matching jobs, including jobs
+    submitted by other clients. Changes arrive at the notification callbacks
+    as 'jobsChanged' notifications, coalesced over a short window. A job is
+    sent in full the first time, then only with the members that changed. A
+    notification with 'resyncNeeded' set means changes were dropped and the
+    jobs should be looked up again. States are given by name, e.g.
+    'RunningRemote'. Returns the subscription id, or None on timeout."""
+    params = {}
+    if queues != None:
+      params['queues'] = list(queues)
+    if programs != None:
+      params['programs'] = list(programs)
+    if states != None:
+      params['states'] = list(states)
+    if min_molequeue_id != None:
+      params['minMoleQueueId'] = min_molequeue_id
+    if max_molequeue_id != None:
+      params['maxMoleQueueId'] = max_molequeue_id
+
+    packet_id = self._next_packet_id()
+    jsonrpc = JsonRpc.generate_request(packet_id,
+                                       'subscribe',
+                                       params,
+                                       self._binary_encoding)
+
+    self._send_request(packet_id, jsonrpc)
+    response = self._wait_for_response(packet_id, timeout)
+
+    # Timeout
+    if response == None:
+      return None
+
+    if 'error' in response:
+      exception = JobException(response['id'],
+                               response['error']['code'],
+                               response['error']['message'])
+      raise exception
+
+    return response['result']['subscriptionId']
+
+  def unsubscribe(self, subscription_id, timeout=None):
+    params = {'subscriptionId': subscription_id}
+    packet_id = self._next_packet_id()
+    jsonrpc = JsonRpc.generate_request(packet_id,
+                                       'unsubscribe',
+                                       params,
+                                       self._binary_encoding)
+
+    self._send_request(packet_id, jsonrpc)
+    response = self._wait_for_response(packet_id, timeout)
+
+    # Timeout
+    if response == None:
+      return None
+
+    return 'result' in response and response['result']['success'] == True
+
+  def request_binary_encoding(self, timeout=None):
+    """Ask the server to send CBOR encoded packets, which are more compact
+    for large jobs. Requests are also sent CBOR encoded once the server agrees.
+    Requires the cbor2 module. Returns the encoding chosen by the server
+    ('cbor' or 'json'), or None on timeout."""
+    if not JsonRpc.binary_encoding_supported():
+      return 'json'
+
+    params = {'encodings': ['cbor', 'json']}
+    packet_id = self._next_packet_id()
+    jsonrpc = JsonRpc.generate_request(packet_id,
+                                       'negotiateEncoding',
+                                       params,
+                                       self._binary_encoding)
+
+    self._send_request(packet_id, jsonrpc)
+    response = self._wait_for_response(packet_id, timeout)
+
+    # Timeout
+    if response == None:
+      return None
+
+    encoding = response['result']['encoding']
+    self._binary_encoding = encoding == 'cbor'
+
+    return encoding
 
   def _on_response(self, packet_id, msg):
     if packet_id in self._request_response_map:
@@ -237,7 +402,8 @@ class Client:
   def _send_rpc_kill_request(self, timeout=None):
     params = {}
     packet_id = self._next_packet_id()
-    jsonrpc = JsonRpc.generate_request(packet_id, 'rpcKill', params)
+    jsonrpc = JsonRpc.generate_request(packet_id, 'rpcKill', params,
+                                       self._binary_encoding)
     self._send_request(packet_id, jsonrpc)
     response = self._wait_for_response(packet_id, timeout)
 
@@ -287,7 +453,7 @@ class Client:
       raise
 
 def _on_recv(client, msg):
-  jsonrpc = json.loads(msg[0])
+  jsonrpc = JsonRpc.decode_packet(msg[0])
 
   # reply to a request
   if 'id' in jsonrpc:
@@ -1,14 +1,19 @@
 import json
 import re
 import itertools
-import types
 import molequeue
 
+# The CBOR packet encoding is optional
+try:
+  import cbor2
+except ImportError:
+  cbor2 = None
+
 class JsonRpc:
   INTERNAL_FIELDS = ['moleQueueId', 'queueId', 'jobState']
 
   @staticmethod
-  def generate_request(packet_id, method, parameters):
+  def generate_request(packet_id, method, parameters, binary=False):
     request = {}
     request['jsonrpc'] = "2.0"
     request['id'] = packet_id
@@ -16,13 +21,41 @@ class JsonRpc:
     if parameters != None:
       request['params'] = parameters
 
-    return json.dumps(request)
+    return JsonRpc.encode_packet(request, binary)
+
+  @staticmethod
+  def binary_encoding_supported():
+    return cbor2 != None
+
+  @staticmethod
+  def encode_packet(packet, binary=False):
+    if binary:
+      return cbor2.dumps(packet)
+    # compact separators, no whitespace on the wire
+    return json.dumps(packet, separators=(',', ':'))
+
+  @staticmethod
+  def decode_packet(data):
+    # JSON packets start with an object or array, anything else is CBOR
+    if data.lstrip()[:1] in ('{', '[', b'{', b'['):
+      return json.loads(data)
+    if cbor2 == None:
+      raise ValueError('Received a binary packet but cbor2 is not available')
+    return cbor2.loads(data)
 
   @staticmethod
   def json_to_job(json):
+    return JsonRpc._job_object_to_job(json['result'])
+
+  @staticmethod
+  def json_to_jobs(json):
+    return [JsonRpc._job_object_to_job(job) for job in json['result']['jobs']]
+
+  @staticmethod
+  def _job_object_to_job(job_object):
     job = molequeue.Job()
     # convert response into Job object
-    for key, value in json['result'].iteritems():
+    for key, value in job_object.items():
       field = camelcase_to_underscore(key)
       if key in JsonRpc.INTERNAL_FIELDS:
         field = '_' + field
@@ -34,7 +67,7 @@ class JsonRpc:
   def json_to_queues(json):
     queues = []
 
-    for name, programs in json['result'].iteritems():
+    for name, programs in json['result'].items():
       queue = molequeue.Queue();
       queue.name = name
       queue.programs = programs
@@ -46,10 +79,11 @@ class JsonRpc:
   def object_to_json_params(job):
     params = {}
 
-    for key, value in job.__dict__.iteritems():
+    for key, value in job.__dict__.items():
       field = underscore_to_camelcase(key)
 
-      if type(value) == types.InstanceType:
+      # FilePath, FileContents etc. are nested objects
+      if hasattr(value, '__dict__'):
         value = JsonRpc.object_to_json_params(value)
 
       params[field] = value
@@ -64,8 +98,8 @@ def underscore_to_camelcase(value):
 
   c = camelcase()
 
-  return ''.join(c.next()(x) for x in value.split('_'))
+  return ''.join(next(c)(x) for x in value.split('_'))
 
 def camelcase_to_underscore(value):
   operation = itertools.cycle((lambda x : x.lower(), lambda x : '_' + x.lower()))
-  return ''.join(operation.next()(x) for x in re.split('([A-Z])', value))
+  return ''.join(next(operation)(x) for x in re.split('([A-Z])', value))
@@ -0,0 +1,57 @@
+"""Time 10k concurrent job lookups with the asyncio client.
+
+Run against a local server with a queue and program that accept jobs, e.g.
+
+  python3 aiobenchmark.py --server MoleQueue --queue salix \\
+    --program 'sleep (testing)'
+"""
+
+import argparse
+import asyncio
+import time
+
+import molequeue
+from molequeue.aio import AsyncClient
+
+async def benchmark(args):
+  async with AsyncClient(args.server) as client:
+    jobs = []
+    for i in range(args.jobs):
+      job = molequeue.Job()
+      job.queue = args.queue
+      job.program = args.program
+      job.description = 'aiobenchmark %d' % i
+      job.popup_on_state_change = False
+      job.hide_from_gui = True
+      jobs.append(job)
+
+    start = time.perf_counter()
+    ids = await client.submit_jobs(jobs)
+    report('submit_jobs', len(ids), time.perf_counter() - start)
+
+    lookups = [ids[i % len(ids)] for i in range(args.lookups)]
+
+    # One coroutine and one request per lookup, all in flight together.
+    start = time.perf_counter()
+    await asyncio.gather(*[client.lookup_job(i) for i in lookups])
+    report('concurrent lookup_job', len(lookups), time.perf_counter() - start)
+
+    start = time.perf_counter()
+    await client.lookup_jobs(lookups)
+    report('batched lookup_jobs', len(lookups), time.perf_counter() - start)
+
+    await asyncio.gather(*[client.cancel_job(i) for i in ids],
+                         return_exceptions=True)
+
+def report(name, count, seconds):
+  print('%-24s %6d requests in %7.3f s: %9.0f requests/s'
+        % (name, count, seconds, count / seconds))
+
+if __name__ == '__main__':
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  parser.add_argument('--server', default='MoleQueue')
+  parser.add_argument('--queue', default='salix')
+  parser.add_argument('--program', default='sleep (testing)')
+  parser.add_argument('--jobs', type=int, default=100)
+  parser.add_argument('--lookups', type=int, default=10000)
+  asyncio.get_event_loop().run_until_complete(benchmark(parser.parse_args()))
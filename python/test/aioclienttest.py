@@ -0,0 +1,99 @@
+import asyncio
+import unittest
+
+import molequeue
+from molequeue.aio import AsyncClient
+
+def run(coroutine):
+  return asyncio.get_event_loop().run_until_complete(coroutine)
+
+def test_job(description=''):
+  job = molequeue.Job()
+  job.queue = 'salix'
+  job.program = 'sleep (testing)'
+  job.description = description
+  return job
+
+class TestAsyncClient(unittest.TestCase):
+
+  def test_submit_and_lookup_job(self):
+    async def test():
+      async with AsyncClient('MoleQueue') as client:
+        molequeue_id = await client.submit_job(test_job('This is a test job'))
+        self.assertTrue(isinstance(molequeue_id, int))
+
+        job = await client.lookup_job(molequeue_id)
+        self.assertEqual(job.molequeue_id(), molequeue_id)
+        self.assertEqual(job.description, 'This is a test job')
+
+    run(test())
+
+  def test_batches(self):
+    async def test():
+      async with AsyncClient('MoleQueue') as client:
+        # More than one batch worth.
+        count = AsyncClient.MAX_BATCH_SIZE + 10
+        jobs = [test_job('Batch job %d' % i) for i in range(count)]
+        ids = await client.submit_jobs(jobs)
+        self.assertEqual(len(set(ids)), count)
+
+        looked_up = await client.lookup_jobs(ids)
+        self.assertEqual([job.molequeue_id() for job in looked_up], ids)
+        self.assertEqual(looked_up[-1].description, 'Batch job %d' % (count - 1))
+
+    run(test())
+
+  def test_concurrent_requests(self):
+    async def test():
+      async with AsyncClient('MoleQueue') as client:
+        ids = await client.submit_jobs([test_job('a'), test_job('b')])
+        # Both in flight at once, each resolved by its own response.
+        jobs = await asyncio.gather(client.lookup_job(ids[1]),
+                                    client.lookup_job(ids[0]))
+        self.assertEqual(jobs[0].description, 'b')
+        self.assertEqual(jobs[1].description, 'a')
+
+    run(test())
+
+  def test_lookup_unknown_job(self):
+    async def test():
+      async with AsyncClient('MoleQueue') as client:
+        with self.assertRaises(molequeue.JobInformationException):
+          await client.lookup_job(2 ** 31)
+
+    run(test())
+
+  def test_cancel_job(self):
+    async def test():
+      async with AsyncClient('MoleQueue') as client:
+        molequeue_id = await client.submit_job(test_job())
+        self.assertEqual(await client.cancel_job(molequeue_id), molequeue_id)
+
+    run(test())
+
+  def test_job_state_changes(self):
+    async def test():
+      async with AsyncClient('MoleQueue') as client:
+        changes = client.job_state_changes()
+        # Start listening before submitting.
+        first = asyncio.ensure_future(changes.__anext__())
+        await asyncio.sleep(0)
+        molequeue_id = await client.submit_job(test_job())
+        change = await asyncio.wait_for(first, 5)
+        self.assertEqual(change['moleQueueId'], molequeue_id)
+        self.assertTrue('newState' in change)
+        await changes.aclose()
+
+    run(test())
+
+  def test_timeout(self):
+    async def test():
+      # Nothing is listening on this name.
+      async with AsyncClient('MoleQueue-not-running') as client:
+        with self.assertRaises(asyncio.TimeoutError):
+          await client.call('listQueues', timeout=0.5)
+
+    run(test())
+
+if __name__ == '__main__':
+    unittest.main()
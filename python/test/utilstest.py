@@ -18,5 +18,31 @@ class TestUtils(unittest.TestCase):
       self.assertEqual(molequeue.utils.camelcase_to_underscore(camelcase),
                        underscores)
 
+  def test_compact_request(self):
+    request = molequeue.utils.JsonRpc.generate_request(1, 'listQueues', None)
+    self.assertFalse(' ' in request)
+    self.assertEqual(molequeue.utils.JsonRpc.decode_packet(request)['method'],
+                     'listQueues')
+
+  @unittest.skipUnless(molequeue.utils.JsonRpc.binary_encoding_supported(),
+                       'cbor2 not available')
+  def test_binary_request(self):
+    params = {'moleQueueId': 7}
+    request = molequeue.utils.JsonRpc.generate_request(2, 'lookupJob', params,
+                                                       True)
+    decoded = molequeue.utils.JsonRpc.decode_packet(request)
+    self.assertEqual(decoded['id'], 2)
+    self.assertEqual(decoded['params'], params)
+
+  def test_json_to_jobs(self):
+    response = {'result': {'jobs': [{'moleQueueId': 3, 'jobState': 'Finished'},
+                                    {'moleQueueId': 5, 'queue': 'cluster'}],
+                           'nextCursor': 5}}
+    jobs = molequeue.utils.JsonRpc.json_to_jobs(response)
+    self.assertEqual(len(jobs), 2)
+    self.assertEqual(jobs[0].molequeue_id(), 3)
+    self.assertEqual(jobs[0].job_state(), 'Finished')
+    self.assertEqual(jobs[1].queue, 'cluster')
+
 if __name__ == '__main__':
     unittest.main()